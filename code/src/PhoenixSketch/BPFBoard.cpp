@@ -49,7 +49,8 @@ errno_t InitializeBPFBoard(void){
  * @param band Band number to select, or -1 for no filter (out of band)
  *
  * Sets the BPF hardware register via I2C to activate the correct band pass filter.
- * Only writes to I2C if the band selection has changed from the previous state.
+ * Only writes to I2C if the band selection has changed from the previous state,
+ * and defers the write while an expander batch is open.
  */
 void SelectBPFBand(int32_t band) {
     if (band == -1){
@@ -60,11 +61,23 @@ void SelectBPFBand(int32_t band) {
     // this updates the hardware register. To read the hardware register and turn it
     // into the control word, use the BPF_WORD macro
     SET_BPF_BAND(BandToBCD(band)); 
-    if (BPF_GPAB_state != BPF_WORD){
-        // Only write I2C traffic if the band has changed from its previous state
-        BPF_GPAB_state = BPF_WORD;
-        mcpBPF.writeGPIOAB(BPF_GPAB_state);
-    }
+    RequestExpanderWrite(EXPANDER_BPF);
+}
+
+/**
+ * Write the BPF control word to the MCP23017 if it differs from the last one
+ * written. Only the port that changed is sent when the other one is unchanged.
+ * @return Number of I2C transactions used
+ *
+ * Called by the expander write queue.
+ */
+uint8_t FlushBPFMCPRegisters(void){
+    uint16_t word = BPF_WORD;
+    uint8_t gpioa = (uint8_t)(BPF_GPAB_state & 0x00FF);
+    uint8_t gpiob = (uint8_t)(BPF_GPAB_state >> 8);
+    uint8_t n = WriteMCPPorts(mcpBPF, (uint8_t)(word & 0x00FF), (uint8_t)(word >> 8), &gpioa, &gpiob);
+    BPF_GPAB_state = (uint16_t)gpioa | ((uint16_t)gpiob << 8);
+    return n;
 }
 
 /**
@@ -20,7 +20,7 @@ If not, see <https://www.gnu.org/licenses/>.
 #define BPF_CONTROL_H
 
 // BPF control macros
-#define SET_BPF_BAND(val) (hardwareRegister = (hardwareRegister & 0x0FFFFFFF) | (((uint64_t)val & 0x0000000F) << BPFBAND0BIT));buffer_add()
+#define SET_BPF_BAND(val) (hardwareRegister = (hardwareRegister & 0xFFFFFFFF0FFFFFFFULL) | (((uint64_t)val & 0x0000000F) << BPFBAND0BIT));buffer_add()
 #define GET_BPF_BAND ((hardwareRegister & 0xF0000000) >> BPFBAND0BIT)
 
 /*
@@ -66,6 +66,13 @@ errno_t InitializeBPFBoard(void);
  */
 void SelectBPFBand(int32_t band);
 
+/**
+ * @brief Write the BPF control word to the MCP23017 if it changed
+ * @return Number of I2C transactions used
+ * @note Called by the expander write queue
+ */
+uint8_t FlushBPFMCPRegisters(void);
+
 /**
  * @brief Get the current MCP23017 GPIO register state for testing
  * @return 16-bit register value combining GPIOA and GPIOB
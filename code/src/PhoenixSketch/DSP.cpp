@@ -20,6 +20,7 @@ If not, see <https://www.gnu.org/licenses/>.
 
 float32_t DMAMEM float_buffer_L[READ_BUFFER_SIZE];
 float32_t DMAMEM float_buffer_R[READ_BUFFER_SIZE];
+static float32_t DMAMEM agcGain[AGC_GAIN_BLOCK];
 
 DataBlock data;
 
@@ -35,6 +36,13 @@ static uint32_t swrTimer_ms = 0;
 #define RXTXZoom 3
 #define TXIQZOOM 3
 
+// Per-stage timing of the receive chain is only compiled into the host benchmark
+#ifdef DSP_STAGE_TIMING
+#define STAGE_DONE(stage) DSPStageTimer(stage)
+#else
+#define STAGE_DONE(stage)
+#endif
+
 /**
  * Perform the appropriate IQ signal processing depending on the state we're in
  */
@@ -62,7 +70,9 @@ void PerformSignalProcessing(void){
             break;
         }
         default:{
-            // In all other states we don't perform IQ signal processing
+            // In all other states we don't perform IQ signal processing, so a
+            // requested filter mask can be prepared for the next receive
+            ServiceFIRFilterMask();
             break;
         }
     }
@@ -229,6 +239,17 @@ void VolumeScale(DataBlock *data){
     arm_scale_f32(data->Q, volScaleFactor, data->Q, data->N);
 }
 
+/**
+ * AGC gain for an envelope voltage, from the wdsp gain curve
+ * 
+ * @param a Pointer to the AGC structure
+ * @param volts The envelope voltage, at least a->min_volts
+ * @return The gain to apply to the delayed samples
+ */
+static inline float32_t AGCGainForVolts(const AGCConfig *a, float32_t volts){
+    return (a->out_target - a->slope_constant * fmin (0.0, log10f_fast(a->inv_max_input * volts))) / volts;
+}
+
 /**
  * Initialize the AGC structure's variables
  * 
@@ -302,31 +323,75 @@ void InitializeAGC(AGCConfig *a, uint32_t sampleRate_Hz){
         a->ring[i] = 0;
     for (size_t i = 0; i < a->ring_buffsize; i++)
         a->abs_ring[i] = 0;
+    a->peak_head = 0;
+    a->peak_count = 0;
+    if (a->gain_decimation == 0)
+        a->gain_decimation = 1;
+    // Start the gain interpolation from the gain of the current envelope, so the
+    // first segment after a re-initialization does not ramp up from zero
+    a->gain_volts = (a->volts > a->min_volts) ? a->volts : a->min_volts;
+    a->gain = AGCGainForVolts(a, a->gain_volts);
 }
 
 /**
- * Perform audio gain control (AGC).
- * 
- * @param data Pointer to the DataBlock to act upon
+ * Update the sliding-window peak tracker after abs_ring[in_index] has been
+ * written. The deque holds the indices of the look-ahead window
+ * (out_index, in_index] whose magnitudes are larger than every later sample,
+ * so its front is the window maximum. Each sample is pushed and popped at
+ * most once, making the update O(1) amortized regardless of attack_buffsize.
+ *
+ * @param a The AGC structure
+ */
+static inline void UpdateAGCPeak(AGCConfig *a){
+    uint32_t size = a->ring_buffsize;
+    float32_t v = a->abs_ring[a->in_index];
+    // Drop the sample that just left the window
+    if ((a->peak_count > 0) && (a->peak_index[a->peak_head] == a->out_index)){
+        if (++a->peak_head == size)
+            a->peak_head = 0;
+        a->peak_count--;
+    }
+    // Drop samples that can never be the peak again
+    while (a->peak_count > 0){
+        uint32_t back = a->peak_head + a->peak_count - 1;
+        if (back >= size)
+            back -= size;
+        if (a->abs_ring[a->peak_index[back]] > v)
+            break;
+        a->peak_count--;
+    }
+    uint32_t slot = a->peak_head + a->peak_count;
+    if (slot >= size)
+        slot -= size;
+    a->peak_index[slot] = a->in_index;
+    a->peak_count++;
+}
+
+/**
+ * Scalar pass of the AGC. Runs the envelope detector and the attack/decay state
+ * machine on every sample, replaces I and Q with the look-ahead delayed samples
+ * and fills agcGain with the gain to apply to them. The gain itself, which needs
+ * a log and a division, is evaluated only at the end of every gain_decimation
+ * samples, at the end of the block, and whenever volts has moved by more than
+ * AGC_GAIN_MAX_CHANGE since the last evaluation; the samples in between get a
+ * linear interpolation from the previous value. Over such a small change in
+ * volts the gain is close to linear, so the interpolation error stays well
+ * below 0.1 dB while a steady or slowly decaying signal costs one gain
+ * evaluation per gain_decimation samples.
+ *
+ * @param I In-phase samples, replaced by the delayed samples
+ * @param Q Quadrature samples, replaced by the delayed samples
+ * @param n Number of samples, at most AGC_GAIN_BLOCK
+ * @param sampleRate_Hz The sample rate, in Hz
  * @param a The AGC structure containing the AGC state and variables
  */
-void AGC(DataBlock *data, AGCConfig *a){
-    int k;
+static void AGCGainVector(float32_t *I, float32_t *Q, unsigned n, float32_t sampleRate_Hz, AGCConfig *a){
     float32_t mult;
     float32_t abs_out_sample;
     float32_t out_sample[2];
+    unsigned segment = 0;
 
-    if (ED.agc == AGCOff)  // AGC OFF
-    {
-        for (unsigned i = 0; i < data->N; i++)
-        {
-            data->I[i] = a->fixed_gain * data->I[i];
-            data->Q[i] = a->fixed_gain * data->Q[i];
-        }
-        return;
-    }
-
-    for (unsigned i = 0; i < data->N; i++)
+    for (unsigned i = 0; i < n; i++)
     {
         if (++a->out_index >= a->ring_buffsize)
             a->out_index -= a->ring_buffsize;
@@ -336,8 +401,10 @@ void AGC(DataBlock *data, AGCConfig *a){
         out_sample[0] = a->ring[2 * a->out_index + 0];
         out_sample[1] = a->ring[2 * a->out_index + 1];
         abs_out_sample = a->abs_ring[a->out_index];
-        a->ring[2 * a->in_index + 0] = data->I[i];
-        a->ring[2 * a->in_index + 1] = data->Q[i];
+        a->ring[2 * a->in_index + 0] = I[i];
+        a->ring[2 * a->in_index + 1] = Q[i];
+        I[i] = out_sample[0];
+        Q[i] = out_sample[1];
         if (a->pmode == 0) // MAGNITUDE CALCULATION
             a->abs_ring[a->in_index] = fmax(fabs(a->ring[2 * a->in_index + 0]), fabs(a->ring[2 * a->in_index + 1]));
         else
@@ -347,18 +414,12 @@ void AGC(DataBlock *data, AGCConfig *a){
         a->fast_backaverage = a->fast_backmult * abs_out_sample + a->onemfast_backmult * a->fast_backaverage;
         a->hang_backaverage = a->hang_backmult * abs_out_sample + a->onemhang_backmult * a->hang_backaverage;
 
+        UpdateAGCPeak(a);
+
+        // The peak leaving the window forces a new maximum: take it from the
+        // front of the peak tracker rather than rescanning the window
         if ((abs_out_sample >= a->ring_max) && (abs_out_sample > 0.0))
-        {
-            a->ring_max = 0.0;
-            k = a->out_index;
-            for (uint32_t j = 0; j < a->attack_buffsize; j++)
-            {
-                if (++k == (int)a->ring_buffsize)
-                    k = 0;
-                if (a->abs_ring[k] > a->ring_max)
-                    a->ring_max = a->abs_ring[k];
-            }
-        }
+            a->ring_max = a->abs_ring[a->peak_index[a->peak_head]];
         if (a->abs_ring[a->in_index] > a->ring_max)
             a->ring_max = a->abs_ring[a->in_index];
 
@@ -377,7 +438,7 @@ void AGC(DataBlock *data, AGCConfig *a){
                     } else {
                         if (a->hang_enable && (a->hang_backaverage > a->hang_level)) {
                             a->state = 2;
-                            a->hang_counter = (int)(a->hangtime * data->sampleRate_Hz);
+                            a->hang_counter = (int)(a->hangtime * sampleRate_Hz);
                             a->decay_type = 1;
                         } else {
                             a->state = 3;
@@ -451,9 +512,51 @@ void AGC(DataBlock *data, AGCConfig *a){
             a->agc_action = 1;
         }
 
-        mult = (a->out_target - a->slope_constant * fmin (0.0, log10f_fast(a->inv_max_input * a->volts))) / a->volts;
-        data->I[i] = out_sample[0] * mult;
-        data->Q[i] = out_sample[1] * mult;
+        if ((i + 1 - segment == a->gain_decimation) || (i + 1 == n)
+            || (fabsf(a->volts - a->gain_volts) > AGC_GAIN_MAX_CHANGE * a->gain_volts)){
+            mult = AGCGainForVolts(a, a->volts);
+            float32_t step = (mult - a->gain) / (float32_t)(i + 1 - segment);
+            for (unsigned j = segment; j < i; j++)
+                agcGain[j] = a->gain + step * (float32_t)(j + 1 - segment);
+            agcGain[i] = mult;
+            a->gain = mult;
+            a->gain_volts = a->volts;
+            segment = i + 1;
+        }
+    }
+}
+
+/**
+ * Perform audio gain control (AGC).
+ *
+ * The envelope and gain are computed by a scalar pass over blocks of up to
+ * AGC_GAIN_BLOCK samples, and the gain vector is then applied to I and Q with a
+ * vector multiply.
+ * 
+ * @param data Pointer to the DataBlock to act upon
+ * @param a The AGC structure containing the AGC state and variables
+ */
+void AGC(DataBlock *data, AGCConfig *a){
+    if (ED.agc == AGCOff)  // AGC OFF
+    {
+        for (unsigned i = 0; i < data->N; i++)
+        {
+            data->I[i] = a->fixed_gain * data->I[i];
+            data->Q[i] = a->fixed_gain * data->Q[i];
+        }
+        return;
+    }
+
+    for (unsigned start = 0; start < data->N; start += AGC_GAIN_BLOCK)
+    {
+        unsigned n = data->N - start;
+        if (n > AGC_GAIN_BLOCK)
+            n = AGC_GAIN_BLOCK;
+        float32_t *I = &data->I[start];
+        float32_t *Q = &data->Q[start];
+        AGCGainVector(I, Q, n, data->sampleRate_Hz, a);
+        arm_mult_f32(I, agcGain, I, n);
+        arm_mult_f32(Q, agcGain, Q, n);
     }
 }
 
@@ -738,7 +841,7 @@ void PlayBuffer(DataBlock *data){
 
 /**
  * Initialize the global variables to their default startup values
- * 1) Configure the RXfilters
+ * 1) Configure the RXfilters, with their buffers in the DSP arena
  * 2) Configure the AGC
  * 3) Configure the noise reduction
  */
@@ -746,12 +849,18 @@ void InitializeSignalProcessing(void){
     InitializeFilters(ED.spectrum_zoom,&RXfilters);
     InitializeFilters(RXTXZoom,&RXTXfilters);
     InitializeFilters(TXIQZOOM,&TXIQfilters);
+    ReportDSPArena();
+    // The calibration routines read psdnew after every ZoomFFTExe()
+    RXTXfilters.zoom_track_every_frame = true;
+    TXIQfilters.zoom_track_every_frame = true;
     InitializeTransmitFilters(&TXfilters);
     InitializeAGC(&agc, SR[SampleRate].rate/RXfilters.DF);
     InitializeKim1NoiseReduction();
     InitializeXanrNoiseReduction();
     InitializeSpectralNoiseReduction();
     InitializeCWProcessing(ED.currentWPM, &RXfilters);
+    InitializeCWSkimmer();
+    ResetPSD();
 }
 
 /**
@@ -840,7 +949,9 @@ DataBlock * ReceiveProcessing(const char *fname){
 
     // Read data from buffer
     if (ReadIQInputBuffer(&data)){
-        // There is no data available, skip the rest
+        // There is no data available. Use the idle time to prepare a new
+        // filter mask if one was requested.
+        ServiceFIRFilterMask();
         return NULL;
     }
     //Flag(1);
@@ -856,35 +967,31 @@ DataBlock * ReceiveProcessing(const char *fname){
         sprintf(fn2,"IQ_%s",filename);
         WriteIQFile(&data, fn2);
     }
+    STAGE_DONE(DSPStage_Start);
 
     // Scale data channels by the overall system RF gain and the band-specified gain adjustment
     ApplyRFGain(&data, ED.rfGainAllBands_dB, bands[ED.currentBand[ED.activeVFO]].RFgain_dB);
+    STAGE_DONE(DSPStage_ApplyRFGain);
 
     // Perform IQ correction
     ApplyIQCorrection(&data,
         ED.IQAmpCorrectionFactor[ED.currentBand[ED.activeVFO]],
         ED.IQPhaseCorrectionFactor[ED.currentBand[ED.activeVFO]]);
+    STAGE_DONE(DSPStage_ApplyIQCorrection);
 
-    // Perform FFT of full spectrum for spectral display at this point if no zoom
-    if (ED.spectrum_zoom == SPECTRUM_ZOOM_1) {
-        ZoomFFTExe(&data, ED.spectrum_zoom, &RXfilters);
+    // Decode every CW signal in the band
+    if (IsCWSkimmerEnabled()) {
+        DoCWSkimmerProcessing(&data);
+        STAGE_DONE(DSPStage_CWSkimmer);
     }
 
-    // First, frequency translation by +Fs/4 without multiplication from Lyons 
-    // (2011): chapter 13.1.2 page 646. Together with the savings of not having 
-    // to shift/rotate the FFT_buffer, this saves about 1% of processor use.
-    // A signal at x Hz will be at x + 48,000 Hz after this step.
-    FreqShiftFs4(&data);
-
-    SaveData(&data, 1); // used by the unit tests
-
-    // Perform FFT of zoomed-in spectrum for spectral display at this point if zoom != 1
-    if (ED.spectrum_zoom != SPECTRUM_ZOOM_1) {
+    // Perform FFT of full spectrum for spectral display at this point if no zoom
+    if (ED.spectrum_zoom == SPECTRUM_ZOOM_1) {
         ZoomFFTExe(&data, ED.spectrum_zoom, &RXfilters);
+        STAGE_DONE(DSPStage_ZoomFFTExe);
     }
 
-    // Now, translate by the fine tune frequency. A signal at x Hz will be at 
-    // x + shift Hz after this step.
+    // Fine tune frequency, including the CW sidetone offset
     float32_t sideToneShift_Hz = 0;
     if (modeSM.state_id == ModeSm_StateId_CW_RECEIVE ) {
         if (bands[ED.currentBand[ED.activeVFO]].mode == 1) {
@@ -894,42 +1001,71 @@ DataBlock * ReceiveProcessing(const char *fname){
         }
     }
     float32_t shift = ED.fineTuneFreq_Hz[ED.activeVFO] + sideToneShift_Hz;
-    FreqShiftF(&data,shift);
-    SaveData(&data, 2); // used by the unit tests
 
-    // Decimate by 8. Reduce the sampled band to -12,000 Hz to +12,000 Hz.
-    // The 3dB bandwidth is approximately -6,000 to +6,000 Hz
-    DecimateBy8(&data, &RXfilters);
+    if (ED.spectrum_zoom == SPECTRUM_ZOOM_1) {
+        // Frequency translation by +Fs/4 and by the fine tune frequency, fused with
+        // the first decimate-by-4 stage. A signal at x Hz will be at x + 48,000 Hz
+        // + shift Hz before decimation.
+        FreqShiftAndDecimateBy4(&data, true, shift, &RXfilters);
+        STAGE_DONE(DSPStage_FreqShiftDecimateBy4);
+    } else {
+        // The zoomed spectrum is computed after the +Fs/4 shift, so it has to be done
+        // as a separate step. Frequency translation by +Fs/4 without multiplication
+        // from Lyons (2011): chapter 13.1.2 page 646. A signal at x Hz will be at 
+        // x + 48,000 Hz after this step.
+        FreqShiftFs4(&data);
+        STAGE_DONE(DSPStage_FreqShiftFs4);
+        SaveData(&data, 1); // used by the unit tests
+
+        // Perform FFT of zoomed-in spectrum for spectral display
+        ZoomFFTExe(&data, ED.spectrum_zoom, &RXfilters);
+        STAGE_DONE(DSPStage_ZoomFFTExe);
+
+        FreqShiftAndDecimateBy4(&data, false, shift, &RXfilters);
+        STAGE_DONE(DSPStage_FreqShiftDecimateBy4);
+    }
+
+    // Complete the decimation by 8. Reduce the sampled band to -12,000 Hz to 
+    // +12,000 Hz. The 3dB bandwidth is approximately -6,000 to +6,000 Hz
+    DecimateBy2(&data, &RXfilters);
+    STAGE_DONE(DSPStage_DecimateBy2);
 
     SaveData(&data, 3); // used by the unit tests
 
     // Volume adjust for frequency cuts
     VolumeScale(&data);
+    STAGE_DONE(DSPStage_VolumeScale);
 
     // Apply convolution filter. Restrict signals to those between 
     // bands[currentBand].FLoCut_Hz and bands[currentBand].FHiCut_Hz
     ConvolutionFilter(&data, &RXfilters, filename);
+    STAGE_DONE(DSPStage_ConvolutionFilter);
 
     SaveData(&data, 4); // used by the unit tests
 
     // AGC
     AGC(&data, &agc);
+    STAGE_DONE(DSPStage_AGC);
 
     // Demodulate
     Demodulate(&data, &RXfilters);
+    STAGE_DONE(DSPStage_Demodulate);
 
     SaveData(&data, 5); // used by the unit tests
 
     // Receive EQ
     BandEQ(&data, &RXfilters, RX);
+    STAGE_DONE(DSPStage_BandEQ);
 
     // Noise reduction
     NoiseReduction(&data);
+    STAGE_DONE(DSPStage_NoiseReduction);
 
     // Notch filter
     if (ED.ANR_notchOn == 1) {
         Xanr(&data,1);
         arm_copy_f32(data.Q, data.I, data.N);
+        STAGE_DONE(DSPStage_Notch);
     }
 
     if (modeSM.state_id == ModeSm_StateId_CW_RECEIVE){
@@ -937,19 +1073,23 @@ DataBlock * ReceiveProcessing(const char *fname){
         DoCWReceiveProcessing(&data, &RXfilters);
         // CW audio bandpass
         CWAudioFilter(&data, &RXfilters);
+        STAGE_DONE(DSPStage_CWProcessing);
     }
 
     // Interpolate
     InterpolateReceiveData(&data, &RXfilters);
+    STAGE_DONE(DSPStage_InterpolateReceiveData);
 
     // Volume adjust for audio volume setting. I and Q contain duplicate data, don't 
     // need to scale both
     AdjustVolume(&data, &RXfilters);
+    STAGE_DONE(DSPStage_AdjustVolume);
 
     SaveData(&data, 6); // used by the unit tests
 
     // Play sound on the speaker
     PlayBuffer(&data);
+    STAGE_DONE(DSPStage_PlayBuffer);
 
     elapsed_micros_sum = elapsed_micros_sum + usec;
     elapsed_micros_idx_t++;
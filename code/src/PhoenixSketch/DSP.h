@@ -193,4 +193,38 @@ void AdjustVolume(DataBlock *data, ReceiveFilterConfig *RXfilters);
  */
 void PlayBuffer(DataBlock *data);
 
+// Profiling
+
+/** Stages of the receive chain that can be timed individually */
+enum DSPStage {
+    DSPStage_Start = 0,
+    DSPStage_ApplyRFGain,
+    DSPStage_ApplyIQCorrection,
+    DSPStage_CWSkimmer,
+    DSPStage_ZoomFFTExe,
+    DSPStage_FreqShiftFs4,
+    DSPStage_FreqShiftDecimateBy4,
+    DSPStage_DecimateBy2,
+    DSPStage_VolumeScale,
+    DSPStage_ConvolutionFilter,
+    DSPStage_AGC,
+    DSPStage_Demodulate,
+    DSPStage_BandEQ,
+    DSPStage_NoiseReduction,
+    DSPStage_Notch,
+    DSPStage_CWProcessing,
+    DSPStage_InterpolateReceiveData,
+    DSPStage_AdjustVolume,
+    DSPStage_PlayBuffer,
+    DSPStage_Count
+};
+
+/**
+ * @brief Mark the completion of a receive chain stage
+ * @param stage The stage that has just finished; DSPStage_Start marks the start of a block
+ * @note Only called when compiled with DSP_STAGE_TIMING defined. The implementation is
+ *       supplied by the host-side benchmark, so the firmware build contains no timing code.
+ */
+void DSPStageTimer(DSPStage stage);
+
 #endif // DSP_H
@@ -0,0 +1,110 @@
+/*
+Copyright (C) 2026 T41 EP Software Contributors
+See Contributors.txt for list of known authors.
+
+This file is part of Phoenix.
+
+Phoenix is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Phoenix is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Phoenix.
+If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file DSP_Arena.cpp
+ * @brief Fixed memory pool for DSP filter buffers
+ *
+ * The decimation filters used to malloc their state and coefficient buffers each
+ * time they were initialized and never freed them. The arena is a fixed pool in
+ * OCRAM, split into one region per receive filter bank. InitializeFilters()
+ * empties the region of its bank and allocates from it again, so initializing a
+ * bank any number of times never needs more memory. Nothing comes from the heap.
+ */
+
+#include "SDT.h"
+
+static uint8_t DMAMEM dspArena[DSP_ARENA_BYTES] __attribute__((aligned(DSP_ARENA_ALIGN)));
+
+struct DSPArenaBank {
+    const ReceiveFilterConfig *owner;  // NULL if the region is free
+    size_t used;
+};
+static DSPArenaBank dspArenaBanks[DSP_ARENA_BANKS];
+static size_t dspArenaOverflow = 0;
+
+static DSPArenaBank *FindDSPArenaBank(const ReceiveFilterConfig *filters){
+    for (size_t i = 0; i < DSP_ARENA_BANKS; i++){
+        if (dspArenaBanks[i].owner == filters)
+            return &dspArenaBanks[i];
+    }
+    return NULL;
+}
+
+bool ResetDSPArenaBank(const ReceiveFilterConfig *filters){
+    DSPArenaBank *bank = FindDSPArenaBank(filters);
+    if (bank == NULL)
+        bank = FindDSPArenaBank(NULL);
+    if (bank == NULL){
+        Debug("ERROR: no DSP arena region left for a filter bank");
+        return false;
+    }
+    bank->owner = filters;
+    bank->used = 0;
+    return true;
+}
+
+void ReleaseDSPArenaBank(const ReceiveFilterConfig *filters){
+    DSPArenaBank *bank = FindDSPArenaBank(filters);
+    if (bank == NULL)
+        return;
+    bank->owner = NULL;
+    bank->used = 0;
+}
+
+void *DSPArenaAlloc(const ReceiveFilterConfig *filters, size_t bytes){
+    size_t size = (bytes + DSP_ARENA_ALIGN - 1) & ~((size_t)DSP_ARENA_ALIGN - 1);
+    DSPArenaBank *bank = FindDSPArenaBank(filters);
+    if ((bank == NULL) || (size > DSP_ARENA_BANK_BYTES - bank->used)){
+        Debug("ERROR: DSP arena region full, " + String((uint32_t)bytes) + " bytes refused");
+        dspArenaOverflow += bytes;
+        return NULL;
+    }
+    void *p = &dspArena[(bank - dspArenaBanks) * DSP_ARENA_BANK_BYTES + bank->used];
+    bank->used += size;
+    return p;
+}
+
+size_t GetDSPArenaBytesUsed(void){
+    size_t used = 0;
+    for (size_t i = 0; i < DSP_ARENA_BANKS; i++)
+        used += dspArenaBanks[i].used;
+    return used;
+}
+
+size_t GetDSPArenaOverflowBytes(void){
+    return dspArenaOverflow;
+}
+
+size_t GetDSPArenaBankBytes(const ReceiveFilterConfig *filters){
+    DSPArenaBank *bank = FindDSPArenaBank(filters);
+    if (bank == NULL)
+        return 0;
+    return bank->used;
+}
+
+void ReportDSPArena(void){
+    Debug("DSP arena: RX " + String((uint32_t)GetDSPArenaBankBytes(&RXfilters)) +
+          ", RXTX " + String((uint32_t)GetDSPArenaBankBytes(&RXTXfilters)) +
+          ", TXIQ " + String((uint32_t)GetDSPArenaBankBytes(&TXIQfilters)) +
+          " bytes; " + String((uint32_t)GetDSPArenaBytesUsed()) + " of " + String((uint32_t)DSP_ARENA_BYTES) +
+          " used");
+    if (dspArenaOverflow > 0){
+        Debug("DSP arena overflow: " + String((uint32_t)dspArenaOverflow) + " bytes refused");
+    }
+}
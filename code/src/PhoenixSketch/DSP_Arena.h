@@ -0,0 +1,81 @@
+/*
+Copyright (C) 2026 T41 EP Software Contributors
+See Contributors.txt for list of known authors.
+
+This file is part of Phoenix.
+
+Phoenix is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Phoenix is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Phoenix.
+If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DSP_ARENA_H
+#define DSP_ARENA_H
+#include "SDT.h"
+
+// Room for the decimation filters of one receive filter bank at 192 ksps
+// (about 21 kB), with some to spare
+#define DSP_ARENA_BANK_BYTES (24 * 1024)
+// One region each for the RX, RXTX and TXIQ filter banks
+#ifndef DSP_ARENA_BANKS
+#define DSP_ARENA_BANKS 3
+#endif
+#define DSP_ARENA_BYTES (DSP_ARENA_BANKS * DSP_ARENA_BANK_BYTES)
+#define DSP_ARENA_ALIGN 8
+
+/**
+ * @brief Give a filter bank an empty arena region
+ * @param filters The filter bank
+ * @return true if the bank has a region. If every region belongs to another
+ *         bank an error is logged and false is returned
+ * @note Called by InitializeFilters(). Buffers the bank was given earlier must
+ *       not be used afterwards
+ */
+bool ResetDSPArenaBank(const ReceiveFilterConfig *filters);
+
+/**
+ * @brief Hand a filter bank's arena region back
+ * @param filters The filter bank
+ * @note Called when the bank is destroyed
+ */
+void ReleaseDSPArenaBank(const ReceiveFilterConfig *filters);
+
+/**
+ * @brief Allocate a buffer from a filter bank's arena region
+ * @param filters The filter bank
+ * @param bytes Size of the buffer
+ * @return Pointer to the buffer. If the region is full an error is logged and
+ *         NULL is returned
+ */
+void *DSPArenaAlloc(const ReceiveFilterConfig *filters, size_t bytes);
+
+/**
+ * @brief Get the number of arena bytes in use by all filter banks
+ */
+size_t GetDSPArenaBytesUsed(void);
+
+/**
+ * @brief Get the number of bytes that were asked for and did not fit in the arena
+ */
+size_t GetDSPArenaOverflowBytes(void);
+
+/**
+ * @brief Get the arena bytes held by the decimation filters of a filter bank
+ * @param filters The filter bank
+ * @return Bytes of state and coefficient buffers, with alignment padding
+ */
+size_t GetDSPArenaBankBytes(const ReceiveFilterConfig *filters);
+
+/**
+ * @brief Log the arena bytes used by each receive filter bank and in total
+ */
+void ReportDSPArena(void);
+
+#endif // DSP_ARENA_H
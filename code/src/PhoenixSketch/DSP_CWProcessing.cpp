@@ -19,33 +19,28 @@ If not, see <https://www.gnu.org/licenses/>.
 #include "DSP_CWProcessing.h"
 
 float32_t float_buffer_CW[256];
-float32_t sinBuffer[256];
-float32_t float_Corr_Buffer[511];
-static float32_t aveCorrResult;
-static uint32_t CWLevelTimer, CWLevelTimerOld;
-
-// charProcessFlag means a character is being decoded.  
-// blankFlag indicates a blank has already been printed.
-bool charProcessFlag, blankFlag;
-static enum MorseStates decodeStates = state0;
-static int currentTime, interElementGap, noSignalTimeStamp;
-static int64_t signalStart, signalEnd;
-static int64_t gapLength;//, gapEnd, gapStart; // Time for noise measures
-static float32_t thresholdGeometricMean = 140.0;  // This changes as decoder runs
-static uint64_t ditLength, dahLength;
-static int64_t signalElapsedTime;
-static uint8_t currentDashJump = DECODER_BUFFER_SIZE;
-static uint8_t currentDecoderIndex = 0;
-static int32_t gapHistogram[HISTOGRAM_ELEMENTS];
-static int32_t gapAtom, topGapIndex, topGapIndexOld, gapChar;
-static uint8_t endGapFlag;
+
+// Sliding DFT tone detector. Bin 0 is at the CW tone; bins 1 and 2 sit
+// CW_NOISE_BIN_OFFSET bins below and above it and measure the noise floor.
+static float32_t cwDelayLine[CW_DETECTOR_LENGTH];
+static uint32_t cwDelayIndex;
+static float32_t cwBinRe[CW_DETECTOR_BINS], cwBinIm[CW_DETECTOR_BINS];
+static float32_t cwRotRe[CW_DETECTOR_BINS], cwRotIm[CW_DETECTOR_BINS];   // r e^{jw}
+static float32_t cwTailRe[CW_DETECTOR_BINS], cwTailIm[CW_DETECTOR_BINS]; // r^L e^{jwL}
+static float32_t cwToneEnvelope[256];
+static float32_t cwNoiseEnvelope[256];
+static float32_t cwDetectorTone_Hz;
+static float32_t cwDetectorRate_Hz = 24000.0;
+static float32_t cwSNR_dB;
+static const float32_t cwSNRThreshold = powf(10.0, CW_DETECT_SNR_DB / 10.0);
+
+// The decoder is timed by counting the audio samples it has processed, so mark
+// and space durations are not quantized to the 256 sample block period.
+static int64_t cwSampleClock = 0;
+static int64_t cwLastMarkTime = 0;
+static CWMarkDetector cwMarkDetector;
+static CWDecoder cwDecoder;
 static bool CWLocked = false;
-uint8_t valFlag = 0;
-int64_t valRef1, gapRef1, valRef2;
-int64_t aveDitLength = 80;
-int64_t aveDahLength = 200;
-int64_t signalStartOld = 0;
-int32_t signalHistogram[HISTOGRAM_ELEMENTS];
 char *bigMorseCodeTree = (char *)"-EISH5--4--V---3--UF--------?-2--ARL---------.--.WP------J---1--TNDB6--.--X/-----KC------Y------MGZ7----,Q------O-8------9--0----";
 //                                012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789012345678
 //                                         10        20        30        40        50        60        70        80        90       100       110       120
@@ -54,73 +49,162 @@ char *bigMorseCodeTree = (char *)"-EISH5--4--V---3--UF--------?-2--ARL---------.
  * Initialize CW processing and decoder
  * @param wpm Words per minute for initial decoder speed
  * @param RXfilters Filter configuration containing decimation factor
- * @return Pointer to sine buffer used for CW tone correlation
  *
- * Generates a reference sine wave at the CW tone frequency for correlation-based
- * detection. Resets decoder histograms and sets initial dit length based on WPM.
+ * Tunes the tone detector to the CW tone frequency, resets decoder histograms
+ * and sets initial dit length based on WPM.
+ */
+void InitializeCWProcessing(uint32_t wpm, ReceiveFilterConfig *RXfilters){
+    float32_t sampleRate_Hz = (float32_t)SR[SampleRate].rate/(float32_t)RXfilters->DF;
+    InitializeCWToneDetector(CWToneOffsetsHz[ED.CWToneIndex], sampleRate_Hz);
+    InitializeCWDecoder(&cwDecoder, wpm, sampleRate_Hz, cwSampleClock);
+    ED.currentWPM = 1200 / cwDecoder.ditLength;
+}
+
+/**
+ * Tune the sliding DFT tone detector and clear its state.
+ * @param tone_Hz Frequency of the CW tone in the demodulated audio
+ * @param sampleRate_Hz Sample rate of the audio
+ *
+ * Each bin is a damped sliding DFT over the last CW_DETECTOR_LENGTH samples:
+ *     S[n] = x[n] + r e^{jw} S[n-1] - r^L e^{jwL} x[n-L]
+ * which costs one complex multiply-add per sample and bin whatever the window
+ * length. The damping r keeps rounding errors from accumulating.
  */
-float32_t * InitializeCWProcessing(uint32_t wpm, ReceiveFilterConfig *RXfilters){
-    float32_t theta = 0.0;
-    // phs = 2 * PI * freqSideTone / 24000
-    float32_t phs = 2.0 * PI * CWToneOffsetsHz[ED.CWToneIndex] 
-            / ((float32_t)SR[SampleRate].rate/(float32_t)RXfilters->DF);
-    for (uint32_t kf = 0; kf < READ_BUFFER_SIZE/RXfilters->DF; kf++) {
-        theta = kf * phs;  
-        sinBuffer[kf] = sin(theta);
+void InitializeCWToneDetector(float32_t tone_Hz, float32_t sampleRate_Hz){
+    float32_t binSpacing_Hz = sampleRate_Hz / (float32_t)CW_DETECTOR_LENGTH;
+    float32_t freqs[CW_DETECTOR_BINS] = {
+        tone_Hz,
+        tone_Hz - CW_NOISE_BIN_OFFSET * binSpacing_Hz,
+        tone_Hz + CW_NOISE_BIN_OFFSET * binSpacing_Hz
+    };
+    float32_t rL = powf(CW_DETECTOR_DAMPING, (float32_t)CW_DETECTOR_LENGTH);
+    for (uint32_t b = 0; b < CW_DETECTOR_BINS; b++){
+        float32_t w = 2.0 * PI * freqs[b] / sampleRate_Hz;
+        cwRotRe[b] = CW_DETECTOR_DAMPING * cosf(w);
+        cwRotIm[b] = CW_DETECTOR_DAMPING * sinf(w);
+        cwTailRe[b] = rL * cosf(w * CW_DETECTOR_LENGTH);
+        cwTailIm[b] = rL * sinf(w * CW_DETECTOR_LENGTH);
+        cwBinRe[b] = 0;
+        cwBinIm[b] = 0;
     }
-    ResetHistograms();
-    SetDitLength(wpm);
-    return sinBuffer;
+    for (uint32_t i = 0; i < CW_DETECTOR_LENGTH; i++)
+        cwDelayLine[i] = 0;
+    cwDelayIndex = 0;
+    cwDetectorTone_Hz = tone_Hz;
+    cwDetectorRate_Hz = sampleRate_Hz;
+    cwSNR_dB = 0;
+    cwMarkDetector.peak = 0;
+    cwMarkDetector.mark = false;
 }
 
 /**
- * Process CW receive signals using correlation and Goertzel detection
+ * Run the tone detector over a block of audio.
+ * @param data Pointer to the audio samples
+ * @param N Number of samples, at most 256
+ * @param toneEnvelope Receives the squared tone amplitude at each sample
+ * @param noiseEnvelope Receives the mean squared amplitude of the noise bins at each sample
+ *
+ * The envelopes are scaled so that a sine of amplitude A at the bin frequency
+ * reads A*A once it has filled the window.
+ */
+void CWToneDetect(const float32_t *data, uint32_t N, float32_t *toneEnvelope, float32_t *noiseEnvelope){
+    const float32_t scale = 4.0 / ((float32_t)CW_DETECTOR_LENGTH * (float32_t)CW_DETECTOR_LENGTH);
+    for (uint32_t n = 0; n < N; n++){
+        float32_t x = data[n];
+        float32_t old = cwDelayLine[cwDelayIndex];
+        cwDelayLine[cwDelayIndex] = x;
+        if (++cwDelayIndex == CW_DETECTOR_LENGTH)
+            cwDelayIndex = 0;
+        float32_t power[CW_DETECTOR_BINS];
+        for (uint32_t b = 0; b < CW_DETECTOR_BINS; b++){
+            float32_t re = x + cwRotRe[b] * cwBinRe[b] - cwRotIm[b] * cwBinIm[b] - cwTailRe[b] * old;
+            float32_t im = cwRotRe[b] * cwBinIm[b] + cwRotIm[b] * cwBinRe[b] - cwTailIm[b] * old;
+            cwBinRe[b] = re;
+            cwBinIm[b] = im;
+            power[b] = (re * re + im * im) * scale;
+        }
+        toneEnvelope[n] = power[0];
+        noiseEnvelope[n] = 0.5 * (power[1] + power[2]);
+    }
+}
+
+/**
+ * Decide whether the CW tone is keyed from its power averaged over a few samples.
+ * @param det The detector state for this signal
+ * @param tone Mean power at the CW tone
+ * @param noise Mean power in the noise reference bins
+ * @return 1 for a mark, 0 for a space
+ *
+ * The thresholds follow the peak tone power, so the envelope is cut about halfway
+ * up its rising and falling edges and the measured durations do not depend on
+ * the signal level. The gap between the two thresholds stops the decision
+ * chattering on a noisy edge.
+ */
+uint8_t CWMarkDecision(CWMarkDetector *det, float32_t tone, float32_t noise){
+    det->peak *= CW_PEAK_DECAY;
+    if (tone > det->peak)
+        det->peak = tone;
+    float32_t fraction = det->mark ? CW_MARK_OFF_FRACTION : CW_MARK_ON_FRACTION;
+    det->mark = (tone > fraction * det->peak) && (tone > CW_DETECT_MIN_POWER)
+                && (tone > cwSNRThreshold * noise);
+    return det->mark ? 1 : 0;
+}
+
+/**
+ * Return the signal to noise ratio of the CW tone over the last block, in dB
+ */
+float32_t GetCWToneSNR_dB(void){
+    return cwSNR_dB;
+}
+
+/**
+ * Process CW receive signals with the sliding DFT tone detector
  * @param data Data block containing I/Q samples to process
  * @param RXfilters Filter configuration including CW decode FIR filter
  *
- * Applies FIR filtering to incoming signal, then uses both correlation with a
- * reference sine wave and Goertzel magnitude detection to identify CW signals.
- * Combined coefficient determines if signal is present and drives the decoder.
- * Updates CW lock status based on signal strength. Only active when decoder is enabled.
+ * Applies FIR filtering to incoming signal, then measures the envelope at the
+ * CW tone and at two neighbouring frequencies. Every CW_DECISION_SAMPLES samples
+ * the tone is declared present or absent and the decoder is stepped with the
+ * sample clock, so it times the edges to within CW_DECISION_SAMPLES samples.
+ * The lock is dropped CW_LOCK_HOLD_S after the last mark. Only active when
+ * decoder is enabled.
  */
 void DoCWReceiveProcessing(DataBlock *data, ReceiveFilterConfig *RXfilters) {
-    float32_t goertzelMagnitude;
-    uint8_t audioTemp;
-    float32_t corrResult;
-    uint32_t corrResultIndex;
-    float32_t combinedCoeff;
-
     // Park McClellan FIR filter const Group delay
     // Note that data-Q contains duplicate data as this is after demod
     arm_fir_f32(&RXfilters->FIR_CW_Decode, data->I, float_buffer_CW, 256);
 
     if (ED.decoderFlag == 1) {
-        // Calculate correlation between calc sine and incoming signal
-        arm_correlate_f32(float_buffer_CW, 256, sinBuffer, 256, float_Corr_Buffer);
-        arm_max_f32(float_Corr_Buffer, 511, &corrResult, &corrResultIndex);
-        //running average of corr coeff.
-        aveCorrResult = .7 * corrResult + .3 * aveCorrResult;
-        
-        // Calculate Goertzel Magnitude of incomming signal
-        goertzelMagnitude = goertzel_mag(256, CWToneOffsetsHz[ED.CWToneIndex], 
-                                    data->sampleRate_Hz, float_buffer_CW);
-
-        // Combine Correlation and Gowetzel Coefficients
-        combinedCoeff = 10 * aveCorrResult * 100 * goertzelMagnitude;
-
-        // If have a reasonable corr coeff, >50, then we have a keeper, changed CW decode "lock" indicator
-        if (combinedCoeff > 50) {
-            audioTemp = 1;
-            CWLocked = true;
-        } else {
-            audioTemp = 0;
-            CWLevelTimer = millis();
-            if (CWLevelTimer - CWLevelTimerOld > 2000) {
-                CWLevelTimerOld = millis();
+        // Follow changes of the CW tone
+        if ((cwDetectorTone_Hz != CWToneOffsetsHz[ED.CWToneIndex]) ||
+            (cwDetectorRate_Hz != (float32_t)data->sampleRate_Hz)) {
+            InitializeCWToneDetector(CWToneOffsetsHz[ED.CWToneIndex], (float32_t)data->sampleRate_Hz);
+        }
+        CWToneDetect(float_buffer_CW, data->N, cwToneEnvelope, cwNoiseEnvelope);
+
+        float32_t toneSum = 0, noiseSum = 0;
+        for (uint32_t i = 0; i < data->N; i += CW_DECISION_SAMPLES) {
+            uint32_t n = data->N - i;
+            if (n > CW_DECISION_SAMPLES)
+                n = CW_DECISION_SAMPLES;
+            float32_t tone = 0, noise = 0;
+            for (uint32_t j = i; j < i + n; j++) {
+                tone += cwToneEnvelope[j];
+                noise += cwNoiseEnvelope[j];
+            }
+            toneSum += tone;
+            noiseSum += noise;
+            cwSampleClock += n;
+            uint8_t audioValue = CWMarkDecision(&cwMarkDetector, tone / (float32_t)n, noise / (float32_t)n);
+            if (audioValue) {
+                cwLastMarkTime = cwSampleClock;
+                CWLocked = true;
+            } else if (cwSampleClock - cwLastMarkTime > (int64_t)(CW_LOCK_HOLD_S * cwDetectorRate_Hz)) {
                 CWLocked = false;
             }
+            DoCWDecoding(audioValue, cwSampleClock);
         }
-        DoCWDecoding(audioTemp);
+        cwSNR_dB = 10.0 * log10f_fast((toneSum + 1e-12) / (noiseSum + 1e-12));
     }
 }
 
@@ -215,9 +299,50 @@ bool IsMorseCharacterBufferUpdated(void){
     return morseCharacterUpdated;
 }
 
+/**
+ * Convert a duration measured with a decoder's sample clock to milliseconds
+ * @param dec The decoder
+ * @param samples Duration in samples
+ * @return Duration in ms, rounded to the nearest ms
+ */
+static int64_t SamplesToMs(CWDecoder *dec, int64_t samples){
+    return (int64_t)((float32_t)samples * 1000.0 / dec->sampleRate_Hz + 0.5);
+}
+
+/**
+ * Prepare a decoder for a new signal
+ * @param dec The decoder
+ * @param wpm Words per minute for initial decoder speed
+ * @param sampleRate_Hz Rate of the sample clock the decoder is stepped with
+ * @param sampleTime The sample clock now
+ */
+void InitializeCWDecoder(CWDecoder *dec, uint32_t wpm, float32_t sampleRate_Hz, int64_t sampleTime){
+    dec->sampleRate_Hz = sampleRate_Hz;
+    dec->decodeState = state0;
+    dec->charProcessFlag = false;
+    dec->blankFlag = true;  // Don't start with a blank
+    dec->currentDashJump = DECODER_BUFFER_SIZE;
+    dec->currentDecoderIndex = 0;
+    dec->currentTime = sampleTime;
+    dec->noSignalTimeStamp = sampleTime;
+    dec->signalStart = sampleTime;
+    dec->signalEnd = sampleTime;
+    dec->signalStartOld = sampleTime;
+    dec->interElementGap = 0;
+    dec->gapLength = 0;
+    dec->signalElapsedTime = 0;
+    dec->topGapIndex = 0;
+    dec->topGapIndexOld = 0;
+    dec->endGapFlag = 0;
+    dec->valFlag = 0;
+    dec->gapRef1 = 0;
+    ResetHistograms(dec);
+    SetDitLength(dec, wpm);
+}
+
 /**
  * Called when in CW mode to decode morse. Function assumes:
- * 
+ *
  *     dit           = 1
  *     dah           = dit * 3
  *     inter-atom    = dit
@@ -225,101 +350,122 @@ bool IsMorseCharacterBufferUpdated(void){
  *     inter-word    = dit * 7
  *
  * You can distinguish between dah and inter-letter by presence/absence of signal. Same for inter-atom.
- * 
- * @param audioValue        the strength of audio signal
+ * Edges are timestamped with the sample clock and the durations converted to ms.
+ *
+ * @param dec               the decoder
+ * @param audioValue        1 if the tone is present, 0 if not
+ * @param sampleTime        the sample clock at the end of the samples audioValue describes
+ * @return the character decoded, a blank at the end of a word, or '\0' if there is none yet
  */
-void DoCWDecoding(uint8_t audioValue) {
-    static int64_t oldTime = millis();
-    switch (decodeStates) {
+char CWDecoderStep(CWDecoder *dec, uint8_t audioValue, int64_t sampleTime) {
+    char decoded = '\0';
+    switch (dec->decodeState) {
         case state0:{
             // State 0.  Detects start of signal and starts timer.
             // Detect signal and redirect to appropriate state.
             if (audioValue == 1) {
-                signalStart = millis(); // Time stamp beginning of signal.
-                decodeStates = state1;  // Go to "signalStart" state.
+                dec->signalStart = sampleTime; // Time stamp beginning of signal.
+                dec->decodeState = state1;  // Go to "signalStart" state.
                 // Calculate the time gap between the start of this new signal and the end of the last one.
-                gapLength = signalStart - signalEnd;  
-                if (gapLength > LOWEST_ATOM_TIME // range
-                    && (uint32_t)gapLength < (uint32_t)(thresholdGeometricMean * 3)
-                    && signalStart - oldTime > 5000L) {    // Only call histogram every 5 seconds
-                    DoGapHistogram(gapLength);             // Map the gap in the signal
-                    oldTime = signalStart;                 // Reset old time
+                dec->gapLength = SamplesToMs(dec, dec->signalStart - dec->signalEnd);
+                if (dec->gapLength > LOWEST_ATOM_TIME // range
+                    && (uint32_t)dec->gapLength < (uint32_t)(dec->thresholdGeometricMean * 3)
+                    && SamplesToMs(dec, dec->signalStart - dec->histogramTime) > 5000L) {    // Only call histogram every 5 seconds
+                    DoGapHistogram(dec, dec->gapLength);   // Map the gap in the signal
+                    dec->histogramTime = dec->signalStart; // Reset old time
                 }
                 break;
             }
-            noSignalTimeStamp = millis();
-            interElementGap = noSignalTimeStamp - signalEnd;
+            dec->noSignalTimeStamp = sampleTime;
+            dec->interElementGap = SamplesToMs(dec, dec->noSignalTimeStamp - dec->signalEnd);
             // use thresholdGeometricMean??? was ditLength. End of character!  65 * 2
-            if ((interElementGap > ditLength * 1.95) && charProcessFlag) {  
-                decodeStates = state5;   // Character ended, print it!
+            if ((dec->interElementGap > dec->ditLength * 1.95) && dec->charProcessFlag) {
+                dec->decodeState = state5;   // Character ended, print it!
                 break;
             }
             // A big gap, print a blank, but don't repeat a blank.  85 * 3.5
-            if (interElementGap > ditLength * 4.5 && not blankFlag && not charProcessFlag) {  
-                decodeStates = state6;
+            if (dec->interElementGap > dec->ditLength * 4.5 && not dec->blankFlag && not dec->charProcessFlag) {
+                dec->decodeState = state6;
                 break;
             }
-            decodeStates = state0;  // Stay in state0; no signal.
+            dec->decodeState = state0;  // Stay in state0; no signal.
             break;                                                                                                 // End state0
         }
         case state1:{
             // Times a signal and measures its duration.  The next state determines if the signal is a dit or a dah.
             if (audioValue == 0) {
-                currentTime       = millis();
-                signalElapsedTime = currentTime - signalStart;     // Calculate the duration of the signal.
+                dec->currentTime       = sampleTime;
+                dec->signalElapsedTime = SamplesToMs(dec, dec->currentTime - dec->signalStart);     // Calculate the duration of the signal.
                 // Ignore short noisy signal bursts:
-                if (signalElapsedTime < LOWEST_ATOM_TIME) {        // A hiccup or a real signal?  Make this a fraction of ditLength instead???
-                    decodeStates    = state0;                      // False signal, start over.
+                if (dec->signalElapsedTime < LOWEST_ATOM_TIME) {   // A hiccup or a real signal?  Make this a fraction of ditLength instead???
+                    dec->decodeState = state0;                     // False signal, start over.
                     break;
                 }
-                if (signalElapsedTime > LOWEST_ATOM_TIME           // Valid elapsed time?
-                    && signalElapsedTime < HISTOGRAM_ELEMENTS
-                    && currentTime - oldTime > 5000L) {            // Only call histogram every 5 seconds
-                    DoSignalHistogram(signalElapsedTime);          // Yep
-                    oldTime = currentTime;                         // Reset old time
+                if (dec->signalElapsedTime > LOWEST_ATOM_TIME      // Valid elapsed time?
+                    && dec->signalElapsedTime < HISTOGRAM_ELEMENTS
+                    && SamplesToMs(dec, dec->currentTime - dec->histogramTime) > 5000L) {  // Only call histogram every 5 seconds
+                    DoSignalHistogram(dec, dec->signalElapsedTime);     // Yep
+                    dec->histogramTime = dec->currentTime;              // Reset old time
                 }
-                signalEnd         = currentTime;                   // Time gap to next signal.
-                decodeStates      = state2;                        // Proceed to state2.  A timed signal is available and must be processed.
+                dec->signalEnd   = dec->currentTime;                    // Time gap to next signal.
+                dec->decodeState = state2;                              // Proceed to state2.  A timed signal is available and must be processed.
                 break;
             }
-            decodeStates = state1;  // Signal still present, stay in state1.
+            dec->decodeState = state1;  // Signal still present, stay in state1.
             break;                  // End state1
         }
         case state2:{
             // Determine if a timed signal was a dit or a dah and increment the decode tree.
-            if (signalElapsedTime > (0.5 * ditLength)) {              // Use the geometric mean instead of ditLength???
-                currentDashJump = currentDashJump >> 1;                 // Fast divide by 2
-                if (signalElapsedTime < (int)thresholdGeometricMean) {  // It was a dit
-                    charProcessFlag = true;                               
-                    currentDecoderIndex++;
+            if (dec->signalElapsedTime > (0.5 * dec->ditLength)) {               // Use the geometric mean instead of ditLength???
+                dec->currentDashJump = dec->currentDashJump >> 1;                  // Fast divide by 2
+                if (dec->signalElapsedTime < (int)dec->thresholdGeometricMean) {   // It was a dit
+                    dec->charProcessFlag = true;
+                    dec->currentDecoderIndex++;
                 } else {  // It's a dah!
-                    charProcessFlag = true;
-                    currentDecoderIndex += currentDashJump;
+                    dec->charProcessFlag = true;
+                    dec->currentDecoderIndex += dec->currentDashJump;
                 }
             }
-            decodeStates = state0;  // Begin process again.
+            dec->decodeState = state0;  // Begin process again.
             break;                  // End state2
         }
         case state5:{
             // Display the character
-            MorseCharacterAdd(bigMorseCodeTree[currentDecoderIndex]);  // This always prints.  How do blanks get printed.
-            currentDecoderIndex = 0;                                       //Reset everything if char or word
-            currentDashJump     = DECODER_BUFFER_SIZE;
-            charProcessFlag     = false;  // Char printed and no longer in progress.
-            decodeStates        = state0;    // Start process for next incoming character.
-            blankFlag           = false;
+            decoded = bigMorseCodeTree[dec->currentDecoderIndex];  // This always prints.  How do blanks get printed.
+            dec->currentDecoderIndex = 0;                              //Reset everything if char or word
+            dec->currentDashJump     = DECODER_BUFFER_SIZE;
+            dec->charProcessFlag     = false;  // Char printed and no longer in progress.
+            dec->decodeState         = state0;    // Start process for next incoming character.
+            dec->blankFlag           = false;
             break;                                                    // End state5
         }
         case state6:{
             //  Blank printing state.
-            MorseCharacterAdd(' '); 
-            blankFlag = true;
-            decodeStates = state0;  // Start process for next incoming character.
+            decoded = ' ';
+            dec->blankFlag = true;
+            dec->decodeState = state0;  // Start process for next incoming character.
             break;
         }
         default:
         break;
     }
+    return decoded;
+}
+
+/**
+ * Step the receiver's decoder, add any character it decodes to the morse
+ * character buffer and update the decoded speed shown in ED.currentWPM
+ *
+ * @param audioValue        1 if the tone is present, 0 if not
+ * @param sampleTime        the sample clock at the end of the samples audioValue describes
+ */
+void DoCWDecoding(uint8_t audioValue, int64_t sampleTime) {
+    char decoded = CWDecoderStep(&cwDecoder, audioValue, sampleTime);
+    if (decoded != '\0') {
+        MorseCharacterAdd(decoded);
+    }
+    // Only the receiver's decoder reports its speed, the skimmer channels don't
+    ED.currentWPM = 1200 / cwDecoder.ditLength;
 }
 
 /**
@@ -328,13 +474,15 @@ void DoCWDecoding(uint8_t audioValue) {
  *    1. inter-atom time (one dit length)
  *    2. inter-character (three dit lengths)
  *    3. word end (seven dit lengths)
- * 
+ *
+ * @param dec the decoder
  * @param gapLen the duration of the signal gap (ms)
  */
-void DoGapHistogram(int64_t gapLen) {
+void DoGapHistogram(CWDecoder *dec, int64_t gapLen) {
     int32_t tempAtom, tempChar;
     int32_t atomIndex, charIndex, firstDit, temp;
     uint32_t offset;
+    int32_t *gapHistogram = dec->gapHistogram;
 
     if (gapHistogram[gapLen] > 10) {  // Need over 1 so we don't have fractional value
         for (int k = 0; k < HISTOGRAM_ELEMENTS; k++) {
@@ -343,48 +491,54 @@ void DoGapHistogram(int64_t gapLen) {
     }
     gapHistogram[gapLen]++;  // Add new signal to distribution
     atomIndex = charIndex = 0;
-    if (gapLen <= thresholdGeometricMean) {                                                                                 // Find new dit length
-        JackClusteredArrayMax(gapHistogram, (uint32_t)thresholdGeometricMean, &tempAtom, &atomIndex, &firstDit, (int32_t)1);  // Find max dit gap
+    if (gapLen <= dec->thresholdGeometricMean) {                                                                                 // Find new dit length
+        JackClusteredArrayMax(gapHistogram, (uint32_t)dec->thresholdGeometricMean, &tempAtom, &atomIndex, &firstDit, (int32_t)1);  // Find max dit gap
         if (atomIndex) {                                                                                                    // if something found
-            gapAtom = atomIndex;
+            dec->gapAtom = atomIndex;
         }
-        for (int j = 0; j < HISTOGRAM_ELEMENTS; j++) {                        // count down
-            if (gapHistogram[HISTOGRAM_ELEMENTS - j] > 0 && endGapFlag == 0) {  //Look for non-zero entries in the histogram
-                if (HISTOGRAM_ELEMENTS - j < gapAtom * 2) {                       // limit search to probable gapAtom entries
-                topGapIndex = HISTOGRAM_ELEMENTS - j;                           //Upper end of gapAtom range
-                endGapFlag = 1;                                                 // set flag so we know tha this is the top of the gapAtom range
+        for (int j = 1; j < HISTOGRAM_ELEMENTS; j++) {                        // count down
+            if (gapHistogram[HISTOGRAM_ELEMENTS - j] > 0 && dec->endGapFlag == 0) {  //Look for non-zero entries in the histogram
+                if (HISTOGRAM_ELEMENTS - j < dec->gapAtom * 2) {                       // limit search to probable gapAtom entries
+                dec->topGapIndex = HISTOGRAM_ELEMENTS - j;                      //Upper end of gapAtom range
+                dec->endGapFlag = 1;                                            // set flag so we know tha this is the top of the gapAtom range
                 }
             }
-            if (topGapIndex > 2 * gapAtom) topGapIndex = topGapIndexOld;  // discard outliers
+            if (dec->topGapIndex > 2 * dec->gapAtom) dec->topGapIndex = dec->topGapIndexOld;  // discard outliers
         }
-        endGapFlag = 0;                //reset flag
-        topGapIndexOld = topGapIndex;  //Keep good value for reference
+        dec->endGapFlag = 0;                     //reset flag
+        dec->topGapIndexOld = dec->topGapIndex;  //Keep good value for reference
     } else {                         // dah calculation
-        if (gapLen <= thresholdGeometricMean * 2) {
-        offset = (uint32_t)(thresholdGeometricMean * 2);  // Find number of elements to check
-        JackClusteredArrayMax(&gapHistogram[(int32_t)thresholdGeometricMean + 1], offset, &tempChar, &charIndex, &temp, (int32_t)3);
+        if (gapLen <= dec->thresholdGeometricMean * 2) {
+        offset = (uint32_t)(dec->thresholdGeometricMean * 2);  // Find number of elements to check
+        JackClusteredArrayMax(&gapHistogram[(int32_t)dec->thresholdGeometricMean + 1], offset, &tempChar, &charIndex, &temp, (int32_t)3);
         if (charIndex)  // if something found
-            gapChar = charIndex;
+            dec->gapChar = charIndex;
         }
     }
     if (atomIndex) {
-        gapAtom = atomIndex;
+        dec->gapAtom = atomIndex;
     }
     if (charIndex) {
-        gapChar = charIndex;
+        dec->gapChar = charIndex;
     }
 }
 
 
 /**
- * Establish the dit length for code transmission. Crucial since all spacing is 
- * done using dit length. Sets the value of the shared variable ditLength
- * 
+ * Establish the dit length for code transmission. Crucial since all spacing is
+ * done using dit length. Sets the decoder's ditLength, and starts the dah length
+ * and the dit/dah threshold at the same speed
+ *
+ * @param dec the decoder
  * @param wpm Words per minute
  */
-void SetDitLength(uint32_t wpm) {
-    ditLength = 1200 / wpm;
-    ED.currentWPM = 1200 / ditLength;
+void SetDitLength(CWDecoder *dec, uint32_t wpm) {
+    dec->ditLength = 1200 / wpm;
+    dec->dahLength = 3 * dec->ditLength;
+    // Start the dit/dah threshold and the averages at this speed too
+    dec->aveDitLength = dec->ditLength;
+    dec->aveDahLength = dec->dahLength;
+    dec->thresholdGeometricMean = sqrtf((float32_t)(dec->ditLength * dec->dahLength));
 }
 
 /**
@@ -392,7 +546,7 @@ void SetDitLength(uint32_t wpm) {
  * The histograms are "fuzzy" in the sense that dits and dahs "cluster" around a maximum value rather
  * than having a single max value. This algorithm looks at a given cell and the adds in the previous
  * (index - 1) and next (index + 1) cells to get the total for that index.
- * 
+ *
  * @param *array         the base address of the array to search
  * @param elements       the number of elements of the array to examine
  * @param *maxCount      the largest clustered value found
@@ -418,7 +572,7 @@ void JackClusteredArrayMax(int32_t *array, int32_t elements, int32_t *maxCount,
             ;  // Include adjacent elements
         }
 
-        if (temp >= clusteredMax) {
+        if ((temp > 0) && (temp >= clusteredMax)) {  // An empty histogram has no cluster
             clusteredMax = temp;
             clusteredIndex = i;
         }
@@ -434,61 +588,72 @@ void JackClusteredArrayMax(int32_t *array, int32_t elements, int32_t *maxCount,
  * milliseconds. The result is a bi-modal distribution around those two timings. The
  * modal value is then used for the timing of the decoder. The range should be between 20
  * (60wpm) and 240 (5wpm)
- * 
- * @param val        the strength of audio signal
- * 
+ *
+ * @param dec        the decoder
+ * @param val        the duration of the signal (ms)
+ *
  */
-void DoSignalHistogram(int64_t val) {
+void DoSignalHistogram(CWDecoder *dec, int64_t val) {
     float compareFactor = 2.0;
     int32_t firstNonEmpty;
     int32_t tempDit, tempDah;
+    int32_t ditIndex, dahIndex;
     int32_t offset;
+    int32_t *signalHistogram = dec->signalHistogram;
     //float32_t thresholdArithmeticMean;
 
-    if (valFlag == 0) {
-        valRef1 = signalElapsedTime;
-        signalStartOld = millis();
-        valFlag = 1;
+    if (dec->valFlag == 0) {
+        dec->valRef1 = dec->signalElapsedTime;
+        dec->signalStartOld = dec->currentTime;
+        dec->valFlag = 1;
     }
 
-    if (millis() - signalStartOld > LOWEST_ATOM_TIME && valFlag == 1) {
-        gapRef1 = gapLength;
-        valRef2 = signalElapsedTime;
-        valFlag = 0;
+    if (SamplesToMs(dec, dec->currentTime - dec->signalStartOld) > LOWEST_ATOM_TIME && dec->valFlag == 1) {
+        dec->gapRef1 = dec->gapLength;
+        dec->valRef2 = dec->signalElapsedTime;
+        dec->valFlag = 0;
     }
 
+    int64_t valRef1 = dec->valRef1;
+    int64_t valRef2 = dec->valRef2;
+    int64_t gapRef1 = dec->gapRef1;
     if ((valRef2 >= valRef1 * compareFactor && gapRef1 <= valRef1 * compareFactor)
         || (valRef1 >= valRef2 * compareFactor && gapRef1 <= valRef2 * compareFactor)) {
         // See if consecutive signal lengths in approximate dit to dah ratio and which one is larger
         if (valRef2 >= valRef1) {
-            aveDitLength = (long)(0.9 * aveDitLength + 0.1 * valRef1);  //Do some dit length averaging
-            aveDahLength = (long)(0.9 * aveDahLength + 0.1 * valRef2);
+            dec->aveDitLength = (long)(0.9 * dec->aveDitLength + 0.1 * valRef1);  //Do some dit length averaging
+            dec->aveDahLength = (long)(0.9 * dec->aveDahLength + 0.1 * valRef2);
         } else {
-            aveDitLength = (long)(0.9 * aveDitLength + 0.1 * valRef2);  // Use larger one. Note reversal of calc order
-            aveDahLength = (long)(0.9 * aveDahLength + 0.1 * valRef1);  // Do some dah length averaging
+            dec->aveDitLength = (long)(0.9 * dec->aveDitLength + 0.1 * valRef2);  // Use larger one. Note reversal of calc order
+            dec->aveDahLength = (long)(0.9 * dec->aveDahLength + 0.1 * valRef1);  // Do some dah length averaging
         }
     }
-    thresholdGeometricMean = sqrt(aveDitLength * aveDahLength);    //calculate geometric mean
+    dec->thresholdGeometricMean = sqrt(dec->aveDitLength * dec->aveDahLength);    //calculate geometric mean
     //thresholdArithmeticMean = (aveDitLength + aveDahLength) >> 1;  // Fast divide by 2 on integer data
 
     signalHistogram[val]++;  // Don't care which half it's in, just put it in
 
-    offset = (uint32_t)thresholdGeometricMean - 1;  // Only do cast once
+    offset = (uint32_t)dec->thresholdGeometricMean - 1;  // Only do cast once
     // Dit calculation
     // 2nd parameter means we only look for dits below the geomean.
 
-    for (int32_t j = (int32_t)thresholdGeometricMean; j; j--) {
+    for (int32_t j = (int32_t)dec->thresholdGeometricMean; j; j--) {
         if (signalHistogram[j] != 0) {
             firstNonEmpty = j;
             break;
         }
     }
 
-    JackClusteredArrayMax(signalHistogram, offset, &tempDit, (int32_t *)&ditLength, &firstNonEmpty, (int32_t)1);
+    JackClusteredArrayMax(signalHistogram, offset, &tempDit, &ditIndex, &firstNonEmpty, (int32_t)1);
+    if (ditIndex) {  // Keep the old length until a dit has been seen
+        dec->ditLength = ditIndex;
+    }
     // dah calculation
     // Elements above the geomean. Note larger spread: higher variance
-    JackClusteredArrayMax(&signalHistogram[offset], HISTOGRAM_ELEMENTS - offset, &tempDah, (int32_t *)&dahLength, &firstNonEmpty, (uint32_t)3);
-    dahLength += (uint32_t)offset;
+    JackClusteredArrayMax(&signalHistogram[offset], HISTOGRAM_ELEMENTS - offset, &tempDah, &dahIndex, &firstNonEmpty, (uint32_t)3);
+    if (dahIndex) {
+        dec->dahLength = dahIndex + (uint32_t)offset;
+    }
 
     if (tempDit > SCALE_CONSTANT && tempDah > SCALE_CONSTANT) {  //Adaptive dit signalHistogram[]
         for (int k = 0; k < HISTOGRAM_ELEMENTS; k++) {
@@ -498,27 +663,27 @@ void DoSignalHistogram(int64_t val) {
 }
 
 /**
- * Reset CW decoder histograms and timing parameters to defaults
+ * Reset a decoder's histograms and timing parameters to defaults
+ * @param dec The decoder
  *
  * Initializes decoder to 15 WPM starting values. Clears signal and gap histograms.
  * Called when decoder is reset or when tuning changes require reacquisition.
  * Sets ditLength=80ms, dahLength=240ms, and geometric mean threshold=160ms.
  */
-void ResetHistograms() {
-    gapAtom = 80;
-    ditLength = 80;  // Start with 15wpm ditLength
-    gapChar = 240;
-    dahLength = 240;
-    thresholdGeometricMean = 160;  // Use simple mean for starters so we don't have 0
-    aveDitLength = ditLength;
-    aveDahLength = dahLength;
-    valRef1 = 0;
-    valRef2 = 0;
+void ResetHistograms(CWDecoder *dec) {
+    dec->gapAtom = 80;
+    dec->ditLength = 80;  // Start with 15wpm ditLength
+    dec->gapChar = 240;
+    dec->dahLength = 240;
+    dec->thresholdGeometricMean = 160;  // Use simple mean for starters so we don't have 0
+    dec->aveDitLength = dec->ditLength;
+    dec->aveDahLength = dec->dahLength;
+    dec->valRef1 = 0;
+    dec->valRef2 = 0;
+    dec->histogramTime = dec->currentTime;
     // Clear graph arrays
-    memset(signalHistogram, 0, HISTOGRAM_ELEMENTS * sizeof(uint32_t));
-    memset(gapHistogram, 0, HISTOGRAM_ELEMENTS * sizeof(uint32_t));
-    ED.currentWPM = 1200 / ditLength;
-    //UpdateWPMField();
+    memset(dec->signalHistogram, 0, HISTOGRAM_ELEMENTS * sizeof(int32_t));
+    memset(dec->gapHistogram, 0, HISTOGRAM_ELEMENTS * sizeof(int32_t));
 }
 
 /**
@@ -21,25 +21,105 @@ If not, see <https://www.gnu.org/licenses/>.
 #include "SDT.h"
 
 #define DECODER_BUFFER_SIZE 128  // Max chars in binary search string with , . ?
-#define LOWEST_ATOM_TIME 20      // 60WPM has an atom of 20ms
+#define LOWEST_ATOM_TIME 10      // Shorter marks (ms) are noise. 60WPM has an atom of 20ms
 #define HISTOGRAM_ELEMENTS 750
 #define ADAPTIVE_SCALE_FACTOR 0.8                             // The amount of old histogram values are preserved
 #define SCALE_CONSTANT (1.0 / (1.0 - ADAPTIVE_SCALE_FACTOR))  // Insure array has enough observations to scale
+#define CW_DETECTOR_LENGTH 96     // Sliding DFT window: 4 ms, 250 Hz bins at 24 ksps
+#define CW_DETECTOR_BINS 3        // The CW tone and two noise reference bins
+#define CW_NOISE_BIN_OFFSET 2     // Noise bins sit this many bins either side of the tone
+#define CW_DETECTOR_DAMPING 0.9999
+#define CW_DETECT_SNR_DB 6.0      // Tone must be this far above the noise bins
+#define CW_DETECT_MIN_POWER 1e-4  // and above this squared amplitude (0.01 amplitude)
+#define CW_DECISION_SAMPLES 16    // Samples per mark/space decision, 0.67 ms at 24 ksps
+#define CW_MARK_ON_FRACTION 0.3   // Mark starts when the tone power rises above this fraction of its peak
+#define CW_MARK_OFF_FRACTION 0.2  // and ends when it falls below this fraction
+#define CW_PEAK_DECAY 0.9995      // Decay of the peak tone power per decision
+#define CW_LOCK_HOLD_S 2.0        // Lock is held this long after the last mark
+
+/**
+ * @brief Mark/space decision state for one keyed signal
+ */
+typedef struct {
+    float32_t peak;  // Decaying peak of the tone power
+    bool mark;       // The last decision
+} CWMarkDetector;
+
+/**
+ * @brief State of one Morse decoder
+ * @note The receiver decodes the tuned signal with one of these and the CW skimmer
+ *       runs one for every channel it follows. Times named *Time, signalStart,
+ *       signalEnd and signalStartOld are sample clock values, the rest are ms
+ */
+typedef struct {
+    float32_t sampleRate_Hz;           // Rate of the sample clock
+    enum MorseStates decodeState;
+    bool charProcessFlag;              // A character is being decoded
+    bool blankFlag;                    // A blank has already been printed
+    uint8_t currentDashJump;
+    uint8_t currentDecoderIndex;
+    int64_t currentTime, noSignalTimeStamp, histogramTime;
+    int64_t signalStart, signalEnd, signalStartOld;
+    int64_t interElementGap, gapLength, signalElapsedTime;
+    float32_t thresholdGeometricMean;  // This changes as decoder runs
+    uint64_t ditLength, dahLength;
+    int64_t aveDitLength, aveDahLength;
+    uint8_t valFlag;
+    int64_t valRef1, gapRef1, valRef2;
+    int32_t gapAtom, topGapIndex, topGapIndexOld, gapChar;
+    uint8_t endGapFlag;
+    int32_t signalHistogram[HISTOGRAM_ELEMENTS];
+    int32_t gapHistogram[HISTOGRAM_ELEMENTS];
+} CWDecoder;
 
 /**
  * @brief Initialize CW processing subsystem
  * @param wpm Words per minute for Morse code timing
  * @param RXfilters Pointer to receive filter configuration
- * @return Pointer to internal CW processing buffer
- * @note Sets up Goertzel tone detector, histogram analyzers, and Morse decoder
+ * @note Sets up the sliding DFT tone detector, histogram analyzers, and Morse decoder
  */
-float32_t * InitializeCWProcessing(uint32_t wpm, ReceiveFilterConfig *RXfilters);
+void InitializeCWProcessing(uint32_t wpm, ReceiveFilterConfig *RXfilters);
+
+/**
+ * @brief Tune the CW tone detector and clear its state
+ * @param tone_Hz CW tone frequency in the demodulated audio
+ * @param sampleRate_Hz Audio sampling rate in Hz
+ * @note Places one sliding DFT bin on the tone and two noise reference bins
+ *       CW_NOISE_BIN_OFFSET bins either side of it
+ */
+void InitializeCWToneDetector(float32_t tone_Hz, float32_t sampleRate_Hz);
+
+/**
+ * @brief Run the CW tone detector over a block of audio
+ * @param data Pointer to audio samples
+ * @param N Number of samples
+ * @param toneEnvelope Output: squared tone amplitude at every sample
+ * @param noiseEnvelope Output: mean squared amplitude of the noise bins at every sample
+ * @note Costs a few multiply-adds per sample, independent of CW_DETECTOR_LENGTH
+ */
+void CWToneDetect(const float32_t *data, uint32_t N, float32_t *toneEnvelope, float32_t *noiseEnvelope);
+
+/**
+ * @brief Get the SNR of the CW tone measured over the last processed block
+ * @return Tone power relative to the noise reference bins, in dB
+ */
+float32_t GetCWToneSNR_dB(void);
+
+/**
+ * @brief Decide whether a CW tone is keyed
+ * @param det Decision state for this signal
+ * @param tone Power of the tone averaged over a few samples
+ * @param noise Noise power in the same bandwidth
+ * @return 1 for a mark, 0 for a space
+ * @note Thresholds follow the peak tone power, with hysteresis
+ */
+uint8_t CWMarkDecision(CWMarkDetector *det, float32_t tone, float32_t noise);
 
 /**
  * @brief Process received CW signal to extract Morse code
  * @param data Pointer to DataBlock containing received audio
  * @param RXfilters Pointer to receive filter configuration
- * @note Applies CW audio filter and feeds samples to Morse decoder
+ * @note Applies CW audio filter, detects the tone and feeds the result to the Morse decoder
  */
 void DoCWReceiveProcessing(DataBlock *data, ReceiveFilterConfig *RXfilters);
 
@@ -55,28 +135,49 @@ void DoCWReceiveProcessing(DataBlock *data, ReceiveFilterConfig *RXfilters);
 float32_t goertzel_mag(uint32_t numSamples, int32_t TARGET_FREQUENCY, uint32_t SAMPLING_RATE, float32_t *data);
 
 /**
- * @brief Decode Morse code from audio envelope
+ * @brief Prepare a Morse decoder for a new signal
+ * @param dec The decoder
+ * @param wpm Words per minute for the initial timing
+ * @param sampleRate_Hz Rate of the sample clock the decoder will be stepped with
+ * @param sampleTime The sample clock now
+ */
+void InitializeCWDecoder(CWDecoder *dec, uint32_t wpm, float32_t sampleRate_Hz, int64_t sampleTime);
+
+/**
+ * @brief Step a Morse decoder with the next mark/space decision
+ * @param dec The decoder
  * @param audioValue Current audio envelope value (0=space, 1=mark)
+ * @param sampleTime Sample clock at the end of the samples audioValue describes
+ * @return The decoded character, a blank at the end of a word, or '\0'
  * @note Implements adaptive Morse decoder with automatic speed tracking
+ */
+char CWDecoderStep(CWDecoder *dec, uint8_t audioValue, int64_t sampleTime);
+
+/**
+ * @brief Decode Morse code from audio envelope with the receiver's decoder
+ * @param audioValue Current audio envelope value (0=space, 1=mark)
+ * @param sampleTime Number of audio samples processed so far, used to time marks and spaces
  * @note Updates internal Morse character buffer when characters decoded
  */
-void DoCWDecoding(uint8_t audioValue);
+void DoCWDecoding(uint8_t audioValue, int64_t sampleTime);
 
 /**
  * @brief Update histogram of gap (space) durations
+ * @param dec The decoder
  * @param gapLen Duration of space in milliseconds
  * @note Analyzes inter-element and inter-character spacing patterns
  * @note Used for adaptive dit/dah timing estimation
  */
-void DoGapHistogram(int64_t gapLen);
+void DoGapHistogram(CWDecoder *dec, int64_t gapLen);
 
 /**
  * @brief Set Morse code dit length based on WPM
+ * @param dec The decoder
  * @param wpm Words per minute (5-60 typical range)
  * @note Standard timing: 1 dit = 1200ms / WPM
  * @note Configures decoder timing for specified speed
  */
-void SetDitLength(uint32_t wpm);
+void SetDitLength(CWDecoder *dec, uint32_t wpm);
 
 /**
  * @brief Find maximum value in clustered histogram data
@@ -92,18 +193,20 @@ void JackClusteredArrayMax(int32_t *array, int32_t elements, int32_t *maxCount,
 
 /**
  * @brief Update histogram of signal (mark) durations
+ * @param dec The decoder
  * @param val Duration of mark in milliseconds
  * @note Analyzes dit and dah duration patterns
  * @note Used for adaptive dit/dah timing estimation
  */
-void DoSignalHistogram(int64_t val);
+void DoSignalHistogram(CWDecoder *dec, int64_t val);
 
 /**
  * @brief Reset all timing histograms
+ * @param dec The decoder
  * @note Clears signal and gap histograms for fresh decoder adaptation
  * @note Called when CW speed changes significantly
  */
-void ResetHistograms(void);
+void ResetHistograms(CWDecoder *dec);
 
 /**
  * @brief Apply narrow bandpass filter optimized for CW reception
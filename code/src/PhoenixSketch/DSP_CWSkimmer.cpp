@@ -0,0 +1,402 @@
+/*
+Copyright (C) 2026 T41 EP Software Contributors
+See Contributors.txt for list of known authors.
+
+This file is part of Phoenix.
+
+Phoenix is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Phoenix is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Phoenix.
+If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "DSP_CWSkimmer.h"
+
+#define CW_SKIMMER_TAPS (CW_SKIMMER_CHANNELS * CW_SKIMMER_TAPS_PER_CHANNEL)
+#define CW_SKIMMER_FRAMES (READ_BUFFER_SIZE / CW_SKIMMER_CHANNELS) // Channel samples per block
+
+/** One channel being decoded */
+typedef struct {
+    bool active;
+    uint32_t channel;
+    int64_t lastMarkTime;  // Skimmer clock
+    CWMarkDetector detector;
+    CWDecoder decoder;
+    char text[CW_SKIMMER_TEXT_LEN + 1];
+    uint8_t textLength;
+} SkimmerChannel;
+
+// Polyphase FFT filter bank. The history holds the last CW_SKIMMER_TAPS samples
+// of the previous block followed by the new block.
+static float32_t DMAMEM skimPrototype[CW_SKIMMER_TAPS];
+static float32_t DMAMEM skimHistoryI[CW_SKIMMER_TAPS + READ_BUFFER_SIZE];
+static float32_t DMAMEM skimHistoryQ[CW_SKIMMER_TAPS + READ_BUFFER_SIZE];
+static float32_t DMAMEM skimFFT[2*CW_SKIMMER_CHANNELS] __attribute__((aligned(4)));
+static float32_t DMAMEM skimFramePower[CW_SKIMMER_FRAMES][CW_SKIMMER_CHANNELS];
+static float32_t DMAMEM skimScratch[CW_SKIMMER_CHANNELS];
+static float32_t skimChannelPower[CW_SKIMMER_CHANNELS];  // Mean over the last block
+static float32_t skimChannelLevel[CW_SKIMMER_CHANNELS];  // Decaying peak of the block means
+static float32_t skimNoiseFloor;
+
+static SkimmerChannel DMAMEM skimChannels[CW_SKIMMER_DECODERS];
+static int8_t skimChannelDecoder[CW_SKIMMER_CHANNELS];   // Index into skimChannels, or -1
+
+static CWSkimmerSpot skimQueue[CW_SKIMMER_QUEUE_LEN];
+static uint32_t skimQueueHead = 0;
+static uint32_t skimQueueCount = 0;
+
+static bool skimEnabled = false;
+static int64_t skimClock = 0;            // Channel samples processed
+static uint32_t skimBlockTime_us = 0;
+static uint32_t skimOverruns = 0;
+static const float32_t skimSNRThreshold = powf(10.0, CW_SKIMMER_SNR_DB / 10.0);
+
+/**
+ * Clear the filter bank history, the channels and the spot queue
+ */
+static void ResetCWSkimmer(void){
+    for (size_t i = 0; i < CW_SKIMMER_TAPS + READ_BUFFER_SIZE; i++){
+        skimHistoryI[i] = 0;
+        skimHistoryQ[i] = 0;
+    }
+    for (size_t k = 0; k < CW_SKIMMER_CHANNELS; k++){
+        skimChannelPower[k] = 0;
+        skimChannelLevel[k] = 0;
+        skimChannelDecoder[k] = -1;
+    }
+    for (size_t d = 0; d < CW_SKIMMER_DECODERS; d++){
+        skimChannels[d].active = false;
+    }
+    skimNoiseFloor = 0;
+    skimQueueHead = 0;
+    skimQueueCount = 0;
+    skimBlockTime_us = 0;
+    skimOverruns = 0;
+}
+
+/**
+ * Design the prototype low pass filter of the filter bank and clear the skimmer.
+ *
+ * The prototype is a Hann windowed sinc with its cutoff at half the channel
+ * spacing, so neighbouring channels cross at -6 dB, scaled so that a tone at a
+ * channel centre comes out with its own amplitude.
+ */
+void InitializeCWSkimmer(void){
+    float32_t sum = 0;
+    float32_t centre = (CW_SKIMMER_TAPS - 1) / 2.0;
+    for (size_t m = 0; m < CW_SKIMMER_TAPS; m++){
+        float32_t x = ((float32_t)m - centre) / (float32_t)CW_SKIMMER_CHANNELS;
+        float32_t sinc = (fabsf(x) < 1e-6) ? 1.0 : sinf(PI * x) / (PI * x);
+        float32_t window = 0.5 - 0.5 * cosf(2.0 * PI * (float32_t)m / (float32_t)(CW_SKIMMER_TAPS - 1));
+        skimPrototype[m] = sinc * window;
+        sum += skimPrototype[m];
+    }
+    for (size_t m = 0; m < CW_SKIMMER_TAPS; m++){
+        skimPrototype[m] /= sum;
+    }
+    ResetCWSkimmer();
+}
+
+/**
+ * Turn the CW skimmer on or off. It starts afresh each time it is turned on.
+ * @param enable true to run the skimmer
+ */
+void EnableCWSkimmer(bool enable){
+    if (enable && !skimEnabled){
+        ResetCWSkimmer();
+    }
+    skimEnabled = enable;
+}
+
+/**
+ * Return true if the CW skimmer is running
+ */
+bool IsCWSkimmerEnabled(void){
+    return skimEnabled;
+}
+
+/**
+ * Return the centre of a channel relative to the centre of the IQ band
+ * @param channel Channel index
+ * @param sampleRate_Hz IQ sample rate
+ */
+int32_t GetCWSkimmerChannelOffset_Hz(uint32_t channel, uint32_t sampleRate_Hz){
+    int32_t k = (int32_t)channel;
+    if (k >= CW_SKIMMER_CHANNELS/2){
+        k -= CW_SKIMMER_CHANNELS;
+    }
+    return k * (int32_t)(sampleRate_Hz / CW_SKIMMER_CHANNELS);
+}
+
+/**
+ * Return the mean power of a channel over the last block
+ * @param channel Channel index
+ */
+float32_t GetCWSkimmerChannelPower(uint32_t channel){
+    return skimChannelPower[channel % CW_SKIMMER_CHANNELS];
+}
+
+/**
+ * Return the number of channels being decoded
+ */
+uint32_t GetCWSkimmerActiveChannels(void){
+    uint32_t n = 0;
+    for (size_t d = 0; d < CW_SKIMMER_DECODERS; d++){
+        if (skimChannels[d].active) n++;
+    }
+    return n;
+}
+
+/**
+ * Return the duration of the last DoCWSkimmerProcessing() call in microseconds
+ */
+uint32_t GetCWSkimmerBlockTime_us(void){
+    return skimBlockTime_us;
+}
+
+/**
+ * Return the number of blocks that took longer than CW_SKIMMER_BUDGET_US
+ */
+uint32_t GetCWSkimmerOverruns(void){
+    return skimOverruns;
+}
+
+/**
+ * Take the oldest spot off the queue
+ * @param spot Receives the spot
+ * @return true if there was a spot
+ */
+bool GetCWSkimmerSpot(CWSkimmerSpot *spot){
+    if (skimQueueCount == 0){
+        return false;
+    }
+    *spot = skimQueue[skimQueueHead];
+    skimQueueHead = (skimQueueHead + 1) % CW_SKIMMER_QUEUE_LEN;
+    skimQueueCount--;
+    return true;
+}
+
+/**
+ * Queue the word a channel has decoded so far and start a new one. When the
+ * queue is full the oldest spot is dropped.
+ * @param sc The channel
+ * @param sampleRate_Hz IQ sample rate
+ */
+static void PushCWSkimmerSpot(SkimmerChannel *sc, uint32_t sampleRate_Hz){
+    if (sc->textLength == 0){
+        return;
+    }
+    if (skimQueueCount == CW_SKIMMER_QUEUE_LEN){
+        skimQueueHead = (skimQueueHead + 1) % CW_SKIMMER_QUEUE_LEN;
+        skimQueueCount--;
+    }
+    CWSkimmerSpot *spot = &skimQueue[(skimQueueHead + skimQueueCount) % CW_SKIMMER_QUEUE_LEN];
+    skimQueueCount++;
+    spot->offset_Hz = GetCWSkimmerChannelOffset_Hz(sc->channel, sampleRate_Hz);
+    spot->frequency_Hz = ED.centerFreq_Hz[ED.activeVFO] + spot->offset_Hz;
+    spot->snr_dB = 10.0 * log10f_fast((skimChannelLevel[sc->channel] + 1e-20) / (skimNoiseFloor + 1e-20));
+    memcpy(spot->text, sc->text, sc->textLength);
+    spot->text[sc->textLength] = '\0';
+    sc->textLength = 0;
+}
+
+/**
+ * Find the median of an array by partial sorting. The array is reordered.
+ * @param x The array
+ * @param n Number of elements
+ * @return The median
+ */
+static float32_t MedianOf(float32_t *x, uint32_t n){
+    int32_t k = n / 2;
+    int32_t lo = 0;
+    int32_t hi = n - 1;
+    while (lo < hi){
+        float32_t pivot = x[(lo + hi) / 2];
+        int32_t i = lo;
+        int32_t j = hi;
+        while (i <= j){
+            while (x[i] < pivot) i++;
+            while (x[j] > pivot) j--;
+            if (i <= j){
+                float32_t tmp = x[i];
+                x[i] = x[j];
+                x[j] = tmp;
+                i++;
+                j--;
+            }
+        }
+        if (k <= j){
+            hi = j;
+        } else if (k >= i){
+            lo = i;
+        } else {
+            break;
+        }
+    }
+    return x[k];
+}
+
+/**
+ * Split the new block into CW_SKIMMER_FRAMES samples of every channel and store
+ * their powers in skimFramePower. Each frame is the weighted overlap-add form of
+ * the polyphase filter bank: the last CW_SKIMMER_TAPS samples are windowed by the
+ * prototype filter and folded into CW_SKIMMER_CHANNELS points, and one FFT of
+ * those gives every channel at once. Channel k, at k*fs/CW_SKIMMER_CHANNELS,
+ * comes out in FFT bin -k.
+ * @param data The block
+ */
+static void Channelize(DataBlock *data){
+    memcpy(&skimHistoryI[CW_SKIMMER_TAPS], data->I, READ_BUFFER_SIZE * sizeof(float32_t));
+    memcpy(&skimHistoryQ[CW_SKIMMER_TAPS], data->Q, READ_BUFFER_SIZE * sizeof(float32_t));
+    for (size_t k = 0; k < CW_SKIMMER_CHANNELS; k++){
+        skimChannelPower[k] = 0;
+    }
+    for (size_t f = 0; f < CW_SKIMMER_FRAMES; f++){
+        // Newest sample of this frame
+        const float32_t *xI = &skimHistoryI[CW_SKIMMER_TAPS - 1 + (f + 1) * CW_SKIMMER_CHANNELS];
+        const float32_t *xQ = &skimHistoryQ[CW_SKIMMER_TAPS - 1 + (f + 1) * CW_SKIMMER_CHANNELS];
+        for (size_t p = 0; p < CW_SKIMMER_CHANNELS; p++){
+            float32_t accI = 0;
+            float32_t accQ = 0;
+            for (size_t t = 0; t < CW_SKIMMER_TAPS; t += CW_SKIMMER_CHANNELS){
+                float32_t h = skimPrototype[p + t];
+                accI += h * *(xI - p - t);
+                accQ += h * *(xQ - p - t);
+            }
+            skimFFT[2*p] = accI;
+            skimFFT[2*p + 1] = accQ;
+        }
+        FFT256Forward(skimFFT);
+        float32_t *power = skimFramePower[f];
+        for (size_t k = 0; k < CW_SKIMMER_CHANNELS; k++){
+            size_t j = (CW_SKIMMER_CHANNELS - k) & (CW_SKIMMER_CHANNELS - 1);
+            power[k] = skimFFT[2*j] * skimFFT[2*j] + skimFFT[2*j + 1] * skimFFT[2*j + 1];
+            skimChannelPower[k] += power[k];
+        }
+    }
+    for (size_t k = 0; k < CW_SKIMMER_CHANNELS; k++){
+        skimChannelPower[k] /= (float32_t)CW_SKIMMER_FRAMES;
+    }
+    memmove(skimHistoryI, &skimHistoryI[READ_BUFFER_SIZE], CW_SKIMMER_TAPS * sizeof(float32_t));
+    memmove(skimHistoryQ, &skimHistoryQ[READ_BUFFER_SIZE], CW_SKIMMER_TAPS * sizeof(float32_t));
+}
+
+/**
+ * Run a channel's detector and decoder over the frames of the last block and
+ * queue each word it completes. The channel is freed once it has been quiet for
+ * CW_SKIMMER_RELEASE_S.
+ * @param sc The channel
+ * @param sampleRate_Hz IQ sample rate
+ */
+static void DecodeCWSkimmerChannel(SkimmerChannel *sc, uint32_t sampleRate_Hz){
+    int64_t clock = skimClock;
+    for (size_t f = 0; f < CW_SKIMMER_FRAMES; f++){
+        clock++;
+        // The noise floor is the noise power in one channel
+        uint8_t mark = CWMarkDecision(&sc->detector, skimFramePower[f][sc->channel] / skimNoiseFloor, 1.0);
+        if (mark){
+            sc->lastMarkTime = clock;
+        }
+        char c = CWDecoderStep(&sc->decoder, mark, clock);
+        if (c == ' '){
+            PushCWSkimmerSpot(sc, sampleRate_Hz);
+        } else if (c != '\0'){
+            if (sc->textLength == CW_SKIMMER_TEXT_LEN){
+                PushCWSkimmerSpot(sc, sampleRate_Hz);
+            }
+            sc->text[sc->textLength++] = c;
+        }
+    }
+    float32_t channelRate_Hz = (float32_t)sampleRate_Hz / CW_SKIMMER_CHANNELS;
+    if (clock - sc->lastMarkTime > (int64_t)(CW_SKIMMER_RELEASE_S * channelRate_Hz)){
+        PushCWSkimmerSpot(sc, sampleRate_Hz);
+        sc->active = false;
+        skimChannelDecoder[sc->channel] = -1;
+    }
+}
+
+/**
+ * Start decoding a channel if a decoder is free
+ * @param channel The channel
+ * @param sampleRate_Hz IQ sample rate
+ */
+static void StartCWSkimmerChannel(uint32_t channel, uint32_t sampleRate_Hz){
+    for (size_t d = 0; d < CW_SKIMMER_DECODERS; d++){
+        SkimmerChannel *sc = &skimChannels[d];
+        if (sc->active) continue;
+        sc->active = true;
+        sc->channel = channel;
+        sc->lastMarkTime = skimClock;
+        sc->detector.peak = 0;
+        sc->detector.mark = false;
+        sc->textLength = 0;
+        InitializeCWDecoder(&sc->decoder, CW_SKIMMER_WPM,
+                            (float32_t)sampleRate_Hz / CW_SKIMMER_CHANNELS, skimClock);
+        skimChannelDecoder[channel] = d;
+        return;
+    }
+}
+
+/**
+ * Run the CW skimmer over a block of IQ samples.
+ * @param data READ_BUFFER_SIZE IQ samples after IQ correction. Not modified
+ *
+ * The block is split into CW_SKIMMER_CHANNELS channels. The noise floor is the
+ * median channel power, since only a few channels hold signals. A channel is
+ * decoded when its level is CW_SKIMMER_SNR_DB above the floor and above its
+ * neighbours, so a signal between two channels is only decoded once. A new
+ * channel is decoded from the start of the block that raised it, so the first
+ * mark is not cut short. DC (the LO) and the band edge are never decoded. No new channels are started while the
+ * blocks are over CW_SKIMMER_BUDGET_US; the filter bank itself has a fixed cost.
+ */
+void DoCWSkimmerProcessing(DataBlock *data){
+    if (data->N != READ_BUFFER_SIZE){
+        return;
+    }
+    uint32_t start_us = micros();
+    uint32_t sampleRate_Hz = data->sampleRate_Hz;
+
+    Channelize(data);
+    arm_copy_f32(skimChannelPower, skimScratch, CW_SKIMMER_CHANNELS);
+    skimNoiseFloor = MedianOf(skimScratch, CW_SKIMMER_CHANNELS) + 1e-20;
+    for (size_t k = 0; k < CW_SKIMMER_CHANNELS; k++){
+        skimChannelLevel[k] *= CW_SKIMMER_LEVEL_DECAY;
+        if (skimChannelPower[k] > skimChannelLevel[k]){
+            skimChannelLevel[k] = skimChannelPower[k];
+        }
+    }
+
+    if (skimBlockTime_us <= CW_SKIMMER_BUDGET_US){
+        for (uint32_t k = 1; k < CW_SKIMMER_CHANNELS; k++){
+            if (k == CW_SKIMMER_CHANNELS/2) continue;
+            uint32_t below = (k - 1) & (CW_SKIMMER_CHANNELS - 1);
+            uint32_t above = (k + 1) & (CW_SKIMMER_CHANNELS - 1);
+            if ((skimChannelLevel[k] > skimSNRThreshold * skimNoiseFloor)
+                && (skimChannelLevel[k] >= skimChannelLevel[below])
+                && (skimChannelLevel[k] > skimChannelLevel[above])
+                && (skimChannelDecoder[below] < 0)
+                && (skimChannelDecoder[k] < 0)
+                && (skimChannelDecoder[above] < 0)){
+                StartCWSkimmerChannel(k, sampleRate_Hz);
+            }
+        }
+    }
+
+    for (size_t d = 0; d < CW_SKIMMER_DECODERS; d++){
+        if (skimChannels[d].active){
+            DecodeCWSkimmerChannel(&skimChannels[d], sampleRate_Hz);
+        }
+    }
+    skimClock += CW_SKIMMER_FRAMES;
+
+    skimBlockTime_us = micros() - start_us;
+    if (skimBlockTime_us > CW_SKIMMER_BUDGET_US){
+        skimOverruns++;
+    }
+}
@@ -0,0 +1,112 @@
+/*
+Copyright (C) 2026 T41 EP Software Contributors
+See Contributors.txt for list of known authors.
+
+This file is part of Phoenix.
+
+Phoenix is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Phoenix is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Phoenix.
+If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DSP_CWSKIMMER_H
+#define DSP_CWSKIMMER_H
+#include "SDT.h"
+
+#define CW_SKIMMER_CHANNELS 256         // Filter bank channels, 750 Hz apart at 192 ksps
+#define CW_SKIMMER_TAPS_PER_CHANNEL 8   // The prototype filter has CHANNELS * TAPS_PER_CHANNEL taps
+#define CW_SKIMMER_DECODERS 8           // Most channels decoded at once
+#define CW_SKIMMER_SNR_DB 10.0          // Channel must be this far above the noise floor to be decoded
+#define CW_SKIMMER_LEVEL_DECAY 0.9      // Decay of a channel's level per block
+#define CW_SKIMMER_RELEASE_S 5.0        // A decoder is freed after its channel has been quiet this long
+#define CW_SKIMMER_WPM 20               // Starting speed of a new decoder
+#define CW_SKIMMER_TEXT_LEN 15          // Longest word in a spot
+#define CW_SKIMMER_QUEUE_LEN 16         // Spots waiting to be read
+#define CW_SKIMMER_BUDGET_US 1500       // No new channels are decoded while a block takes longer
+
+/**
+ * @brief A word decoded by the CW skimmer
+ */
+typedef struct {
+    int64_t frequency_Hz;  // RF frequency of the channel centre
+    int32_t offset_Hz;     // Channel centre relative to the centre of the IQ band
+    float32_t snr_dB;      // Channel level above the noise floor when the word ended
+    char text[CW_SKIMMER_TEXT_LEN + 1];
+} CWSkimmerSpot;
+
+/**
+ * @brief Design the skimmer's filter bank and clear its channels and spot queue
+ * @note Called by InitializeSignalProcessing()
+ */
+void InitializeCWSkimmer(void);
+
+/**
+ * @brief Turn the CW skimmer on or off
+ * @param enable true to decode every CW signal in the IQ band
+ * @note Turning the skimmer on clears its state
+ */
+void EnableCWSkimmer(bool enable);
+
+/**
+ * @brief Check whether the CW skimmer is running
+ * @return true if ReceiveProcessing() feeds the skimmer
+ */
+bool IsCWSkimmerEnabled(void);
+
+/**
+ * @brief Run the CW skimmer over a block of IQ samples
+ * @param data Pointer to READ_BUFFER_SIZE IQ samples at 192 ksps, after IQ correction. Not modified
+ * @note Splits the band into CW_SKIMMER_CHANNELS channels with a polyphase FFT filter
+ *       bank and decodes up to CW_SKIMMER_DECODERS channels that stand out from the
+ *       noise floor. Completed words are queued as spots
+ */
+void DoCWSkimmerProcessing(DataBlock *data);
+
+/**
+ * @brief Take the oldest spot off the skimmer's queue
+ * @param spot Receives the spot
+ * @return true if there was a spot, false if the queue is empty
+ */
+bool GetCWSkimmerSpot(CWSkimmerSpot *spot);
+
+/**
+ * @brief Get the frequency of a filter bank channel
+ * @param channel Channel index, 0 to CW_SKIMMER_CHANNELS-1
+ * @param sampleRate_Hz IQ sample rate
+ * @return Channel centre relative to the centre of the IQ band, in Hz
+ */
+int32_t GetCWSkimmerChannelOffset_Hz(uint32_t channel, uint32_t sampleRate_Hz);
+
+/**
+ * @brief Get the mean power of a channel over the last block
+ * @param channel Channel index, 0 to CW_SKIMMER_CHANNELS-1
+ * @return Power, scaled so that a tone of amplitude A at the channel centre reads A*A
+ */
+float32_t GetCWSkimmerChannelPower(uint32_t channel);
+
+/**
+ * @brief Get the number of channels being decoded
+ * @return 0 to CW_SKIMMER_DECODERS
+ */
+uint32_t GetCWSkimmerActiveChannels(void);
+
+/**
+ * @brief Get the time the last block took
+ * @return Duration of the last DoCWSkimmerProcessing() call in microseconds
+ */
+uint32_t GetCWSkimmerBlockTime_us(void);
+
+/**
+ * @brief Get the number of blocks that went over CW_SKIMMER_BUDGET_US
+ * @return Count since the skimmer was turned on
+ */
+uint32_t GetCWSkimmerOverruns(void);
+
+#endif // DSP_CWSKIMMER_H
@@ -17,18 +17,25 @@ If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include "DSP_FFT.h"
+#include <atomic>
+#include <cfloat>
 
-float32_t DMAMEM buffer_spec_FFT[2*SPECTRUM_RES] __attribute__((aligned(4))); /** Used by multiple functions */
+float32_t DMAMEM buffer_spec_FFT[2*SPECTRUM_FFT_MAX] __attribute__((aligned(4))); /** Used by multiple functions */
 float32_t DMAMEM iFFT_buffer[2*SPECTRUM_RES] __attribute__((aligned(4)));
-float32_t DMAMEM FFT_spec[SPECTRUM_RES];
-float32_t DMAMEM FFT_spec_old[SPECTRUM_RES];
-
-float32_t DMAMEM FIR_filter_mask[FFT_LENGTH * 2] __attribute__((aligned(4)));
+float32_t DMAMEM FFT_spec[SPECTRUM_FFT_MAX];
+float32_t DMAMEM FFT_spec_old[SPECTRUM_FFT_MAX];
+
+// The convolution filter masks. FIR_filter_mask is the one in use; a new mask is
+// prepared in the other buffer and swapped in at the start of a block.
+static float32_t DMAMEM filterMaskBank[2][FFT_LENGTH * 2] __attribute__((aligned(4)));
+float32_t *FIR_filter_mask = filterMaskBank[0];
+static float32_t *nextFilterMask = filterMaskBank[1];
+static float32_t DMAMEM crossfadeBuffer[FFT_LENGTH * 2] __attribute__((aligned(4)));
 static float32_t DMAMEM last_sample_buffer_L[FFT_LENGTH];
 static float32_t DMAMEM last_sample_buffer_R[FFT_LENGTH];
 // Defined as static because we want their values to persist between calls
-static float32_t DMAMEM FFT_ring_buffer_x[SPECTRUM_RES];
-static float32_t DMAMEM FFT_ring_buffer_y[SPECTRUM_RES];
+static float32_t DMAMEM FFT_ring_buffer_x[SPECTRUM_FFT_MAX];
+static float32_t DMAMEM FFT_ring_buffer_y[SPECTRUM_FFT_MAX];
 // Note: zoom_sample_ptr moved to ReceiveFilterConfig struct so each filter has its own pointer
 static uint32_t iFSF;
 static float32_t audioPowerMax;
@@ -83,69 +90,519 @@ float32_t log10f_fast(float32_t X) {
 }
 
 /**
- * Zero the arrays used by the PSD calculations 
+ * Fast log10 of a block of values, using the same approximation as log10f_fast().
+ * The exponent and mantissa are extracted with integer operations instead of a
+ * call to frexpf(), so the loop has no calls or branches and the compiler can
+ * unroll and pipeline it.
+ * 
+ * The input values must not be negative. Inputs below FLT_MIN, including zero and
+ * denormals, are clamped to FLT_MIN and give log10f_fast(FLT_MIN), about -37.9,
+ * rather than -inf. This is the floor of an empty PSD bin.
+ * 
+ * @param pSrc Pointer to the input values
+ * @param pDst Pointer to the output array, can be the same as pSrc
+ * @param blockSize Number of values
+ */
+void log10f_fast_f32(const float32_t *pSrc, float32_t *pDst, uint32_t blockSize){
+    for (size_t i = 0; i < blockSize; i++){
+        union { float32_t f; uint32_t u; } x;
+        x.f = fmaxf(pSrc[i], FLT_MIN);
+        // X = F * 2^E with F in [0.5, 1), as returned by frexpf
+        float32_t E = (float32_t)((int32_t)((x.u >> 23) & 0xFF) - 126);
+        x.u = (x.u & 0x007FFFFF) | 0x3F000000;
+        float32_t F = x.f;
+        float32_t Y = ((1.23149591368684f * F - 4.11852516267426f) * F + 6.02197014179219f) * F
+                        - 3.13396450166353f + E;
+        pDst[i] = Y * 0.3010299956639812f;
+    }
+}
+
+/**
+ * A 256-point real frame is transformed as 128 complex samples z[n] = x[2n] + j x[2n+1]
+ * with a 128-point complex FFT. The spectrum Z is then split into the spectra of
+ * the even and odd samples,
+ *   Xe[k] = (Z[k] + conj(Z[128-k]))/2,  Xo[k] = (Z[k] - conj(Z[128-k]))/2j
+ * and recombined as X[k] = Xe[k] + W^k Xo[k] with W = exp(-j 2 pi / 256). This is
+ * what arm_rfft_fast_f32 does internally, and the output uses the same packing.
+ * Only the complex FFT is stubbed, so the split and merge steps that define the
+ * packing run unchanged in the unit tests.
+ */
+static float32_t rfftTwiddle[2*128]; // W^k, k = 0..127
+static bool rfftTwiddleBuilt = false;
+
+static void BuildRealFFT256Twiddle(void){
+    if (rfftTwiddleBuilt) return;
+    for (uint32_t k = 0; k < 128; k++){
+        rfftTwiddle[2*k]     = (float32_t)cos(2.0 * PI * k / 256.0);
+        rfftTwiddle[2*k + 1] = (float32_t)-sin(2.0 * PI * k / 256.0);
+    }
+    rfftTwiddleBuilt = true;
+}
+
+void RealFFT256Forward(float32_t *in, float32_t *out){
+    BuildRealFFT256Twiddle();
+    FFT128Forward(in);
+    out[0] = in[0] + in[1];   // X0
+    out[1] = in[0] - in[1];   // X128
+    for (uint32_t k = 1; k < 128; k++){
+        float32_t zr = in[2*k],         zi = in[2*k + 1];
+        float32_t cr = in[2*(128-k)],   ci = -in[2*(128-k) + 1]; // conj(Z[128-k])
+        float32_t er = 0.5f*(zr + cr),  ei = 0.5f*(zi + ci);     // Xe[k]
+        float32_t orr = 0.5f*(zi - ci), oi = -0.5f*(zr - cr);    // Xo[k]
+        float32_t wr = rfftTwiddle[2*k], wi = rfftTwiddle[2*k + 1];
+        out[2*k]     = er + wr*orr - wi*oi;
+        out[2*k + 1] = ei + wr*oi + wi*orr;
+    }
+}
+
+void RealFFT256Reverse(float32_t *in, float32_t *out){
+    BuildRealFFT256Twiddle();
+    // Rebuild Z = Xe + j Xo from the half spectrum, then invert the complex FFT
+    out[0] = 0.5f*(in[0] + in[1]);
+    out[1] = 0.5f*(in[0] - in[1]);
+    for (uint32_t k = 1; k < 128; k++){
+        float32_t xr = in[2*k],         xi = in[2*k + 1];
+        float32_t cr = in[2*(128-k)],   ci = -in[2*(128-k) + 1]; // conj(X[128-k])
+        float32_t er = 0.5f*(xr + cr),  ei = 0.5f*(xi + ci);
+        float32_t dr = 0.5f*(xr - cr),  di = 0.5f*(xi - ci);
+        float32_t wr = rfftTwiddle[2*k], wi = -rfftTwiddle[2*k + 1]; // W^-k
+        float32_t orr = dr*wr - di*wi,  oi = dr*wi + di*wr;
+        out[2*k]     = er - oi;
+        out[2*k + 1] = ei + orr;
+    }
+    FFT128Reverse(out);
+}
+
+// Window tables, built on first use by GetWindowTable()
+static float32_t DMAMEM windowTable256[WindowTypeCount][SPECTRUM_RES/2];
+static float32_t DMAMEM windowTable512[WindowTypeCount][SPECTRUM_RES];
+static bool windowBuilt256[WindowTypeCount] = {false};
+static bool windowBuilt512[WindowTypeCount] = {false};
+static WindowType psdWindow = WindowHann;
+
+// Panadapter spectrum engine
+static float32_t DMAMEM spectrumWindow[SPECTRUM_FFT_MAX]; // window for FFTs larger than SPECTRUM_RES
+static WindowType spectrumWindowType = WindowTypeCount;
+static uint32_t spectrumWindowSize = 0;
+static uint32_t spectrumFFTSize = SPECTRUM_RES;
+static SpectrumAveraging spectrumAveraging = SpectrumAvgExponential;
+static uint32_t spectrumAverageFrames = 0;
+static float32_t spectrumAlpha = 0.7;        // weight of a new frame in the exponential average
+static uint32_t spectrumFramesAveraged = 0;  // frames in the current linear or peak-hold average
+static uint32_t spectrumFrameCount = 0;
+
+// Triple buffer between the DSP and the display. The DSP fills psdFrames[psdBack] and the
+// display reads psdFrames[psdFront]. The third frame is swapped between them through
+// psdMiddle, whose PSD_FRAME_FRESH bit says it holds a frame the display has not seen yet.
+#define PSD_FRAME_INDEX 0x3
+#define PSD_FRAME_FRESH 0x4
+static PSDFrame DMAMEM psdFrames[3];
+static std::atomic<uint32_t> psdMiddle(1);
+static uint32_t psdBack = 0;      // only used by the DSP
+static uint32_t psdFront = 2;     // only used by the display
+static uint32_t psdSequence = 0;  // only used by the DSP
+
+// Cosine series coefficients a0, a1, ... of each window:
+//   w[i] = a0 - a1*cos(2*pi*i/N) + a2*cos(4*pi*i/N) - a3*cos(6*pi*i/N) + a4*cos(8*pi*i/N)
+static const double windowCoeffs[WindowTypeCount][5] = {
+    {0.5, 0.5, 0.0, 0.0, 0.0},                                  // Hann
+    {0.35875, 0.48829, 0.14128, 0.01168, 0.0},                  // 4-term Blackman-Harris
+    {0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368}, // flat-top
+};
+
+/**
+ * Fill a table with N points of a periodic window, scaled so that its coherent
+ * gain (the mean of the coefficients, a0) matches that of the Hann window.
+ * 
+ * @param table Pointer to the array of N coefficients to fill
+ * @param type The window function
+ * @param N Number of points
+ */
+static void BuildWindowTable(float32_t *table, WindowType type, uint32_t N){
+    const double *a = windowCoeffs[type];
+    double scale = windowCoeffs[WindowHann][0] / a[0];
+    for (size_t i = 0; i < N; i++){
+        double w = 0.0;
+        double sign = 1.0;
+        for (size_t k = 0; k < 5; k++){
+            w += sign * a[k] * cos(TWO_PI * (double)(k * i) / (double)N);
+            sign = -sign;
+        }
+        table[i] = (float32_t)(scale * w);
+    }
+}
+
+/**
+ * Get a table of window coefficients. The table is calculated the first time it
+ * is requested, so the PSD and noise reduction paths don't evaluate any trig
+ * functions per block.
+ * 
+ * @param type The window function
+ * @param N Number of points, 256 or 512
+ * @return Pointer to the N coefficients, NULL if the size or type is not supported
+ */
+const float32_t * GetWindowTable(WindowType type, uint32_t N){
+    if (type >= WindowTypeCount) return NULL;
+    switch (N){
+        case SPECTRUM_RES/2:
+            if (!windowBuilt256[type]){
+                BuildWindowTable(windowTable256[type], type, N);
+                windowBuilt256[type] = true;
+            }
+            return windowTable256[type];
+        case SPECTRUM_RES:
+            if (!windowBuilt512[type]){
+                BuildWindowTable(windowTable512[type], type, N);
+                windowBuilt512[type] = true;
+            }
+            return windowTable512[type];
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * Select the window function used by the PSD calculations
+ * @param type The window function
+ */
+void SetPSDWindow(WindowType type){
+    if (type < WindowTypeCount) psdWindow = type;
+}
+
+/**
+ * Get the window function used by the PSD calculations
+ * @return The window function
+ */
+WindowType GetPSDWindow(void){
+    return psdWindow;
+}
+
+/**
+ * Zero the arrays used by the PSD calculations. The arrays are in DMAMEM, which
+ * is not cleared at power up on the Teensy, so this must be called before the
+ * first PSD is calculated or the smoothing in AverageSpectrum() will carry NaNs.
  */
 void ResetPSD(void){
-    for (size_t x = 0; x < SPECTRUM_RES; x++) {
+    for (size_t x = 0; x < SPECTRUM_FFT_MAX; x++) {
         FFT_spec[x] = 0;
         FFT_spec_old[x] = 0;
+    }
+    for (size_t x = 0; x < SPECTRUM_RES; x++) {
         psdnew[x] = 0;
     }
+    spectrumFramesAveraged = 0;
+    spectrumFrameCount = 0;
 }
 
 /**
- * Calculate a 512-point power spectrum from the complex data stored in real 
- * and imag arrays. A Hanning window is applied to the data. The result is
- * written into the global array psdnew. The value of the data in the psd buffers
- * is log10( I*I + Q*Q ). So the units are log10(V^2 / Hz).
+ * Select the number of points in the panadapter FFT. With 512 points the
+ * panadapter works as it always has: one frame from the first 512 (decimated)
+ * samples available. 1024 and 2048 points use every sample in frames that
+ * overlap by 50% (Welch's method), which gives finer resolution and, with
+ * averaging, a steadier noise floor. The ring buffers of each filter config
+ * restart on their next call to ZoomFFTExe().
  * 
- * Note that this function requires that there are at least 512 samples in the
- * arrays being passed
+ * @param N Number of points: 512, 1024 or 2048
+ * @return ESUCCESS, or EFAIL if N is not supported
+ */
+errno_t SetSpectrumFFTSize(uint32_t N){
+    if ((N != SPECTRUM_RES) && (N != 2*SPECTRUM_RES) && (N != SPECTRUM_FFT_MAX)){
+        return EFAIL;
+    }
+    if (N != spectrumFFTSize){
+        spectrumFFTSize = N;
+        for (size_t x = 0; x < SPECTRUM_FFT_MAX; x++) {
+            FFT_spec_old[x] = 0;
+        }
+        spectrumFramesAveraged = 0;
+    }
+    return ESUCCESS;
+}
+
+/**
+ * Get the number of points in the panadapter FFT
+ * @return 512, 1024 or 2048
+ */
+uint32_t GetSpectrumFFTSize(void){
+    return spectrumFFTSize;
+}
+
+/**
+ * Select how successive FFT frames are combined into the displayed spectrum.
+ * 
+ * | Mode        | nFrames                               | psdnew updated       |
+ * |-------------|---------------------------------------|----------------------|
+ * | Exponential | span, weight = 2/(nFrames+1); 0 = 0.7 | every frame          |
+ * | Linear      | frames in each mean                   | every nFrames frames |
+ * | Peak hold   | frames a peak is held, 0 = forever    | every frame          |
+ * 
+ * @param mode The averaging mode
+ * @param nFrames See the table above
+ * @return ESUCCESS, or EFAIL if mode is not supported
+ */
+errno_t SetSpectrumAveraging(SpectrumAveraging mode, uint32_t nFrames){
+    if (mode >= SpectrumAvgCount){
+        return EFAIL;
+    }
+    spectrumAveraging = mode;
+    spectrumAverageFrames = nFrames;
+    if ((mode == SpectrumAvgLinear) && (nFrames == 0)){
+        spectrumAverageFrames = 1;
+    }
+    if (mode == SpectrumAvgExponential){
+        spectrumAlpha = (nFrames == 0) ? 0.7 : 2.0 / (float32_t)(nFrames + 1);
+        for (size_t x = 0; x < SPECTRUM_FFT_MAX; x++) {
+            FFT_spec_old[x] = 0;
+        }
+    }
+    spectrumFramesAveraged = 0;
+    return ESUCCESS;
+}
+
+/**
+ * Get the panadapter averaging mode
+ * @return The mode selected with SetSpectrumAveraging()
+ */
+SpectrumAveraging GetSpectrumAveraging(void){
+    return spectrumAveraging;
+}
+
+/**
+ * Get the number of FFT frames that have been averaged since the last ResetPSD()
+ * @return Number of frames
+ */
+uint32_t GetSpectrumFrameCount(void){
+    return spectrumFrameCount;
+}
+
+/**
+ * Get the window for an N-point panadapter FFT. The 256 and 512 point windows
+ * come from GetWindowTable(); the larger window is rebuilt only when the size or
+ * the selected window changes.
+ * 
+ * @param N Number of points
+ * @return Pointer to N window coefficients
+ */
+static const float32_t * GetSpectrumWindow(uint32_t N){
+    if (N <= SPECTRUM_RES){
+        return GetWindowTable(psdWindow, N);
+    }
+    if ((spectrumWindowType != psdWindow) || (spectrumWindowSize != N)){
+        BuildWindowTable(spectrumWindow, psdWindow, N);
+        spectrumWindowType = psdWindow;
+        spectrumWindowSize = N;
+    }
+    return spectrumWindow;
+}
+
+/**
+ * Copy a complete spectrum into the DSP's frame of the triple buffer, then swap
+ * that frame with the middle one. Neither side ever waits for the other: if the
+ * display has not collected the previous frame, it is simply replaced.
+ * 
+ * @param psd Pointer to SPECTRUM_RES bins
+ */
+void PublishPSDFrame(const float32_t *psd){
+    PSDFrame *frame = &psdFrames[psdBack];
+    memcpy(frame->bins, psd, sizeof(frame->bins));
+    frame->sequence = ++psdSequence;
+    // release: the frame contents are visible before its index is
+    uint32_t old = psdMiddle.exchange(psdBack | PSD_FRAME_FRESH, std::memory_order_acq_rel);
+    psdBack = old & PSD_FRAME_INDEX;
+}
+
+/**
+ * Swap the display's frame with the middle one if the DSP has published since
+ * the last call, and return the display's frame.
+ * 
+ * @return Pointer to the newest complete frame
+ */
+const PSDFrame * AcquirePSDFrame(void){
+    if (psdMiddle.load(std::memory_order_relaxed) & PSD_FRAME_FRESH){
+        uint32_t old = psdMiddle.exchange(psdFront, std::memory_order_acq_rel);
+        psdFront = old & PSD_FRAME_INDEX;
+    }
+    return &psdFrames[psdFront];
+}
+
+/**
+ * Check whether the DSP has published a frame since the last AcquirePSDFrame()
+ * @return true if a new frame is waiting
+ */
+bool PSDFrameAvailable(void){
+    return (psdMiddle.load(std::memory_order_relaxed) & PSD_FRAME_FRESH) != 0;
+}
+
+/**
+ * Convert the N-point complex FFT in buffer_spec_FFT to a power spectrum and add
+ * it to the average in FFT_spec_old using the mode selected with
+ * SetSpectrumAveraging(). The spectrum is swapped into display order (negative
+ * frequencies first). Spectra larger than SPECTRUM_RES are scaled by
+ * (SPECTRUM_RES/N)^2 so that a tone has the same power as in a 512-point FFT.
+ * In the default exponential mode:
+ *   FFT_spec_old = 0.7 * |X|^2 + 0.3 * FFT_spec_old
+ * Each step is a block operation over the whole spectrum.
+ * 
+ * @param N Number of bins in buffer_spec_FFT
+ * @param mode How the frame is combined with the average, normally spectrumAveraging
+ * @return true if the average is ready to be shown by PublishSpectrum()
+ */
+static bool AverageSpectrum(uint32_t N, SpectrumAveraging mode){
+    // we do not need to calculate magnitudes with square roots, it would seem to be sufficient to
+    // calculate mag = I*I + Q*Q, because we are doing a log10-transformation later anyway.
+    // Writing the two halves to opposite ends of FFT_spec puts them into the right order.
+    arm_cmplx_mag_squared_f32(buffer_spec_FFT, &FFT_spec[N/2], N/2);
+    arm_cmplx_mag_squared_f32(&buffer_spec_FFT[N], FFT_spec, N/2);
+    if (N > SPECTRUM_RES){
+        float32_t ratio = (float32_t)SPECTRUM_RES / (float32_t)N;
+        arm_scale_f32(FFT_spec, ratio * ratio, FFT_spec, N);
+    }
+    spectrumFrameCount++;
+
+    bool ready;
+    switch (mode){
+        case SpectrumAvgLinear:
+            if (spectrumFramesAveraged == 0){
+                arm_copy_f32(FFT_spec, FFT_spec_old, N);
+            } else {
+                arm_add_f32(FFT_spec, FFT_spec_old, FFT_spec_old, N);
+            }
+            spectrumFramesAveraged++;
+            if (spectrumFramesAveraged < spectrumAverageFrames){
+                return false;
+            }
+            arm_scale_f32(FFT_spec_old, 1.0 / (float32_t)spectrumFramesAveraged, FFT_spec_old, N);
+            // the next frame starts a new average
+            spectrumFramesAveraged = 0;
+            ready = true;
+            break;
+        case SpectrumAvgPeakHold:
+            if (spectrumFramesAveraged == 0){
+                arm_copy_f32(FFT_spec, FFT_spec_old, N);
+            } else {
+                for (size_t i = 0; i < N; i++){
+                    if (FFT_spec[i] > FFT_spec_old[i]) FFT_spec_old[i] = FFT_spec[i];
+                }
+            }
+            spectrumFramesAveraged++;
+            if ((spectrumAverageFrames > 0) && (spectrumFramesAveraged >= spectrumAverageFrames)){
+                // release the held peaks when the next frame arrives
+                spectrumFramesAveraged = 0;
+            }
+            ready = true;
+            break;
+        default:
+            // apply spectrum AGC. A linear or peak-hold average in progress is
+            // dropped, so the display mode starts cleanly after a calibration frame.
+            spectrumFramesAveraged = 0;
+            arm_scale_f32(FFT_spec, spectrumAlpha, FFT_spec, N);
+            arm_scale_f32(FFT_spec_old, 1 - spectrumAlpha, FFT_spec_old, N);
+            arm_add_f32(FFT_spec, FFT_spec_old, FFT_spec_old, N);
+            ready = true;
+            break;
+    }
+    // A NaN or Inf from a bad frame would latch in the average, so the average
+    // is dropped and started afresh. The mean is non-finite if any bin is, and
+    // it is only taken once per finished average.
+    float32_t mean;
+    arm_mean_f32(FFT_spec_old, N, &mean);
+    if (!isfinite(mean)){
+        for (size_t i = 0; i < N; i++) FFT_spec_old[i] = 0;
+        spectrumFramesAveraged = 0;
+        return false;
+    }
+    return ready;
+}
+
+/**
+ * Convert the averaged power spectrum in FFT_spec_old to the log power spectrum
+ * in psdnew. Spectra larger than SPECTRUM_RES are max-pooled down to SPECTRUM_RES
+ * bins first, so the display always gets the same number of bins and narrow
+ * signals are not diluted. Each group of k+1 bins is centred on the frequency of
+ * its display bin, which keeps psdnew[SPECTRUM_RES/2] at DC. Neighbouring groups
+ * share their edge bin.
+ * 
+ * @param N Number of bins in FFT_spec_old
+ */
+static void PublishSpectrum(uint32_t N){
+    if (N <= SPECTRUM_RES){
+        // convert to log scale for the spectrum display
+        log10f_fast_f32(FFT_spec_old, psdnew, N);
+        return;
+    }
+    uint32_t k = N / SPECTRUM_RES;
+    uint32_t index;
+    float32_t edge;
+    // FFT_spec is free to use as scratch once the frame has been averaged. The
+    // group of display bin 0, at -fs/2, wraps around to the top k/2 bins.
+    arm_max_f32(FFT_spec_old, k/2 + 1, &FFT_spec[0], &index);
+    arm_max_f32(&FFT_spec_old[N - k/2], k/2, &edge, &index);
+    if (edge > FFT_spec[0]) FFT_spec[0] = edge;
+    for (size_t j = 1; j < SPECTRUM_RES; j++){
+        arm_max_f32(&FFT_spec_old[j*k - k/2], k + 1, &FFT_spec[j], &index);
+    }
+    log10f_fast_f32(FFT_spec, psdnew, SPECTRUM_RES);
+}
+
+/**
+ * Flag that psdnew holds a new spectrum and hand it to the display. The
+ * calibration filter banks pass toDisplay = false: their spectra are read from
+ * psdnew by the calibration routines and must not replace the panadapter's frame.
+ * 
+ * @param toDisplay Publish psdnew to the home screen's frames
+ */
+static void PSDUpdated(bool toDisplay){
+    if (toDisplay){
+        PublishPSDFrame(psdnew);
+    }
+    psdupdated = true;
+}
+
+/**
+ * Window, FFT and average 512 points of complex data
  * 
  * @param *I Pointer to the array containing the real part of the samples
  * @param *Q Pointer to the array containing the imag part of the samples
+ * @param mode How the frame is combined with the average
+ * @param toDisplay Publish psdnew to the home screen's frames
+ * @return true if psdnew was updated
  */
-void CalcPSD512(float32_t *I, float32_t *Q)
-{
+static bool PSD512(float32_t *I, float32_t *Q, SpectrumAveraging mode, bool toDisplay){
     // interleave real and imaginary input values [real, imag, real, imag . . .]
+    // and apply the window function
+    const float32_t *window = GetWindowTable(psdWindow, SPECTRUM_RES);
     for (size_t i = 0; i < SPECTRUM_RES; i++) { 
-        // Apply a Hanning window function
-        buffer_spec_FFT[i * 2] =      I[i] * (0.5 - 0.5 * cos(TWO_PI * i / SPECTRUM_RES)); 
-        buffer_spec_FFT[i * 2 + 1] =  Q[i] * (0.5 - 0.5 * cos(TWO_PI * i / SPECTRUM_RES));
+        buffer_spec_FFT[i * 2] =      I[i] * window[i]; 
+        buffer_spec_FFT[i * 2 + 1] =  Q[i] * window[i];
     }
     // perform complex FFT
     // calculation is performed in-place the FFT_buffer [re, im, re, im, re, im . . .]
     FFT512Forward(buffer_spec_FFT);
-
-    // calculate magnitudes and put into FFT_spec
-    // we do not need to calculate magnitudes with square roots, it would seem to be sufficient to
-    // calculate mag = I*I + Q*Q, because we are doing a log10-transformation later anyway
-    // and simultaneously put them into the right order
-    // 38.50%, saves 0.05% of processor power and 1kbyte RAM ;-)
-    for (size_t i = 0; i < SPECTRUM_RES/2; i++) {
-        FFT_spec[i + SPECTRUM_RES/2] = (buffer_spec_FFT[i * 2] * buffer_spec_FFT[i * 2] + buffer_spec_FFT[i * 2 + 1] * buffer_spec_FFT[i * 2 + 1]);
-        FFT_spec[i]                  = (buffer_spec_FFT[(i + SPECTRUM_RES/2) * 2] * buffer_spec_FFT[(i + SPECTRUM_RES/2)  * 2] + buffer_spec_FFT[(i + SPECTRUM_RES/2)  * 2 + 1] * buffer_spec_FFT[(i + SPECTRUM_RES/2)  * 2 + 1]);
-    }
-
-    // apply spectrum AGC
-    float32_t LPFcoeff = 0.7;
-    for (size_t x = 0; x < SPECTRUM_RES; x++) {
-        // get rid of the nans that sometimes appear at boot
-        // TODO: figure out why they appear
-        if (isnan(FFT_spec_old[x])){
-            FFT_spec_old[x] = -3.0; // assume a very low power
-        }
-        FFT_spec[x] = LPFcoeff * FFT_spec[x] + (1-LPFcoeff) * FFT_spec_old[x];
-        FFT_spec_old[x] = FFT_spec[x];
+    if (!AverageSpectrum(SPECTRUM_RES, mode)){
+        return false;
     }
+    PublishSpectrum(SPECTRUM_RES);
+    PSDUpdated(toDisplay);
+    return true;
+}
 
-    // scale the magnitude values and convert to int for spectrum display
-    for (size_t i = 0; i < SPECTRUM_RES; i++) {
-        psdnew[i] = log10f_fast(FFT_spec[i]);
-    }
-    // this bin is always nan for some reason
-    //psdnew[170] = (psdnew[170-1]+psdnew[170+1])/2; 
-    psdupdated = true;
+/**
+ * Calculate a 512-point power spectrum from the complex data stored in real 
+ * and imag arrays. The window selected with SetPSDWindow() (Hann by default) is 
+ * applied to the data and the spectrum is averaged as selected with
+ * SetSpectrumAveraging(). The result is
+ * written into the global array psdnew. The value of the data in the psd buffers
+ * is log10( I*I + Q*Q ). So the units are log10(V^2 / Hz).
+ * 
+ * Note that this function requires that there are at least 512 samples in the
+ * arrays being passed
+ * 
+ * @param *I Pointer to the array containing the real part of the samples
+ * @param *Q Pointer to the array containing the imag part of the samples
+ */
+void CalcPSD512(float32_t *I, float32_t *Q)
+{
+    PSD512(I, Q, spectrumAveraging, true);
 }
 
 /**
@@ -153,37 +610,26 @@ void CalcPSD512(float32_t *I, float32_t *Q)
  * @param I Pointer to array containing real (I) samples
  * @param Q Pointer to array containing imaginary (Q) samples
  *
- * Similar to CalcPSD512 but operates on 256 samples. Applies Hanning window,
+ * Similar to CalcPSD512 but operates on 256 samples. Applies the PSD window,
  * performs 256-point FFT, calculates magnitudes, applies spectrum AGC, and
- * converts to log scale. Result written to first half of psdnew array.
+ * converts to log scale. Result written to first half of psdnew array, which
+ * is then published to the display like the CalcPSD512() result.
  */
 void CalcPSD256(float32_t *I, float32_t *Q)
 {
     // interleave real and imaginary input values [real, imag, real, imag . . .]
+    // and apply the window function
+    const float32_t *window = GetWindowTable(psdWindow, SPECTRUM_RES/2);
     for (size_t i = 0; i < SPECTRUM_RES/2; i++) { 
-        // Apply a Hanning window function
-        buffer_spec_FFT[i * 2] =      I[i] * (0.5 - 0.5 * cos(TWO_PI * i / SPECTRUM_RES/2)); 
-        buffer_spec_FFT[i * 2 + 1] =  Q[i] * (0.5 - 0.5 * cos(TWO_PI * i / SPECTRUM_RES/2));
+        buffer_spec_FFT[i * 2] =      I[i] * window[i]; 
+        buffer_spec_FFT[i * 2 + 1] =  Q[i] * window[i];
     }
     // perform complex FFT
     // calculation is performed in-place the FFT_buffer [re, im, re, im, re, im . . .]
     FFT256Forward(buffer_spec_FFT);
-    for (size_t i = 0; i < SPECTRUM_RES/4; i++) {
-        FFT_spec[i + SPECTRUM_RES/4] = (buffer_spec_FFT[i * 2] * buffer_spec_FFT[i * 2] + buffer_spec_FFT[i * 2 + 1] * buffer_spec_FFT[i * 2 + 1]);
-        FFT_spec[i]                  = (buffer_spec_FFT[(i + SPECTRUM_RES/4) * 2] * buffer_spec_FFT[(i + SPECTRUM_RES/4)  
-                    * 2] + buffer_spec_FFT[(i + SPECTRUM_RES/4)  * 2 + 1] * buffer_spec_FFT[(i + SPECTRUM_RES/4)  * 2 + 1]);
-    }
-
-    // apply spectrum AGC
-    float32_t LPFcoeff = 0.7;
-    for (size_t x = 0; x < SPECTRUM_RES/2; x++) {
-      FFT_spec[x] = LPFcoeff * FFT_spec[x] + (1-LPFcoeff) * FFT_spec_old[x];
-      FFT_spec_old[x] = FFT_spec[x];
-    }
-
-    // scale the magnitude values and convert to int for spectrum display
-    for (size_t i = 0; i < SPECTRUM_RES/2; i++) {
-        psdnew[i] = log10f_fast(FFT_spec[i]);
+    if (AverageSpectrum(SPECTRUM_RES/2, spectrumAveraging)){
+        PublishSpectrum(SPECTRUM_RES/2);
+        PSDUpdated(true);
     }
 }
 
@@ -252,6 +698,29 @@ void FreqShiftMFs4(DataBlock *data)
     }
 }
 
+// Number of samples FreqShiftF() advances its oscillator by recursive rotation
+// before it re-anchors the phasor to the exact phase of sample iFSF
+#define NCO_ANCHOR_INTERVAL 64
+
+/**
+ * Exact phase of the fine tune oscillator at sample index n.
+ *
+ * Computed in double precision and reduced modulo one cycle before scaling to
+ * radians, so the result stays accurate for the full range of iFSF. The single
+ * precision product NCO_INC*n loses about a milliradian once n approaches the
+ * sample rate.
+ *
+ * @param freqShift_Hz Oscillator frequency in Hz
+ * @param n Sample index
+ * @param sampleRate_Hz Sample rate in Hz
+ * @return Phase in radians in the range [0, 2*pi)
+ */
+static float32_t NCOPhase(float32_t freqShift_Hz, uint32_t n, uint32_t sampleRate_Hz){
+    double cycles = (double)freqShift_Hz * (double)n / (double)sampleRate_Hz;
+    cycles -= floor(cycles);
+    return (float32_t)(TWO_PI * cycles);
+}
+
 /**
  * Frequency translation by frequency F. 
  * 
@@ -259,27 +728,44 @@ void FreqShiftMFs4(DataBlock *data)
  * @param freqShift_Hz Frequency to shift by in Hz
  * 
  * Frequency translation is performed in-place.
+ * 
+ * The oscillator is a phasor that is rotated by the per-sample phase increment
+ * with one complex multiply per sample. Every NCO_ANCHOR_INTERVAL samples, and
+ * whenever iFSF wraps, the phasor is re-anchored to the exact phase of sample
+ * iFSF. This bounds the amplitude and phase error of the recursion, and because
+ * the phase is always derived from iFSF it is continuous between blocks. Only
+ * N/NCO_ANCHOR_INTERVAL + 1 cosf/sinf pairs are evaluated per block instead of N.
  */
 void FreqShiftF(DataBlock *data, float32_t freqShift_Hz){
     // We need to avoid phase discontinuities between adjacent blocks of samples
-    float32_t omegaShift = TWO_PI * (freqShift_Hz); 
-    float32_t tSample = 1/(float32_t)data->sampleRate_Hz;
-    float32_t NCO_INC = omegaShift * tSample;
-    float32_t OSC_COS, OSC_SIN,ip,qp;
-    for (size_t i = 0; i < data->N; i++) {
-        float32_t itheta = NCO_INC*(float32_t)iFSF;
-        //OSC_COS = arm_cos_f32 (itheta); // these are too inaccurate
-        //OSC_SIN = arm_sin_f32 (itheta);
+    float32_t NCO_INC = TWO_PI * freqShift_Hz / (float32_t)data->sampleRate_Hz;
+    float32_t STEP_COS = cosf(NCO_INC);
+    float32_t STEP_SIN = sinf(NCO_INC);
+    float32_t OSC_COS, OSC_SIN, ip, qp, tmp;
+    size_t i = 0;
+    while (i < data->N) {
+        // Re-anchor the oscillator, then rotate it until the next anchor point
+        // or until iFSF wraps
+        float32_t itheta = NCOPhase(freqShift_Hz, iFSF, data->sampleRate_Hz);
         OSC_COS = cosf (itheta);
         OSC_SIN = sinf (itheta);
-        ip = data->I[i];
-        qp = data->Q[i];
-        data->I[i] = (ip * OSC_COS - qp * OSC_SIN);
-        data->Q[i] = (qp * OSC_COS + ip * OSC_SIN);
+        size_t n = data->N - i;
+        if (n > NCO_ANCHOR_INTERVAL) n = NCO_ANCHOR_INTERVAL;
+        if (n > data->sampleRate_Hz - iFSF) n = data->sampleRate_Hz - iFSF;
+        for (size_t j = i; j < i + n; j++) {
+            ip = data->I[j];
+            qp = data->Q[j];
+            data->I[j] = (ip * OSC_COS - qp * OSC_SIN);
+            data->Q[j] = (qp * OSC_COS + ip * OSC_SIN);
+            tmp = OSC_COS * STEP_COS - OSC_SIN * STEP_SIN;
+            OSC_SIN = OSC_SIN * STEP_COS + OSC_COS * STEP_SIN;
+            OSC_COS = tmp;
+        }
+        i += n;
         // to avoid issues with errors due to iFSF growing too large, reset 
         // iFSF to zero if we're at a multiple of 2*pi. This is guaranteed 
         // to happen when iFSF == sample rate.
-        iFSF++;
+        iFSF += n;
         if (iFSF == data->sampleRate_Hz) iFSF = 0;
     }
 }
@@ -324,16 +810,174 @@ void FreqShiftF2(float32_t *I, float32_t *Q, uint32_t blocksize,
     }
 }
 
+// Recently used filter masks. Designing a mask takes a windowed sinc per tap and
+// a 512 point FFT, while tuning and toggling between the usual filter widths
+// only ever needs a handful of different masks.
+#define FILTER_MASK_CACHE_SIZE 4
+
+typedef struct {
+    int32_t low_Hz;
+    int32_t high_Hz;
+    ModulationType modulation;
+    uint8_t sampleRate;      // Index into SR[]
+    uint32_t DF;
+} FilterMaskKey;
+
+typedef struct {
+    FilterMaskKey key;
+    uint32_t lastUsed;       // 0 if the entry is empty
+} FilterMaskCacheEntry;
+
+static FilterMaskCacheEntry maskCache[FILTER_MASK_CACHE_SIZE];
+static float32_t DMAMEM maskCacheData[FILTER_MASK_CACHE_SIZE][FFT_LENGTH * 2] __attribute__((aligned(4)));
+static FilterMaskKey activeMaskKey;
+static bool activeMaskValid = false;
+static uint32_t maskCacheClock = 0;
+static uint32_t maskCacheHits = 0;
+static uint32_t maskCacheMisses = 0;
+
+static bool SameFilterMaskKey(const FilterMaskKey *a, const FilterMaskKey *b){
+    return (a->low_Hz == b->low_Hz) && (a->high_Hz == b->high_Hz) &&
+           (a->modulation == b->modulation) && (a->sampleRate == b->sampleRate) &&
+           (a->DF == b->DF);
+}
+
+// A requested mask is designed in idle time, then waits in nextFilterMask for
+// the next block
+enum FilterMaskState {
+    MaskCurrent,    // FIR_filter_mask matches the last request
+    MaskRequested,  // requestedMaskKey has to be prepared
+    MaskReady       // nextFilterMask holds requestedMaskKey
+};
+static FilterMaskState maskState = MaskCurrent;
+static FilterMaskKey requestedMaskKey;
+static ReceiveFilterConfig *requestedMaskFilters = NULL;
+
 /**
- * Update the FIR filter mask for convolution filtering
+ * Request a new FIR filter mask for convolution filtering
  * @param RXfilters Filter configuration structure
  *
- * Recalculates the frequency-domain filter mask used by ConvolutionFilter().
- * Should be called whenever filter parameters change (e.g., bandwidth adjustments).
+ * Asks for FIR_filter_mask, the frequency-domain filter mask used by ConvolutionFilter(),
+ * to match the current passband. Nothing is done if the passband, modulation and
+ * sample rate are those of the mask in use or of the one already requested, so this
+ * is cheap to call on every tune step. The mask is prepared by ServiceFIRFilterMask()
+ * and swapped in by ConvolutionFilter() at the start of the next block. Only the last
+ * of several requests made in between is prepared.
  */
 void UpdateFIRFilterMask(ReceiveFilterConfig *RXfilters){
-    // FIR filter mask
-    InitFilterMask(FIR_filter_mask, RXfilters);
+    FilterMaskKey key;
+    GetFilterMaskPassband(&key.low_Hz, &key.high_Hz);
+    key.modulation = ED.modulation[ED.activeVFO];
+    key.sampleRate = SampleRate;
+    key.DF = RXfilters->DF;
+
+    // Neither case changes the mask, so they do not count as cache hits
+    if (activeMaskValid && SameFilterMaskKey(&key, &activeMaskKey)){
+        // Back to the mask in use, drop any newer request
+        maskState = MaskCurrent;
+        return;
+    }
+    if ((maskState != MaskCurrent) && SameFilterMaskKey(&key, &requestedMaskKey)){
+        return;
+    }
+    requestedMaskKey = key;
+    requestedMaskFilters = RXfilters;
+    maskState = MaskRequested;
+}
+
+/**
+ * Prepare the requested filter mask in the spare buffer
+ *
+ * A mask used recently is copied from the cache; any other is designed for the
+ * requested passband and replaces the least recently used cache entry. The design
+ * uses the request, not the band settings, which may have changed since. Called in
+ * idle time so that designing a mask never delays a block of audio.
+ */
+void ServiceFIRFilterMask(void){
+    if (maskState != MaskRequested) return;
+    maskCacheClock++;
+    size_t victim = 0;
+    for (size_t i = 0; i < FILTER_MASK_CACHE_SIZE; i++){
+        if ((maskCache[i].lastUsed > 0) && SameFilterMaskKey(&requestedMaskKey, &maskCache[i].key)){
+            memcpy(nextFilterMask, maskCacheData[i], sizeof(maskCacheData[i]));
+            maskCache[i].lastUsed = maskCacheClock;
+            maskCacheHits++;
+            maskState = MaskReady;
+            return;
+        }
+        if (maskCache[i].lastUsed < maskCache[victim].lastUsed)
+            victim = i;
+    }
+    DesignFilterMask(nextFilterMask, requestedMaskFilters->m_NumTaps,
+                     requestedMaskKey.low_Hz, requestedMaskKey.high_Hz,
+                     (float32_t)SR[requestedMaskKey.sampleRate].rate / requestedMaskKey.DF);
+    memcpy(maskCacheData[victim], nextFilterMask, sizeof(maskCacheData[victim]));
+    maskCache[victim].key = requestedMaskKey;
+    maskCache[victim].lastUsed = maskCacheClock;
+    maskCacheMisses++;
+    maskState = MaskReady;
+}
+
+/**
+ * Make the prepared filter mask the one in use. Returns the mask it replaced.
+ */
+static float32_t *SwapFIRFilterMask(void){
+    float32_t *old = FIR_filter_mask;
+    FIR_filter_mask = nextFilterMask;
+    nextFilterMask = old;
+    activeMaskKey = requestedMaskKey;
+    activeMaskValid = true;
+    maskState = MaskCurrent;
+    return old;
+}
+
+/**
+ * Put the filter mask for the current passband in use at once, without a
+ * crossfade. For use when no audio is running, such as at startup.
+ * @param RXfilters Filter configuration structure
+ */
+void ApplyFIRFilterMask(ReceiveFilterConfig *RXfilters){
+    UpdateFIRFilterMask(RXfilters);
+    ServiceFIRFilterMask();
+    if (maskState == MaskReady)
+        SwapFIRFilterMask();
+}
+
+/**
+ * Check whether a requested filter mask is not yet in use
+ * @return true from UpdateFIRFilterMask() until ConvolutionFilter() swaps the mask in
+ */
+bool IsFIRFilterMaskPending(void){
+    return maskState != MaskCurrent;
+}
+
+/**
+ * Empty the filter mask cache and zero its counters. A mask request made
+ * after this designs the mask from scratch.
+ */
+void ResetFilterMaskCache(void){
+    for (size_t i = 0; i < FILTER_MASK_CACHE_SIZE; i++){
+        maskCache[i].lastUsed = 0;
+    }
+    activeMaskValid = false;
+    maskState = MaskCurrent;
+    maskCacheClock = 0;
+    maskCacheHits = 0;
+    maskCacheMisses = 0;
+}
+
+/**
+ * Number of filter mask changes that copied a cached mask instead of designing one
+ */
+uint32_t GetFilterMaskCacheHits(void){
+    return maskCacheHits;
+}
+
+/**
+ * Number of filter mask updates that designed a new mask
+ */
+uint32_t GetFilterMaskCacheMisses(void){
+    return maskCacheMisses;
 }
 
 /**
@@ -369,13 +1013,16 @@ void InitializeFilters(uint32_t spectrum_zoom, ReceiveFilterConfig *RXfilters) {
     // ****************************************************************************************
     // *  Decimate: RXfilters involved with decimate by 2 and decimate by 4
     // ****************************************************************************************
+    // The buffers of the last initialization are handed back first
+    ResetDSPArenaBank(RXfilters);
     InitializeDecimationFilter(&RXfilters->DecimateRxStage1, RXfilters->DF1, (float32_t)SR[SampleRate].rate,
-                                RXfilters->n_att_dB, RXfilters->n_desired_BW_Hz, READ_BUFFER_SIZE);
+                                RXfilters->n_att_dB, RXfilters->n_desired_BW_Hz, READ_BUFFER_SIZE, RXfilters);
     InitializeDecimationFilter(&RXfilters->DecimateRxStage2, RXfilters->DF2, (float32_t)SR[SampleRate].rate / RXfilters->DF1,
-                                RXfilters->n_att_dB, RXfilters->n_desired_BW_Hz, READ_BUFFER_SIZE/RXfilters->DF1);
+                                RXfilters->n_att_dB, RXfilters->n_desired_BW_Hz, READ_BUFFER_SIZE/RXfilters->DF1, RXfilters);
 
-    // FIR filter mask
-    InitFilterMask(FIR_filter_mask, RXfilters);
+    // FIR filter mask. The cached masks may be for another sample rate.
+    ResetFilterMaskCache();
+    ApplyFIRFilterMask(RXfilters);
 
     // Clear the convolution overlap-add history buffers. These are declared as
     // static DMAMEM, which is NOT zero-initialized at cold boot on the Teensy 4.x
@@ -552,12 +1199,84 @@ void ZoomFFTPrep(uint32_t spectrum_zoom, ReceiveFilterConfig *RXfilters){
     RXfilters->biquadZoomI.pCoeffs = mag_coeffs[spectrum_zoom];
     RXfilters->biquadZoomQ.pCoeffs = mag_coeffs[spectrum_zoom];
     RXfilters->zoom_sample_ptr = 0;
+    RXfilters->zoom_fft_size = 0; // restart the ring buffer on the next ZoomFFTExe()
+}
+
+/**
+ * The averaging applied to frames from this filter config. The calibration
+ * routines read psdnew after every frame, so they get the exponential average
+ * whatever mode the panadapter is set to.
+ * 
+ * @param RXfilters Struct holding the filter variables and objects
+ * @return The averaging mode to pass to AverageSpectrum()
+ */
+static SpectrumAveraging ZoomAveraging(const ReceiveFilterConfig *RXfilters){
+    return RXfilters->zoom_track_every_frame ? SpectrumAvgExponential : spectrumAveraging;
 }
 
 /**
- * Zoom FFT. Calculate a 512 point PSD from complex number input arrays, but 
+ * Write samples into the FFT ring buffers and calculate a frame each time another
+ * half of the FFT size has arrived, so consecutive frames overlap by 50% (Welch's
+ * method). The window tapers the ends of each frame, so without the overlap the
+ * samples near the frame edges would hardly contribute to the spectrum.
+ * 
+ * @param x Pointer to the real part of the samples
+ * @param y Pointer to the imaginary part of the samples
+ * @param Nsamples Number of samples
+ * @param multiplier Gain applied to the samples
+ * @param RXfilters Struct holding the ring buffer position
+ * @return true if psdnew was updated
+ */
+static bool WelchSpectrum(float32_t *x, float32_t *y, uint32_t Nsamples,
+                            float32_t multiplier, ReceiveFilterConfig *RXfilters){
+    uint32_t N = RXfilters->zoom_fft_size;
+    uint32_t mask = N - 1;
+    bool updated = false;
+    size_t i = 0;
+    while (i < Nsamples){
+        uint32_t n = Nsamples - i;
+        if (n > RXfilters->zoom_samples_to_frame) n = RXfilters->zoom_samples_to_frame;
+        uint32_t ptr = RXfilters->zoom_sample_ptr;
+        for (size_t k = 0; k < n; k++){
+            FFT_ring_buffer_x[ptr] = multiplier*x[i + k];
+            FFT_ring_buffer_y[ptr] = multiplier*y[i + k];
+            ptr = (ptr + 1) & mask;
+        }
+        RXfilters->zoom_sample_ptr = ptr;
+        RXfilters->zoom_samples_to_frame -= n;
+        i += n;
+        if (RXfilters->zoom_samples_to_frame > 0){
+            break;
+        }
+
+        // The write pointer is now at the oldest sample in the ring
+        const float32_t *window = GetSpectrumWindow(N);
+        for (size_t k = 0; k < N; k++){
+            uint32_t idx = (ptr + k) & mask;
+            buffer_spec_FFT[k * 2] =     FFT_ring_buffer_x[idx] * window[k];
+            buffer_spec_FFT[k * 2 + 1] = FFT_ring_buffer_y[idx] * window[k];
+        }
+        if (N == SPECTRUM_FFT_MAX){
+            FFT2048Forward(buffer_spec_FFT);
+        } else {
+            FFT1024Forward(buffer_spec_FFT);
+        }
+        if (AverageSpectrum(N, ZoomAveraging(RXfilters))){
+            PublishSpectrum(N);
+            updated = true;
+        }
+        RXfilters->zoom_samples_to_frame = N/2;
+    }
+    if (updated){
+        PSDUpdated(!RXfilters->zoom_track_every_frame);
+    }
+    return updated;
+}
+
+/**
+ * Zoom FFT. Calculate a PSD from complex number input arrays, but 
  * apply decimation beforehand in order to decrease the sample rate, and hence 
- * increase the frequency resolution of the PSD. 
+ * increase the frequency resolution of the PSD. With the default 512-point FFT:
  * 
  * | Zoom |   Fsample |   Nsamples   |   PSD bin width |
  * |------|-----------|--------------|-----------------|
@@ -571,40 +1290,63 @@ void ZoomFFTPrep(uint32_t spectrum_zoom, ReceiveFilterConfig *RXfilters){
  * in a single call to this function, so we need to write the decimated samples
  * to a buffer and call the PSD function only when this buffer fills up. 
  * 
+ * With a 1024 or 2048 point FFT (see SetSpectrumFFTSize()) the bins are 2 or 4
+ * times narrower and every decimated sample is used, in frames that overlap by
+ * 50%. The result is max-pooled down to SPECTRUM_RES display bins.
+ * 
  * @param data Pointer to the DataBlock to act upon
  * @param spectrum_zoom The zoom factor
  * @param RXfilters Struct holding the filter variables and objects
- * @return true if we calculated a PSD, false if we did not
+ * @return true if psdnew was updated, false if it was not
  * 
  * The resulting PSD is written to the psdnew global array. 
  */
 bool ZoomFFTExe(DataBlock *data, uint32_t spectrum_zoom, ReceiveFilterConfig *RXfilters)
 {
-    if (spectrum_zoom == SPECTRUM_ZOOM_1) {
+    uint32_t fftSize = spectrumFFTSize;
+    if ((spectrum_zoom == SPECTRUM_ZOOM_1) && (fftSize == SPECTRUM_RES)) {
         // No decimation required
-        CalcPSD512(data->I,data->Q);
-        return true;
+        return PSD512(data->I, data->Q, ZoomAveraging(RXfilters),
+                        !RXfilters->zoom_track_every_frame);
+    }
+    if (RXfilters->zoom_fft_size != fftSize){
+        // The FFT size has changed, start filling the ring buffers again
+        RXfilters->zoom_fft_size = fftSize;
+        RXfilters->zoom_sample_ptr = 0;
+        RXfilters->zoom_samples_to_frame = fftSize;
     }
+
     float32_t x_buffer[data->N];
     float32_t y_buffer[data->N];
-    // We use a biquad to filter first,
-    arm_biquad_cascade_df1_f32 (&(RXfilters->biquadZoomI), data->I, x_buffer, data->N);
-    arm_biquad_cascade_df1_f32 (&(RXfilters->biquadZoomQ), data->Q, y_buffer, data->N);
-    // then decimate. We don't need a FIR decimate because of the IIR filter
-    decimate_f32(x_buffer,x_buffer,RXfilters->zoom_M,data->N);
-    decimate_f32(y_buffer,y_buffer,RXfilters->zoom_M,data->N);
-    
-    // and then copy the decimated samples into the FFT buffer, but no more than SPECTRUM_RES of them
-    uint32_t Nsamples = data->N / (1 << spectrum_zoom); // Samples after decimation
+    float32_t *x = data->I;
+    float32_t *y = data->Q;
+    uint32_t Nsamples = data->N;
+    float32_t multiplier = 1.0;
+    if (spectrum_zoom != SPECTRUM_ZOOM_1) {
+        // We use a biquad to filter first,
+        arm_biquad_cascade_df1_f32 (&(RXfilters->biquadZoomI), data->I, x_buffer, data->N);
+        arm_biquad_cascade_df1_f32 (&(RXfilters->biquadZoomQ), data->Q, y_buffer, data->N);
+        // then decimate. We don't need a FIR decimate because of the IIR filter
+        decimate_f32(x_buffer,x_buffer,RXfilters->zoom_M,data->N);
+        decimate_f32(y_buffer,y_buffer,RXfilters->zoom_M,data->N);
+        x = x_buffer;
+        y = y_buffer;
+        Nsamples = data->N / (1 << spectrum_zoom); // Samples after decimation
+        // This multiplier overcomes the effects of the filter and decimate functions. Keeps
+        // the amplitude in the PSD more stable as zoom increases.
+        multiplier = zoomMultiplierCoeff[spectrum_zoom];
+    }
+    if (fftSize > SPECTRUM_RES) {
+        return WelchSpectrum(x, y, Nsamples, multiplier, RXfilters);
+    }
+
+    // copy the decimated samples into the FFT buffer, but no more than SPECTRUM_RES of them
     if (Nsamples > SPECTRUM_RES) {
         Nsamples = SPECTRUM_RES;
     }
-    // This multiplier overcomes the effects of the filter and decimate functions. Keeps
-    // the amplitude in the PSD more stable as zoom increases.
-    float32_t multiplier = zoomMultiplierCoeff[spectrum_zoom];
     for (size_t i = 0; i < Nsamples; i++) {
-        FFT_ring_buffer_x[RXfilters->zoom_sample_ptr] = multiplier*x_buffer[i];
-        FFT_ring_buffer_y[RXfilters->zoom_sample_ptr] = multiplier*y_buffer[i];
+        FFT_ring_buffer_x[RXfilters->zoom_sample_ptr] = multiplier*x[i];
+        FFT_ring_buffer_y[RXfilters->zoom_sample_ptr] = multiplier*y[i];
         RXfilters->zoom_sample_ptr++;
     }
 
@@ -614,9 +1356,8 @@ bool ZoomFFTExe(DataBlock *data, uint32_t spectrum_zoom, ReceiveFilterConfig *RX
     }
     // FFT_ring_buffers are full, reset the sample pointer and then continue
     RXfilters->zoom_sample_ptr = 0;
-    CalcPSD512(FFT_ring_buffer_x,FFT_ring_buffer_y);
-
-    return true;
+    return PSD512(FFT_ring_buffer_x, FFT_ring_buffer_y, ZoomAveraging(RXfilters),
+                    !RXfilters->zoom_track_every_frame);
 }
 
 /**
@@ -673,11 +1414,108 @@ errno_t DecimateBy8(DataBlock *data, ReceiveFilterConfig *RXfilters){
     return err;
 }
 
+/**
+ * Frequency translation by +Fs/4 (optional) and by the fine tune frequency F, followed
+ * by the first decimation-by-4 stage, in a single pass over the data. Equivalent to
+ * calling FreqShiftFs4(), FreqShiftF() and DecimateBy4() in turn.
+ * 
+ * The Fs/4 shift is a rotation by pi/2 per sample, so it is folded into the NCO of
+ * FreqShiftF(): the phasor step and the anchor phase both gain a pi/2 per sample term.
+ * The mixed samples are written straight into the state buffer of the stage 1 decimation
+ * filter and each output is computed as soon as the last input it depends on is in place.
+ * Only the N/DF1 outputs that survive decimation are calculated. The filter state and
+ * iFSF are shared with DecimateBy4() and FreqShiftF(), so the two paths are
+ * interchangeable from one block to the next.
+ * 
+ * Only works on input arrays of READ_BUFFER_SIZE samples sampled at the original sample
+ * rate SR[SampleRate].rate
+ * 
+ * @param data Pointer to the DataBlock to act upon
+ * @param shiftFs4 Apply the +Fs/4 shift of FreqShiftFs4() before the fine tune shift
+ * @param freqShift_Hz Fine tune frequency to shift by in Hz
+ * @param RXfilters Struct holding the filter variables and objects
+ */
+errno_t FreqShiftAndDecimateBy4(DataBlock *data, bool shiftFs4, float32_t freqShift_Hz,
+                                ReceiveFilterConfig *RXfilters){
+    if (data->N != READ_BUFFER_SIZE){
+        return EFAIL;
+    }
+    arm_fir_decimate_instance_f32 *SI = &(RXfilters->DecimateRxStage1.FIR_dec_I);
+    arm_fir_decimate_instance_f32 *SQ = &(RXfilters->DecimateRxStage1.FIR_dec_Q);
+    const uint32_t M = SI->M;
+    const uint32_t numTaps = SI->numTaps;
+    const float32_t *coeffs = SI->pCoeffs;
+    // New samples go after the numTaps-1 samples of history from the previous block
+    float32_t *stateI = SI->pState + numTaps - 1;
+    float32_t *stateQ = SQ->pState + numTaps - 1;
+
+    float32_t NCO_INC = TWO_PI * freqShift_Hz / (float32_t)data->sampleRate_Hz;
+    if (shiftFs4) NCO_INC += HALF_PI;
+    float32_t STEP_COS = cosf(NCO_INC);
+    float32_t STEP_SIN = sinf(NCO_INC);
+    float32_t OSC_COS, OSC_SIN, ip, qp, tmp;
+    size_t m = 0;
+    size_t i = 0;
+    while (i < data->N) {
+        float32_t itheta = NCOPhase(freqShift_Hz, iFSF, data->sampleRate_Hz);
+        if (shiftFs4) itheta += HALF_PI * (float32_t)(i & 3);
+        OSC_COS = cosf (itheta);
+        OSC_SIN = sinf (itheta);
+        size_t n = data->N - i;
+        if (n > NCO_ANCHOR_INTERVAL) n = NCO_ANCHOR_INTERVAL;
+        if (n > data->sampleRate_Hz - iFSF) n = data->sampleRate_Hz - iFSF;
+        for (size_t j = i; j < i + n; j++) {
+            ip = data->I[j];
+            qp = data->Q[j];
+            stateI[j] = (ip * OSC_COS - qp * OSC_SIN);
+            stateQ[j] = (qp * OSC_COS + ip * OSC_SIN);
+            tmp = OSC_COS * STEP_COS - OSC_SIN * STEP_SIN;
+            OSC_SIN = OSC_SIN * STEP_COS + OSC_COS * STEP_SIN;
+            OSC_COS = tmp;
+        }
+        i += n;
+        iFSF += n;
+        if (iFSF == data->sampleRate_Hz) iFSF = 0;
+
+        // Output m depends on inputs up to M*m. Inputs before i have been consumed, so
+        // the outputs can overwrite the start of the data arrays.
+        for (; M*m < i; m++) {
+            const float32_t *xI = SI->pState + M*m;
+            const float32_t *xQ = SQ->pState + M*m;
+            float32_t accI = 0.0;
+            float32_t accQ = 0.0;
+            for (size_t k = 0; k < numTaps; k++) {
+                accI += coeffs[k] * xI[k];
+                accQ += coeffs[k] * xQ[k];
+            }
+            data->I[m] = accI;
+            data->Q[m] = accQ;
+        }
+    }
+
+    // Keep the last numTaps-1 samples as history for the next block
+    memmove(SI->pState, SI->pState + data->N, (numTaps - 1) * sizeof(float32_t));
+    memmove(SQ->pState, SQ->pState + data->N, (numTaps - 1) * sizeof(float32_t));
+    data->N = data->N/RXfilters->DF1;
+    data->sampleRate_Hz = data->sampleRate_Hz/RXfilters->DF1;
+    return ESUCCESS;
+}
+
+/**
+ * Restart the fine tune oscillator at sample index zero (for unit testing)
+ */
+void ResetFreqShiftF(void){
+    iFSF = 0;
+}
+
 /**
  * Digital FFT convolution filtering is accomplished by combining (multiplying) 
  * spectra in the frequency domain. Basis for this was Lyons, R. (2011): 
  * Understanding Digital Processing. "Fast FIR Filtering using the FFT", pages 688 - 694.
  * Method used here: overlap-and-save.
+ *
+ * A filter mask prepared by ServiceFIRFilterMask() is swapped in at the start of
+ * the block, and that block is crossfaded from the old filter's output to the new.
  * 
  * @param data Pointer to the DataBlock to act upon
  * @param RXfilters Struct holding the filter variables and objects
@@ -727,6 +1565,15 @@ errno_t ConvolutionFilter(DataBlock *data, ReceiveFilterConfig *RXfilters, const
     //   calculation is performed in-place the FFT_buffer [re, im, re, im, re, im . . .]
     FFT512Forward(buffer_spec_FFT);
 
+    // A new filter mask only takes effect at a block boundary. The previous mask
+    // still filters this block so that the two outputs can be crossfaded.
+    float32_t *oldMask = NULL;
+    if (maskState == MaskReady){
+        oldMask = SwapFIRFilterMask();
+        arm_cmplx_mult_cmplx_f32(buffer_spec_FFT, oldMask, crossfadeBuffer, FFT_LENGTH);
+        FFT512Reverse(crossfadeBuffer);
+    }
+
     // The filter mask is initialized using InitFilterMask(). Only need to do 
     // this once for each filter setting.Allows efficient real-time variable LP 
     // and HP audio RXfilters, without the overhead of time-domain convolution 
@@ -770,6 +1617,15 @@ errno_t ConvolutionFilter(DataBlock *data, ReceiveFilterConfig *RXfilters, const
         data->I[i] = iFFT_buffer[256*2 + 2*i];
         data->Q[i] = iFFT_buffer[256*2 + 2*i+1];
     }
+
+    // Fade linearly from the old filter output to the new one over this block
+    if (oldMask != NULL){
+        for (unsigned i = 0; i < data->N; i++) {
+            float32_t w = (float32_t)(i + 1) / (float32_t)data->N;
+            data->I[i] = w * data->I[i] + (1.0f - w) * crossfadeBuffer[256*2 + 2*i];
+            data->Q[i] = w * data->Q[i] + (1.0f - w) * crossfadeBuffer[256*2 + 2*i+1];
+        }
+    }
     return ESUCCESS;
 }
 
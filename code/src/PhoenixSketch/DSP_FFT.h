@@ -37,6 +37,93 @@ float32_t GetAudioPowerMax(void);
  */
 float32_t log10f_fast(float32_t X);
 
+/**
+ * @brief Fast approximation of base-10 logarithm of a block of values
+ * @param pSrc Pointer to the input values (must be positive)
+ * @param pDst Pointer to the output values, can be the same as pSrc
+ * @param blockSize Number of values
+ * @note Same approximation as log10f_fast(), written so the loop can be unrolled and pipelined
+ */
+void log10f_fast_f32(const float32_t *pSrc, float32_t *pDst, uint32_t blockSize);
+
+// Window Functions
+
+/** Window functions available from GetWindowTable() */
+enum WindowType {
+    WindowHann = 0,          /** Good frequency resolution, general purpose */
+    WindowBlackmanHarris,    /** Low sidelobes (-92 dB), for weak signals next to strong ones */
+    WindowFlatTop,           /** Flat passband, accurate amplitude regardless of tone position in a bin */
+    WindowTypeCount
+};
+
+/**
+ * @brief Get a precomputed window table
+ * @param type The window function
+ * @param N Number of points, 256 or 512
+ * @return Pointer to N window coefficients, or NULL if N or type is not supported
+ * @note The tables are periodic (suitable for FFTs and 50% overlap) and are built on first use
+ * @note All windows are scaled to the coherent gain of the Hann window (0.5), so a tone reads
+ *       the same PSD level whichever window is selected
+ */
+const float32_t * GetWindowTable(WindowType type, uint32_t N);
+
+/**
+ * @brief Select the window function applied by CalcPSD512() and CalcPSD256()
+ * @param type The window function
+ * @note Hann by default. The flat-top window gives the most accurate power readings
+ */
+void SetPSDWindow(WindowType type);
+
+/**
+ * @brief Get the window function applied by CalcPSD512() and CalcPSD256()
+ * @return The selected window function
+ */
+WindowType GetPSDWindow(void);
+
+// Panadapter Spectrum
+
+/** How successive FFT frames are combined into the displayed spectrum */
+enum SpectrumAveraging {
+    SpectrumAvgExponential = 0, /** Exponential moving average, updated every frame */
+    SpectrumAvgLinear,          /** Mean of N frames, published once every N frames */
+    SpectrumAvgPeakHold,        /** Highest power seen in each bin over N frames */
+    SpectrumAvgCount
+};
+
+/**
+ * @brief Select the number of points in the panadapter FFT
+ * @param N 512, 1024 or 2048
+ * @return ESUCCESS, or EFAIL if N is not supported
+ * @note 512 reproduces the original single-frame behaviour. The larger sizes use all of the
+ *       (decimated) samples in Welch frames with 50% overlap
+ * @note psdnew always holds SPECTRUM_RES bins; larger spectra are max-pooled down to it and
+ *       scaled so a tone reads the same level at every size
+ */
+errno_t SetSpectrumFFTSize(uint32_t N);
+
+/**
+ * @brief Get the number of points in the panadapter FFT
+ * @return 512, 1024 or 2048
+ */
+uint32_t GetSpectrumFFTSize(void);
+
+/**
+ * @brief Select how the panadapter combines successive FFT frames
+ * @param mode The averaging mode
+ * @param nFrames Exponential: span of the average, weight of a new frame is 2/(nFrames+1),
+ *                0 selects the default weight of 0.7. Linear: number of frames averaged.
+ *                Peak hold: number of frames a peak is held for, 0 holds until ResetPSD()
+ * @return ESUCCESS, or EFAIL if mode is not supported
+ * @note Clears the averaging state but leaves psdnew untouched
+ */
+errno_t SetSpectrumAveraging(SpectrumAveraging mode, uint32_t nFrames);
+
+/**
+ * @brief Get the panadapter averaging mode
+ * @return The averaging mode selected with SetSpectrumAveraging()
+ */
+SpectrumAveraging GetSpectrumAveraging(void);
+
 // Power Spectral Density Calculation
 
 /**
@@ -55,6 +142,38 @@ void CalcPSD512(float32_t *real, float32_t *imag);
  */
 void CalcPSD256(float32_t *I, float32_t *Q);
 
+// Spectrum Hand-off
+
+/** One complete spectrum, passed from the DSP to the display by PublishPSDFrame() */
+struct PSDFrame {
+    float32_t bins[SPECTRUM_RES];  /** Same contents and units as psdnew */
+    uint32_t sequence;             /** Number of the frame, counting from 1 */
+};
+
+/**
+ * @brief Hand a complete spectrum to the display
+ * @param psd Pointer to SPECTRUM_RES bins, normally psdnew
+ * @note Called by the PSD calculations every time psdnew is updated
+ * @note Lock-free and wait-free: a triple buffer lets the DSP publish from an interrupt or
+ *       another thread while the display is still drawing an earlier frame
+ */
+void PublishPSDFrame(const float32_t *psd);
+
+/**
+ * @brief Get the newest spectrum published by the DSP
+ * @return Pointer to the frame. It is not modified by the DSP until the next call, so the
+ *         display can draw it over several passes without tearing
+ * @note Returns the same frame again if nothing new has been published. Call from one
+ *       place only (the spectrum display)
+ */
+const PSDFrame * AcquirePSDFrame(void);
+
+/**
+ * @brief Check whether a frame newer than the last one acquired has been published
+ * @return true if the next AcquirePSDFrame() will return a new frame
+ */
+bool PSDFrameAvailable(void);
+
 // Frequency Shifting
 
 /**
@@ -76,6 +195,7 @@ void FreqShiftMFs4(DataBlock *data);
  * @param data Pointer to DataBlock containing I/Q samples
  * @param freqShift_Hz Frequency shift in Hz (positive or negative)
  * @note Uses complex multiplication with NCO for arbitrary frequency shifts
+ * @note The NCO phase is continuous from one call to the next
  */
 void FreqShiftF(DataBlock *data, float32_t freqShift_Hz);
 
@@ -98,7 +218,7 @@ void FreqShiftF2(float32_t *I, float32_t *Q, uint32_t blocksize,
  * @param data Pointer to DataBlock containing I/Q samples
  * @param spectrum_zoom Zoom factor (1, 2, 4, 8, 16, 32, 64)
  * @param RXfilters Pointer to receive filter configuration
- * @return true if zoom FFT executed successfully, false otherwise
+ * @return true if psdnew was updated, false otherwise
  * @note Implements software-defined "panadapter zoom" for detailed spectrum view
  */
 bool ZoomFFTExe(DataBlock *data, uint32_t spectrum_zoom, ReceiveFilterConfig *RXfilters);
@@ -155,12 +275,49 @@ void SetIIRCoeffs(float32_t *coefficient_set, float32_t f0, float32_t Q,
 // Filter Management
 
 /**
- * @brief Update FIR filter frequency mask for convolution filtering
+ * @brief Request a FIR filter frequency mask for the current passband
  * @param RXfilters Pointer to receive filter configuration
- * @note Recalculates filter coefficients when filter bandwidth changes
+ * @note Only records the request. ServiceFIRFilterMask() prepares the mask and
+ *       ConvolutionFilter() swaps it in, crossfading over one block
  */
 void UpdateFIRFilterMask(ReceiveFilterConfig *RXfilters);
 
+/**
+ * @brief Prepare a requested filter mask in the spare mask buffer
+ * @note Called in idle time. Copies the mask from the cache or designs it
+ */
+void ServiceFIRFilterMask(void);
+
+/**
+ * @brief Put the filter mask for the current passband in use at once
+ * @param RXfilters Pointer to receive filter configuration
+ * @note No crossfade; for use when no audio is being filtered
+ */
+void ApplyFIRFilterMask(ReceiveFilterConfig *RXfilters);
+
+/**
+ * @brief Check whether a requested filter mask has yet to be swapped in
+ * @return true while a mask request is waiting for ConvolutionFilter()
+ */
+bool IsFIRFilterMaskPending(void);
+
+/**
+ * @brief Empty the filter mask cache and zero its hit and miss counters
+ */
+void ResetFilterMaskCache(void);
+
+/**
+ * @brief Get the number of filter mask changes served from the cache
+ * @return Cache hit count since the last ResetFilterMaskCache()
+ */
+uint32_t GetFilterMaskCacheHits(void);
+
+/**
+ * @brief Get the number of filter mask updates that designed a new mask
+ * @return Cache miss count since the last ResetFilterMaskCache()
+ */
+uint32_t GetFilterMaskCacheMisses(void);
+
 /**
  * @brief Initialize all receive filters for specified zoom level
  * @param spectrum_zoom Zoom factor for FFT display
@@ -185,6 +342,25 @@ void FilterSetSSB(int32_t filter_change, uint8_t changeFilterHiCut);
  */
 void InitFilterMask(float32_t *FIR_filter_mask, ReceiveFilterConfig *RXfilters);
 
+/**
+ * @brief Calculate the FIR filter mask for an explicit passband
+ * @param FIR_filter_mask Output buffer for filter frequency response
+ * @param numTaps Number of FIR filter taps
+ * @param low_Hz Lower passband edge
+ * @param high_Hz Upper passband edge
+ * @param sampleRate_Hz Sample rate the filter runs at
+ * @note InitFilterMask() calls this with the current band settings
+ */
+void DesignFilterMask(float32_t *FIR_filter_mask, uint32_t numTaps, int32_t low_Hz, int32_t high_Hz,
+                      float32_t sampleRate_Hz);
+
+/**
+ * @brief Get the convolution filter passband for the current band and modulation
+ * @param low_Hz Receives the lower passband edge in Hz
+ * @param high_Hz Receives the upper passband edge in Hz
+ */
+void GetFilterMaskPassband(int32_t *low_Hz, int32_t *high_Hz);
+
 /**
  * @brief Apply convolution filter to received signal
  * @param data Pointer to DataBlock containing I/Q samples
@@ -224,6 +400,19 @@ errno_t DecimateBy4(DataBlock *data, ReceiveFilterConfig *RXfilters);
  */
 errno_t DecimateBy2(DataBlock *data, ReceiveFilterConfig *RXfilters);
 
+/**
+ * @brief Fine tune and decimate by 4 in a single pass
+ * @param data Pointer to DataBlock containing I/Q samples
+ * @param shiftFs4 Also apply the +Fs/4 shift of FreqShiftFs4() first
+ * @param freqShift_Hz Fine tune frequency shift in Hz
+ * @param RXfilters Pointer to receive filter configuration
+ * @return ESUCCESS on success, EFAIL if data->N is not READ_BUFFER_SIZE
+ * @note Equivalent to FreqShiftFs4() (optional), FreqShiftF() and DecimateBy4() but
+ *       only computes the samples that survive decimation
+ */
+errno_t FreqShiftAndDecimateBy4(DataBlock *data, bool shiftFs4, float32_t freqShift_Hz,
+                                ReceiveFilterConfig *RXfilters);
+
 /**
  * @brief Initialize a decimation filter structure
  * @param filter Pointer to DecimationFilter structure to initialize
@@ -232,10 +421,12 @@ errno_t DecimateBy2(DataBlock *data, ReceiveFilterConfig *RXfilters);
  * @param att_dB Stopband attenuation in dB
  * @param bandwidth_kHz Passband bandwidth in kHz
  * @param blockSize Number of samples per processing block
+ * @param bank Filter bank whose DSP arena region holds the buffers
  * @note Calculates FIR coefficients for anti-aliasing filter
  */
 void InitializeDecimationFilter(DecimationFilter *filter, float32_t DF, float32_t sampleRate_kHz,
-                                float32_t att_dB, float32_t bandwidth_kHz, uint32_t blockSize);
+                                float32_t att_dB, float32_t bandwidth_kHz, uint32_t blockSize,
+                                const ReceiveFilterConfig *bank);
 
 /**
  * @brief Decimate float array by factor M (generic decimator)
@@ -251,7 +442,7 @@ void decimate_f32(float32_t *in_buffer, float32_t *out_buffer, uint16_t M, uint3
 
 /**
  * @brief Reset Power Spectral Density accumulators
- * @note Clears spectrum averaging buffers for fresh spectrum display
+ * @note Clears spectrum averaging buffers and the frame count for fresh spectrum display
  */
 void ResetPSD(void);
 
@@ -285,6 +476,19 @@ void ApplyEQBandFilter(DataBlock *data, ReceiveFilterConfig *RXfilters, uint8_t
  */
 float32_t * GetFilteredBufferAddress(void);
 
+/**
+ * @brief Restart the FreqShiftF() oscillator at sample index zero
+ * @note This function is intended for unit testing only
+ */
+void ResetFreqShiftF(void);
+
+/**
+ * @brief Get the number of panadapter FFT frames calculated since the last ResetPSD()
+ * @return Number of frames
+ * @note This function is intended for unit testing only
+ */
+uint32_t GetSpectrumFrameCount(void);
+
 /**
  * @brief Set filename for FIR filter coefficient debugging
  * @param fnm Filename for debug output
@@ -380,6 +584,39 @@ void FFT256Forward(float32_t *buffer);
  */
 void FFT256Reverse(float32_t *buffer);
 
+/**
+ * @brief Perform 128-point forward FFT
+ * @param buffer Pointer to interleaved I/Q data [I0,Q0,I1,Q1,...]
+ * @note This function is stubbed in test builds for deterministic testing
+ */
+void FFT128Forward(float32_t *buffer);
+
+/**
+ * @brief Perform 128-point inverse FFT
+ * @param buffer Pointer to interleaved I/Q data [I0,Q0,I1,Q1,...]
+ * @note This function is stubbed in test builds for deterministic testing
+ */
+void FFT128Reverse(float32_t *buffer);
+
+/**
+ * @brief Perform 256-point forward FFT of a real frame
+ * @param in Pointer to 256 real samples. Used as scratch space and overwritten
+ * @param out Pointer to 256 floats receiving the 128 bins of the half spectrum,
+ *            packed as [Re X0, Re X128, Re X1, Im X1, ... Re X127, Im X127]
+ * @note Same packing as arm_rfft_fast_f32. Costs about half of FFT256Forward
+ * @note in and out must not overlap
+ */
+void RealFFT256Forward(float32_t *in, float32_t *out);
+
+/**
+ * @brief Perform 256-point inverse FFT back to a real frame
+ * @param in Pointer to a half spectrum packed as by RealFFT256Forward. Not modified
+ * @param out Pointer to 256 floats receiving the real samples
+ * @note Scaled so that RealFFT256Reverse(RealFFT256Forward(x)) returns x
+ * @note in and out must not overlap
+ */
+void RealFFT256Reverse(float32_t *in, float32_t *out);
+
 /**
  * @brief Perform 512-point forward FFT
  * @param buffer Pointer to interleaved I/Q data [I0,Q0,I1,Q1,...]
@@ -394,6 +631,20 @@ void FFT512Forward(float32_t *buffer);
  */
 void FFT512Reverse(float32_t *buffer);
 
+/**
+ * @brief Perform 1024-point forward FFT
+ * @param buffer Pointer to interleaved I/Q data [I0,Q0,I1,Q1,...]
+ * @note This function is stubbed in test builds for deterministic testing
+ */
+void FFT1024Forward(float32_t *buffer);
+
+/**
+ * @brief Perform 2048-point forward FFT
+ * @param buffer Pointer to interleaved I/Q data [I0,Q0,I1,Q1,...]
+ * @note This function is stubbed in test builds for deterministic testing
+ */
+void FFT2048Forward(float32_t *buffer);
+
 /**
  * @brief Write I/Q data to file for debugging
  * @param data Pointer to DataBlock containing I/Q samples
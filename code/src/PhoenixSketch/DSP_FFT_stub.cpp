@@ -48,6 +48,14 @@ void FFT256Reverse(float32_t *buffer){
     arm_cfft_f32(&arm_cfft_sR_f32_len256, buffer, 1, 1);
 }
 
+void FFT128Forward(float32_t *buffer){
+    arm_cfft_f32(&arm_cfft_sR_f32_len128, buffer, 0, 1);
+}
+
+void FFT128Reverse(float32_t *buffer){
+    arm_cfft_f32(&arm_cfft_sR_f32_len128, buffer, 1, 1);
+}
+
 void FFT512Forward(float32_t *buffer){
     arm_cfft_f32(&arm_cfft_sR_f32_len512, buffer, 0, 1);
 }
@@ -56,6 +64,14 @@ void FFT512Reverse(float32_t *buffer){
     arm_cfft_f32(&arm_cfft_sR_f32_len512, buffer, 1, 1);
 }
 
+void FFT1024Forward(float32_t *buffer){
+    arm_cfft_f32(&arm_cfft_sR_f32_len1024, buffer, 0, 1);
+}
+
+void FFT2048Forward(float32_t *buffer){
+    arm_cfft_f32(&arm_cfft_sR_f32_len2048, buffer, 0, 1);
+}
+
 // These really don't belong here, but it saves the bother of creating another stub.
 // These functions are used by the unit tests to examine data as it flows through the
 // DSP chains.
@@ -1280,9 +1280,14 @@ void SetIIRCoeffs(float32_t *coefficient_set, float32_t f0, float32_t Q, float32
  * @param att_dB The stopband attenuation in dB
  * @param bandwidth_Hz The bandwidth
  * @param blockSize The number of samples to act upon
+ * @param bank The filter bank whose DSP arena region holds the buffers
+ *
+ * The state and coefficient buffers come from the DSP arena. If they do not
+ * fit, an error is logged and the filter is left without buffers.
  */
 void InitializeDecimationFilter(DecimationFilter *filter, float32_t DF, float32_t sampleRate_Hz, 
-                                float32_t att_dB, float32_t bandwidth_Hz, uint32_t blockSize){
+                                float32_t att_dB, float32_t bandwidth_Hz, uint32_t blockSize,
+                                const ReceiveFilterConfig *bank){
   filter->M = DF;
   filter->n_samplerate_Hz = sampleRate_Hz;
   filter->n_att_dB = att_dB;
@@ -1292,9 +1297,14 @@ void InitializeDecimationFilter(DecimationFilter *filter, float32_t DF, float32_
   filter->n_fstop = ((filter->n_samplerate_Hz / filter->M) - filter->n_desired_BW_Hz) / filter->n_samplerate_Hz;
   filter->n_dec_taps = (1 + (uint16_t)(filter->n_att_dB / (22.0 * (filter->n_fstop - filter->n_fpass))));
 
-  filter->FIR_dec_I_state = (float32_t*)malloc(sizeof(float32_t) * (filter->n_dec_taps + blockSize - 1));
-  filter->FIR_dec_Q_state = (float32_t*)malloc(sizeof(float32_t) * (filter->n_dec_taps + blockSize - 1));
-  filter->FIR_dec_coeffs = (float32_t*)malloc(sizeof(float32_t) * filter->n_dec_taps);
+  uint32_t stateSize = filter->n_dec_taps + blockSize - 1;
+  filter->FIR_dec_I_state = (float32_t*)DSPArenaAlloc(bank, sizeof(float32_t) * stateSize);
+  filter->FIR_dec_Q_state = (float32_t*)DSPArenaAlloc(bank, sizeof(float32_t) * stateSize);
+  filter->FIR_dec_coeffs = (float32_t*)DSPArenaAlloc(bank, sizeof(float32_t) * filter->n_dec_taps);
+  if ((filter->FIR_dec_I_state == NULL) || (filter->FIR_dec_Q_state == NULL) || (filter->FIR_dec_coeffs == NULL)){
+    Debug("ERROR: decimation filter has no buffers");
+    return;
+  }
 
   CalcFIRCoeffs(filter->FIR_dec_coeffs, filter->n_dec_taps, (float32_t)(filter->n_desired_BW_Hz), 
                 filter->n_att_dB, Lowpass, 0.0, (float32_t)(sampleRate_Hz));
@@ -1320,27 +1330,21 @@ void decimate_f32(float32_t *in_buffer, float32_t *out_buffer, uint16_t M, uint3
 }
 
 /**
- * Calculate the FFT of the FIR filter coefficients once to produce the FIR filter mask.
+ * Get the passband of the convolution filter for the current band and modulation.
+ * @param low_Hz Receives the lower edge of the passband
+ * @param high_Hz Receives the upper edge of the passband
  */
-void InitFilterMask(float32_t *FIR_filter_mask, ReceiveFilterConfig *RXfilters) {
-    // the FIR has exactly m_NumTaps = (FFT_length / 2) + 1 coefficients, 
-    // so we have to add (FFT_length / 2) -1 zeros before the FFT in order to produce a FFT_length 
-    // point input buffer for the FFT
-    // copy coefficients into real values of first part of buffer, rest is zero
-
-    float32_t FIR_Coef_I[RXfilters->m_NumTaps];
-    float32_t FIR_Coef_Q[RXfilters->m_NumTaps];
-    int32_t high_Hz, low_Hz;
+void GetFilterMaskPassband(int32_t *low_Hz, int32_t *high_Hz) {
     if (ED.modulation[ED.activeVFO] == bands[ED.currentBand[ED.activeVFO]].mode){
-        high_Hz = bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz;
-        low_Hz = bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz;
+        *high_Hz = bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz;
+        *low_Hz = bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz;
     } else {
         // we have changed from the default modulation
         switch (ED.modulation[ED.activeVFO]){
             case LSB:
             case USB:
-                low_Hz  = -bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz;
-                high_Hz = -bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz;
+                *low_Hz  = -bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz;
+                *high_Hz = -bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz;
                 break;
             case SAM:
             case AM:
@@ -1349,17 +1353,42 @@ void InitFilterMask(float32_t *FIR_filter_mask, ReceiveFilterConfig *RXfilters)
                 #define MAXABS(a, b) ((abs(a)) > (abs(b)) ? (abs(a)) : (abs(b)))
                 int32_t edge_Hz = MAXABS(bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz,
                                          bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz); 
-                low_Hz = -edge_Hz;
-                high_Hz = edge_Hz;
+                *low_Hz = -edge_Hz;
+                *high_Hz = edge_Hz;
                 break;
         }
     }
-    CalcCplxFIRCoeffs(FIR_Coef_I, FIR_Coef_Q, RXfilters->m_NumTaps, 
+}
+
+/**
+ * Calculate the FFT of the FIR filter coefficients once to produce the FIR filter mask.
+ */
+void InitFilterMask(float32_t *FIR_filter_mask, ReceiveFilterConfig *RXfilters) {
+    int32_t high_Hz, low_Hz;
+    GetFilterMaskPassband(&low_Hz, &high_Hz);
+    DesignFilterMask(FIR_filter_mask, RXfilters->m_NumTaps, low_Hz, high_Hz,
+        (float)SR[SampleRate].rate / RXfilters->DF);
+}
+
+/**
+ * Calculate the FIR filter mask for the given passband, whatever the current
+ * band and modulation settings are.
+ */
+void DesignFilterMask(float32_t *FIR_filter_mask, uint32_t numTaps, int32_t low_Hz, int32_t high_Hz,
+                      float32_t sampleRate_Hz) {
+    // the FIR has exactly m_NumTaps = (FFT_length / 2) + 1 coefficients, 
+    // so we have to add (FFT_length / 2) -1 zeros before the FFT in order to produce a FFT_length 
+    // point input buffer for the FFT
+    // copy coefficients into real values of first part of buffer, rest is zero
+
+    float32_t FIR_Coef_I[numTaps];
+    float32_t FIR_Coef_Q[numTaps];
+    CalcCplxFIRCoeffs(FIR_Coef_I, FIR_Coef_Q, numTaps, 
         (float32_t)low_Hz, 
         (float32_t)high_Hz, 
-        (float)SR[SampleRate].rate / RXfilters->DF);
+        sampleRate_Hz);
 
-    for (size_t i = 0; i < RXfilters->m_NumTaps; i++) {
+    for (size_t i = 0; i < numTaps; i++) {
         FIR_filter_mask[i * 2] = FIR_Coef_I[i];
         FIR_filter_mask[i * 2 + 1] = FIR_Coef_Q[i];
     }
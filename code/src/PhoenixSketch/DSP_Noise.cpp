@@ -20,6 +20,9 @@ If not, see <https://www.gnu.org/licenses/>.
 
 // DMAMEM places these in OCRAM, which is accessible by DMA and is slower
 float32_t DMAMEM NR_FFT_buffer[2 * NR_FFT_L] __attribute__((aligned(4)));
+// The NR frames are real: the time samples use the first half of NR_FFT_buffer
+// and the half spectrum from RealFFT256Forward() the second half
+static float32_t *const NR_spectrum = &NR_FFT_buffer[NR_FFT_L];
 float32_t DMAMEM NR_last_sample_buffer_L[NR_FFT_L / 2];
 float32_t DMAMEM NR_X[NR_FFT_L / 2][3];
 float32_t DMAMEM NR_E[NR_FFT_L / 2][15];
@@ -121,6 +124,51 @@ void InitializeKim1NoiseReduction(void){
     CLEAR_VAR(NR_last_iFFT_result);
 }
 
+/**
+ * Build one 50% overlapped NR frame in the first half of NR_FFT_buffer: the
+ * previous 128 samples followed by the next 128 samples from in, multiplied by
+ * the window. The new samples are kept for the next frame.
+ *
+ * @param in Pointer to the next NR_FFT_L / 2 audio samples
+ * @param window Pointer to the NR_FFT_L point window
+ */
+static void LoadNRFrame(const float32_t *in, const float32_t *window){
+    for (int i = 0; i < NR_FFT_L / 2; i++) {
+        NR_FFT_buffer[i] = NR_last_sample_buffer_L[i];
+        NR_FFT_buffer[NR_FFT_L / 2 + i] = in[i];
+        NR_last_sample_buffer_L[i] = in[i];
+    }
+    arm_mult_f32(NR_FFT_buffer, (float32_t *)window, NR_FFT_buffer, NR_FFT_L);
+}
+
+/**
+ * Squared magnitude of one bin of the half spectrum in NR_spectrum.
+ *
+ * @param bindx Bin index, 0 to NR_FFT_L / 2 - 1
+ */
+static inline float32_t NRBinPower(int bindx){
+    if (bindx == 0)
+        return NR_spectrum[0] * NR_spectrum[0]; // DC is real
+    return NR_spectrum[bindx * 2] * NR_spectrum[bindx * 2] + NR_spectrum[bindx * 2 + 1] * NR_spectrum[bindx * 2 + 1];
+}
+
+/**
+ * Weight the half spectrum in NR_spectrum with one gain per bin. The other half
+ * of the spectrum of a real frame is the conjugate mirror of this one, so each
+ * gain implicitly applies to both bin k and bin NR_FFT_L - k. The Nyquist bin
+ * takes the gain of the bin below it.
+ *
+ * @param gain Pointer to NR_FFT_L / 2 gains
+ */
+static void ApplyNRGain(const float32_t *gain){
+    NR_spectrum[0] *= gain[0];
+    NR_spectrum[1] *= gain[NR_FFT_L / 2 - 1];
+    for (int bindx = 1; bindx < NR_FFT_L / 2; bindx++) {
+        NR_spectrum[bindx * 2] *= gain[bindx];
+        NR_spectrum[bindx * 2 + 1] *= gain[bindx];
+    }
+}
+
 /**
  * Apply Kim & Ruwisch 2002 noise reduction. Thanks to Michael DL2FW for your support!
  * This is exactly the implementation by
@@ -171,33 +219,17 @@ void Kim1_NR(DataBlock *data){
         VAD_high = NR_FFT_L / 2;
     }
 
+    // Periodic Hann window, which sums to a constant for the 50% overlapped frames
+    const float32_t *hannWindow = GetWindowTable(WindowHann, NR_FFT_L);
     for (int k = 0; k < 2; k++) {
-        // NR_FFT_buffer is 512 floats big
-        // interleaved r, i, r, i . . .
-        // fill first half of FFT_buffer with last events audio samples
-        for (int i = 0; i < NR_FFT_L / 2; i++) {
-            NR_FFT_buffer[i * 2] = NR_last_sample_buffer_L[i]; // real
-            NR_FFT_buffer[i * 2 + 1] = 0.0; // imaginary
-        }
-        // copy recent samples to last_sample_buffer for next time!
-        for (int i = 0; i < NR_FFT_L  / 2; i++) {
-            NR_last_sample_buffer_L [i] = data->I[i + k * (NR_FFT_L / 2)];
-        }
-        // now fill recent audio samples into second half of FFT_buffer
-        for (int i = 0; i < NR_FFT_L / 2; i++) {
-            NR_FFT_buffer[NR_FFT_L + i * 2] = data->I[i + k * (NR_FFT_L / 2)]; // real
-            NR_FFT_buffer[NR_FFT_L + i * 2 + 1] = 0.0;
-        }
-        // perform windowing on 256 real samples in the NR_FFT_buffer
-        for (int idx = 0; idx < NR_FFT_L; idx++)  {     // Hann window
-            float32_t temp_sample = 0.5 * (float32_t)(1.0 - (cosf(PI * 2.0 * (float32_t)idx / (float32_t)((NR_FFT_L) - 1))));
-            NR_FFT_buffer[idx * 2] *= temp_sample;
-        }
-        FFT256Forward(NR_FFT_buffer);
-        // take first 128 bin values of the FFT result
+        // The frame is real, so NR_FFT_buffer holds the 256 windowed samples in
+        // its first half and their 128-bin half spectrum in its second half
+        LoadNRFrame(&data->I[k * (NR_FFT_L / 2)], hannWindow);
+        RealFFT256Forward(NR_FFT_buffer, NR_spectrum);
+        // take the 128 bin values of the half spectrum
         for (int bindx = 0; bindx < NR_FFT_L / 2; bindx++) { 
             // it seems that taking power works better than taking magnitude . . . !?
-            NR_X[bindx][NR_X_pointer] = (NR_FFT_buffer[bindx * 2] * NR_FFT_buffer[bindx * 2] + NR_FFT_buffer[bindx * 2 + 1] * NR_FFT_buffer[bindx * 2 + 1]);
+            NR_X[bindx][NR_X_pointer] = NRBinPower(bindx);
         }
         // take first 128 bin values of the FFT result
         for (int bindx = VAD_low; bindx < VAD_high; bindx++) { 
@@ -251,12 +283,7 @@ void Kim1_NR(DataBlock *data){
                                                                                 // take care of bin 0 and bin NR_FFT_L/2 - 1
         NR_G[0] = (NR_onemtwobeta + NR_beta) * NR_Gts[0][0] + NR_beta * NR_Gts[1][0];
         NR_G[(NR_FFT_L / 2) - 1] = NR_beta * NR_Gts[(NR_FFT_L / 2) - 2][0] + (NR_onemtwobeta + NR_beta) * NR_Gts[(NR_FFT_L / 2) - 1][0];
-        for (int bindx = 0; bindx < NR_FFT_L / 2; bindx++) {                                      // try 128:
-            NR_FFT_buffer[bindx * 2] = NR_FFT_buffer [bindx * 2] * NR_G[bindx];                     // real part
-            NR_FFT_buffer[bindx * 2 + 1] = NR_FFT_buffer [bindx * 2 + 1] * NR_G[bindx];             // imag part
-            NR_FFT_buffer[NR_FFT_L * 2 - bindx * 2 - 2] = NR_FFT_buffer[NR_FFT_L * 2 - bindx * 2 - 2] * NR_G[bindx]; // real part conjugate symmetric
-            NR_FFT_buffer[NR_FFT_L * 2 - bindx * 2 - 1] = NR_FFT_buffer[NR_FFT_L * 2 - bindx * 2 - 1] * NR_G[bindx]; // imag part conjugate symmetric
-        }
+        ApplyNRGain(NR_G);
         NR_X_pointer = NR_X_pointer + 1;
         if (NR_X_pointer >= NR_L_frames) {
             NR_X_pointer = 0;
@@ -266,12 +293,12 @@ void Kim1_NR(DataBlock *data){
         if (NR_E_pointer >= NR_N_frames) {
             NR_E_pointer = 0;
         }
-        FFT256Reverse(NR_FFT_buffer);
-        for (int i = 0; i < NR_FFT_L / 2; i++) { // take real part of first half of current iFFT result and add to 2nd half of last iFFT_result
-            NR_output_audio_buffer[i + k * (NR_FFT_L / 2)] = NR_FFT_buffer[i * 2] + NR_last_iFFT_result[i];
+        RealFFT256Reverse(NR_spectrum, NR_FFT_buffer);
+        for (int i = 0; i < NR_FFT_L / 2; i++) { // add first half of current iFFT result to 2nd half of last iFFT_result
+            NR_output_audio_buffer[i + k * (NR_FFT_L / 2)] = NR_FFT_buffer[i] + NR_last_iFFT_result[i];
         }
         for (int i = 0; i < NR_FFT_L / 2; i++) {
-            NR_last_iFFT_result[i] = NR_FFT_buffer[NR_FFT_L + i * 2];
+            NR_last_iFFT_result[i] = NR_FFT_buffer[NR_FFT_L / 2 + i];
         }
     }
 
@@ -452,36 +479,16 @@ void SpectralNoiseReduction(DataBlock *data){
     }
 
     for (int k = 0; k < 2; k++) {
-        // NR_FFT_buffer is 512 floats big
-        // interleaved r, i, r, i . . .
-        // fill first half of FFT_buffer with last events audio samples
-        for (int i = 0; i < NR_FFT_L / 2; i++) {
-            NR_FFT_buffer[i * 2] = NR_last_sample_buffer_L[i]; // real
-            NR_FFT_buffer[i * 2 + 1] = 0.0; // imaginary
-        }
-        // copy recent samples to last_sample_buffer for next time!
-        for (int i = 0; i < NR_FFT_L  / 2; i++) {
-            NR_last_sample_buffer_L [i] = data->I[i + k * (NR_FFT_L / 2)];
-        }
-        // now fill recent audio samples into second half of FFT_buffer
-        for (int i = 0; i < NR_FFT_L / 2; i++) {
-            NR_FFT_buffer[NR_FFT_L + i * 2] = data->I[i + k * (NR_FFT_L / 2)]; // real
-            NR_FFT_buffer[NR_FFT_L + i * 2 + 1] = 0.0;
-        }
-        // perform windowing on samples in the NR_FFT_buffer
-        for (int idx = 0; idx < NR_FFT_L; idx++) { // sqrt Hann window
-            //float32_t temp_sample = 0.5 * (float32_t)(1.0 - (cosf(PI * 2.0 * (float32_t)idx / (float32_t)((NR_FFT_L) - 1))));
-            //NR_FFT_buffer[idx * 2] *= temp_sample;
-            NR_FFT_buffer[idx * 2] *= sqrtHann[idx];
-        }
+        // sqrt Hann window on the way in and on the way out
+        LoadNRFrame(&data->I[k * (NR_FFT_L / 2)], sqrtHann);
 
         // NR_FFT
-        // calculation is performed in-place the FFT_buffer [re, im, re, im, re, im . . .]
-        FFT256Forward(NR_FFT_buffer);
+        // real input, half spectrum out [Re X0, Re X128, Re X1, Im X1, . . .]
+        RealFFT256Forward(NR_FFT_buffer, NR_spectrum);
 
         for (int bindx = 0; bindx < NR_FFT_L / 2; bindx++) {
             // this is squared magnitude for the current frame
-            NR_X[bindx][0] = (NR_FFT_buffer[bindx * 2] * NR_FFT_buffer[bindx * 2] + NR_FFT_buffer[bindx * 2 + 1] * NR_FFT_buffer[bindx * 2 + 1]);
+            NR_X[bindx][0] = NRBinPower(bindx);
             // Sanitize at the single entry point: a NaN/Inf reaching the noise
             // estimate (xt) or the gain feedback would otherwise latch permanently
             // and silence the audio until NR is toggled off.
@@ -603,12 +610,9 @@ void SpectralNoiseReduction(DataBlock *data){
         } //end of "if ts.nr_first_time == 3"
 
         // FINAL SPECTRAL WEIGHTING: Multiply current FFT results with NR_FFT_buffer for 128 bins with the 128 bin-specific gain factors G
-        for (int bindx = 0; bindx < NR_FFT_L / 2; bindx++) {                              // try 128:
-            NR_FFT_buffer[bindx * 2]                    = NR_FFT_buffer [bindx * 2] * NR_G[bindx] * NR_long_tone_gain[bindx];              // real part
-            NR_FFT_buffer[bindx * 2 + 1]                = NR_FFT_buffer [bindx * 2 + 1] * NR_G[bindx] * NR_long_tone_gain[bindx];      // imag part
-            NR_FFT_buffer[NR_FFT_L * 2 - bindx * 2 - 2] = NR_FFT_buffer[NR_FFT_L * 2 - bindx * 2 - 2] * NR_G[bindx] * NR_long_tone_gain[bindx]; // real part conjugate symmetric
-            NR_FFT_buffer[NR_FFT_L * 2 - bindx * 2 - 1] = NR_FFT_buffer[NR_FFT_L * 2 - bindx * 2 - 1] * NR_G[bindx] * NR_long_tone_gain[bindx]; // imag part conjugate symmetric
-        }
+        float32_t gain[NR_FFT_L / 2];
+        arm_mult_f32(NR_G, NR_long_tone_gain, gain, NR_FFT_L / 2);
+        ApplyNRGain(gain);
 
         // *****************************************************************
         //  NOISE REDUCTION CODE ENDS HERE
@@ -624,23 +628,21 @@ void SpectralNoiseReduction(DataBlock *data){
             // bins 2 to 29 attenuated
             // set real values to 0.1 of their original value
         {
-            NR_FFT_buffer[bindx * 2] *= 0.1;
-            NR_FFT_buffer[bindx * 2 + 1] *= 0.1; //NR_iFFT_buffer[idx] * 0.1;
+            NR_spectrum[bindx * 2] *= 0.1;
+            NR_spectrum[bindx * 2 + 1] *= 0.1; //NR_iFFT_buffer[idx] * 0.1;
         }
     #endif
-        FFT256Reverse(NR_FFT_buffer);
+        RealFFT256Reverse(NR_spectrum, NR_FFT_buffer);
         
-        for (int idx = 0; idx < NR_FFT_L; idx++) {
-            NR_FFT_buffer[idx * 2] *= sqrtHann[idx];      // sqrt Hann window
-        }
+        arm_mult_f32(NR_FFT_buffer, (float32_t *)sqrtHann, NR_FFT_buffer, NR_FFT_L); // sqrt Hann window
 
         // do the overlap & add
-        for (int i = 0; i < NR_FFT_L / 2; i++) {        // take real part of first half of current iFFT result and add to 2nd half of last iFFT_result
-            data->I[i + k * (NR_FFT_L / 2)] = NR_FFT_buffer[i * 2] + NR_last_iFFT_result[i];
+        for (int i = 0; i < NR_FFT_L / 2; i++) {        // add first half of current iFFT result to 2nd half of last iFFT_result
+            data->I[i + k * (NR_FFT_L / 2)] = NR_FFT_buffer[i] + NR_last_iFFT_result[i];
             data->Q[i + k * (NR_FFT_L / 2)] = data->I[i + k * (NR_FFT_L / 2)];
         }
         for (int i = 0; i < NR_FFT_L / 2; i++) {
-            NR_last_iFFT_result[i] = NR_FFT_buffer[NR_FFT_L + i * 2];
+            NR_last_iFFT_result[i] = NR_FFT_buffer[NR_FFT_L / 2 + i];
         }
         // end of "for" loop which repeats the FFT_iFFT_chain two times !!!
         }
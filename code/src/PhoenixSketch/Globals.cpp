@@ -488,7 +488,9 @@ IntervalTimer timer1ms;
  * are needed for time dependent state changes like the CW keyer
  */
 void tick1ms(void){
-    ModeSm_dispatch_event(&modeSM, ModeSm_EventId_DO);
+    // State entry actions run from here must not join a batch of the main loop
+    SetExpanderInterruptContext(true);
+    TickRFHardwareAndModeSm();
     UISm_dispatch_event(&uiSM, UISm_EventId_DO);
     PowerCalSm_dispatch_event(&powerSM, PowerCalSm_EventId_DO);
     ReceiveIQCalSm_dispatch_event(&rxiqSM, ReceiveIQCalSm_EventId_DO);
@@ -496,6 +498,7 @@ void tick1ms(void){
     #ifdef DIRECT_COUPLED_TX
     TransmitCarrierCalSm_dispatch_event(&txcarrSM, TransmitCarrierCalSm_EventId_DO);
     #endif
+    SetExpanderInterruptContext(false);
 }
 
 time_t getTeensy3Time() {
@@ -62,7 +62,7 @@ If not, see <https://www.gnu.org/licenses/>.
  * ---------------------
  * - State transitions follow carefully sequenced hardware operations to prevent
  *   RF power spikes or relay damage (RX components disabled before TX enabled)
- * - Delays (MyDelay) ensure relay and PIN diode settling times
+ * - Settling times for relays and PIN diodes are timed by a non-blocking sequencer
  * - Multiple ModeSm states can map to the same RF hardware state (optimization)
  * - Frequency changes are handled independently via the tune state machine
  * - State tracking prevents redundant hardware reconfigurations
@@ -78,7 +78,9 @@ If not, see <https://www.gnu.org/licenses/>.
  * ------------------------
  * - Must complete within main loop timing budget (10ms)
  * - State changes are event-driven, not polled continuously
- * - Hardware delays are necessary but kept to minimum required values
+ * - Hardware settling times are necessary but kept to minimum required values, and
+ *   are counted down by TickRFHardwareSequence() rather than waited out in the
+ *   main loop, which runs the next step through ServiceRFHardwareSequence()
  *
  * @see ModeSm.cpp - High-level radio mode state machine
  * @see RFBoard.cpp - Low-level RF hardware control functions
@@ -92,6 +94,10 @@ static ModeSm_StateId previousRadioState = ModeSm_StateId_ROOT;
 static RFHardwareState rfHardwareState = RFReceive;
 static RFHardwareState oldrfHardwareState = RFInvalid;
 static TuneState tuneState = TuneReceive;
+static volatile bool sequenceBusy = false;
+static volatile bool sequenceStepDue = false;
+static volatile RFHardwareState pendingState = RFInvalid;
+static volatile bool retunePending = false;
 
 /**
  * @brief Initialize the RF board by calling the initialization functions for each
@@ -119,6 +125,10 @@ errno_t InitializeRFBoard(void){
     oldrfHardwareState = RFInvalid;
     previousRadioState = ModeSm_StateId_ROOT;
     tuneState = TuneInvalid;
+    sequenceBusy = false;
+    sequenceStepDue = false;
+    pendingState = RFInvalid;
+    retunePending = false;
     return err;
 }
 
@@ -170,16 +180,325 @@ RFHardwareState GetRFHardwareState(void){
     return rfHardwareState;
 }
 
+////////////////////////////////////////////////////////////////////////////////////
+// T/R sequencer
+//
+// Each RF hardware state is entered by a table of steps. A step is a group of
+// hardware actions followed by the time the hardware needs to settle before the
+// next step may run. The first step runs as soon as the state changes. tick1ms()
+// counts down the settle time and ServiceRFHardwareSequence() runs the next steps
+// from the main loop, so the DSP and the display keep running while the relays
+// switch and no I2C traffic happens in the interrupt.
+////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    void (*action)(void);  // Hardware actions of this step
+    uint8_t settle_ms;     // Time the hardware needs after the actions
+} RFSequenceStep;
+
+static const RFSequenceStep *sequenceSteps = NULL;
+static size_t sequenceLength = 0;
+static volatile size_t sequenceIndex = 0;
+static volatile uint8_t sequenceWait_ms = 0;
+static float32_t cwAttenuation_dB = 31.5;
+
+static void SelectPA(void){
+    if (ED.PA100Wactive)
+        Select100WPA();
+    else
+        Bypass100WPA();
+}
+
+static void SetMaxTXAttenuation(void){
+    SetTXAttenuation(31.5);
+}
+
+/**
+ * First, do things that reduce the transmitted power, then shunt the transmit
+ * path to nothing.
+ */
+static void TransmitPathOff(void){
+    // Set cwState to LO                                //  Duration | Total
+    CWoff();                                            // <<1ms  | < 1ms
+    // Set clockEnableCW to LO
+    DisableCWVFOOutput();                               // ~ 1ms  | < 2ms
+    if (HasDualVFOs()){
+        DisableTXVFOOutput();
+    }
+    SetTXAttenuation(31.5);                             // queued | < 2ms
+    TXBypassBPF(); // BPF out of TX path                // queued | < 2ms
+    SelectXVTR();  // Shunt the TX path to nothing      // queued | < 2ms
+    Bypass100WPA(); // always bypassed                  // queued | < 2ms
+    // When the step ends the queued expander writes go out as one transaction
+    // to the RF board and one to the LPF board         // < 1ms  | < 3ms
+}
+
+/**
+ * Switch in the receive path hardware, except for the T/R relay.
+ */
+static void ReceivePathOn(void){
+    // Set frequency
+    RXSelectBPF(); // BPF in to RX path
+    UpdateTuneState();
+    // Set GPA state to appropriate value
+    SetRXAttenuation( ED.RAtten[ED.currentBand[ED.activeVFO]] );
+    // Set driveCurrentSSB_mA to appropriate value
+    // > This does not change after initialization, so do nothing
+    // Set clockEnableSSB to HI (SSB)
+    EnableRXVFOOutput();
+    SelectTXSSBModulation();
+    // Make sure calFeedbackState is LO
+    DisableCalFeedback();
+}
+
+/**
+ * Get all the receive hardware out of the path.
+ */
+static void ReceivePathOff(void){
+    SetRXAttenuation( 31.5 );
+    RXBypassBPF(); // BPF out of RX path
+    // Set calFeedbackState to LO
+    DisableCalFeedback();
+}
+
+static void SSBTransmitReceivePathOff(void){
+    // We are in SSB mode. The DSP chain uses g to set gain, we can ignore it. Here we
+    // just determine whether to switch in the 100W PA.
+    // In calibration modes, ED.PA100Wactive is already set correctly
+    // and we don't need to calculate gain
+    if (modeSM.state_id != ModeSm_StateId_CALIBRATE_OFFSET_MARK) {
+        CalculateSSBTXGain(ED.powerOutSSB[ED.currentBand[ED.activeVFO]],&ED.PA100Wactive);
+    }
+    ReceivePathOff();
+}
+
+/**
+ * Configure the SSB transmit chain, except for the T/R relay. The transmit
+ * attenuation is left to the caller.
+ */
+static void SSBTransmitPathOn(void){
+    // Set clockEnableCW to LO
+    DisableCWVFOOutput();
+    // Set cwState to LO
+    CWoff();
+    UpdateTuneState();
+    // Set driveCurrentSSB_mA to appropriate value
+    // > This does not change after initialization, so do nothing
+    // Set clockEnableSSB to HI
+    EnableRXVFOOutput();
+    EnableTXVFOOutput();
+    // Set modulationState to HI (SSB)
+    SelectTXSSBModulation();
+
+    TXSelectBPF(); // BPF in to TX path
+    BypassXVTR();  // Bypass XVTR
+    SelectPA();
+}
+
+static void SSBTransmitPathOnNoAttenuation(void){
+    SetTXAttenuation( 0 ); // Always 0 in SSB mode. Gain is set in DSP chain.
+    SSBTransmitPathOn();
+}
+
+static void CalTransmitIQReceivePathOff(void){
+    SetRXAttenuation( 31.5 );
+    SetTXAttenuation( 31.5 );
+    RXBypassBPF(); // BPF out of RX path
+    // Set calFeedbackState to HI
+    EnableCalFeedback();
+}
+
+/**
+ * Start the transmit chain but route the signal away from the T/R switch to
+ * minimize the possibility of multiple receive paths.
+ */
+static void CalTransmitIQPathOn(void){
+    // Set clockEnableCW to LO
+    DisableCWVFOOutput();
+    // Set cwState to LO
+    CWoff();
+    UpdateTuneState();
+    // Set clockEnableSSB to HI
+    EnableRXVFOOutput();
+    EnableTXVFOOutput();
+    // Set modulationState to HI (SSB)
+    SelectTXSSBModulation();
+    TXBypassBPF(); // BPF out of TX path
+    SelectXVTR(); // send the signal on a path away from the T/R switch
+    Bypass100WPA();
+}
+
+/**
+ * Configure the CW transmit chain and switch the T/R relay to transmit with
+ * the carrier still off.
+ */
+static void CWTransmitPathOn(void){
+    RXBypassBPF(); // BPF out of RX path
+    // Set calFeedbackState to LO
+    DisableCalFeedback();
+    // Set GPB state to appropriate value
+    if ((cwAttenuation_dB >= 0) && (cwAttenuation_dB < 32))
+        SetTXAttenuation( cwAttenuation_dB );
+    else
+        SetTXAttenuation( ED.XAttenCW[ED.currentBand[ED.activeVFO]] );
+    // Set clockEnableSSB to LO
+    DisableRXVFOOutput();
+    DisableTXVFOOutput();
+    // Set frequencyCW_Hz to appropriate value
+    UpdateTuneState();
+    // Set driveCurrentCW_mA to appropriate value
+    // > This does not change after initialization, so do nothing
+    // Set clockEnableCW to HI
+    EnableCWVFOOutput();
+    // Set modulationState to LO (CW)
+    SelectTXCWModulation();
+    TXSelectBPF(); // BPF in to TX path
+    BypassXVTR();  // Bypass XVTR
+    SelectPA();
+    // Set rxtxState to HI (TX)
+    SelectTXMode();
+}
+
+static void CWMarkOn(void){
+    DisableCalFeedback();
+    // Set cwState to HI
+    CWon();
+}
+
+static void CWSpaceOn(void){
+    // Set cwState to LO
+    CWoff();
+    EnableCalFeedback(); // reduce the power even more
+}
+
+static void CalReceiveIQPathOn(void){
+    // Set frequency
+    RXSelectBPF(); // BPF in to RX path
+    UpdateTuneState();
+    // Set GPA state to appropriate value
+    SetRXAttenuation( 31.5 );
+    // Set clockEnableSSB to HI (SSB)
+    EnableRXVFOOutput();
+    SelectTXCWModulation();
+    // Make sure calFeedbackState is HI
+    EnableCalFeedback();
+}
+
+static void CalReceiveIQToneOn(void){
+    // Set rxtxState to LO (RX)
+    SelectRXMode();
+    // Set clockEnableCW to HI
+    EnableCWVFOOutput();
+    // Set cwState to HI
+    CWon();
+    // Set the zoom for the FFT to 1:
+    ED.spectrum_zoom = 0;
+    ZoomFFTPrep(ED.spectrum_zoom, &RXfilters);
+}
+
+// The settling times after the transmit path is turned off and after the receive
+// path is configured are probably unnecessary. The T/R relay takes about 6 ms to
+// switch; wait a little longer.
+static const RFSequenceStep receiveSequence[] = {
+    {TransmitPathOff, 10},
+    {ReceivePathOn, 10},
+    {SelectRXMode, 20},
+    {SetMaxTXAttenuation, 0},
+};
+
+static const RFSequenceStep transmitSequence[] = {
+    {SSBTransmitReceivePathOff, 10},
+    {SSBTransmitPathOnNoAttenuation, 10},
+    {SelectTXMode, 0},
+};
+
+// The transmit attenuation is set by the calibration loop
+static const RFSequenceStep calTransmitIQSingleVFOSequence[] = {
+    {ReceivePathOff, 10},
+    {SSBTransmitPathOn, 10},
+    {SelectTXMode, 0},
+};
+
+static const RFSequenceStep calTransmitIQSequence[] = {
+    {CalTransmitIQReceivePathOff, 10},
+    {CalTransmitIQPathOn, 10},
+    {SelectTXMode, 0},
+};
+
+// Wait for the T/R relay to switch before we turn the CW signal on
+static const RFSequenceStep cwMarkSequence[] = {
+    {CWTransmitPathOn, 20},
+    {CWMarkOn, 0},
+};
+
+static const RFSequenceStep cwSpaceSequence[] = {
+    {CWTransmitPathOn, 0},
+    {CWSpaceOn, 0},
+};
+
+// Between a CW mark and a CW space, only the carrier changes
+static const RFSequenceStep cwMarkFromSpaceSequence[] = {
+    {CWMarkOn, 0},
+};
+
+static const RFSequenceStep cwSpaceFromMarkSequence[] = {
+    {CWSpaceOn, 0},
+};
+
+static const RFSequenceStep calReceiveIQSequence[] = {
+    {TransmitPathOff, 10},
+    {CalReceiveIQPathOn, 10},
+    {CalReceiveIQToneOn, 0},
+};
+
+#define SEQUENCE(steps) do { sequenceSteps = steps; sequenceLength = sizeof(steps)/sizeof(steps[0]); } while (0)
+
+/**
+ * Run steps of the current sequence until one needs time to settle or the
+ * sequence ends. At the end, start the sequence for a state that was requested
+ * while this one was running.
+ */
+static void StartRFSequence(RFHardwareState newState);
+
+static void RunSequenceSteps(void){
+    while (sequenceIndex < sequenceLength){
+        const RFSequenceStep *step = &sequenceSteps[sequenceIndex++];
+        // Send the expander changes of the whole step together
+        BeginExpanderBatch();
+        step->action();
+        EndExpanderBatch();
+        if (step->settle_ms > 0){
+            sequenceWait_ms = step->settle_ms;
+            return;
+        }
+    }
+    // Stay busy when chaining into the pending state so that nobody sees the
+    // sequencer idle in between
+    __disable_irq();
+    RFHardwareState next = pendingState;
+    pendingState = RFInvalid;
+    if (next == RFInvalid)
+        sequenceBusy = false;
+    __enable_irq();
+    if (next != RFInvalid){
+        StartRFSequence(next);
+    } else if (retunePending){
+        // The frequency changed while the sequence was running
+        retunePending = false;
+        UpdateTuneState();
+    }
+}
+
 /**
- * @brief Execute hardware configuration changes for a new RF state
+ * @brief Start the hardware sequence that enters a new RF state
  *
  * Implements the detailed hardware sequencing required to transition into a new
  * RF hardware state. Follows state transition diagrams in T41_V12_board_api.drawio.
  *
- * The function performs carefully ordered operations to ensure safe transitions:
+ * The sequences perform carefully ordered operations to ensure safe transitions:
  * - When entering RFReceive: Power down TX path first, then enable RX path
  * - When entering RFTransmit/RFCWMark: Disable RX path first, then configure TX
- * - Includes appropriate delays for relay settling and PIN diode switching
+ * - Include settling times for relay and PIN diode switching
  *
  * Special optimization: Transitions between RFCWMark and RFCWSpace only toggle
  * the CW carrier on/off without reconfiguring the entire TX chain.
@@ -187,324 +506,153 @@ RFHardwareState GetRFHardwareState(void){
  * @param newState The target RF hardware state to configure
  *
  * @note If newState matches the previous state, only updates tune state (frequency)
- * @note Uses MyDelay() for hardware settling times (relay: 50ms typical)
+ * @note Returns once the first step has run. The remaining steps are run by
+ *       ServiceRFHardwareSequence(). A state requested while a sequence is running
+ *       is entered when that sequence ends
  */
 void HandleRFHardwareStateChange(RFHardwareState newState){
+    __disable_irq();
+    if (sequenceBusy){
+        // Only the latest request matters. Requesting the state we are already
+        // heading to cancels any other pending state.
+        pendingState = (newState == oldrfHardwareState) ? RFInvalid : newState;
+        __enable_irq();
+        return;
+    }
+    // Claim the sequencer before a CW state entry made by the keyer in tick1ms()
+    // can start one of its own
+    sequenceBusy = true;
+    __enable_irq();
+    StartRFSequence(newState);
+}
+
+/**
+ * Pick the steps that enter newState and run the first of them. Called with
+ * the sequencer already claimed.
+ */
+static void StartRFSequence(RFHardwareState newState){
     if (newState == oldrfHardwareState){
+        sequenceBusy = false;
         UpdateTuneState();
         return;
     }
-    // Following the state diagrams in T41_V12_board_api.drawio, implement the actions
+    // Following the state diagrams in T41_V12_board_api.drawio, pick the steps
     // required to enter the new state.
     switch (newState){
         case RFReceive:{
-            // First, do things that reduce the transmitted power
-
-            // Set cwState to LO                             //  Duration | Total
-            CWoff();                                            // <<1ms  | < 1ms
-            // Set clockEnableCW to LO
-            DisableCWVFOOutput();                               // ~ 1ms  | < 2ms
-            if (HasDualVFOs()){
-                DisableTXVFOOutput();
-            }
-            SetTXAttenuation(31.5);                             // ~ 1ms  | < 3ms
-            TXBypassBPF(); // BPF out of TX path                // ~ 1ms  | < 4ms
-            SelectXVTR();  // Shunt the TX path to nothing      // ~ 1ms  | < 5ms
-            Bypass100WPA(); // always bypassed                  // 0 ms   | < 5ms
-            // Wait to make sure all the above have happened
-            // This settling time is probably unnecessary
-            MyDelay(10);                                        // 10ms   | <15 ms  
-            
-            // Now, switch in the receive path hardware
-            // Set frequency
-            RXSelectBPF(); // BPF in to RX path                 // ~1ms   | <16 ms
-            UpdateTuneState();
-            // Set GPA state to appropriate value
-            SetRXAttenuation( ED.RAtten[ED.currentBand[ED.activeVFO]] );
-            // Set driveCurrentSSB_mA to appropriate value
-            // > This does not change after initialization, so do nothing
-            // Set clockEnableSSB to HI (SSB)
-            EnableRXVFOOutput();
-            SelectTXSSBModulation();
-            // Make sure calFeedbackState is LO
-            DisableCalFeedback();
-            // Wait to make sure all these changes have happened
-            // This settling time is probably unnecessary
-            MyDelay(10);
-            // Set rxtxState to LO (RX)
-            SelectRXMode();
-            // Wait for the relay to switch. This takes about 6 ms. Wait a little longer
-            MyDelay(20);
-            SetTXAttenuation( 31.5 );
+            SEQUENCE(receiveSequence);
             break;
         }
         case RFTransmit:{
-            // We are in SSB mode. The DSP chain uses g to set gain, we can ignore it. Here we
-            // just determine whether to switch in the 100W PA.
-            if (modeSM.state_id != ModeSm_StateId_CALIBRATE_OFFSET_MARK) {
-                CalculateSSBTXGain(ED.powerOutSSB[ED.currentBand[ED.activeVFO]],&ED.PA100Wactive);
-            }
-
-            // In calibration modes, ED.PA100Wactive is already set correctly
-            // and we don't need to calculate gain
-            SetRXAttenuation( 31.5 );
-
-            // Get all the receive hardware out of the path
-            RXBypassBPF(); // BPF out of RX path
-            // Set calFeedbackState to LO
-            DisableCalFeedback();
-            MyDelay(10);
-
-            // Start configuring the transmit chain
-            // Set GPB state to appropriate value
-            SetTXAttenuation( 0 ); // Always 0 in SSB mode. Gain is set in DSP chain.
-            // Set clockEnableCW to LO
-            DisableCWVFOOutput();
-            // Set cwState to LO
-            CWoff();
-            UpdateTuneState();
-            // Set driveCurrentSSB_mA to appropriate value
-            // > This does not change after initialization, so do nothing
-            // Set clockEnableSSB to HI
-            EnableRXVFOOutput();
-            EnableTXVFOOutput();
-            // Set modulationState to HI (SSB)
-            SelectTXSSBModulation();
-            
-            TXSelectBPF(); // BPF in to TX path
-            BypassXVTR();  // Bypass XVTR
-            if (ED.PA100Wactive)
-                Select100WPA();
-            else
-                Bypass100WPA();
-
-            MyDelay(10);
-            // Set rxtxState to HI (TX)
-            SelectTXMode();
-            
+            SEQUENCE(transmitSequence);
             break;
         }
         // This is the RF transmit IQ case where we have to use an external spectrum
         // analyzer to measure the image rejection
         case RFCalTransmitIQSingleVFO:{
-            SetRXAttenuation( 31.5 );
-
-            // Get all the receive hardware out of the path
-            RXBypassBPF(); // BPF out of RX path
-            // Set calFeedbackState to LO
-            DisableCalFeedback();
-            MyDelay(10);
-
-            // Start configuring the transmit chain
-            // Don't mess with the transmit attenuation, this is set by the 
-            // calibration loop
-
-            // Set clockEnableCW to LO
-            DisableCWVFOOutput();
-            // Set cwState to LO
-            CWoff();
-            UpdateTuneState();
-            // Set driveCurrentSSB_mA to appropriate value
-            // > This does not change after initialization, so do nothing
-            // Set clockEnableSSB to HI
-            EnableRXVFOOutput();
-            EnableTXVFOOutput();
-            // Set modulationState to HI (SSB)
-            SelectTXSSBModulation();
-            
-            TXSelectBPF(); // BPF in to TX path
-            BypassXVTR();  // Bypass XVTR
-            if (ED.PA100Wactive)
-                Select100WPA();
-            else
-                Bypass100WPA();
-
-            MyDelay(10);
-            // Set rxtxState to HI (TX)
-            SelectTXMode();
-            
+            SEQUENCE(calTransmitIQSingleVFOSequence);
             break;
         }
         case RFCalTransmitIQ:{
-            SetRXAttenuation( 31.5 );
-            SetTXAttenuation( 31.5 );
-
-            // Get all the receive hardware out of the path
-            RXBypassBPF(); // BPF out of RX path
-            // Set calFeedbackState to LO
-            EnableCalFeedback();
-            MyDelay(10);
-
-            // Start configuring the transmit chain
-            // Set clockEnableCW to LO
-            DisableCWVFOOutput();
-            // Set cwState to LO
-            CWoff();
-            UpdateTuneState();
-            // Set driveCurrentSSB_mA to appropriate value
-            // > This does not change after initialization, so do nothing
-            // Set clockEnableSSB to HI
-            EnableRXVFOOutput();
-            EnableTXVFOOutput();
-            // Set modulationState to HI (SSB)
-            SelectTXSSBModulation();
-            
-            // Configure the signal routing on the LPF board to minimize the possiblity of 
-            // multiple receive paths
-            TXBypassBPF(); // BPF out of TX path
-            SelectXVTR(); // send the signal on a path away from the T/R switch
-            Bypass100WPA();
-            MyDelay(10);
-            // Set rxtxState to HI (TX)
-            SelectTXMode();
-            
-            break;
-        }
-        case RFCWMark:{
-            // If we come from the RFCWSpace state, we only have to change one thing
-            if (oldrfHardwareState != RFCWSpace){
-                float32_t att_dB;
-                if (modeSM.state_id == ModeSm_StateId_CALIBRATE_POWER_MARK) {
-                    // In power calibration mode, use manual attenuation setting
-                    // and don't override PA selection
-                    att_dB = ED.XAttenCW[ED.currentBand[ED.activeVFO]];
-                } else {
-                    // Normal operation: calculate attenuation based on power level
-                    att_dB = CalculateCWAttenuation(ED.powerOutCW[ED.currentBand[ED.activeVFO]],&ED.PA100Wactive);
-                }
-
-                RXBypassBPF(); // BPF out of RX path
-                // Set calFeedbackState to LO
-                DisableCalFeedback();
-                // Set GPB state to appropriate value
-                if ((att_dB >= 0) && (att_dB < 32))
-                    SetTXAttenuation( att_dB );
-                else
-                    SetTXAttenuation( ED.XAttenCW[ED.currentBand[ED.activeVFO]] );
-                // Set clockEnableSSB to LO
-                DisableRXVFOOutput();
-                DisableTXVFOOutput();
-                // Set frequencyCW_Hz to appropriate value
-                UpdateTuneState();
-                // Set driveCurrentCW_mA to appropriate value
-                // > This does not change after initialization, so do nothing
-                // Set clockEnableCW to HI
-                EnableCWVFOOutput();
-                // Set modulationState to LO (CW)
-                SelectTXCWModulation();
-                TXSelectBPF(); // BPF in to TX path
-                BypassXVTR();  // Bypass XVTR
-                if (ED.PA100Wactive)
-                    Select100WPA();
-                else
-                    Bypass100WPA();
-                // Set rxtxState to HI (TX)
-                SelectTXMode();
-                // Potential issue here if we don't wait for the relay to switch before
-                // we turn the CW signal on.
-                MyDelay(20);
-            }
-            DisableCalFeedback();
-            // Set cwState to HI
-            CWon();
+            SEQUENCE(calTransmitIQSequence);
             break;
         }
+        case RFCWMark:
         case RFCWSpace:{
-            // If we come from the RFCWMark state, we only have to change one thing
-            if (oldrfHardwareState != RFCWMark){
-                float32_t att_dB;
-                if (modeSM.state_id == ModeSm_StateId_CALIBRATE_POWER_SPACE) {
-                    // In power calibration mode, use manual attenuation setting
-                    // and don't override PA selection
-                    att_dB = ED.XAttenCW[ED.currentBand[ED.activeVFO]];
+            // If we come from the other CW state, we only have to change one thing
+            if ((oldrfHardwareState == RFCWMark) || (oldrfHardwareState == RFCWSpace)){
+                if (newState == RFCWMark){
+                    SEQUENCE(cwMarkFromSpaceSequence);
                 } else {
-                    // Normal operation: calculate attenuation based on power level
-                    att_dB = CalculateCWAttenuation(ED.powerOutCW[ED.currentBand[ED.activeVFO]],&ED.PA100Wactive);
+                    SEQUENCE(cwSpaceFromMarkSequence);
                 }
-
-                RXBypassBPF(); // BPF out of RX path
-                // Set calFeedbackState to LO
-                DisableCalFeedback();
-                // Set GPB state to appropriate value
-                if ((att_dB >= 0) && (att_dB < 32))
-                    SetTXAttenuation( att_dB );
-                else
-                    SetTXAttenuation( ED.XAttenCW[ED.currentBand[ED.activeVFO]] );
-                // Set clockEnableSSB to LO
-                DisableRXVFOOutput();
-                DisableTXVFOOutput();
-                // Set frequencyCW_Hz to appropriate value
-                //SetCWVFOFrequency( GetCWTXFreq_dHz() );
-                UpdateTuneState();
-                // Set driveCurrentCW_mA to appropriate value
-                // > This does not change after initialization, so do nothing
-                // Set clockEnableCW to HI
-                EnableCWVFOOutput();
-                // Set modulationState to LO (CW)
-                SelectTXCWModulation();
-                TXSelectBPF(); // BPF in to TX path
-                BypassXVTR();  // Bypass XVTR
-                if (ED.PA100Wactive)
-                    Select100WPA();
-                else
-                    Bypass100WPA();
-                // Set rxtxState to HI (TX)
-                SelectTXMode();
+                break;
+            }
+            if ((modeSM.state_id == ModeSm_StateId_CALIBRATE_POWER_MARK) ||
+                (modeSM.state_id == ModeSm_StateId_CALIBRATE_POWER_SPACE)) {
+                // In power calibration mode, use manual attenuation setting
+                // and don't override PA selection
+                cwAttenuation_dB = ED.XAttenCW[ED.currentBand[ED.activeVFO]];
+            } else {
+                // Normal operation: calculate attenuation based on power level
+                cwAttenuation_dB = CalculateCWAttenuation(ED.powerOutCW[ED.currentBand[ED.activeVFO]],&ED.PA100Wactive);
+            }
+            if (newState == RFCWMark){
+                SEQUENCE(cwMarkSequence);
+            } else {
+                SEQUENCE(cwSpaceSequence);
             }
-            // Set cwState to LO
-            CWoff();
-            EnableCalFeedback(); // reduce the power even more
             break;
         }
         case RFCalReceiveIQ:{
-
-            // Turn these off just in case we somehow entered from CW Transmit Mode
-            // Set cwState to LO
-            CWoff();
-            // Set clockEnableCW to LO
-            DisableCWVFOOutput();
-            if (HasDualVFOs())
-                DisableTXVFOOutput();
-            SetTXAttenuation(31.5);
-            TXBypassBPF(); // BPF out of TX path
-            SelectXVTR();  // Shunt the TX path to nothing
-            Bypass100WPA(); // always bypassed
-            MyDelay(10);
-
-            // Now, switch in the receive path hardware
-            // Set frequency
-            RXSelectBPF(); // BPF in to RX path
-            UpdateTuneState();
-            // Set GPA state to appropriate value
-            SetRXAttenuation( 31.5 );
-            // Set driveCurrentSSB_mA to appropriate value
-            // > This does not change after initialization, so do nothing
-            // Set clockEnableSSB to HI (SSB)
-            EnableRXVFOOutput();
-            SelectTXCWModulation();
-            // Make sure calFeedbackState is HI
-            EnableCalFeedback();
-            // Wait to make sure all these changes have happened
-            MyDelay(10);
-            // Set rxtxState to LO (RX)
-            SelectRXMode();
-            
-            // Set clockEnableCW to HI
-            EnableCWVFOOutput();
-            // Set cwState to HI
-            CWon();
-
-            // Set the zoom for the FFT to 1:
-            ED.spectrum_zoom = 0;
-            ZoomFFTPrep(ED.spectrum_zoom, &RXfilters);
+            // Turn the transmit path off just in case we somehow entered from CW Transmit Mode
+            SEQUENCE(calReceiveIQSequence);
             break;
         }
         case RFInvalid:{
             Debug("Asked to handle RFInvalid state, doing nothing.");
-            break;
+            sequenceBusy = false;
+            return;
         }
     }
     oldrfHardwareState = newState;
+    sequenceIndex = 0;
+    sequenceWait_ms = 0;
+    sequenceStepDue = false;
+    RunSequenceSteps();
+}
+
+/**
+ * @brief Advance the T/R sequence by one millisecond
+ *
+ * Counts down the settle time of the last step of the sequence started by
+ * HandleRFHardwareStateChange(). When it has passed, the next steps are left
+ * for ServiceRFHardwareSequence() so that their I2C traffic stays out of the
+ * interrupt. Runs no steps itself.
+ *
+ * @note Called from tick1ms() through TickRFHardwareAndModeSm()
+ */
+void TickRFHardwareSequence(void){
+    // sequenceWait_ms is zero while steps are being run from the main loop
+    if (!sequenceBusy || (sequenceWait_ms == 0)) return;
+    if (--sequenceWait_ms > 0) return;
+    sequenceStepDue = true;
+}
+
+/**
+ * @brief Run the T/R sequence steps whose settle time has passed
+ *
+ * @note Called from the main loop
+ */
+void ServiceRFHardwareSequence(void){
+    if (!sequenceStepDue) return;
+    sequenceStepDue = false;
+    RunSequenceSteps();
+}
+
+/**
+ * @brief 1 ms tick of the T/R sequencer and the mode state machine
+ *
+ * Count down the settle time of a running T/R sequence, and hold the keyer
+ * timers while the T/R relays settle so a CW element is not shortened by the
+ * switching time. The mode state machine may enter a CW state here, which
+ * runs the first step of a new sequence from the interrupt.
+ *
+ * @note Called from tick1ms()
+ */
+void TickRFHardwareAndModeSm(void){
+    bool settling = IsRFHardwareSequenceBusy();
+    TickRFHardwareSequence();
+    if (!settling)
+        ModeSm_dispatch_event(&modeSM, ModeSm_EventId_DO);
+}
+
+/**
+ * @brief Check whether a T/R sequence is still running
+ * @return true until the last step of the sequence has run
+ */
+bool IsRFHardwareSequenceBusy(void){
+    return sequenceBusy;
 }
 
 /**
@@ -531,8 +679,11 @@ void HandleRFHardwareStateChange(RFHardwareState newState){
 void UpdateRFHardwareState(void){
     if (modeSM.state_id == previousRadioState){
         // Already in this state, no need to change RF hardware, though the
-        // tuning might have changed.
-        UpdateTuneState();
+        // tuning might have changed. Wait for a running T/R sequence to end.
+        if (IsRFHardwareSequenceBusy())
+            retunePending = true;
+        else
+            UpdateTuneState();
         return;
     }
     // Several transceiver states map to the same RF board state. Handle this mapping
@@ -639,6 +790,8 @@ void TuneForReceiveIQCalibration(void){
 void HandleTuneState(TuneState tuneState){
     if (tuneState == TuneInvalid) return;
     
+    // One write per expander for the PA, filter and antenna changes
+    BeginExpanderBatch();
     if (ED.PA100Wactive)
         Select100WPA();
     else
@@ -646,6 +799,7 @@ void HandleTuneState(TuneState tuneState){
     SelectLPFBand(ED.currentBand[ED.activeVFO]);
     SelectBPFBand(ED.currentBand[ED.activeVFO]);
     SelectAntenna(ED.antennaSelection[ED.currentBand[ED.activeVFO]]);
+    EndExpanderBatch();
     UpdateFIRFilterMask(&RXfilters);
     switch (tuneState){
         case TuneReceive:{
@@ -45,6 +45,10 @@ ModeSm_StateId GetRFHardwarePreviousState(void);
 void UpdateRFHardwareState(void);
 void ForceUpdateRFHardwareState(void);
 void HandleRFHardwareStateChange(RFHardwareState newState);
+void TickRFHardwareSequence(void);
+void ServiceRFHardwareSequence(void);
+void TickRFHardwareAndModeSm(void);
+bool IsRFHardwareSequenceBusy(void);
 errno_t InitializeRFHardware(void);
 void UpdateTuneState(void);
 RFHardwareState GetRFHardwareState(void);
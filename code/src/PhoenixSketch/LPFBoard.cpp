@@ -78,10 +78,10 @@ static AD7991 swrADC;
 #define LPF_GPA_STATE (uint8_t)((hardwareRegister >> 8) & 0x00000003)   // Bits 8 & 9
 #define LPF_GPB_STATE (uint8_t)(hardwareRegister & 0x000000FF)          // Lowest byte
 
-#define SET_LPF_GPA(val) (hardwareRegister = (hardwareRegister & 0xFFFFFCFF) | (((uint64_t)val & 0x00000003) << 8));buffer_add()
-#define SET_LPF_GPB(val) (hardwareRegister = (hardwareRegister & 0xFFFFFF00) | ((uint64_t)val  & 0x000000FF));buffer_add()
-#define SET_LPF_BAND(val) (hardwareRegister = (hardwareRegister & 0xFFFFFFF0) | ((uint64_t)val & 0x0000000F));buffer_add()
-#define SET_ANTENNA(val) (hardwareRegister = (hardwareRegister & 0xFFFFFFCF) | (((uint64_t)val & 0x00000003) << 4));buffer_add()
+#define SET_LPF_GPA(val) (hardwareRegister = (hardwareRegister & 0xFFFFFFFFFFFFFCFFULL) | (((uint64_t)val & 0x00000003) << 8));buffer_add()
+#define SET_LPF_GPB(val) (hardwareRegister = (hardwareRegister & 0xFFFFFFFFFFFFFF00ULL) | ((uint64_t)val  & 0x000000FF));buffer_add()
+#define SET_LPF_BAND(val) (hardwareRegister = (hardwareRegister & 0xFFFFFFFFFFFFFFF0ULL) | ((uint64_t)val & 0x0000000F));buffer_add()
+#define SET_ANTENNA(val) (hardwareRegister = (hardwareRegister & 0xFFFFFFFFFFFFFFCFULL) | (((uint64_t)val & 0x00000003) << 4));buffer_add()
 
 ///////////////////////////////////////////////////////////////////////////////
 // Unit Testing Helper Functions
@@ -107,7 +107,7 @@ uint16_t GetLPFRegisterState(void) {
  * @param value The 10-bit value to set (only lower 10 bits used)
  */
 void SetLPFRegisterState(uint16_t value) {
-    hardwareRegister = (hardwareRegister & 0xFFFFFC00) | (value & 0x03FF);
+    hardwareRegister = (hardwareRegister & 0xFFFFFFFFFFFFFC00ULL) | (value & 0x03FF);
 }
 
 /**
@@ -272,23 +272,29 @@ uint16_t GetLPFMCPRegisters(void){
 }
 
 /**
- * Update MCP23017 hardware registers if they differ from cached values.
+ * Write the MCP23017 ports that differ from the cached values.
  *
- * Implements write-on-change optimization to minimize I2C bus traffic.
  * Compares desired register states (from hardwareRegister) with cached
- * previous states (mcpA_old, mcpB_old) and only writes if changed.
+ * previous states (mcpA_old, mcpB_old) and writes only the ports that changed,
+ * both in one transaction if needed.
  *
- * Called after any hardware register modification to push changes to physical hardware.
+ * Called by the expander write queue.
+ *
+ * @return Number of I2C transactions used
+ */
+uint8_t FlushLPFMCPRegisters(void){
+    return WriteMCPPorts(mcpLPF, LPF_GPA_STATE, LPF_GPB_STATE, &mcpA_old, &mcpB_old);
+}
+
+/**
+ * Push hardware register changes to the MCP23017.
+ *
+ * Called after any hardware register modification. The write happens at once
+ * unless an expander batch is open, in which case it is sent, together with
+ * any other changes to this board, when the batch ends.
  */
 void UpdateMCPRegisters(void){
-    if (mcpA_old != LPF_GPA_STATE){
-        mcpLPF.writeGPIOA(LPF_GPA_STATE); 
-        mcpA_old = LPF_GPA_STATE;
-    }
-    if (mcpB_old != LPF_GPB_STATE){
-        mcpLPF.writeGPIOB(LPF_GPB_STATE); 
-        mcpB_old = LPF_GPB_STATE;
-    }
+    RequestExpanderWrite(EXPANDER_LPF);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -159,10 +159,18 @@ uint8_t BandToBCD(int32_t band);
 
 /**
  * @brief Update MCP23017 GPIO registers with current state
- * @note Writes cached register values to hardware via I2C
+ * @note Writes cached register values to hardware via I2C, deferred while an
+ *       expander batch is open
  */
 void UpdateMCPRegisters(void);
 
+/**
+ * @brief Write the MCP23017 ports that differ from the cached values
+ * @return Number of I2C transactions used
+ * @note Called by the expander write queue
+ */
+uint8_t FlushLPFMCPRegisters(void);
+
 // For unit testing - access to internal register state
 
 /**
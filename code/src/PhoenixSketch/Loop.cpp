@@ -1507,6 +1507,10 @@ FASTRUN void loop(void){
     CheckForCATSerialEvents();
     CheckForSerialTimeSync();
     ConsumeInterrupt();
+    // Run the T/R sequence step and finish the VFO quadrature setup whose
+    // wait has passed
+    ServiceRFHardwareSequence();
+    ServiceVFOQuadrature();
 
     // Step 2: Perform signal processing
     PerformSignalProcessing();
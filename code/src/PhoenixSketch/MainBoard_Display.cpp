@@ -69,6 +69,87 @@ void BlankBox(Rectangle *rect){
     tft.fillRect(rect->x0, rect->y0, rect->width, rect->height, RA8875_BLACK);
 }
 
+/**
+ * Get the glyph of a character, or NULL if the font does not have it.
+ */
+static const GFXglyph *FontGlyph(const GFXfont *font, char c){
+    if (((uint8_t)c < font->first) || ((uint8_t)c > font->last))
+        return NULL;
+    return &font->glyph[(uint8_t)c - font->first];
+}
+
+/**
+ * Check whether a glyph is drawn entirely inside its advance width, so that it
+ * can be erased without touching its neighbours.
+ */
+static bool GlyphInCell(const GFXglyph *glyph){
+    return (glyph->xOffset >= 0) && (glyph->xOffset + glyph->width <= glyph->xAdvance);
+}
+
+/**
+ * Draw a line of GFX font text, rendering only the characters that changed.
+ *
+ * The MCU rasterizes every GFX glyph it prints, so a frequency display that
+ * reprints ten large digits for each tuning step spends most of its time on
+ * digits that did not change. When the new text has the same length, and each
+ * character has the same advance width as the one it replaces, every character
+ * keeps its position and only the changed cells are erased and reprinted.
+ */
+void DrawTextRun(TextRun *run, const Rectangle *box, int16_t x, int16_t y,
+                 const void *font, uint16_t color, const char *text){
+    const GFXfont *gfx = (const GFXfont *)font;
+    size_t n = strlen(text);
+    if (n >= sizeof(run->text))
+        n = sizeof(run->text) - 1;
+
+    bool inPlace = (run->font == font) && (run->color == color) &&
+                   (run->x == x) && (run->y == y) && (strlen(run->text) == n);
+    for (size_t i = 0; inPlace && (i < n); i++){
+        if (run->text[i] == text[i]) continue;
+        const GFXglyph *was = FontGlyph(gfx, run->text[i]);
+        const GFXglyph *now = FontGlyph(gfx, text[i]);
+        inPlace = (was != NULL) && (now != NULL) && (was->xAdvance == now->xAdvance) &&
+                  GlyphInCell(was) && GlyphInCell(now);
+    }
+
+    tft.setFont(gfx);
+    tft.setTextColor(color);
+    if (inPlace){
+        int16_t cx = x;
+        char glyph[2] = {0, 0};
+        for (size_t i = 0; i < n; i++){
+            const GFXglyph *g = FontGlyph(gfx, text[i]);
+            uint8_t advance = (g != NULL) ? g->xAdvance : 0;
+            if (run->text[i] != text[i]){
+                tft.fillRect(cx, box->y0, advance, box->height, RA8875_BLACK);
+                tft.setCursor(cx, y);
+                glyph[0] = text[i];
+                tft.print(glyph);
+            }
+            cx += advance;
+        }
+    } else {
+        tft.fillRect(box->x0, box->y0, box->width, box->height, RA8875_BLACK);
+        tft.setCursor(x, y);
+        tft.print(text);
+    }
+
+    run->font = font;
+    run->color = color;
+    run->x = x;
+    run->y = y;
+    memcpy(run->text, text, n);
+    run->text[n] = '\0';
+}
+
+/**
+ * Forget the text on screen so that the next DrawTextRun() redraws it in full.
+ */
+void InvalidateTextRun(TextRun *run){
+    run->font = NULL;
+    run->text[0] = '\0';
+}
+
 /**
  * @brief Main BIT screen rendering function
  * @note Called from DrawDisplay() when in BIT UI state
@@ -24,10 +24,13 @@ If not, see <https://www.gnu.org/licenses/>.
 #define WINDOW_WIDTH    800
 #define WINDOW_HEIGHT   480
 #define DARKGREY 0x7BEF
+#define DISPLAY_BUDGET_US 4000  // default time allowed for drawing home screen panes per loop
 
 /**
  * Display pane structure for modular screen regions.
  * Each pane represents a rectangular area with its own draw function.
+ * The scheduling fields are used by the home screen, which draws its panes
+ * in priority order within a time budget.
  */
 struct Pane {
     uint16_t x0;            ///< Top-left X coordinate
@@ -36,6 +39,12 @@ struct Pane {
     uint16_t height;        ///< Height in pixels
     void (*DrawFunction)(void);  ///< Function to render this pane
     bool stale;             ///< True if pane needs redrawing
+    uint8_t priority = 0;       ///< Higher priority panes are drawn first
+    uint16_t refresh_ms = 0;    ///< Minimum time between calls while not stale, 0 for every loop
+    uint32_t redraw_us = 0;     ///< Measured time of a full redraw
+    uint32_t update_us = 0;     ///< Measured time of a call while not stale
+    uint32_t lastDraw_ms = 0;   ///< millis() at the last call
+    uint8_t deferred = 0;       ///< Consecutive loops the pane was passed over
 };
 
 /**
@@ -59,6 +68,16 @@ struct dispSc {
     uint16_t pixelsPerDB;         ///< Pixel height per dB
 };
 
+/**
+ * Colour palettes for the waterfall display (ED.waterfallPalette).
+ */
+enum WaterfallPalette {
+    WaterfallPaletteClassic = 0,  ///< Blue-green-yellow-red-magenta gradient
+    WaterfallPaletteGrey,         ///< Black to white
+    WaterfallPaletteHeat,         ///< Black-red-yellow-white
+    WaterfallPaletteCount
+};
+
 // Helper function declarations
 
 /**
@@ -81,6 +100,40 @@ void CalculateTextCorners(int16_t x0,int16_t y0,Rectangle *rect,int16_t Nchars,
  */
 void BlankBox(Rectangle *rect);
 
+/**
+ * A line of text drawn in a GFX font that remembers what is on screen, so that
+ * redrawing it only renders the characters that changed.
+ */
+struct TextRun {
+    const void *font;       ///< GFX font of the text on screen, NULL if unknown
+    uint16_t color;         ///< Text colour
+    int16_t x;              ///< Cursor X of the first character
+    int16_t y;              ///< Cursor Y of the first character
+    char text[16];          ///< Text on screen
+};
+
+/**
+ * @brief Draw text in a GFX font, rendering only the characters that differ from the screen
+ * @param run Record of the text on screen, updated on return
+ * @param box Area owned by the text, blanked when the whole line is redrawn
+ * @param x Cursor X of the first character
+ * @param y Cursor Y of the first character
+ * @param font GFX font to draw with
+ * @param color Text colour
+ * @param text Text to show, at most sizeof(TextRun::text)-1 characters
+ * @note Only a change of characters with the same advance width is drawn in place,
+ *       such as one frequency digit for another. A change of font, colour, position,
+ *       length or character spacing redraws the whole line
+ */
+void DrawTextRun(TextRun *run, const Rectangle *box, int16_t x, int16_t y,
+                 const void *font, uint16_t color, const char *text);
+
+/**
+ * @brief Forget what a text run has on screen, so that it is drawn in full next time
+ * @param run Text run whose area was cleared or drawn over
+ */
+void InvalidateTextRun(TextRun *run);
+
 /**
  * Variable type enumeration for type-safe parameter handling.
  * Used by VariableParameter to support different data types in menu system.
@@ -195,6 +248,46 @@ void InitializeDisplay(void);
  */
 void DrawHome(void);
 
+/**
+ * @brief Set the time allowed for drawing home screen panes in one call to DrawHome()
+ * @param budget_us Budget in microseconds
+ * @note Panes that do not fit are drawn by a later call. At least one pane is
+ *       drawn per call, so a small budget slows the display but never stops it
+ */
+void SetDisplayBudget_us(uint32_t budget_us);
+
+/**
+ * @brief Get the time allowed for drawing home screen panes in one call to DrawHome()
+ * @return Budget in microseconds
+ */
+uint32_t GetDisplayBudget_us(void);
+
+/**
+ * @brief Get the number of pane draws deferred to a later loop for lack of time
+ * @return Deferral count since startup
+ */
+uint32_t GetDeferredPaneDraws(void);
+
+/**
+ * @brief Mark the start of drawing a home screen pane
+ * @param pane Name of the pane about to be drawn, or NULL when pane drawing is finished
+ * @note Only called when compiled with DISPLAY_PANE_PROFILING defined. The implementation is
+ *       supplied by the host-side RA8875 test doubles, which attribute display commands to
+ *       the named pane, so the firmware build contains no profiling code.
+ */
+void DisplayPaneProfile(const char *pane);
+
+/**
+ * @brief Convert one PSD frame into a line of waterfall colours
+ * @param psd PSD bins, in the units of PSDFrame::bins
+ * @param line Output RGB565 colours, one per bin
+ * @param n Number of bins
+ * @note Maps power straight to colour through a lookup table built from ED.waterfallFloor_dBm,
+ *       ED.waterfallRange_dB and ED.waterfallPalette, independent of the spectrum scale and floor.
+ *       The table is rebuilt when any of these settings change.
+ */
+void WaterfallLine(const float32_t *psd, uint16_t *line, uint32_t n);
+
 /**
  * @brief Draw startup splash screen with logo and version
  * @note Displayed briefly during system initialization
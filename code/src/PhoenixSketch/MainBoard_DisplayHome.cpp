@@ -76,20 +76,20 @@ static void DrawSettingsPane(void);
 static void DrawNameBadgePane(void);
 static void DrawSAMOffsetPane(void);
 
-// Pane instances
-static Pane PaneVFOA =        {5,5,280,50,DrawVFOPanes,1};
-static Pane PaneVFOB =        {300,5,220,40,DrawVFOPanes,1};
-static Pane PaneFreqBandMod = {5,60,310,30,DrawFreqBandModPane,1};
-Pane PaneSpectrum =    {5,95,520,345,DrawSpectrumPane,1}; // this one is updated by menus
-static Pane PaneStateOfHealth={5,445,260,30,DrawStateOfHealthPane,1};
-static Pane PaneTime =        {270,445,260,30,DrawTimePane,1};
-static Pane PaneSWR =         {535,15,150,40,DrawSWRPane,1};
-static Pane PaneTXRXStatus =  {710,20,60,30,DrawTXRXStatusPane,1};
-static Pane PaneSMeter =      {515,60,260,50,DrawSMeterPane,1};
-static Pane PaneAudioSpectrum={535,115,260,150,DrawAudioSpectrumPane,1};
-static Pane PaneSettings =    {535,270,260,170,DrawSettingsPane,1};
-static Pane PaneNameBadge =   {535,445,260,30,DrawNameBadgePane,1};
-static Pane PaneSAMOffset =   {320,60,180,30,DrawSAMOffsetPane,1};
+// Pane instances: position, size, draw function, stale, priority, refresh_ms
+static Pane PaneVFOA =        {5,5,280,50,DrawVFOPanes,1,10,0};
+static Pane PaneVFOB =        {300,5,220,40,DrawVFOPanes,1,9,0};
+static Pane PaneFreqBandMod = {5,60,310,30,DrawFreqBandModPane,1,8,0};
+Pane PaneSpectrum =    {5,95,520,345,DrawSpectrumPane,1,6,0}; // this one is updated by menus
+static Pane PaneStateOfHealth={5,445,260,30,DrawStateOfHealthPane,1,2,0};
+static Pane PaneTime =        {270,445,260,30,DrawTimePane,1,1,0};
+static Pane PaneSWR =         {535,15,150,40,DrawSWRPane,1,3,250};
+static Pane PaneTXRXStatus =  {710,20,60,30,DrawTXRXStatusPane,1,9,0};
+static Pane PaneSMeter =      {515,60,260,50,DrawSMeterPane,1,5,0};
+static Pane PaneAudioSpectrum={535,115,260,150,DrawAudioSpectrumPane,1,4,0};
+static Pane PaneSettings =    {535,270,260,170,DrawSettingsPane,1,7,0};
+static Pane PaneNameBadge =   {535,445,260,30,DrawNameBadgePane,1,1,0};
+static Pane PaneSAMOffset =   {320,60,180,30,DrawSAMOffsetPane,1,4,0};
 
 // Array of all panes for iteration
 static Pane* WindowPanes[NUMBER_OF_PANES] = {&PaneVFOA,&PaneVFOB,&PaneFreqBandMod,
@@ -98,6 +98,18 @@ static Pane* WindowPanes[NUMBER_OF_PANES] = {&PaneVFOA,&PaneVFOB,&PaneFreqBandMo
                                     &PaneSMeter,&PaneAudioSpectrum,&PaneSettings,
                                     &PaneNameBadge, &PaneSAMOffset};
 
+// Attribution of display commands to panes is only compiled into the host test builds
+#ifdef DISPLAY_PANE_PROFILING
+#define PANE_PROFILE(name) DisplayPaneProfile(name)
+static const char *PaneNames[NUMBER_OF_PANES] = {"PaneVFOA","PaneVFOB","PaneFreqBandMod",
+                                    "PaneSpectrum","PaneStateOfHealth",
+                                    "PaneTime","PaneSWR","PaneTXRXStatus",
+                                    "PaneSMeter","PaneAudioSpectrum","PaneSettings",
+                                    "PaneNameBadge","PaneSAMOffset"};
+#else
+#define PANE_PROFILE(name)
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 // DISPLAY SCALE AND COLOR STRUCTURES (HOME SCREEN SPECIFIC)
 ///////////////////////////////////////////////////////////////////////////////
@@ -219,6 +231,8 @@ FASTRUN int16_t FreqToBin(int64_t freq_Hz){
 // State tracking for VFO display updates
 static int64_t TxRxFreq_old = 0;
 static uint8_t activeVFO_old = 10;
+static TextRun VFOAText;
+static TextRun VFOBText;
 
 /**
  * Render both VFO A and VFO B frequency displays.
@@ -228,6 +242,11 @@ void DrawVFOPanes(void) {
     if ((TxRxFreq == TxRxFreq_old) && (ED.activeVFO == activeVFO_old) &&
         (!PaneVFOA.stale) && (!PaneVFOB.stale))
         return;
+    // A pane marked stale from outside may have been cleared, so draw all its digits
+    if (PaneVFOA.stale)
+        InvalidateTextRun(&VFOAText);
+    if (PaneVFOB.stale)
+        InvalidateTextRun(&VFOBText);
     if ((ED.activeVFO != activeVFO_old) || (PaneSettings.stale)){
         PaneVFOA.stale = 1;
         PaneVFOB.stale = 1;
@@ -244,52 +263,51 @@ void DrawVFOPanes(void) {
     activeVFO_old = ED.activeVFO;
 
     int16_t pixelOffset;
+    uint16_t color;
     char freqBuffer[15];
 
     if (PaneVFOA.stale){
-        tft.fillRect(PaneVFOA.x0, PaneVFOA.y0, PaneVFOA.width, PaneVFOA.height, RA8875_BLACK);
+        Rectangle box = {PaneVFOA.x0, PaneVFOA.y0, PaneVFOA.width, PaneVFOA.height};
 
         TxRxFreq = GetTXRXFreq(0);
         if (TxRxFreq < bands[ED.currentBand[0]].fBandLow_Hz ||
             TxRxFreq > bands[ED.currentBand[0]].fBandHigh_Hz) {
-            tft.setTextColor(RA8875_RED);
+            color = RA8875_RED;
         } else {
-            tft.setTextColor(RA8875_GREEN);
+            color = RA8875_GREEN;
         }
         if (ED.activeVFO == 1)
-            tft.setTextColor(RA8875_LIGHT_GREY);
+            color = RA8875_LIGHT_GREY;
         pixelOffset = 0;
         if (TxRxFreq < 10000000L)
             pixelOffset = 13;
 
-        tft.setFont(&FreeSansBold24pt7b);
-        tft.setCursor(PaneVFOA.x0+pixelOffset, PaneVFOA.y0+10);
         FormatFrequency(TxRxFreq, freqBuffer);
-        tft.print(freqBuffer);
+        DrawTextRun(&VFOAText, &box, PaneVFOA.x0+pixelOffset, PaneVFOA.y0+10,
+                    &FreeSansBold24pt7b, color, freqBuffer);
         PaneVFOA.stale = false;
     }
 
     if (PaneVFOB.stale){
-        tft.fillRect(PaneVFOB.x0, PaneVFOB.y0, PaneVFOB.width, PaneVFOB.height, RA8875_BLACK);
+        Rectangle box = {PaneVFOB.x0, PaneVFOB.y0, PaneVFOB.width, PaneVFOB.height};
 
         TxRxFreq = GetTXRXFreq(1);
         if (TxRxFreq < bands[ED.currentBand[1]].fBandLow_Hz ||
             TxRxFreq > bands[ED.currentBand[1]].fBandHigh_Hz) {
-            tft.setTextColor(RA8875_RED);
+            color = RA8875_RED;
         } else {
-            tft.setTextColor(RA8875_GREEN);
+            color = RA8875_GREEN;
         }
         if (ED.activeVFO == 0)
-            tft.setTextColor(RA8875_LIGHT_GREY);
+            color = RA8875_LIGHT_GREY;
 
         pixelOffset = 0;
         if (TxRxFreq < 10000000L)
             pixelOffset = 8;
 
-        tft.setFont(&FreeSansBold18pt7b);
-        tft.setCursor(PaneVFOB.x0+pixelOffset, PaneVFOB.y0+10);
         FormatFrequency(TxRxFreq, freqBuffer);
-        tft.print(freqBuffer);
+        DrawTextRun(&VFOBText, &box, PaneVFOB.x0+pixelOffset, PaneVFOB.y0+10,
+                    &FreeSansBold18pt7b, color, freqBuffer);
         PaneVFOB.stale = false;
     }
 }
@@ -429,6 +447,20 @@ uint16_t pixelold[MAX_WATERFALL_WIDTH];
 uint16_t waterfall[MAX_WATERFALL_WIDTH];
 #define NCHUNKS 6
 
+// Dirty-column trace state. traceTop/traceBottom hold the span of each column as it
+// is currently drawn on L2 (top > bottom means nothing is drawn there). A column is
+// only redrawn when either end of its span moves by more than SPECTRUM_DIRTY_THRESHOLD
+// pixels, and only columns flagged in columnDirty are copied to L1 at sweep end.
+#define SPECTRUM_DIRTY_THRESHOLD 1          // pixels of movement ignored per column
+#define SPECTRUM_RUN_GAP 8                  // clean columns bridged when merging BTE runs
+static int16_t traceTop[MAX_WATERFALL_WIDTH];
+static int16_t traceBottom[MAX_WATERFALL_WIDTH];
+static bool columnDirty[MAX_WATERFALL_WIDTH];
+static bool spectrumBackgroundStale = true; // L2 needs a full clear before the next sweep
+static int16_t filterLeft = 0;              // screen x range of the filter highlight
+static int16_t filterRight = 0;
+static int16_t filterLine = 0;              // screen x of the cyan tuning line
+
 // S-meter constants (used by DisplaydbM function within spectrum rendering)
 #define SMETER_X PaneSMeter.x0+20
 #define SMETER_Y PaneSMeter.y0+24
@@ -484,6 +516,18 @@ FASTRUN void DrawBandWidthIndicatorBar(void){
     int16_t xRight = vline + (int16_t)(high_Hz * scale);
     tft.fillRect(xLeft, SPECTRUM_TOP_Y + 20, xRight - xLeft, SPECTRUM_HEIGHT - 20, FILTER_WIN);
     tft.drawFastVLine(vline, SPECTRUM_TOP_Y + 20, SPECTRUM_HEIGHT-25, RA8875_CYAN);
+
+    // The trace has been wiped: remember the new background so single columns can be
+    // erased later, and have every column redrawn and published by the next sweep.
+    filterLeft = xLeft;
+    filterRight = xRight;
+    filterLine = vline;
+    for (uint16_t x = 0; x < MAX_WATERFALL_WIDTH; x++){
+        traceTop[x] = 1;
+        traceBottom[x] = 0;
+        columnDirty[x] = true;
+    }
+    spectrumBackgroundStale = false;
 }
 
 /**
@@ -643,6 +687,7 @@ static int16_t middleSlice = centerLine / 2;
 static float32_t adjustment = 0.0f; // used by ED.spectrumFloorAuto
 static float32_t newadjust = 0.0f; // used by ED.spectrumFloorAuto
 static int16_t pixelmax = 0; // used by ED.spectrumFloorAuto
+static const PSDFrame *spectrumFrame = nullptr; // the frame being drawn, held for the whole sweep
 
 /**
  * Calculate vertical pixel position for a spectrum FFT bin. This is an
@@ -658,29 +703,163 @@ static int16_t pixelmax = 0; // used by ED.spectrumFloorAuto
  */
 FASTRUN int16_t pixelnew(uint32_t i){
     int16_t zeroPoint = -1*(int16_t)((-124.0 - RECEIVE_POWER_OFFSET)/10.0*displayScale[ED.spectrumScale].dBScale);
-    int16_t result = zeroPoint+(int16_t)(displayScale[ED.spectrumScale].dBScale*psdnew[i]);
+    int16_t result = zeroPoint+(int16_t)(displayScale[ED.spectrumScale].dBScale*spectrumFrame->bins[i]);
     return result;
 }
 
+/**
+ * Background colour of spectrum column x: the filter highlight or black.
+ */
+static FASTRUN uint16_t TraceBackground(int16_t x){
+    int16_t screenX = SPECTRUM_LEFT_X + x;
+    return ((screenX >= filterLeft) && (screenX < filterRight)) ? FILTER_WIN : RA8875_BLACK;
+}
+
+/**
+ * Redraw the adjacent trace columns [start, end) on L2. The old spans are erased
+ * with a single fillRect covering eraseTop..eraseBottom (all columns in a run share
+ * the same background colour), the cyan tuning line is restored if it passes
+ * through the run, and the new spans in traceTop/traceBottom are drawn.
+ */
+static FASTRUN void DrawTraceRun(int16_t start, int16_t end, int16_t eraseTop, int16_t eraseBottom, uint16_t colour){
+    // The bottom row of the pane border is yellow like the trace, so leave it alone
+    if (eraseBottom > SPECTRUM_TOP_Y + SPECTRUM_HEIGHT - 2)
+        eraseBottom = SPECTRUM_TOP_Y + SPECTRUM_HEIGHT - 2;
+    if (eraseBottom >= eraseTop){
+        tft.fillRect(SPECTRUM_LEFT_X + start, eraseTop, end - start, eraseBottom - eraseTop + 1, colour);
+        if ((filterLine >= SPECTRUM_LEFT_X + start) && (filterLine < SPECTRUM_LEFT_X + end)){
+            int16_t lineTop = (eraseTop > SPECTRUM_TOP_Y + 20) ? eraseTop : SPECTRUM_TOP_Y + 20;
+            int16_t lineBottom = (eraseBottom < SPECTRUM_TOP_Y + SPECTRUM_HEIGHT - 6) ? eraseBottom : SPECTRUM_TOP_Y + SPECTRUM_HEIGHT - 6;
+            if (lineBottom >= lineTop)
+                tft.drawFastVLine(filterLine, lineTop, lineBottom - lineTop + 1, RA8875_CYAN);
+        }
+    }
+    for (int16_t x = start; x < end; x++){
+        tft.drawLine(SPECTRUM_LEFT_X + x, traceTop[x], SPECTRUM_LEFT_X + x, traceBottom[x], RA8875_YELLOW);
+    }
+}
+
+/**
+ * Copy the dirty trace columns from L2 to L1, one BTE_move per run. Runs separated
+ * by no more than SPECTRUM_RUN_GAP clean columns are merged, since a wider blit is
+ * cheaper than setting up another BTE transaction.
+ */
+static FASTRUN void PublishTraceRuns(void){
+    int16_t x = 0;
+    while (x < MAX_WATERFALL_WIDTH){
+        if (!columnDirty[x]){
+            x++;
+            continue;
+        }
+        int16_t start = x;
+        int16_t end = x + 1;
+        for (x++; (x < MAX_WATERFALL_WIDTH) && (x - end < SPECTRUM_RUN_GAP); x++){
+            if (columnDirty[x]) end = x + 1;
+        }
+        tft.BTE_move(SPECTRUM_LEFT_X + start, SPECTRUM_TOP_Y + 20,
+                     end - start, SPECTRUM_HEIGHT - 20,
+                     SPECTRUM_LEFT_X + start, SPECTRUM_TOP_Y + 20, 2, 1);
+        while (tft.readStatus()) ;
+        for (int16_t k = start; k < end; k++) columnDirty[k] = false;
+        x = end;
+    }
+}
+
+// Waterfall colour lookup table, rebuilt whenever the waterfall settings change
+#define WATERFALL_LUT_SIZE 256
+static uint16_t waterfallLUT[WATERFALL_LUT_SIZE];
+static int16_t lutFloor_dBm = 0;
+static int16_t lutRange_dB = 0;
+static int8_t lutPalette = -1;
+static float32_t lutOffset = 0.0f;  // PSD value mapped to the first colour
+static float32_t lutScale = 0.0f;   // table entries per PSD unit
+
+/**
+ * Colour at position k (0 to WATERFALL_LUT_SIZE-1) along a waterfall palette.
+ */
+static uint16_t PaletteColour(int8_t palette, uint32_t k){
+    switch (palette){
+        case WaterfallPaletteGrey:
+            return ((k >> 3) << 11) | ((k >> 2) << 5) | (k >> 3);
+        case WaterfallPaletteHeat: {
+            // black -> red -> yellow -> white in three equal steps
+            uint32_t t = 3 * k;
+            uint32_t r = (t > 255) ? 255 : t;
+            uint32_t g = (t > 510) ? 255 : ((t > 255) ? t - 255 : 0);
+            uint32_t b = (t > 510) ? t - 510 : 0;
+            return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+        }
+        default:
+            return gradient[k * (sizeof(gradient)/sizeof(gradient[0]) - 1) / (WATERFALL_LUT_SIZE - 1)];
+    }
+}
+
+/**
+ * Rebuild the waterfall colour table from the ED waterfall settings.
+ */
+static void UpdateWaterfallLUT(void){
+    lutFloor_dBm = ED.waterfallFloor_dBm;
+    lutRange_dB = ED.waterfallRange_dB;
+    lutPalette = ED.waterfallPalette;
+    int8_t palette = ((lutPalette >= 0) && (lutPalette < WaterfallPaletteCount)) ? lutPalette : (int8_t)WaterfallPaletteClassic;
+    for (uint32_t k = 0; k < WATERFALL_LUT_SIZE; k++){
+        waterfallLUT[k] = PaletteColour(palette, k);
+    }
+    // PSD bins are log10 of power: power_dBm = 10*psd + RECEIVE_POWER_OFFSET
+    int16_t range_dB = (lutRange_dB > 0) ? lutRange_dB : 1;
+    lutOffset = ((float32_t)lutFloor_dBm - RECEIVE_POWER_OFFSET) / 10.0f;
+    lutScale = (WATERFALL_LUT_SIZE - 1) * 10.0f / (float32_t)range_dB;
+}
+
+/**
+ * Convert a PSD frame into waterfall colours. The clamp compiles to min/max
+ * instructions, so the loop has no per-bin branches.
+ */
+FASTRUN void WaterfallLine(const float32_t *psd, uint16_t *line, uint32_t n){
+    if ((lutFloor_dBm != ED.waterfallFloor_dBm) || (lutRange_dB != ED.waterfallRange_dB)
+        || (lutPalette != ED.waterfallPalette)){
+        UpdateWaterfallLUT();
+    }
+    const float32_t top = (float32_t)(WATERFALL_LUT_SIZE - 1);
+    for (uint32_t i = 0; i < n; i++){
+        float32_t k = (psd[i] - lutOffset) * lutScale;
+        k = fminf(fmaxf(k, 0.0f), top);
+        line[i] = waterfallLUT[(uint32_t)k];
+    }
+}
+
 /**
  * Render the real-time spectrum line display (FASTRUN - executes from RAM).
  *
- * Phase 1 back-buffer: at the start of each sweep, prime L2 with a clean
- * spectrum surface (via DrawBandWidthIndicatorBar's opening fillRect) and
- * restamp the filter highlight. Subsequent chunks accumulate yellow trace
- * segments on L2 with no per-bin black-erase. At sweep end the whole
- * spectrum rect is published to L1 in one BTE_move. The audio spectrum and
- * waterfall colour stamp stay on L1, indexed exactly as the baseline did.
+ * The trace is kept on the L2 back buffer and updated differentially: the span
+ * each column occupies on screen is remembered, and a column is only erased and
+ * redrawn when that span moves by more than SPECTRUM_DIRTY_THRESHOLD pixels.
+ * Adjacent changed columns are erased together, and at sweep end only the dirty
+ * runs are published to L1 with BTE_move. L2 is fully cleared (via
+ * DrawBandWidthIndicatorBar) only when the background has changed: at startup,
+ * after transmit, and whenever the spectrum pane goes stale. The audio spectrum
+ * stays on L1, indexed exactly as the baseline did. The waterfall line is made
+ * from the PSD frame in one pass at sweep end, only when the waterfall scrolls.
+ *
+ * The PSD frame is acquired from the DSP at the start of each sweep and held
+ * until the sweep ends, so every chunk draws bins from the same FFT frame even
+ * though the DSP keeps publishing new ones in between.
  */
 FASTRUN void ShowSpectrum(void){
-    // Sweep-start: prime L2 with a fresh spectrum surface + current filter bar.
-    if (x1 == 0) { spectrumChunkIdx = 0; spectrumFrameCtr++; } // new sweep: reset chunk idx, advance frame counter
-    if (x1 == 0 && modeSM.state_id != ModeSm_StateId_SSB_TRANSMIT) {
-        tft.writeTo(L2);
-        DrawBandWidthIndicatorBar();   // its opening fillRect clears the spectrum body (y >= top+20)
-        // Restamp the yellow frame: DrawBandWidthIndicatorBar's clear overlaps
-        // the bottom + left edges of the spectrum-pane border drawn at stale-redraw time.
-        tft.drawRect(PaneSpectrum.x0-2, PaneSpectrum.y0, MAX_WATERFALL_WIDTH+5, SPECTRUM_HEIGHT, RA8875_YELLOW);
+    if (x1 == 0) {
+        spectrumChunkIdx = 0;   // new sweep: reset chunk idx, advance frame counter
+        spectrumFrameCtr++;
+        spectrumFrame = AcquirePSDFrame();
+        if (modeSM.state_id == ModeSm_StateId_SSB_TRANSMIT) {
+            // Nothing is published from L2 during transmit, so start afresh afterwards
+            spectrumBackgroundStale = true;
+        } else if (spectrumBackgroundStale) {
+            tft.writeTo(L2);
+            DrawBandWidthIndicatorBar();   // its opening fillRect clears the spectrum body (y >= top+20)
+            // Restamp the yellow frame: DrawBandWidthIndicatorBar's clear overlaps
+            // the bottom + left edges of the spectrum-pane border drawn at stale-redraw time.
+            tft.drawRect(PaneSpectrum.x0-2, PaneSpectrum.y0, MAX_WATERFALL_WIDTH+5, SPECTRUM_HEIGHT, RA8875_YELLOW);
+        }
     }
 
     int16_t x1_start = x1;
@@ -691,9 +870,13 @@ FASTRUN void ShowSpectrum(void){
     if (x1_end > MAX_WATERFALL_WIDTH) x1_end = MAX_WATERFALL_WIDTH;
     spectrumChunkIdx++;
 
-    // Pass 1 - spectrum trace on L2 back buffer (no per-bin erase).
+    // Pass 1 - spectrum trace on L2 back buffer, redrawing only the columns that moved.
     tft.writeTo(L2);
-    for (; x1 < x1_end; ){
+    int16_t runStart = -1;
+    int16_t eraseTop = 0;
+    int16_t eraseBottom = -1;
+    uint16_t runColour = RA8875_BLACK;
+    for (; x1 < x1_end; x1++){
         y_left = y_current;
         y_current = offset - pixelnew(x1); // offset is line on screen where -124 dBm is located
         if (ED.spectrumFloorAuto && y_current > pixelmax) pixelmax = y_current;
@@ -703,21 +886,46 @@ FASTRUN void ShowSpectrum(void){
         // Without this, trace pixels accumulate above DrawBandWidthIndicatorBar's clear region
         // and gradually paint over the text on L2.
         if (y_current < SPECTRUM_TOP_Y + 20) y_current = SPECTRUM_TOP_Y + 20;
-
-        tft.drawLine(SPECTRUM_LEFT_X+x1, y_left, SPECTRUM_LEFT_X+x1, y_current, RA8875_YELLOW);
-        pixelold[x1] = y_current;       // retained as the per-bin y record for the waterfall colour pass
-        x1++;
+        pixelold[x1] = y_current;       // retained as the per-bin y record of the trace
+
+        int16_t top = (y_left < y_current) ? y_left : y_current;
+        int16_t bottom = (y_left < y_current) ? y_current : y_left;
+        bool drawn = traceBottom[x1] >= traceTop[x1];
+        bool moved = !drawn || (abs(top - traceTop[x1]) > SPECTRUM_DIRTY_THRESHOLD)
+                            || (abs(bottom - traceBottom[x1]) > SPECTRUM_DIRTY_THRESHOLD);
+        uint16_t colour = TraceBackground(x1);
+        // Close the current run when it is interrupted by a clean column or a background change
+        if ((runStart >= 0) && (!moved || (colour != runColour))){
+            DrawTraceRun(runStart, x1, eraseTop, eraseBottom, runColour);
+            runStart = -1;
+        }
+        if (!moved) continue;
+        if (runStart < 0){
+            runStart = x1;
+            runColour = colour;
+            eraseTop = SPECTRUM_TOP_Y + SPECTRUM_HEIGHT;
+            eraseBottom = -1;
+        }
+        if (drawn){
+            if (traceTop[x1] < eraseTop) eraseTop = traceTop[x1];
+            if (traceBottom[x1] > eraseBottom) eraseBottom = traceBottom[x1];
+        }
+        traceTop[x1] = top;
+        traceBottom[x1] = bottom;
+        columnDirty[x1] = true;
     }
+    if (runStart >= 0)
+        DrawTraceRun(runStart, x1, eraseTop, eraseBottom, runColour);
 
-    // Pass 2 - audio spectrum + waterfall colour on L1 (preserves baseline post-increment indexing).
+    // Pass 2 - audio spectrum on L1 (preserves baseline post-increment indexing).
     // The small audio-spectrum + S-meter redraw is a separate, low-priority display element costing
     // ~13 ms/frame, so it is throttled to every AUDIO_SPECTRUM_DECIMATE-th frame to free real-time
-    // budget for the main spectrum/waterfall. The waterfall colour computation is NOT throttled.
+    // budget for the main spectrum/waterfall.
     tft.writeTo(L1);
-    if (modeSM.state_id != ModeSm_StateId_SSB_TRANSMIT){
-        bool drawAudioSpectrum = (spectrumFrameCtr % AUDIO_SPECTRUM_DECIMATE) == 0;
+    bool drawAudioSpectrum = (spectrumFrameCtr % AUDIO_SPECTRUM_DECIMATE) == 0;
+    if (drawAudioSpectrum && (modeSM.state_id != ModeSm_StateId_SSB_TRANSMIT)){
         for (int16_t xb = x1_start + 1; xb <= x1; xb++){
-            if (drawAudioSpectrum && xb < 128) {
+            if (xb < 128) {
                 tft.drawFastVLine(PaneAudioSpectrum.x0 + 2 + 2*xb, PaneAudioSpectrum.y0+2,
                                   AUDIO_SPECTRUM_BOTTOM-PaneAudioSpectrum.y0-3, RA8875_BLACK);
                 if (audioYPixel[xb] > 2) {
@@ -731,23 +939,16 @@ FASTRUN void ShowSpectrum(void){
                                       audioYPixel[xb] - 2, RA8875_MAGENTA);
                 }
             }
-            if (drawAudioSpectrum && xb == 128){
+            if (xb == 128){
                 audioMaxSquaredAve = .5 * GetAudioPowerMax() + .5 * audioMaxSquaredAve;
                 DisplaydbM();
             }
-            int test1 = -pixelold[xb-1] + 230;
-            if (test1 < 0)
-                test1 = 0;
-            if (test1 > 117)
-                test1 = 117;
-            waterfall[xb] = gradient[test1];
         }
     }
 
     if (x1 >= MAX_WATERFALL_WIDTH){
         x1 = 0;
         y_current = offset;
-        psdupdated = false;
         redrawSpectrum = false;
 
         if (modeSM.state_id == ModeSm_StateId_SSB_TRANSMIT)
@@ -765,11 +966,8 @@ FASTRUN void ShowSpectrum(void){
         // In case spectrumNoiseFloor was changed
         offset = (SPECTRUM_TOP_Y+SPECTRUM_HEIGHT-ED.spectrumNoiseFloor[ED.currentBand[ED.activeVFO]]);
 
-        // Publish back-buffered spectrum (L2 -> L1) in one hardware BTE blit.
-        tft.BTE_move(SPECTRUM_LEFT_X, SPECTRUM_TOP_Y + 20,
-                     MAX_WATERFALL_WIDTH, SPECTRUM_HEIGHT - 20,
-                     SPECTRUM_LEFT_X, SPECTRUM_TOP_Y + 20, 2, 1);
-        while (tft.readStatus()) ;
+        // Publish the changed parts of the back-buffered spectrum (L2 -> L1).
+        PublishTraceRuns();
 
         // EXPERIMENT: scroll the waterfall only every WATERFALL_DECIMATE-th frame (phase-offset
         // from the audio-spectrum throttle so the two heavy ops fall on alternate frames). The
@@ -787,6 +985,7 @@ FASTRUN void ShowSpectrum(void){
               pong = 2;
               tft.writeTo(L1);
             }
+            WaterfallLine(spectrumFrame->bins, waterfall, MAX_WATERFALL_WIDTH);
             tft.writeRect(WATERFALL_LEFT_X, FIRST_WATERFALL_LINE, MAX_WATERFALL_WIDTH, 1, waterfall);
         }
         tft.writeTo(L1);
@@ -798,6 +997,8 @@ static uint32_t oz = 8;
 static int64_t ocf = 0;
 static int64_t oft = 0;
 static ModulationType omd = IQ;
+static int32_t olc = 0;
+static int32_t ohc = 0;
 
 /**
  * Render the RF spectrum display pane with waterfall.
@@ -806,11 +1007,19 @@ void DrawSpectrumPane(void) {
     if ((oz != ED.spectrum_zoom) ||
         (ocf != ED.centerFreq_Hz[ED.activeVFO]) ||
         (oft != ED.fineTuneFreq_Hz[ED.activeVFO]) ||
-        (omd != ED.modulation[ED.activeVFO])){
+        (omd != ED.modulation[ED.activeVFO]) ||
+        (olc != bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz) ||
+        (ohc != bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz)){
         PaneSpectrum.stale = true;
     }
+    // The passband highlight is redrawn by the next sweep as it starts. Clearing
+    // the trace here, part way through a sweep, would lose the columns already drawn.
+    if (PaneSpectrum.stale) {
+        spectrumBackgroundStale = true;
+    }
 
-    if (psdupdated && redrawSpectrum){
+    // Start a sweep when the DSP has a new frame, then finish it chunk by chunk
+    if (redrawSpectrum && ((x1 != 0) || PSDFrameAvailable())){
         ShowSpectrum();
     }
 
@@ -822,9 +1031,10 @@ void DrawSpectrumPane(void) {
     ocf = ED.centerFreq_Hz[ED.activeVFO];
     oft = ED.fineTuneFreq_Hz[ED.activeVFO];
     omd = ED.modulation[ED.activeVFO];
+    olc = bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz;
+    ohc = bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz;
     tft.writeTo(L2);
     DrawFrequencyBarValue();
-    DrawBandWidthIndicatorBar();
     ShowBandwidth();
     tft.drawRect(PaneSpectrum.x0-2,PaneSpectrum.y0,MAX_WATERFALL_WIDTH+5,SPECTRUM_HEIGHT,RA8875_YELLOW);
     tft.writeTo(L1);
@@ -1026,11 +1236,7 @@ void DrawTimePane(void) {
 ///////////////////////////////////////////////////////////////////////////////
 
 void DrawSWRPane(void) {
-
-    // Refresh rate
-    static uint32_t last = 0;
-    if (millis() - last < 250) return;   // 4 Hz
-    last = millis();
+    // Redrawn at the pane's refresh rate, set in its definition
 
     // TX is considered "active" if SWR was updated recently
     const uint32_t age_ms = millis() - ReadSWRLastUpdateMs();
@@ -1687,6 +1893,82 @@ void DrawNameBadgePane(void) {
 // State tracking for periodic display updates
 static uint32_t timer_ms = 0;
 static uint32_t timerDisplay_ms = 0;
+static uint32_t displayBudget_us = DISPLAY_BUDGET_US;
+static uint32_t deferredPaneDraws = 0;
+
+void SetDisplayBudget_us(uint32_t budget_us){
+    displayBudget_us = budget_us;
+}
+
+uint32_t GetDisplayBudget_us(void){
+    return displayBudget_us;
+}
+
+uint32_t GetDeferredPaneDraws(void){
+    return deferredPaneDraws;
+}
+
+/**
+ * Draw the home screen panes that fit in the display budget.
+ *
+ * Panes are taken in order of priority, raised by one for every loop the pane
+ * has been passed over, so a low priority pane waits but is never starved. A
+ * stale pane is expected to take its measured redraw time and any other pane
+ * its measured update time. A pane that would overrun the budget is left for
+ * the next loop, except that the first pane is always drawn. A pane that is not
+ * stale is only called once its refresh period has elapsed.
+ */
+static void DrawPanes(void){
+    uint32_t start_us = micros();
+    uint32_t now_ms = millis();
+    bool considered[NUMBER_OF_PANES] = {false};
+    bool drewPane = false;
+
+    for (;;){
+        int8_t next = -1;
+        int16_t nextRank = -1;
+        for (int8_t i = 0; i < NUMBER_OF_PANES; i++){
+            Pane *pane = WindowPanes[i];
+            if (considered[i]) continue;
+            if (!pane->stale && (now_ms - pane->lastDraw_ms < pane->refresh_ms)){
+                considered[i] = true;
+                continue;
+            }
+            // Ties go to the pane listed first
+            int16_t rank = pane->priority + pane->deferred;
+            if (rank > nextRank){
+                next = i;
+                nextRank = rank;
+            }
+        }
+        if (next < 0) break;
+        considered[next] = true;
+
+        Pane *pane = WindowPanes[next];
+        bool wasStale = pane->stale;
+        uint32_t expected_us = wasStale ? pane->redraw_us : pane->update_us;
+        if (drewPane && (micros() - start_us + expected_us > displayBudget_us)){
+            if (pane->deferred < UINT8_MAX) pane->deferred++;
+            deferredPaneDraws++;
+            continue;
+        }
+
+        uint32_t t0 = micros();
+        PANE_PROFILE(PaneNames[next]);
+        pane->DrawFunction();
+        uint32_t elapsed_us = micros() - t0;
+        // Take a slower draw at once, let a faster one pull the estimate down gradually
+        uint32_t *cost_us = wasStale ? &pane->redraw_us : &pane->update_us;
+        if (elapsed_us > *cost_us)
+            *cost_us = elapsed_us;
+        else
+            *cost_us -= (*cost_us - elapsed_us) / 4;
+        pane->lastDraw_ms = now_ms;
+        pane->deferred = 0;
+        drewPane = true;
+    }
+    PANE_PROFILE(NULL);
+}
 
 /**
  * Render the main operating screen with all 12 display panes.
@@ -1721,9 +2003,7 @@ void DrawHome(){
         if (modeSM.state_id == ModeSm_StateId_SSB_TRANSMIT)
             PaneStateOfHealth.stale = true;
     }
-    for (size_t i = 0; i < NUMBER_OF_PANES; i++){
-        WindowPanes[i]->DrawFunction();
-    }
+    DrawPanes();
     MorseCharacterDisplay();
 }
 
@@ -546,11 +546,32 @@ void DisableAutonoisefloor(void){
     ED.spectrumFloorAuto = 0;
 }
 
-struct SecondaryMenuOption DisplayOptions[4] = {
+VariableParameter waterfallfloor = {
+    .variable = &ED.waterfallFloor_dBm,
+    .type = TYPE_I16,
+    .limits = {.i16 = {.min = -160, .max=-40, .step=2}}
+};
+
+VariableParameter waterfallrange = {
+    .variable = &ED.waterfallRange_dB,
+    .type = TYPE_I16,
+    .limits = {.i16 = {.min = 10, .max=120, .step=5}}
+};
+
+VariableParameter waterfallpalette = {
+    .variable = &ED.waterfallPalette,
+    .type = TYPE_I8,
+    .limits = {.i8 = {.min = 0, .max=WaterfallPaletteCount-1, .step=1}}
+};
+
+struct SecondaryMenuOption DisplayOptions[7] = {
     "Auto spectrum floor", functionOption, NULL, (void *)EnableAutonoisefloor, NULL,
     "Manual spectrum floor", functionOption, NULL, (void *)DisableAutonoisefloor, NULL,
     "Spectrum floor", variableOption, &spectrumfloor, NULL, NULL,
     "Spectrum scale", variableOption, &spectrumscale, NULL, (void *)ScaleUpdated,
+    "Waterfall floor", variableOption, &waterfallfloor, NULL, NULL,
+    "Waterfall range", variableOption, &waterfallrange, NULL, NULL,
+    "Waterfall palette", variableOption, &waterfallpalette, NULL, NULL,
 };
 
 // EEPROM Menu
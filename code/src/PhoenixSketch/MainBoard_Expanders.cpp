@@ -0,0 +1,107 @@
+/*
+Copyright (C) 2026 T41 EP Software Contributors
+See Contributors.txt for list of known authors.
+
+This file is part of Phoenix.
+
+Phoenix is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Phoenix is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Phoenix.
+If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file MainBoard_Expanders.cpp
+ * @brief Write queue for the MCP23017 GPIO expanders on the RF, BPF and LPF boards
+ *
+ * The board modules keep the desired state of their expanders in hardwareRegister
+ * and ask this queue to write it out. Outside a batch the write happens at once,
+ * as it always did. Inside a batch, started by the T/R sequencer for each of its
+ * steps and by HandleTuneState(), the queue only notes which expanders changed.
+ * When the batch ends each changed expander is written once, with both ports in
+ * a single transaction if needed. Values that changed and changed back within
+ * the batch are never sent.
+ *
+ * The 1 ms tick can change the RF state in the middle of a main loop batch,
+ * for example when the keyer enters a CW mark. Its batches are kept apart so
+ * that its writes go out before the interrupt returns rather than when the
+ * interrupted batch ends.
+ */
+
+#include "SDT.h"
+
+static uint8_t (*const flushExpander[EXPANDER_COUNT])(void) = {
+    FlushRFMCPRegisters,    // EXPANDER_RF
+    FlushBPFMCPRegisters,   // EXPANDER_BPF
+    FlushLPFMCPRegisters,   // EXPANDER_LPF
+};
+
+struct ExpanderBatch {
+    uint8_t depth;
+    bool dirty[EXPANDER_COUNT];
+};
+
+static ExpanderBatch loopBatch = {0, {false}};
+static ExpanderBatch interruptBatch = {0, {false}};
+static ExpanderBatch *volatile batch = &loopBatch;
+static uint32_t expanderTransactions = 0;
+
+void SetExpanderInterruptContext(bool inInterrupt){
+    batch = inInterrupt ? &interruptBatch : &loopBatch;
+}
+
+void BeginExpanderBatch(void){
+    batch->depth++;
+}
+
+void EndExpanderBatch(void){
+    if (batch->depth == 0) return;
+    if (--batch->depth > 0) return;
+    for (uint8_t i = 0; i < EXPANDER_COUNT; i++){
+        if (batch->dirty[i]){
+            batch->dirty[i] = false;
+            expanderTransactions += flushExpander[i]();
+        }
+    }
+}
+
+void RequestExpanderWrite(Expander expander){
+    if (batch->depth > 0){
+        batch->dirty[expander] = true;
+        return;
+    }
+    expanderTransactions += flushExpander[expander]();
+}
+
+uint8_t WriteMCPPorts(Adafruit_MCP23X17 &mcp, uint8_t gpioa, uint8_t gpiob,
+                      uint8_t *gpioaOld, uint8_t *gpiobOld){
+    bool writeA = (gpioa != *gpioaOld);
+    bool writeB = (gpiob != *gpiobOld);
+    if (writeA && writeB){
+        // GPIOB follows GPIOA in the register map, so one write covers both
+        mcp.writeGPIOAB((uint16_t)gpioa | ((uint16_t)gpiob << 8));
+    } else if (writeA){
+        mcp.writeGPIOA(gpioa);
+    } else if (writeB){
+        mcp.writeGPIOB(gpiob);
+    } else {
+        return 0;
+    }
+    *gpioaOld = gpioa;
+    *gpiobOld = gpiob;
+    return 1;
+}
+
+uint32_t GetExpanderTransactions(void){
+    return expanderTransactions;
+}
+
+void ResetExpanderTransactions(void){
+    expanderTransactions = 0;
+}
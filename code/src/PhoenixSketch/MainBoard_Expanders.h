@@ -0,0 +1,82 @@
+/*
+Copyright (C) 2026 T41 EP Software Contributors
+See Contributors.txt for list of known authors.
+
+This file is part of Phoenix.
+
+Phoenix is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Phoenix is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Phoenix.
+If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef EXPANDERS_H
+#define EXPANDERS_H
+#include "SDT.h"
+
+// The MCP23017 GPIO expanders on the peripheral boards, in the order they are
+// written when a batch ends. The attenuators go first so that the RF level is
+// settled before any filter or routing relay moves.
+enum Expander {
+    EXPANDER_RF,
+    EXPANDER_BPF,
+    EXPANDER_LPF,
+    EXPANDER_COUNT
+};
+
+/**
+ * @brief Switch between the batch state of the main loop and of the 1 ms tick
+ * @param inInterrupt true on entry to tick1ms(), false before it returns
+ */
+void SetExpanderInterruptContext(bool inInterrupt);
+
+/**
+ * @brief Start collecting expander writes instead of sending them
+ * @note Batches nest. The writes go out when the outermost batch ends
+ */
+void BeginExpanderBatch(void);
+
+/**
+ * @brief End a batch and, if it is the outermost one, write the changed expanders
+ * @note Each expander is written at most once, in the order of enum Expander
+ */
+void EndExpanderBatch(void);
+
+/**
+ * @brief Tell the queue that the hardware register bits of an expander changed
+ * @param expander The expander whose port state may differ from the chip
+ * @note Outside a batch the expander is written immediately
+ */
+void RequestExpanderWrite(Expander expander);
+
+/**
+ * @brief Write the ports of an MCP23017 that differ from the cached values
+ * @param mcp The expander to write
+ * @param gpioa New GPIOA value
+ * @param gpiob New GPIOB value
+ * @param gpioaOld Cached GPIOA value, updated on write
+ * @param gpiobOld Cached GPIOB value, updated on write
+ * @return Number of I2C transactions used (0 or 1)
+ * @note When both ports change they are written in one sequential transaction
+ */
+uint8_t WriteMCPPorts(Adafruit_MCP23X17 &mcp, uint8_t gpioa, uint8_t gpiob,
+                      uint8_t *gpioaOld, uint8_t *gpiobOld);
+
+/**
+ * @brief Get the number of expander I2C transactions since the last reset
+ * @return Transaction count
+ */
+uint32_t GetExpanderTransactions(void);
+
+/**
+ * @brief Zero the expander I2C transaction counter
+ */
+void ResetExpanderTransactions(void);
+
+#endif // EXPANDERS_H
@@ -48,6 +48,22 @@ static int64_t TXVFOFreq_dHz;
 si5351_clock CLK0TX   = SI5351_CLK4;
 si5351_clock CLK90TX  = SI5351_CLK5;
 
+// Below 3.2 MHz the 90 degree offset is made by running CLK90 4 Hz low for
+// VFO_QUADRATURE_DELAY_US. A one-shot timer marks the end of the offset so
+// the rest of the firmware keeps running in the meantime, and the main loop
+// ends it through ServiceVFOQuadrature(). If the main loop gets there more than
+// VFO_QUADRATURE_TOLERANCE_US late the offset is started again.
+IntervalTimer rxQuadratureTimer;
+IntervalTimer txQuadratureTimer;
+static volatile bool rxQuadraturePending = false;
+static volatile bool txQuadraturePending = false;
+static volatile bool rxQuadratureDue = false;
+static volatile bool txQuadratureDue = false;
+static uint64_t rxQuadratureFreq, rxQuadraturePLLFreq;
+static uint64_t txQuadratureFreq, txQuadraturePLLFreq;
+static uint32_t rxQuadratureStart_us, txQuadratureStart_us;
+static int64_t rxRequestedFreq_dHz, txRequestedFreq_dHz;
+
 #define SI5351_DRIVE_CURRENT_CW SI5351_DRIVE_2MA
 static int64_t CWVFOFreq_dHz;
 si5351_clock CLKCW  = SI5351_CLK6;
@@ -66,8 +82,8 @@ static uint8_t mcpB_old = 0x00;
 // Macros to get and set the relevant parts of the hardware register
 #define RF_GPA_RXATT_STATE (uint8_t)((hardwareRegister >> RXATTLSB) & 0x0000003F)
 #define RF_GPB_TXATT_STATE (uint8_t)((hardwareRegister >> TXATTLSB) & 0x0000003F)
-#define SET_RF_GPA_RXATT(val) (hardwareRegister = (hardwareRegister & 0xF03FFFFF) | (((uint64_t)val & 0x0000003F) << RXATTLSB));buffer_add()
-#define SET_RF_GPB_TXATT(val) (hardwareRegister = (hardwareRegister & 0xFFC0FFFF) | (((uint64_t)val & 0x0000003F) << TXATTLSB));buffer_add()
+#define SET_RF_GPA_RXATT(val) (hardwareRegister = (hardwareRegister & 0xFFFFFFFFF03FFFFFULL) | (((uint64_t)val & 0x0000003F) << RXATTLSB));buffer_add()
+#define SET_RF_GPB_TXATT(val) (hardwareRegister = (hardwareRegister & 0xFFFFFFFFFFC0FFFFULL) | (((uint64_t)val & 0x0000003F) << TXATTLSB));buffer_add()
 
 ///////////////////////////////////////////////////////////////////////////////
 // Functions that are only visible from within this file
@@ -108,28 +124,13 @@ static bool InitI2C(void){
 }
 
 /**
- * PRIVATE: Write the value of the GPIOA register to the MCP23017 chip.
- * 
- * Returns boolean true if the write was performed. Returns boolean false if it was not
- * because the new register value matches the old value. 
- */
-static bool WriteGPIOARegister(void){
-    if (RF_GPA_RXATT_STATE == mcpA_old) return false;
-    mcpAtten.writeGPIOA(RF_GPA_RXATT_STATE);
-    mcpA_old = RF_GPA_RXATT_STATE;
-    return true;
-}
-
-/**
- * PRIVATE: Write the value of the GPIOB register to the MCP23017 chip.
+ * Write the attenuator ports of the MCP23017 chip that differ from the last
+ * values written, both in one transaction if needed.
  * 
- * Returns boolean true if the write was successful. Returns boolean false if it was not. 
+ * Called by the expander write queue. Returns the number of I2C transactions used.
  */
-static bool WriteGPIOBRegister(void){
-    if (RF_GPB_TXATT_STATE == mcpB_old) return false;
-    mcpAtten.writeGPIOB(RF_GPB_TXATT_STATE);
-    mcpB_old = RF_GPB_TXATT_STATE;
-    return true;
+uint8_t FlushRFMCPRegisters(void){
+    return WriteMCPPorts(mcpAtten, RF_GPA_RXATT_STATE, RF_GPB_TXATT_STATE, &mcpA_old, &mcpB_old);
 }
 
 /** 
@@ -157,11 +158,11 @@ static int32_t check_range(int32_t val){
 static errno_t SetAttenuator(int32_t Attenuation_dBx2, uint8_t GPIO_register){
     if (GPIO_register == TX) {
         SET_RF_GPB_TXATT( (uint8_t)check_range(Attenuation_dBx2) );
-        WriteGPIOBRegister();
+        RequestExpanderWrite(EXPANDER_RF);
     }
     if (GPIO_register == RX) {
         SET_RF_GPA_RXATT( (uint8_t)check_range(Attenuation_dBx2) );
-        WriteGPIOARegister();
+        RequestExpanderWrite(EXPANDER_RF);
     }
     return ESUCCESS;
 }
@@ -475,12 +476,157 @@ int32_t EvenDivisor(int64_t freq2_Hz) {
     return mult;
 }
 
+/**
+ * One-shot timer callbacks that mark the end of the quadrature delay. The
+ * Si5351 is left alone here so that no I2C traffic runs in the interrupt.
+ */
+static void RXQuadratureDelayDone(void){
+    rxQuadratureTimer.end();
+    rxQuadratureDue = true;
+}
+
+static void TXQuadratureDelayDone(void){
+    txQuadratureTimer.end();
+    txQuadratureDue = true;
+}
+
+/**
+ * Start the low frequency RX quadrature offset: align CLK0RX and CLK90RX 4 Hz
+ * low, then bring CLK0RX up to the required frequency and start the delay.
+ */
+static void StartRXQuadrature(uint64_t freq, uint64_t pll_freq){
+    si5351.set_freq_manual((freq - 400ULL), pll_freq, CLK0RX);  // set up frequencies of CLK 0/90 4 Hz low
+    si5351.set_freq_manual((freq - 400ULL), pll_freq, CLK90RX); // as per TJ-Labs article
+    si5351.set_phase(CLK0RX, 0);                                // set phase registers to 0 just to be sure
+    si5351.set_phase(CLK90RX, 0);
+    si5351.pll_reset(SI5351_PLLA);                              // align both clockss in phase
+    si5351.set_freq_manual(freq, pll_freq, CLK0RX);             // set clock 0  to required freq
+    rxQuadratureStart_us = micros();                            // CLK90 starts to fall behind here
+    rxQuadratureFreq = freq;                                    // FinishRXQuadrature sets CLK90 to the
+    rxQuadraturePLLFreq = pll_freq;                             // required freq after the delay
+    rxQuadraturePending = true;
+    rxQuadratureTimer.begin(RXQuadratureDelayDone, VFO_QUADRATURE_DELAY_US);
+}
+
+/**
+ * Start the low frequency TX quadrature offset: align CLK0TX and CLK90TX 4 Hz
+ * low, then bring CLK0TX up to the required frequency and start the delay.
+ */
+static void StartTXQuadrature(uint64_t freq, uint64_t pll_freq){
+    si5351.set_freq_manual((freq - 400ULL), pll_freq, CLK0TX);  // set up frequencies of CLK 0/90 4 Hz low
+    si5351.set_freq_manual((freq - 400ULL), pll_freq, CLK90TX); // as per TJ-Labs article
+    si5351.set_phase(CLK0TX, 0);                                // set phase registers to 0 just to be sure
+    si5351.set_phase(CLK90TX, 0);
+    si5351.pll_reset(SI5351_PLLB);                              // align both clocks in phase
+    si5351.set_freq_manual(freq, pll_freq, CLK0TX);             // set clock 4 to required freq
+    txQuadratureStart_us = micros();                            // CLK90 starts to fall behind here
+    txQuadratureFreq = freq;                                    // FinishTXQuadrature sets CLK90 to the
+    txQuadraturePLLFreq = pll_freq;                             // required freq after the delay
+    txQuadraturePending = true;
+    txQuadratureTimer.begin(TXQuadratureDelayDone, VFO_QUADRATURE_DELAY_US);
+}
+
+/**
+ * End the low frequency RX quadrature setup by bringing CLK90RX up to the
+ * frequency of CLK0RX. Then applies any frequency that was requested while
+ * the setup was running. If the main loop came too late, CLK90RX has drifted
+ * past 90 degrees and the offset is started again instead.
+ */
+static void FinishRXQuadrature(void){
+    if (micros() - rxQuadratureStart_us > VFO_QUADRATURE_DELAY_US + VFO_QUADRATURE_TOLERANCE_US){
+        StartRXQuadrature(rxQuadratureFreq, rxQuadraturePLLFreq);
+        // set_freq_manual turns the outputs on
+        if (!GET_BIT(hardwareRegister,RXVFOBIT)){
+            si5351.output_enable(CLK0RX, 0);
+            si5351.output_enable(CLK90RX, 0);
+        }
+        return;
+    }
+    si5351.set_freq_manual(rxQuadratureFreq, rxQuadraturePLLFreq, CLK90RX);
+    // set_freq_manual turns CLK90 on. Keep it off if the outputs were
+    // disabled during the delay.
+    if (!GET_BIT(hardwareRegister,RXVFOBIT))
+        si5351.output_enable(CLK90RX, 0);
+    rxQuadraturePending = false;
+    CLEAR_BIT(hardwareRegister,RXVFOQUADBIT);
+    if (rxRequestedFreq_dHz != RXVFOFreq_dHz)
+        SetRXVFOFrequency(rxRequestedFreq_dHz);
+}
+
+/**
+ * End the low frequency TX quadrature setup by bringing CLK90TX up to the
+ * frequency of CLK0TX. Then applies any frequency that was requested while
+ * the setup was running. If the main loop came too late, CLK90TX has drifted
+ * past 90 degrees and the offset is started again instead.
+ */
+static void FinishTXQuadrature(void){
+    if (micros() - txQuadratureStart_us > VFO_QUADRATURE_DELAY_US + VFO_QUADRATURE_TOLERANCE_US){
+        StartTXQuadrature(txQuadratureFreq, txQuadraturePLLFreq);
+        if (!GET_BIT(hardwareRegister,TXVFOBIT)){
+            si5351.output_enable(CLK0TX, 0);
+            si5351.output_enable(CLK90TX, 0);
+        }
+        return;
+    }
+    si5351.set_freq_manual(txQuadratureFreq, txQuadraturePLLFreq, CLK90TX);
+    if (!GET_BIT(hardwareRegister,TXVFOBIT))
+        si5351.output_enable(CLK90TX, 0);
+    txQuadraturePending = false;
+    CLEAR_BIT(hardwareRegister,TXVFOQUADBIT);
+    if (txRequestedFreq_dHz != TXVFOFreq_dHz)
+        SetTXVFOFrequency(txRequestedFreq_dHz);
+}
+
+/**
+ * Finish the low frequency quadrature setups whose delay has passed. Called
+ * from the main loop.
+ */
+void ServiceVFOQuadrature(void){
+    if (rxQuadratureDue){
+        rxQuadratureDue = false;
+        FinishRXQuadrature();
+    }
+    if (txQuadratureDue){
+        txQuadratureDue = false;
+        FinishTXQuadrature();
+    }
+}
+
+/**
+ * Abandon any quadrature setup that is still running
+ */
+static void CancelVFOQuadrature(void){
+    rxQuadratureTimer.end();
+    txQuadratureTimer.end();
+    rxQuadraturePending = false;
+    txQuadraturePending = false;
+    rxQuadratureDue = false;
+    txQuadratureDue = false;
+}
+
+/**
+ * Check whether a low frequency quadrature setup is still running.
+ *
+ * @return true from the start of the setup until CLK90 is at the new frequency
+ */
+bool IsVFOQuadraturePending(void){
+    return rxQuadraturePending || txQuadraturePending;
+}
+
 /**
  * Set the CLK0RX and CLK90RX outputs as quadrature outputs at the specified frequency.
+ * Below 3.2 MHz this returns while CLK90RX is still offset; FinishRXQuadrature()
+ * completes the setup from the main loop once a one-shot timer has ended the delay.
  *
  * @param frequency_dHz The desired clock frequency in (Hz * 100)
  */
 void SetRXVFOFrequency(int64_t frequency_dHz){
+    // The PLL must not change while CLK90 is offset. FinishRXQuadrature()
+    // applies the latest request once the offset has ended.
+    if (rxQuadraturePending){
+        rxRequestedFreq_dHz = frequency_dHz;
+        return;
+    }
     // No need to change if it's already at this setting
     if (frequency_dHz == RXVFOFreq_dHz) return;
     RXVFOFreq_dHz = frequency_dHz;
@@ -505,22 +651,14 @@ void SetRXVFOFrequency(int64_t frequency_dHz){
             SET_BIT(hardwareRegister,RXVFOBIT);
         } else {    // this is the timed delay technique for frequencies below 3.2MHz as detailed in
                     // https://tj-lab.org/2020/08/27/si5351単体で3mhz以下の直交信号を出力する/
-            cli();                //__disable_irq(); or __enable_irq();     // or cli()/sei() pair; needed to get accurate timing??
             //si5351.output_enable(CLK0RX, 0);   // optional switch off clocks if audio effects are generated
             //si5351.output_enable(CLK90RX, 0);  //  with the change of multiple below 3.2MHz
-            si5351.set_freq_manual((freq - 400ULL), pll_freq, CLK0RX);  // set up frequencies of CLK 0/90 4 Hz low
-            si5351.set_freq_manual((freq - 400ULL), pll_freq, CLK90RX); // as per TJ-Labs article
-            si5351.set_phase(CLK0RX, 0);                                // set phase registers to 0 just to be sure
-            si5351.set_phase(CLK90RX, 0);
-            si5351.pll_reset(SI5351_PLLA);                              // align both clockss in phase
-            si5351.set_freq_manual(freq, pll_freq, CLK0RX);             // set clock 0  to required freq
-            //delayNanoseconds(625000000);       // 62.5 * 1000000      // configured for a 62.5 mSec delay at 4 Hz difference
-            delayMicroseconds(58500);                                   // nominally 62500 this figure can be adjusted for a more exact delay which is phase
-            si5351.set_freq_manual(freq, pll_freq, CLK90RX);            // set CLK90 to the required freq after delay
-            sei();
+            StartRXQuadrature(freq, pll_freq);
+            rxRequestedFreq_dHz = frequency_dHz;
             si5351.output_enable(CLK0RX, 1);                            // switch them on to be sure
             si5351.output_enable(CLK90RX, 1);                           //    ""        ""
             SET_BIT(hardwareRegister,RXVFOBIT);
+            SET_BIT(hardwareRegister,RXVFOQUADBIT);
         }
     }
     oldrxMultiple = rxmultiple;
@@ -528,6 +666,8 @@ void SetRXVFOFrequency(int64_t frequency_dHz){
 
 /**
  * Set the CLK0TX and CLK90TX outputs as quadrature outputs at the specified frequency.
+ * Below 3.2 MHz this returns while CLK90TX is still offset; FinishTXQuadrature()
+ * completes the setup from the main loop once a one-shot timer has ended the delay.
  *
  * @param frequency_dHz The desired clock frequency in (Hz * 100)
  */
@@ -536,6 +676,12 @@ void SetTXVFOFrequency(int64_t frequency_dHz){
         SetRXVFOFrequency(frequency_dHz);
         return;
     }
+    // The PLL must not change while CLK90 is offset. FinishTXQuadrature()
+    // applies the latest request once the offset has ended.
+    if (txQuadraturePending){
+        txRequestedFreq_dHz = frequency_dHz;
+        return;
+    }
     // No need to change if it's already at this setting
     if (frequency_dHz == TXVFOFreq_dHz) return;
     TXVFOFreq_dHz = frequency_dHz;
@@ -560,22 +706,14 @@ void SetTXVFOFrequency(int64_t frequency_dHz){
             SET_BIT(hardwareRegister,TXVFOBIT);
         } else {    // this is the timed delay technique for frequencies below 3.2MHz as detailed in
                     // https://tj-lab.org/2020/08/27/si5351単体で3mhz以下の直交信号を出力する/
-            cli();                              // or cli()/sei() pair; needed to get accurate timing??
             //si5351.output_enable(CLK0TX, 0);  // optional switch off clocks if audio effects are generated
             //si5351.output_enable(CLK90TX, 0); //  with the change of multiple below 3.2MHz
-            si5351.set_freq_manual((freq - 400ULL), pll_freq, CLK0TX);  // set up frequencies of CLK 0/90 4 Hz low
-            si5351.set_freq_manual((freq - 400ULL), pll_freq, CLK90TX); // as per TJ-Labs article
-            si5351.set_phase(CLK0TX, 0);                                // set phase registers to 0 just to be sure
-            si5351.set_phase(CLK90TX, 0);
-            si5351.pll_reset(SI5351_PLLB);                              // align both clocks in phase
-            si5351.set_freq_manual(freq, pll_freq, CLK0TX);             // set clock 4 to required freq
-            //delayNanoseconds(625000000);                              // 62.5 * 1000000      //configured for a 62.5 mSec delay at 4 Hz difference
-            delayMicroseconds(58500);                                   //nominally 62500 this figure can be adjusted for a more exact delay which is phase
-            si5351.set_freq_manual(freq, pll_freq, CLK90TX);            // set CLK90 to the required freq after delay
-            sei();
+            StartTXQuadrature(freq, pll_freq);
+            txRequestedFreq_dHz = frequency_dHz;
             si5351.output_enable(CLK0TX, 1);                            // switch them on to be sure
             si5351.output_enable(CLK90TX, 1);                           //    ""        ""
             SET_BIT(hardwareRegister,TXVFOBIT);
+            SET_BIT(hardwareRegister,TXVFOQUADBIT);
         }
     }
     oldtxMultiple = txmultiple;
@@ -771,6 +909,7 @@ bool getCWState(void){
  */
 errno_t InitVFOs(void){
     bool foundDevice = false;
+    CancelVFOQuadrature();
 
     // Try single VFO address first (0x60)
     si5351.set_address(SI5351_BUS_BASE_ADDR);
@@ -998,6 +1137,7 @@ uint16_t GetRFMCPRegisters(void){
  * This is used by unit tests to ensure clean state between test runs.
  */
 void ResetVFOState(void){
+    CancelVFOQuadrature();
     oldrxMultiple = 0;
     oldtxMultiple = 0;
     RXVFOFreq_dHz = 0;
@@ -69,6 +69,13 @@ float32_t GetTXAttenuation(void);
  */
 errno_t InitAttenuation(void);
 
+/**
+ * @brief Write the attenuator ports of the RF board MCP23017 if they changed
+ * @return Number of I2C transactions used
+ * @note Called by the expander write queue
+ */
+uint8_t FlushRFMCPRegisters(void);
+
 /**
  * @brief Get the current MCP23017 GPIO register state for testing
  * @return 16-bit register value combining GPIOA and GPIOB
@@ -98,18 +105,48 @@ int64_t GetRXVFOFrequency(void);
  */
 int64_t GetTXVFOFrequency(void);
 
+/**
+ * @brief Time that CLK90 runs 4 Hz low to build up the 90 degree offset below 3.2 MHz
+ * @note Nominally 62500 us, trimmed for a more exact phase
+ */
+#define VFO_QUADRATURE_DELAY_US 58500
+
+/**
+ * @brief How late the main loop may end the quadrature delay before the offset is started again
+ * @note CLK90 drifts about 1.44 degrees per ms at the 4 Hz offset
+ */
+#define VFO_QUADRATURE_TOLERANCE_US 1000
+
 /**
  * @brief Set the RX VFO frequency
  * @param frequency_dHz Desired frequency in decihertz (Hz × 10)
+ * @note Below 3.2 MHz the quadrature setup finishes VFO_QUADRATURE_DELAY_US
+ *       later in ServiceVFOQuadrature(). RXVFOQUADBIT is set in hardwareRegister
+ *       until then.
  */
 void SetRXVFOFrequency(int64_t frequency_dHz);
 
 /**
  * @brief Set the TX VFO frequency
  * @param frequency_dHz Desired frequency in decihertz (Hz × 10)
+ * @note Below 3.2 MHz the quadrature setup finishes VFO_QUADRATURE_DELAY_US
+ *       later in ServiceVFOQuadrature(). TXVFOQUADBIT is set in hardwareRegister
+ *       until then.
  */
 void SetTXVFOFrequency(int64_t frequency_dHz);
 
+/**
+ * @brief Check whether a low frequency quadrature setup is still running
+ * @return true until CLK90 of both the RX and TX VFOs is at its new frequency
+ */
+bool IsVFOQuadraturePending(void);
+
+/**
+ * @brief Finish the low frequency quadrature setups whose delay has passed
+ * @note Called from the main loop
+ */
+void ServiceVFOQuadrature(void);
+
 /**
  * @brief Set the RX VFO output power level
  * @param power Power level (0-3): SI5351_DRIVE_2MA, 4MA, 6MA, or 8MA
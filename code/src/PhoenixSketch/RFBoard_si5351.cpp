@@ -56,6 +56,7 @@ Si5351::Si5351(uint8_t i2c_addr):
 void Si5351::set_address(uint8_t i2c_addr)
 {
     i2c_bus_addr = i2c_addr;
+    regmap.invalidate();
 }
 
 /*
@@ -79,6 +80,9 @@ bool Si5351::init(uint8_t xtal_load_c, uint32_t xo_freq, int32_t corr)
     // Start I2C comms
     Wire.begin();
 
+    // Nothing is known about the device registers yet
+    regmap.invalidate();
+
     // Check for a device on the bus, bail out if it is not there
     Wire.beginTransmission(i2c_bus_addr);
     uint8_t reg_val;
@@ -1320,41 +1324,48 @@ void Si5351::set_ref_freq(uint32_t ref_freq, enum si5351_pll_input ref_osc)
     //si5351_write(SI5351_PLL_INPUT_SOURCE, reg_val);
 }
 
+/*
+ * Writes go through the register shadow, which sends only the bytes that
+ * differ from what the device already holds.
+ */
 uint8_t Si5351::si5351_write_bulk(uint8_t addr, uint8_t bytes, uint8_t *data)
 {
-    Wire.beginTransmission(i2c_bus_addr);
-    Wire.write(addr);
-    for(int i = 0; i < bytes; i++)
-    {
-        Wire.write(data[i]);
-    }
-    return Wire.endTransmission();
-
+    return regmap.write(i2c_bus_addr, addr, bytes, data);
 }
 
 uint8_t Si5351::si5351_write(uint8_t addr, uint8_t data)
 {
-    Wire.beginTransmission(i2c_bus_addr);
-    Wire.write(addr);
-    Wire.write(data);
-    return Wire.endTransmission();
+    return regmap.write(i2c_bus_addr, addr, 1, &data);
 }
 
 uint8_t Si5351::si5351_read(uint8_t addr)
 {
     uint8_t reg_val = 0;
 
+    if(regmap.lookup(addr, &reg_val))
+    {
+        return reg_val;
+    }
+
     Wire.beginTransmission(i2c_bus_addr);
     Wire.write(addr);
     Wire.endTransmission();
 
     Wire.requestFrom(i2c_bus_addr, (uint8_t)1, (uint8_t)false);
 
+    uint8_t received = 0;
     while(Wire.available())
     {
         reg_val = Wire.read();
+        received = 1;
     }
 
+    regmap.count_read(received);
+    // Only shadow a value the device actually returned
+    if(received)
+    {
+        regmap.fill(addr, reg_val);
+    }
     return reg_val;
 }
 
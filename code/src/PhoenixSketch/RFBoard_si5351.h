@@ -189,6 +189,12 @@
 #define SI5351_XTAL_ENABLE              (1<<6)
 #define SI5351_MULTISYNTH_ENABLE        (1<<4)
 
+#define SI5351_REGISTER_COUNT           188
+// Unchanged registers between two changed ones are rewritten rather than
+// starting a new burst when there are at most this many of them. A new burst
+// costs the device address and the register address.
+#define SI5351_BURST_MAX_GAP            2
+
 
 /* Macro definitions */
 
@@ -278,6 +284,31 @@ struct Si5351IntStatus
     uint8_t LOS_STKY;
 };
 
+/*
+ * Shadow copy of the Si5351 register map. Writes are compared against the
+ * shadow and only the bytes that differ go out on the bus, grouped into burst
+ * writes. Reads of shadowed registers are answered without bus traffic.
+ */
+class Si5351RegisterMap
+{
+public:
+    Si5351RegisterMap(void);
+    void invalidate(void);
+    void enable(uint8_t);
+    uint8_t write(uint8_t, uint8_t, uint8_t, const uint8_t *);
+    bool lookup(uint8_t, uint8_t *);
+    void fill(uint8_t, uint8_t);
+    void count_read(uint8_t);
+    uint32_t bytes_sent;
+    uint32_t transactions;
+private:
+    bool needs_write(uint8_t, uint8_t);
+    uint8_t send(uint8_t, uint8_t, uint8_t, const uint8_t *);
+    uint8_t shadow[SI5351_REGISTER_COUNT];
+    bool valid[SI5351_REGISTER_COUNT];
+    uint8_t enabled;
+};
+
 class Si5351
 {
 public:
@@ -309,6 +340,10 @@ public:
     uint8_t si5351_write_bulk(uint8_t, uint8_t, uint8_t *);
     uint8_t si5351_write(uint8_t, uint8_t);
     uint8_t si5351_read(uint8_t);
+    uint32_t get_i2c_bytes_sent(void);
+    uint32_t get_i2c_transactions(void);
+    void reset_i2c_counters(void);
+    void set_register_shadow(uint8_t);
     struct Si5351Status dev_status = {.SYS_INIT = 0, .LOL_B = 0, .LOL_A = 0,
     .LOS = 0, .REVID = 0};
     struct Si5351IntStatus dev_int_status = {.SYS_INIT_STKY = 0, .LOL_B_STKY = 0,
@@ -339,6 +374,7 @@ private:
   uint8_t clkin_div;
   uint8_t i2c_bus_addr;
   bool clk_first_set[8];
+    Si5351RegisterMap regmap;
 };
 
 #endif /* SI5351_H_ */
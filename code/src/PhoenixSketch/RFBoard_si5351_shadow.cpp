@@ -0,0 +1,251 @@
+/*
+Copyright (C) 2026 T41 EP Software Contributors
+See Contributors.txt for list of known authors.
+
+This file is part of Phoenix.
+
+Phoenix is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Phoenix is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with Phoenix.
+If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+  Register shadow for the Si5351 driver. Every tuning step used to resend
+  whole PLL and multisynth parameter blocks and read back the control
+  registers it was about to modify. The shadow keeps the last value written
+  to each register so that only changed bytes are sent, and so that the
+  read-modify-write sequences in the driver need no bus reads. This file is
+  shared by the driver and the unit test double.
+ */
+#ifndef BEENHERE
+#include "SDT.h"
+#endif
+
+#include <stdint.h>
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "RFBoard_si5351.h"
+
+/*
+ * Registers that must not be shadowed: the status registers change under
+ * the device's own control and the PLL reset bits clear themselves, so a
+ * write has an effect even when the value is unchanged.
+ */
+static bool volatile_register(uint8_t addr)
+{
+    return (addr == SI5351_DEVICE_STATUS) ||
+           (addr == SI5351_INTERRUPT_STATUS) ||
+           (addr == SI5351_PLL_RESET);
+}
+
+Si5351RegisterMap::Si5351RegisterMap(void):
+    bytes_sent(0),
+    transactions(0),
+    enabled(1)
+{
+    invalidate();
+}
+
+/*
+ * invalidate(void)
+ *
+ * Forget the shadow contents. The next write to each register goes out on
+ * the bus. Call this whenever the device state is unknown, for example after
+ * power up or when the I2C address changes.
+ */
+void Si5351RegisterMap::invalidate(void)
+{
+    for (uint16_t i = 0; i < SI5351_REGISTER_COUNT; i++)
+    {
+        valid[i] = false;
+    }
+}
+
+/*
+ * enable(uint8_t enable)
+ *
+ * enable - Set to 0 to send every byte as the unshadowed driver did
+ *
+ * The shadow is kept up to date either way so it can be enabled again
+ * at any time.
+ */
+void Si5351RegisterMap::enable(uint8_t enable)
+{
+    enabled = enable;
+}
+
+bool Si5351RegisterMap::needs_write(uint8_t addr, uint8_t data)
+{
+    if (!enabled || (addr >= SI5351_REGISTER_COUNT) || volatile_register(addr) || !valid[addr])
+    {
+        return true;
+    }
+    return shadow[addr] != data;
+}
+
+uint8_t Si5351RegisterMap::send(uint8_t i2c_addr, uint8_t addr, uint8_t bytes, const uint8_t *data)
+{
+    Wire.beginTransmission(i2c_addr);
+    Wire.write(addr);
+    for (uint8_t i = 0; i < bytes; i++)
+    {
+        Wire.write(data[i]);
+    }
+    // Device address and register address, then the data
+    bytes_sent += 2 + bytes;
+    transactions++;
+    return Wire.endTransmission();
+}
+
+/*
+ * write(uint8_t i2c_addr, uint8_t addr, uint8_t bytes, const uint8_t *data)
+ *
+ * i2c_addr - I2C address of the device
+ * addr - First register to write
+ * bytes - Number of consecutive registers to write
+ * data - Register values
+ *
+ * Send the registers whose value differs from the shadow. Changed registers
+ * are sent as burst writes, and short runs of unchanged registers between
+ * them are resent when that is cheaper than starting a new burst.
+ *
+ * Returns the OR of the Wire.endTransmission() results, 0 on success.
+ */
+uint8_t Si5351RegisterMap::write(uint8_t i2c_addr, uint8_t addr, uint8_t bytes, const uint8_t *data)
+{
+    uint8_t status = 0;
+    uint8_t i = 0;
+
+    while (i < bytes)
+    {
+        if (!needs_write(addr + i, data[i]))
+        {
+            i++;
+            continue;
+        }
+        // Extend the burst to the last changed register that follows within
+        // SI5351_BURST_MAX_GAP unchanged registers
+        uint8_t end = i + 1;
+        for (uint8_t j = end; (j < bytes) && (j - end <= SI5351_BURST_MAX_GAP); j++)
+        {
+            if (needs_write(addr + j, data[j]))
+            {
+                end = j + 1;
+            }
+        }
+        status |= send(i2c_addr, addr + i, end - i, &data[i]);
+        i = end;
+    }
+
+    for (i = 0; i < bytes; i++)
+    {
+        uint8_t reg = addr + i;
+        if ((reg < SI5351_REGISTER_COUNT) && !volatile_register(reg))
+        {
+            shadow[reg] = data[i];
+            // If the write failed the device holds an unknown value
+            valid[reg] = (status == 0);
+        }
+    }
+    return status;
+}
+
+/*
+ * lookup(uint8_t addr, uint8_t *data)
+ *
+ * addr - Register to read
+ * data - Receives the shadowed value
+ *
+ * Returns true if the register is shadowed and data holds its value. A false
+ * return means the register has to be read from the device.
+ */
+bool Si5351RegisterMap::lookup(uint8_t addr, uint8_t *data)
+{
+    if (!enabled || (addr >= SI5351_REGISTER_COUNT) || volatile_register(addr) || !valid[addr])
+    {
+        return false;
+    }
+    *data = shadow[addr];
+    return true;
+}
+
+/*
+ * fill(uint8_t addr, uint8_t data)
+ *
+ * Record a value read from the device so that later reads and writes of the
+ * register can be answered from the shadow.
+ */
+void Si5351RegisterMap::fill(uint8_t addr, uint8_t data)
+{
+    if ((addr < SI5351_REGISTER_COUNT) && !volatile_register(addr))
+    {
+        shadow[addr] = data;
+        valid[addr] = true;
+    }
+}
+
+/*
+ * count_read(uint8_t bytes)
+ *
+ * Account for a register read made on the bus: a write of the register
+ * address, then a read of the data.
+ */
+void Si5351RegisterMap::count_read(uint8_t bytes)
+{
+    bytes_sent += 2 + 1 + bytes;
+    transactions += 2;
+}
+
+/*
+ * get_i2c_bytes_sent(void)
+ *
+ * Returns the number of bytes moved on the I2C bus since the last call to
+ * reset_i2c_counters(), including device and register addresses.
+ */
+uint32_t Si5351::get_i2c_bytes_sent(void)
+{
+    return regmap.bytes_sent;
+}
+
+/*
+ * get_i2c_transactions(void)
+ *
+ * Returns the number of I2C transactions since the last call to
+ * reset_i2c_counters(). A register read counts as two.
+ */
+uint32_t Si5351::get_i2c_transactions(void)
+{
+    return regmap.transactions;
+}
+
+/*
+ * reset_i2c_counters(void)
+ *
+ * Zero the I2C byte and transaction counters.
+ */
+void Si5351::reset_i2c_counters(void)
+{
+    regmap.bytes_sent = 0;
+    regmap.transactions = 0;
+}
+
+/*
+ * set_register_shadow(uint8_t enable)
+ *
+ * enable - Set to 1 to send only changed registers, 0 to send every write
+ *
+ * The shadow is on by default. Turning it off is useful to compare the bus
+ * traffic or to rule the shadow out when debugging the clock outputs.
+ */
+void Si5351::set_register_shadow(uint8_t enable)
+{
+    regmap.enable(enable);
+}
@@ -91,6 +91,8 @@ extern uint64_t hardwareRegister;
 #define BPFBAND2BIT  30
 #define BPFBAND3BIT  31
 #define TXVFOBIT     32
+#define RXVFOQUADBIT 33  // RX VFO low frequency quadrature setup in progress
+#define TXVFOQUADBIT 34  // TX VFO low frequency quadrature setup in progress
 
 #define BAND_NF_BCD   0b1111
 #define BAND_6M_BCD   0b1010
@@ -143,6 +145,7 @@ extern uint64_t hardwareRegister;
 #define SPECTRUM_ZOOM_16   4
 #define SPECTRUM_ZOOM_MAX  4
 #define SPECTRUM_RES       512
+#define SPECTRUM_FFT_MAX   2048  // largest panadapter FFT, see SetSpectrumFFTSize()
 #define FFT_LENGTH         SPECTRUM_RES
 
 #define SAMPLE_RATE_MIN  6
@@ -271,6 +274,9 @@ extern struct config_t {
     int32_t spectrumScale = 1;      /** dB/pixel selection for spectrum display */
     int16_t spectrumNoiseFloor[NUMBER_OF_BANDS] = {50,50,50,50,50,50,50,50,50,50,50,50,50 }; /** Shift spectrum up/down on display */
     int8_t spectrumFloorAuto = 1;   /** Automatically adjust the spectrum floor */
+    int16_t waterfallFloor_dBm = -140; /** Power shown with the first waterfall colour */
+    int16_t waterfallRange_dB = 60; /** Power range spanned by the waterfall palette (contrast) */
+    int8_t waterfallPalette = 0;    /** Waterfall colour palette, see WaterfallPalette */
     uint32_t spectrum_zoom = 1;     /** Zoom level for spectrum */
     int32_t CWFilterIndex = 5;      /** Selects the receive CW audio filter */
     int32_t CWToneIndex = 3;        /** Selects the transmitted CW tone frequency */
@@ -382,9 +388,9 @@ struct DecimationFilter{
     float32_t n_samplerate_Hz;  /** Samplerate before decimation, Hz */
     float32_t n_att_dB;         /** Attenuation of the stopband, dB */
     float32_t n_desired_BW_Hz;  /** Desired max BW of the filters, Hz */
-    float32_t *FIR_dec_I_state; /** Pointer to the state vector for I decimator FIR filter*/
-    float32_t *FIR_dec_Q_state; /** Pointer to the state vector for Q decimator FIR filter */
-    float32_t *FIR_dec_coeffs;  /** Pointer to the decimator FIR filter coefficients */
+    float32_t *FIR_dec_I_state = nullptr; /** Pointer to the state vector for I decimator FIR filter*/
+    float32_t *FIR_dec_Q_state = nullptr; /** Pointer to the state vector for Q decimator FIR filter */
+    float32_t *FIR_dec_coeffs = nullptr;  /** Pointer to the decimator FIR filter coefficients */
     float32_t n_fpass;          /** FIR filter passband edge */
     float32_t n_fstop;          /** FIR filter stopband edge */
     uint16_t n_dec_taps;        /** Number of taps in FIR filter*/
@@ -401,6 +407,9 @@ extern float32_t CW_AudioFilterCoeffs3[30];
 extern float32_t CW_AudioFilterCoeffs4[30];
 extern float32_t CW_AudioFilterCoeffs5[30];
 
+struct ReceiveFilterConfig;
+void ReleaseDSPArenaBank(const ReceiveFilterConfig *filters); // in DSP_Arena.cpp
+
 /** Contains the filter structs and parameters */
 struct ReceiveFilterConfig {
     // Receive decimation filters
@@ -417,6 +426,9 @@ struct ReceiveFilterConfig {
     arm_biquad_casd_df1_inst_f32 biquadZoomQ;
     uint8_t zoom_M;
     uint32_t zoom_sample_ptr = 0;  /** Tracks current position in FFT ring buffers for this filter config */
+    uint32_t zoom_fft_size = 0;    /** Panadapter FFT size the ring buffer position refers to */
+    uint32_t zoom_samples_to_frame = 0; /** Samples still needed before the next overlapped FFT frame */
+    bool zoom_track_every_frame = false; /** Calibration: update psdnew every frame, ignoring SetSpectrumAveraging(), and do not publish it to the display */
     const uint32_t IIR_biquad_Zoom_FFT_N_stages = 4;
 
     // Convolution FIR filter
@@ -521,6 +533,7 @@ struct ReceiveFilterConfig {
         }
         free(FIR_int1_state);
         free(FIR_int2_state);
+        ReleaseDSPArenaBank(this);
     }
 };
 
@@ -582,6 +595,10 @@ struct TransmitFilterConfig {
 };
 
 
+#define AGC_GAIN_DECIMATION 8  // samples per AGC gain evaluation
+#define AGC_GAIN_MAX_CHANGE 0.1 // re-evaluate the gain early if volts moves by this fraction
+#define AGC_GAIN_BLOCK 128     // samples per pass of the AGC gain vector
+
 /** Keep all the AGC configuration parameters in a struct. Consider moving this to DSP.cpp
  * as it is used nowhere else.
  */
@@ -620,9 +637,9 @@ struct AGCConfig {
     float32_t hang_backmult;
     float32_t onemhang_backmult;
     float32_t hang_decay_mult;
-    uint32_t attack_buffsize;
-    uint32_t in_index;
-    uint32_t out_index;
+    uint32_t attack_buffsize = 0;
+    uint32_t in_index = 0;
+    uint32_t out_index = 0;
     float32_t attack_mult;
     float32_t decay_mult;
     float32_t fast_decay_mult;
@@ -633,19 +650,32 @@ struct AGCConfig {
     float32_t inv_max_input;
     float32_t min_volts;
     float32_t slope_constant;
-    int32_t hang_counter;
+    int32_t hang_counter = 0;
+    // The gain is evaluated at the end of every gain_decimation samples, or
+    // sooner during a fast attack or decay, and interpolated linearly in
+    // between. 1 evaluates it on every sample.
+    uint32_t gain_decimation = AGC_GAIN_DECIMATION;
+    float32_t gain = 0.0;       // gain at the end of the last segment
+    float32_t gain_volts = 0.0; // volts at the end of the last segment
 
     float32_t *ring;
     float32_t *abs_ring;
+    // Monotonic deque of abs_ring indices inside the look-ahead window, with
+    // decreasing magnitudes. The front is the window peak.
+    uint32_t *peak_index;
+    uint32_t peak_head = 0;
+    uint32_t peak_count = 0;
 
     AGCConfig(){
         ring = (float32_t *)malloc(sizeof(float32_t) * ring_buffsize * 2);
         abs_ring = (float32_t *)malloc(sizeof(float32_t) * ring_buffsize);
+        peak_index = (uint32_t *)malloc(sizeof(uint32_t) * ring_buffsize);
     }
 
     ~AGCConfig(){
         free(ring);
         free(abs_ring);
+        free(peak_index);
     }
 };
 
@@ -671,6 +701,8 @@ struct AGCConfig {
 #include "DSP_FFT.h"
 #include "DSP_Noise.h"
 #include "DSP_CWProcessing.h"
+#include "DSP_CWSkimmer.h"
+#include "DSP_Arena.h"
 #include "DSP.h"
 #include "MainBoard_AudioIO.h"
 #include "FrontPanel.h"
@@ -678,6 +710,7 @@ struct AGCConfig {
 #include "RFBoard.h"
 #include "LPFBoard.h"
 #include "BPFBoard.h"
+#include "MainBoard_Expanders.h"
 #include "CAT.h"
 #include "Storage.h"
 
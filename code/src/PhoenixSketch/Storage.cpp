@@ -62,6 +62,9 @@ void SaveDataToStorage(bool savetosd){
     doc["ANR_notchOn"] = ED.ANR_notchOn;
     doc["spectrumFloorAuto"] = ED.spectrumFloorAuto;
     doc["spectrumScale"] = ED.spectrumScale;
+    doc["waterfallFloor_dBm"] = ED.waterfallFloor_dBm;
+    doc["waterfallRange_dB"] = ED.waterfallRange_dB;
+    doc["waterfallPalette"] = ED.waterfallPalette;
     for(int i = 0; i < NUMBER_OF_BANDS; i++) {
         doc["spectrumNoiseFloor"][i] = ED.spectrumNoiseFloor[i];
     }
@@ -268,6 +271,9 @@ void RestoreDataFromStorage(void){
     ED.ANR_notchOn = doc["ANR_notchOn"] | ED.ANR_notchOn;
     ED.spectrumScale = doc["spectrumScale"] | ED.spectrumScale;
     ED.spectrumFloorAuto = doc["spectrumFloorAuto"] | ED.spectrumFloorAuto;
+    ED.waterfallFloor_dBm = doc["waterfallFloor_dBm"] | ED.waterfallFloor_dBm;
+    ED.waterfallRange_dB = doc["waterfallRange_dB"] | ED.waterfallRange_dB;
+    ED.waterfallPalette = doc["waterfallPalette"] | ED.waterfallPalette;
     if (doc["spectrumNoiseFloor"].is<JsonArray>()) {
         for(int i = 0; i < NUMBER_OF_BANDS; i++) {
             ED.spectrumNoiseFloor[i] = doc["spectrumNoiseFloor"][i] | ED.spectrumNoiseFloor[i];
@@ -493,6 +499,9 @@ void RestoreDataFromSDCard(void){
     ED.ANR_notchOn = doc["ANR_notchOn"] | ED.ANR_notchOn;
     ED.spectrumScale = doc["spectrumScale"] | ED.spectrumScale;
     ED.spectrumFloorAuto = doc["spectrumFloorAuto"] | ED.spectrumFloorAuto;
+    ED.waterfallFloor_dBm = doc["waterfallFloor_dBm"] | ED.waterfallFloor_dBm;
+    ED.waterfallRange_dB = doc["waterfallRange_dB"] | ED.waterfallRange_dB;
+    ED.waterfallPalette = doc["waterfallPalette"] | ED.waterfallPalette;
     if (doc["spectrumNoiseFloor"].is<JsonArray>()) {
         for(int i = 0; i < NUMBER_OF_BANDS; i++) {
             ED.spectrumNoiseFloor[i] = doc["spectrumNoiseFloor"][i] | ED.spectrumNoiseFloor[i];
@@ -688,6 +697,9 @@ void PrintEDToSerial(void){
     Serial.print("ANR_notchOn:       "); Serial.println(ED.ANR_notchOn);
     Serial.print("spectrumScale:     "); Serial.println(ED.spectrumScale);
     Serial.print("spectrumFloorAuto: "); Serial.println(ED.spectrumFloorAuto);
+    Serial.print("waterfallFloor_dBm:"); Serial.println(ED.waterfallFloor_dBm);
+    Serial.print("waterfallRange_dB: "); Serial.println(ED.waterfallRange_dB);
+    Serial.print("waterfallPalette:  "); Serial.println(ED.waterfallPalette);
     Serial.print("spectrumNoiseFloor:");
     for(int i = 0; i < NUMBER_OF_BANDS; i++) {
         Serial.print(ED.spectrumNoiseFloor[i]);
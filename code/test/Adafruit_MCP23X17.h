@@ -19,16 +19,17 @@ public:
     void pinMode(uint8_t pin, uint8_t mode) {}
     void digitalWrite(uint8_t pin, uint8_t value) {}
     uint8_t digitalRead(uint8_t pin) { return 0; }
-    void writeGPIOA(uint8_t value) {gpioval = (gpioval & 0x00FF) | (value << 8);}
-    void writeGPIOB(uint8_t value) {gpioval = (gpioval & 0xFF00) | (value);}
+    // As in the library, GPIOA is the low byte and GPIOB the high byte of GPIOAB
+    void writeGPIOA(uint8_t value) {gpioval = (gpioval & 0xFF00) | (value);}
+    void writeGPIOB(uint8_t value) {gpioval = (gpioval & 0x00FF) | (value << 8);}
     void writeGPIOAB(uint16_t value) {gpioval = value;}
-    uint8_t readGPIOA() { return (uint8_t)((gpioval >> 8) & 0x00FF); }
-    uint8_t readGPIOB() { return (uint8_t)((gpioval) & 0x00FF);; }
+    uint8_t readGPIOA() { return (uint8_t)((gpioval) & 0x00FF); }
+    uint8_t readGPIOB() { return (uint8_t)((gpioval >> 8) & 0x00FF); }
     uint16_t readGPIOAB() { return gpioval; }
     void setupInterruptPin(uint8_t pin, uint8_t mode) {}
     uint8_t getLastInterruptPin() { return MCP23XXX_INT_ERR; }
     void clearInterrupts() {}
     void setupInterrupts(bool mirror, bool openDrain, uint8_t polarity) {}
 private:
-    uint16_t gpioval;
+    uint16_t gpioval = 0;
 };
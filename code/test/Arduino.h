@@ -92,6 +92,11 @@ public:
         _interval_us = 0;
     }
 
+    // Test hooks: nothing runs the callback on the host, tests fire it by hand
+    bool isRunning() const { return _callback != nullptr; }
+    uint32_t interval() const { return _interval_us; }
+    void fire() { if (_callback) _callback(); }
+
 private:
     voidFuncPtr _callback;
     uint32_t _interval_us;
@@ -548,6 +548,11 @@ TEST(CAT, FBWriteVFOIndependence){
 }
 
 TEST(CAT, CATSerialVFOChange){
+    // A T/R sequence still running from an earlier test would hold the retune
+    while (IsRFHardwareSequenceBusy()){
+        TickRFHardwareSequence();
+        ServiceRFHardwareSequence();
+    }
     // Save initial state
     ED.activeVFO = VFO_A;
     int32_t initialBand = ED.currentBand[ED.activeVFO];
@@ -32,7 +32,7 @@ static std::thread timer_thread;
  * Dispatches DO events to the state machines
  */
 void timer1ms(void) {
-    ModeSm_dispatch_event(&modeSM, ModeSm_EventId_DO);
+    TickRFHardwareAndModeSm();
     UISm_dispatch_event(&uiSM, UISm_EventId_DO);
 }
 
@@ -63,6 +63,15 @@ void stop_timer1ms() {
     }
 }
 
+/**
+ * Run the steps of the T/R sequence as loop() would until the sequence ends
+ */
+static void WaitForRFHardware(void){
+    for (size_t k = 0; (k < 1000) && IsRFHardwareSequenceBusy(); k++){
+        ServiceRFHardwareSequence();
+        MyDelay(1);
+    }
+}
 
 void SelectCalibrationMenu(void){
     // Check the state before loop is invoked and then again after
@@ -209,6 +218,11 @@ protected:
     void TearDown() override {
         // Clean up after each test
         stop_timer1ms(); // Stop the timer thread to prevent crashes during teardown
+        // Let the hardware settle so the next test starts from a complete state
+        while (IsRFHardwareSequenceBusy()){
+            TickRFHardwareSequence();
+            ServiceRFHardwareSequence();
+        }
     }
 };
 
@@ -932,13 +946,13 @@ TEST_F(CalibrationTest, Test100WFitInPowerCal) {
 
 void CheckThatHardwareRegisterMatchesActualHardware(){
     // LPF
-    uint16_t gpioab = GetLPFMCPRegisters(); // a is upper half, b is lower half
-    EXPECT_EQ((uint8_t)(gpioab & 0x00FF), (uint8_t)(hardwareRegister & 0x000000FF)); // gpiob
-    EXPECT_EQ((uint8_t)((gpioab >> 8) & 0x0003), (uint8_t)((hardwareRegister >> 8) & 0x00000003));
+    uint16_t gpioab = GetLPFMCPRegisters(); // a is lower half, b is upper half
+    EXPECT_EQ((uint8_t)((gpioab >> 8) & 0x00FF), (uint8_t)(hardwareRegister & 0x000000FF)); // gpiob
+    EXPECT_EQ((uint8_t)(gpioab & 0x0003), (uint8_t)((hardwareRegister >> 8) & 0x00000003));
     // RF
     gpioab = GetRFMCPRegisters();
-    EXPECT_EQ((uint8_t)(gpioab & 0x003F), (uint8_t)((hardwareRegister >> TXATTLSB) & 0x0000003F)); // tx atten
-    EXPECT_EQ((uint8_t)((gpioab >> 8) & 0x003F), (uint8_t)((hardwareRegister >> RXATTLSB) & 0x0000003F));
+    EXPECT_EQ((uint8_t)((gpioab >> 8) & 0x003F), (uint8_t)((hardwareRegister >> TXATTLSB) & 0x0000003F)); // tx atten
+    EXPECT_EQ((uint8_t)(gpioab & 0x003F), (uint8_t)((hardwareRegister >> RXATTLSB) & 0x0000003F));
     // BPF
     gpioab = GetBPFMCPRegisters();
     EXPECT_EQ(gpioab, BPF_WORD);
@@ -1046,7 +1060,7 @@ TEST_F(CalibrationTest, CalibrateTransmitIQState) {
     Serial.println("2-Entering TX IQ mark state");
 
     SetInterrupt(iPTT_PRESSED);
-    loop(); MyDelay(10);
+    loop(); WaitForRFHardware();
     EXPECT_EQ(uiSM.state_id,UISm_StateId_CALIBRATE_TX_IQ);
     EXPECT_EQ(modeSM.state_id, ModeSm_StateId_CALIBRATE_TX_IQ_MARK);
     CheckThatStateIsCalTransmitIQ();
@@ -1056,7 +1070,7 @@ TEST_F(CalibrationTest, CalibrateTransmitIQState) {
     // Release PTT to go back to CAL IQ transmit space mode
     Serial.println("3-Entering TX IQ space state");
     SetInterrupt(iPTT_RELEASED);
-    loop(); MyDelay(10);
+    loop(); WaitForRFHardware();
 
     CheckThatRegisterStateIsReceive();
     EXPECT_EQ(modeSM.state_id,ModeSm_StateId_CALIBRATE_TX_IQ_SPACE);
@@ -34,6 +34,18 @@ void FFT256Reverse(float32_t *buffer){
     arm_cfft_radix2_f32(&Srev,buffer);
 }
 
+void FFT128Forward(float32_t *buffer){
+    arm_cfft_radix2_instance_f32 Sfor;
+    arm_cfft_radix2_init_f32(&Sfor, 128, 0, 1);
+    arm_cfft_radix2_f32(&Sfor,buffer);
+}
+
+void FFT128Reverse(float32_t *buffer){
+    arm_cfft_radix2_instance_f32 Srev;
+    arm_cfft_radix2_init_f32(&Srev, 128, 1, 1);
+    arm_cfft_radix2_f32(&Srev,buffer);
+}
+
 void FFT512Forward(float32_t *buffer){
     arm_cfft_radix2_instance_f32 S;
     arm_cfft_radix2_init_f32(&S, 512, 0, 1);
@@ -46,6 +58,18 @@ void FFT512Reverse(float32_t *buffer){
     arm_cfft_radix2_f32(&S,buffer);
 }
 
+void FFT1024Forward(float32_t *buffer){
+    arm_cfft_radix2_instance_f32 S;
+    arm_cfft_radix2_init_f32(&S, 1024, 0, 1);
+    arm_cfft_radix2_f32(&S,buffer);
+}
+
+void FFT2048Forward(float32_t *buffer){
+    arm_cfft_radix2_instance_f32 S;
+    arm_cfft_radix2_init_f32(&S, 2048, 0, 1);
+    arm_cfft_radix2_f32(&S,buffer);
+}
+
 // These really don't belong here, but it saves the bother of creating another stub
 void WriteIQFile(DataBlock *data, const char* fname){
     FILE *file2 = fopen(fname, "a");
@@ -9,6 +9,7 @@
 
 #include <gtest/gtest.h>
 #include "SDT.h"
+#include "RA8875.h"
 
 #include <thread>
 #include <chrono>
@@ -24,7 +25,7 @@ static std::thread timer_thread;
  * Dispatches DO events to the state machines
  */
 void timer1ms(void) {
-    ModeSm_dispatch_event(&modeSM, ModeSm_EventId_DO);
+    TickRFHardwareAndModeSm();
     UISm_dispatch_event(&uiSM, UISm_EventId_DO);
 }
 
@@ -65,6 +66,9 @@ protected:
     void SetUp() override {
         // Initialize test environment before each test
         // TODO: Add setup code (e.g., initialize ED structure, display state)
+        // Drawing time on the host says nothing about the radio, so let every pane
+        // draw on every call. The scheduler test sets its own budget.
+        SetDisplayBudget_us(UINT32_MAX);
     }
 
     void TearDown() override {
@@ -130,6 +134,349 @@ TEST_F(DisplayTest, MenuRedrawn) {
 
 }
 
+/**
+ * Run the home screen until one spectrum sweep has been drawn from the latest PSD frame
+ */
+static void DrawSpectrumSweep(void){
+    MyDelay(60); // longer than SPECTRUM_REFRESH_MS
+    for (int i = 0; i < 10; i++) DrawHome();
+}
+
+/**
+ * Bring the radio up to the home screen in SSB receive, then stop the timer so the
+ * test drives DrawHome() itself
+ */
+static void StartHomeScreen(void){
+    Q_in_L.setChannel(0);
+    Q_in_R.setChannel(1);
+    Q_in_L.clear();
+    Q_in_R.clear();
+    // The display timers are not reset between tests, so keep the clock running
+    static bool clockStarted = false;
+    if (!clockStarted) StartMillis();
+    clockStarted = true;
+
+    InitializeStorage();
+    InitializeFrontPanel();
+    InitializeSignalProcessing();
+    InitializeAudio();
+    InitializeDisplay();
+    InitializeRFHardware();
+    modeSM.vars.waitDuration_ms = CW_TRANSMIT_SPACE_TIMEOUT_MS;
+    modeSM.vars.ditDuration_ms = DIT_DURATION_MS;
+    ModeSm_start(&modeSM);
+    ED.agc = AGCOff;
+    ED.nrOptionSelect = NROff;
+    ED.spectrumFloorAuto = false;
+    uiSM.vars.splashDuration_ms = 1;
+    UISm_start(&uiSM);
+    UpdateAudioIOState();
+    start_timer1ms();
+    loop(); MyDelay(10);
+    stop_timer1ms();
+    ASSERT_EQ(uiSM.state_id, UISm_StateId_HOME);
+    ASSERT_EQ(modeSM.state_id, ModeSm_StateId_SSB_RECEIVE);
+}
+
+/**
+ * Test that the spectrum trace is drawn differentially: an unchanged frame sends no
+ * trace commands, a local change sends commands only for the columns around it, and
+ * changed runs are published to L1 with few BTE operations.
+ */
+TEST_F(DisplayTest, SpectrumDirtyColumns) {
+    StartHomeScreen();
+
+    // A noise-like spectrum with plenty of structure, well inside the pane
+    float32_t psd[SPECTRUM_RES];
+    for (int i = 0; i < SPECTRUM_RES; i++)
+        psd[i] = -3.0f + 0.5f * sinf(0.37f * i) + 0.3f * cosf(1.3f * i);
+
+    // Prime the display (first sweep clears L2 and draws every column)
+    PublishPSDFrame(psd); DrawSpectrumSweep();
+    PublishPSDFrame(psd); DrawSpectrumSweep();
+
+    // Identical frame: nothing to redraw and nothing to publish
+    RA8875_ResetCallCounts();
+    PublishPSDFrame(psd); DrawSpectrumSweep();
+    EXPECT_EQ(RA8875_callCounts.drawLine, 0u);
+    uint32_t idleBTE = RA8875_callCounts.BTE_move;
+    EXPECT_LE(idleBTE, 1u); // at most the waterfall scroll
+
+    // Two narrow peaks: only the neighbouring columns are redrawn, one run each
+    psd[100] += 1.0f; psd[101] += 1.0f;
+    psd[400] += 1.0f;
+    RA8875_ResetCallCounts();
+    PublishPSDFrame(psd); DrawSpectrumSweep();
+    EXPECT_GT(RA8875_callCounts.drawLine, 0u);
+    EXPECT_LE(RA8875_callCounts.drawLine, 8u);
+    EXPECT_LE(RA8875_callCounts.BTE_move, 3u);
+    EXPECT_GE(RA8875_callCounts.BTE_move, 2u);
+
+    // Whole spectrum moves: every column is redrawn, published in a single blit
+    for (int i = 0; i < SPECTRUM_RES; i++) psd[i] += 0.5f;
+    RA8875_ResetCallCounts();
+    PublishPSDFrame(psd); DrawSpectrumSweep();
+    EXPECT_EQ(RA8875_callCounts.drawLine, (uint32_t)SPECTRUM_RES);
+    EXPECT_LE(RA8875_callCounts.BTE_move, 2u);
+}
+
+/**
+ * Test that a filter change redraws the passband highlight: the spectrum pane goes
+ * stale, L2 is cleared and every trace column is redrawn over the new background,
+ * even though the PSD frame itself has not changed.
+ */
+TEST_F(DisplayTest, SpectrumFilterChangeRedrawsHighlight) {
+    StartHomeScreen();
+
+    float32_t psd[SPECTRUM_RES];
+    for (int i = 0; i < SPECTRUM_RES; i++)
+        psd[i] = -3.0f + 0.5f * sinf(0.37f * i);
+    PublishPSDFrame(psd); DrawSpectrumSweep();
+    PublishPSDFrame(psd); DrawSpectrumSweep();
+    RA8875_ResetCallCounts();
+    PublishPSDFrame(psd); DrawSpectrumSweep();
+    ASSERT_EQ(RA8875_callCounts.drawLine, 0u);
+
+    // Narrow the filter as the filter encoder does
+    int32_t FHiCut_Hz = bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz;
+    bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = FHiCut_Hz - 500;
+    RA8875_ResetCallCounts();
+    PublishPSDFrame(psd); DrawSpectrumSweep();
+    EXPECT_EQ(RA8875_callCounts.drawLine, (uint32_t)SPECTRUM_RES);
+    EXPECT_GT(RA8875_callCounts.fillRect, 0u);
+
+    // Nothing more to do once the new highlight is drawn
+    RA8875_ResetCallCounts();
+    PublishPSDFrame(psd); DrawSpectrumSweep();
+    EXPECT_EQ(RA8875_callCounts.drawLine, 0u);
+
+    // The same for the other edge
+    int32_t FLoCut_Hz = bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz;
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = FLoCut_Hz + 100;
+    RA8875_ResetCallCounts();
+    PublishPSDFrame(psd); DrawSpectrumSweep();
+    EXPECT_EQ(RA8875_callCounts.drawLine, (uint32_t)SPECTRUM_RES);
+
+    bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = FHiCut_Hz;
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = FLoCut_Hz;
+}
+
+/**
+ * Test the RA8875 command cost model: SPI bytes and BTE operations charged per call,
+ * and attribution to the pane named by DisplayPaneProfile()
+ */
+TEST_F(DisplayTest, RA8875CostModel) {
+    RA8875 display(0, 0);
+    display.begin(RA8875_800x480, 8, 20000000UL, 4000000UL);
+    RA8875_ResetCost();
+
+    DisplayPaneProfile("PaneA");
+    display.fillRect(0, 0, 10, 10, RA8875_BLACK);   // 12 registers + status poll
+    display.BTE_move(0, 0, 10, 20, 100, 0, 2, 1);    // 14 registers + status poll
+    DisplayPaneProfile("PaneB");
+    uint16_t pixels[20] = {0};
+    display.writeRect(0, 0, 10, 2, pixels);         // 20 registers + memory write + 1 byte/pixel
+    display.print("abc");                           // text mode + memory write + 4 bytes/char
+    DisplayPaneProfile(NULL);
+    display.drawLine(0, 0, 0, 9, RA8875_YELLOW);    // outside any pane
+    RA8875_EndCostFrame();
+
+    RA8875Cost a = RA8875_GetFrameCost("PaneA");
+    EXPECT_EQ(a.calls, 2u);
+    EXPECT_EQ(a.spiBytes, 50u + 58u);
+    EXPECT_EQ(a.bteOps, 1u);
+    EXPECT_EQ(a.pixels, 300u);
+    RA8875Cost b = RA8875_GetFrameCost("PaneB");
+    EXPECT_EQ(b.calls, 2u);
+    EXPECT_EQ(b.spiBytes, 103u + 23u);
+    EXPECT_EQ(b.bteOps, 0u);
+    RA8875Cost all = RA8875_GetFrameCost(NULL);
+    EXPECT_EQ(all.calls, 5u);
+    EXPECT_EQ(all.spiBytes, 50u + 58u + 103u + 23u + 50u);
+    EXPECT_EQ(RA8875_GetFrameCost("NoSuchPane").calls, 0u);
+
+    // The last-frame figures cover one frame only; the totals accumulate
+    DisplayPaneProfile("PaneA");
+    display.fillRect(0, 0, 10, 10, RA8875_BLACK);
+    RA8875_EndCostFrame();
+    EXPECT_EQ(RA8875_GetFrameCost("PaneA").calls, 1u);
+    EXPECT_EQ(RA8875_GetTotalCost("PaneA").calls, 3u);
+    EXPECT_EQ(RA8875_GetCostFrames(), 2u);
+    EXPECT_NEAR(RA8875_EstimatedMicros(RA8875_GetFrameCost("PaneA")), 50 / 2.5 + 100 / 30.0, 0.01);
+}
+
+/**
+ * Test that the home screen attributes the spectrum sweep to PaneSpectrum and that
+ * the cost model sees the saving of the dirty-column renderer
+ */
+TEST_F(DisplayTest, SpectrumPaneCost) {
+    StartHomeScreen();
+
+    float32_t psd[SPECTRUM_RES];
+    for (int i = 0; i < SPECTRUM_RES; i++)
+        psd[i] = -3.0f + 0.5f * sinf(0.37f * i);
+    PublishPSDFrame(psd); DrawSpectrumSweep();
+
+    // A sweep where the whole trace moves
+    for (int i = 0; i < SPECTRUM_RES; i++) psd[i] += 0.5f;
+    RA8875_ResetCost();
+    PublishPSDFrame(psd); DrawSpectrumSweep();
+    RA8875_EndCostFrame();
+    RA8875Cost moved = RA8875_GetFrameCost("PaneSpectrum");
+
+    // A sweep where nothing moves
+    PublishPSDFrame(psd); DrawSpectrumSweep();
+    RA8875_EndCostFrame();
+    RA8875Cost still = RA8875_GetFrameCost("PaneSpectrum");
+
+    EXPECT_GE(moved.calls, (uint32_t)SPECTRUM_RES);
+    EXPECT_GT(moved.spiBytes, 50u * SPECTRUM_RES);
+    EXPECT_LT(still.spiBytes * 2, moved.spiBytes);
+    EXPECT_GT(RA8875_GetFrameCost(NULL).spiBytes, still.spiBytes - 1);
+    RA8875_PrintCostReport();
+}
+
+/**
+ * Test that the home screen draws its panes in priority order within the display
+ * budget, and that the panes left over are drawn by later calls
+ */
+TEST_F(DisplayTest, PaneSchedulerKeepsToBudget) {
+    // VFO B is drawn along with VFO A, and the state of health pane is blank in receive
+    static const char *panes[] = {"PaneVFOA","PaneFreqBandMod","PaneSpectrum",
+                                  "PaneTime","PaneSWR","PaneTXRXStatus",
+                                  "PaneSMeter","PaneAudioSpectrum","PaneSettings",
+                                  "PaneNameBadge","PaneSAMOffset"};
+    StartHomeScreen();
+    DrawHome();
+
+    // With no time to spare only the most important pane is drawn per call
+    SetDisplayBudget_us(0);
+    uint32_t deferred = GetDeferredPaneDraws();
+    uiSM.vars.clearScreen = true;
+    RA8875_ResetCost();
+    DrawHome();
+    RA8875_EndCostFrame();
+    EXPECT_GT(RA8875_GetFrameCost("PaneVFOA").calls, 0u);
+    EXPECT_EQ(RA8875_GetFrameCost("PaneNameBadge").calls, 0u);
+    EXPECT_GT(GetDeferredPaneDraws(), deferred);
+
+    // Every pane is drawn in the end, including the lowest priority ones
+    for (int i = 0; i < 100; i++){
+        DrawHome();
+        RA8875_EndCostFrame();
+    }
+    for (const char *pane : panes)
+        EXPECT_GT(RA8875_GetTotalCost(pane).calls, 0u) << pane;
+
+    // With time to spare the whole screen is drawn at once
+    SetDisplayBudget_us(UINT32_MAX);
+    uiSM.vars.clearScreen = true;
+    RA8875_ResetCost();
+    DrawHome();
+    RA8875_EndCostFrame();
+    EXPECT_GT(RA8875_GetFrameCost("PaneNameBadge").calls, 0u);
+    EXPECT_GT(RA8875_GetFrameCost("PaneTime").calls, 0u);
+}
+
+/**
+ * Test that a tuning step redraws only the VFO digits that changed, and that the
+ * whole frequency is drawn again after the screen is cleared
+ */
+TEST_F(DisplayTest, VFODigitsRedrawnInPlace) {
+    StartHomeScreen();
+    int64_t fineTune_Hz = ED.fineTuneFreq_Hz[ED.activeVFO];
+    // Put a 3 in the last digit so that the next step changes no other digit
+    ED.fineTuneFreq_Hz[ED.activeVFO] += GetTXRXFreq(ED.activeVFO) % 10 - 3;
+    DrawHome();
+
+    RA8875_ResetCost();
+    ED.fineTuneFreq_Hz[ED.activeVFO] -= 1;
+    DrawHome();
+    RA8875_EndCostFrame();
+    RA8875Cost step = RA8875_GetFrameCost("PaneVFOA");
+    EXPECT_EQ(GetTXRXFreq(ED.activeVFO) % 10, 4);
+
+    RA8875_ResetCost();
+    uiSM.vars.clearScreen = true;
+    DrawHome();
+    RA8875_EndCostFrame();
+    RA8875Cost full = RA8875_GetFrameCost("PaneVFOA");
+
+    EXPECT_GT(step.calls, 0u);
+    EXPECT_LT(step.pixels * 4, full.pixels);
+    EXPECT_LT(step.spiBytes, full.spiBytes);
+    EXPECT_GE(full.pixels, (uint64_t)280 * 50);
+
+    ED.fineTuneFreq_Hz[ED.activeVFO] = fineTune_Hz;
+}
+
+/**
+ * PSD bin value for a power in dBm (the inverse of the display's power mapping)
+ */
+static float32_t PSDFromdBm(float32_t dBm){
+    return (dBm - RECEIVE_POWER_OFFSET) / 10.0f;
+}
+
+/**
+ * Test that WaterfallLine() maps PSD power to colour through the waterfall floor,
+ * range and palette settings, independent of the spectrum display settings
+ */
+TEST_F(DisplayTest, WaterfallColourMapping) {
+    ED.waterfallFloor_dBm = -140;
+    ED.waterfallRange_dB = 60;
+    ED.waterfallPalette = WaterfallPaletteGrey;
+
+    float32_t psd[8] = {PSDFromdBm(-200), PSDFromdBm(-140), PSDFromdBm(-125), PSDFromdBm(-110),
+                        PSDFromdBm(-95), PSDFromdBm(-80), PSDFromdBm(0), -INFINITY};
+    uint16_t line[8];
+    WaterfallLine(psd, line, 8);
+    EXPECT_EQ(line[0], 0x0000);     // below the floor clamps to the first colour
+    EXPECT_EQ(line[1], 0x0000);
+    EXPECT_EQ(line[5], 0xFFFF);     // floor + range is the last colour
+    EXPECT_EQ(line[6], 0xFFFF);     // above the range clamps
+    EXPECT_EQ(line[7], 0x0000);
+    // Grey levels rise with power: compare the green channel
+    EXPECT_LT(line[1] & 0x07E0, line[2] & 0x07E0);
+    EXPECT_LT(line[2] & 0x07E0, line[3] & 0x07E0);
+    EXPECT_LT(line[3] & 0x07E0, line[4] & 0x07E0);
+    EXPECT_LT(line[4] & 0x07E0, line[5] & 0x07E0);
+    uint16_t mid = line[3];
+
+    // The spectrum scale and floor do not affect the waterfall
+    int32_t scale = ED.spectrumScale;
+    ED.spectrumScale = 4;
+    ED.spectrumNoiseFloor[ED.currentBand[ED.activeVFO]] += 30;
+    WaterfallLine(psd, line, 8);
+    EXPECT_EQ(line[3], mid);
+    ED.spectrumScale = scale;
+    ED.spectrumNoiseFloor[ED.currentBand[ED.activeVFO]] -= 30;
+
+    // A narrower range raises the contrast: -110 dBm is now at the top of the palette
+    ED.waterfallRange_dB = 30;
+    WaterfallLine(psd, line, 8);
+    EXPECT_EQ(line[3], 0xFFFF);
+    EXPECT_EQ(line[1], 0x0000);
+
+    // Raising the floor darkens everything below it
+    ED.waterfallFloor_dBm = -100;
+    WaterfallLine(psd, line, 8);
+    EXPECT_EQ(line[3], 0x0000);
+
+    // Changing the palette rebuilds the table
+    ED.waterfallFloor_dBm = -140;
+    ED.waterfallRange_dB = 60;
+    ED.waterfallPalette = WaterfallPaletteHeat;
+    WaterfallLine(psd, line, 8);
+    EXPECT_EQ(line[1], 0x0000);
+    EXPECT_EQ(line[5], 0xFFFF);
+    EXPECT_EQ(line[3] & 0x001F, 0);    // the middle of the heat palette has no blue
+    EXPECT_NE(line[3], mid);
+    ED.waterfallPalette = WaterfallPaletteClassic;
+    WaterfallLine(psd, line, 8);
+    EXPECT_EQ(line[1], 0x0000);     // first and last entries of the original gradient
+    EXPECT_EQ(line[5], 0xF88F);
+}
+
 /**
  * Test IncrementVariable() with TYPE_I8
  * Verifies that 8-bit integer variables are incremented correctly
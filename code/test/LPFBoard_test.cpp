@@ -650,6 +650,97 @@ TEST_F(LPFBoardTest, UpdateMCPRegistersBothChanged) {
     EXPECT_EQ(GetLPFMCPBOld(), 0xCD);
 }
 
+TEST_F(LPFBoardTest, UpdateMCPRegistersBothChangedIsOneTransaction) {
+    SetLPFRegister(0x02CD);
+    SetLPFMCPAOld(0x03);
+    SetLPFMCPBOld(0x34);
+    ResetExpanderTransactions();
+
+    UpdateMCPRegisters();
+
+    EXPECT_EQ(GetExpanderTransactions(), (uint32_t)1);
+    EXPECT_EQ(GetLPFMCPRegisters(), 0xCD02); // GPIOB is the upper half
+}
+
+// ================== EXPANDER BATCH TESTS ==================
+
+TEST_F(LPFBoardTest, ExpanderBatchDefersWrites) {
+    SetLPFMCPAOld(0x00);
+    SetLPFMCPBOld(0x00);
+    ResetExpanderTransactions();
+
+    BeginExpanderBatch();
+    TXSelectBPF();
+    SelectXVTR();
+    BypassXVTR();
+    Select100WPA();
+    // Nothing is written until the batch ends
+    EXPECT_EQ(GetLPFMCPAOld(), 0x00);
+    EXPECT_EQ(GetLPFMCPBOld(), 0x00);
+    EXPECT_EQ(GetExpanderTransactions(), (uint32_t)0);
+    EndExpanderBatch();
+
+    // Both ports in one write, with only the final values
+    EXPECT_EQ(GetExpanderTransactions(), (uint32_t)1);
+    EXPECT_EQ(GetLPFMCPAOld(), (uint8_t)(GetLPFRegister() >> 8));
+    EXPECT_EQ(GetLPFMCPBOld(), (uint8_t)(GetLPFRegister() & 0xFF));
+}
+
+TEST_F(LPFBoardTest, ExpanderBatchDropsChangesThatAreUndone) {
+    SetLPFMCPAOld(0x00);
+    SetLPFMCPBOld(0x00);
+    ResetExpanderTransactions();
+
+    BeginExpanderBatch();
+    TXSelectBPF();
+    RXSelectBPF();
+    TXBypassBPF();
+    RXBypassBPF();
+    EndExpanderBatch();
+
+    EXPECT_EQ(GetExpanderTransactions(), (uint32_t)0);
+}
+
+TEST_F(LPFBoardTest, ExpanderBatchesNest) {
+    SetLPFMCPAOld(0x00);
+    SetLPFMCPBOld(0x00);
+    ResetExpanderTransactions();
+
+    BeginExpanderBatch();
+    BeginExpanderBatch();
+    TXSelectBPF();
+    EndExpanderBatch();
+    EXPECT_EQ(GetExpanderTransactions(), (uint32_t)0);
+    EndExpanderBatch();
+    EXPECT_EQ(GetExpanderTransactions(), (uint32_t)1);
+
+    // An unmatched end is ignored and later writes go out at once
+    EndExpanderBatch();
+    TXBypassBPF();
+    EXPECT_EQ(GetExpanderTransactions(), (uint32_t)2);
+}
+
+TEST_F(LPFBoardTest, ExpanderBatchInInterruptDoesNotJoinLoopBatch) {
+    SetLPFMCPAOld(0x00);
+    SetLPFMCPBOld(0x00);
+    ResetExpanderTransactions();
+
+    // The main loop has a batch open when the 1 ms tick changes the hardware
+    BeginExpanderBatch();
+    SetExpanderInterruptContext(true);
+    BeginExpanderBatch();
+    TXSelectBPF();
+    EndExpanderBatch();
+    SetExpanderInterruptContext(false);
+    EXPECT_EQ(GetExpanderTransactions(), (uint32_t)1);
+
+    // The loop batch is still open
+    TXBypassBPF();
+    EXPECT_EQ(GetExpanderTransactions(), (uint32_t)1);
+    EndExpanderBatch();
+    EXPECT_EQ(GetExpanderTransactions(), (uint32_t)2);
+}
+
 // ================== UPDATED TXSELECTBPF FUNCTION TESTS ==================
 
 TEST_F(LPFBoardTest, TXSelectBPFUpdatesRegisterAndHardware) {
@@ -22,6 +22,8 @@
  */
 
 extern ReceiveFilterConfig RXfilters;
+extern float32_t NR_G[NR_FFT_L / 2];
+extern float32_t NR_last_iFFT_result[NR_FFT_L / 2];
 
 namespace {
 
@@ -211,3 +213,162 @@ TEST(NoiseReduction, XanrRecoversFromTransientNan) {
 
     EXPECT_TRUE(AllFinite(data.Q, kFrame));
 }
+
+// ---------------------------------------------------------------------------
+// The NR engines transform real frames with RealFFT256Forward/Reverse.
+//
+// The half spectrum must match the first 128 bins of the complex FFT of the
+// same frame, with the Nyquist bin packed into the imaginary slot of bin 0,
+// and the inverse must return the frame. Only the 128-point complex FFT under
+// RealFFT256Forward/Reverse is stubbed, so this checks the same split and merge
+// code that runs on the Teensy.
+// ---------------------------------------------------------------------------
+TEST(NoiseReduction, RealFFT256MatchesComplexFFT) {
+    float32_t x[kFrame];
+    float32_t scratch[kFrame];
+    float32_t half[kFrame];
+    float32_t back[kFrame];
+    float32_t full[2 * kFrame];
+    uint32_t seed = 7;
+    for (uint32_t i = 0; i < kFrame; i++) {
+        seed = seed * 1664525 + 1013904223;
+        x[i] = 0.3f * sinf(2.0f * (float32_t)M_PI * 11.3f * i / kFrame)
+             + ((float32_t)(seed >> 8) / 16777216.0f - 0.5f);
+        full[2 * i] = x[i];
+        full[2 * i + 1] = 0.0f;
+    }
+    memcpy(scratch, x, sizeof(x));
+    RealFFT256Forward(scratch, half);
+    FFT256Forward(full);
+
+    EXPECT_NEAR(half[0], full[0], 1e-4);
+    EXPECT_NEAR(half[1], full[kFrame], 1e-4);
+    for (uint32_t k = 1; k < kFrame / 2; k++) {
+        EXPECT_NEAR(half[2 * k], full[2 * k], 1e-4) << "bin " << k;
+        EXPECT_NEAR(half[2 * k + 1], full[2 * k + 1], 1e-4) << "bin " << k;
+    }
+
+    RealFFT256Reverse(half, back);
+    for (uint32_t i = 0; i < kFrame; i++) {
+        EXPECT_NEAR(back[i], x[i], 1e-5) << "sample " << i;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Kim NR on real frames: after learning a noise floor it attenuates the noise,
+// and a tone that then appears well above it passes.
+// ---------------------------------------------------------------------------
+TEST(NoiseReduction, Kim1AttenuatesNoiseAndPassesToneOnset) {
+    SetupBand();
+    InitializeKim1NoiseReduction();
+
+    float32_t I[kFrame];
+    float32_t Q[kFrame];
+    DataBlock data;
+    data.I = I;
+    data.Q = Q;
+    data.N = kFrame;
+    data.sampleRate_Hz = kSampleRate;
+
+    uint32_t seed = 3;
+    float32_t noiseIn = 0, noiseOut = 0, tonePeak = 0;
+    for (int f = 0; f < 34; f++) {
+        FillTone(I, Q, kFrame, (float32_t)f * kFrame);
+        for (uint32_t i = 0; i < kFrame; i++) {
+            seed = seed * 1664525 + 1013904223;
+            float32_t n = 0.02f * ((float32_t)(seed >> 8) / 16777216.0f - 0.5f);
+            I[i] = (f < 30) ? n : I[i] + n;
+            if (f >= 20 && f < 30) noiseIn += I[i] * I[i];
+        }
+        Kim1_NR(&data);
+        for (uint32_t i = 0; i < kFrame; i++) {
+            if (f >= 20 && f < 30) noiseOut += I[i] * I[i];
+            if (f >= 31) tonePeak = fmaxf(tonePeak, fabsf(I[i]));
+        }
+    }
+    EXPECT_TRUE(AllFinite(data.I, kFrame));
+    EXPECT_LT(noiseOut, noiseIn / 4);   // at least 6 dB of noise reduction
+    EXPECT_GT(tonePeak, 0.05f);         // the gain smoothing slows the onset
+}
+
+// ---------------------------------------------------------------------------
+// Kim NR on the half spectrum matches the full complex FFT path it replaced.
+//
+// After Kim1_NR returns, NR_G holds the gains of the last frame and
+// NR_last_iFFT_result holds the second half of that frame's inverse FFT. The
+// test rebuilds that frame, weights the full 256-bin complex spectrum with the
+// gains and compares the result. Bins k and 256-k share gain[k] and the Nyquist
+// bin takes gain[127]. The pre-real-FFT code applied gain[k] to bin 255-k, so
+// the check also confirms that this mapping no longer matches.
+// ---------------------------------------------------------------------------
+namespace {
+
+// Second half of ifft(G * fft(frame)) with gain[k] applied to bin 'mirror - k'
+void ReferenceKimTail(const float32_t *frame, uint32_t mirror, float32_t *tail) {
+    float32_t spec[2 * kFrame];
+    for (uint32_t i = 0; i < kFrame; i++) {
+        spec[2 * i] = frame[i];
+        spec[2 * i + 1] = 0.0f;
+    }
+    FFT256Forward(spec);
+    float32_t scale[kFrame];
+    for (uint32_t b = 0; b < kFrame; b++) scale[b] = 1.0f;
+    scale[kFrame / 2] = NR_G[kFrame / 2 - 1];
+    for (uint32_t k = 0; k < kFrame / 2; k++) {
+        scale[k] = NR_G[k];
+        if (k > 0 && mirror - k < kFrame) scale[mirror - k] = NR_G[k];
+    }
+    for (uint32_t b = 0; b < kFrame; b++) {
+        spec[2 * b] *= scale[b];
+        spec[2 * b + 1] *= scale[b];
+    }
+    FFT256Reverse(spec);
+    for (uint32_t i = 0; i < kFrame / 2; i++) tail[i] = spec[2 * (kFrame / 2 + i)];
+}
+
+} // namespace
+
+TEST(NoiseReduction, Kim1HalfSpectrumMatchesComplexFFTPath) {
+    SetupBand();
+    InitializeKim1NoiseReduction();
+
+    float32_t I[kFrame];
+    float32_t Q[kFrame];
+    float32_t in[kFrame];
+    DataBlock data;
+    data.I = I;
+    data.Q = Q;
+    data.N = kFrame;
+    data.sampleRate_Hz = kSampleRate;
+
+    uint32_t seed = 11;
+    for (int f = 0; f < 25; f++) {
+        FillTone(I, Q, kFrame, (float32_t)f * kFrame);
+        for (uint32_t i = 0; i < kFrame; i++) {
+            seed = seed * 1664525 + 1013904223;
+            I[i] = 0.1f * I[i] + 0.02f * ((float32_t)(seed >> 8) / 16777216.0f - 0.5f);
+        }
+        memcpy(in, I, sizeof(in));
+        Kim1_NR(&data);
+    }
+
+    // The last frame is the windowed second data block of the call
+    const float32_t *hann = GetWindowTable(WindowHann, NR_FFT_L);
+    float32_t frame[kFrame];
+    for (uint32_t i = 0; i < kFrame; i++) frame[i] = in[i] * hann[i];
+
+    float32_t expected[kFrame / 2];
+    float32_t oldMapping[kFrame / 2];
+    ReferenceKimTail(frame, kFrame, expected);
+    ReferenceKimTail(frame, kFrame - 1, oldMapping);
+
+    float32_t err = 0, errOld = 0, ref = 0;
+    for (uint32_t i = 0; i < kFrame / 2; i++) {
+        err = fmaxf(err, fabsf(NR_last_iFFT_result[i] - expected[i]));
+        errOld = fmaxf(errOld, fabsf(NR_last_iFFT_result[i] - oldMapping[i]));
+        ref = fmaxf(ref, fabsf(expected[i]));
+    }
+    ASSERT_GT(ref, 1e-4f);
+    EXPECT_LT(err, 1e-5f + 1e-4f * ref);
+    EXPECT_GT(errOld, 1e-2f * ref);
+}
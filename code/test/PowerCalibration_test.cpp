@@ -27,7 +27,7 @@ static std::thread timer_thread;
  * Dispatches DO events to the state machines
  */
 void timer1ms(void) {
-    ModeSm_dispatch_event(&modeSM, ModeSm_EventId_DO);
+    TickRFHardwareAndModeSm();
     UISm_dispatch_event(&uiSM, UISm_EventId_DO);
     PowerCalSm_dispatch_event(&powerSM, PowerCalSm_EventId_DO);
 }
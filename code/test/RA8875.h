@@ -105,6 +105,74 @@ private:
     const void* _custom_font;
 };
 
+// Count of drawing commands issued to the display, used to measure how much work
+// the display code sends to the RA8875. Reset with RA8875_ResetCallCounts().
+struct RA8875CallCounts {
+    uint32_t fillRect;
+    uint32_t drawRect;
+    uint32_t drawLine;
+    uint32_t drawFastVLine;
+    uint32_t drawFastHLine;
+    uint32_t drawPixels;
+    uint32_t writeRect;
+    uint32_t BTE_move;
+    uint32_t print;
+    uint32_t total;      // every drawing command, including the ones not listed above
+};
+extern RA8875CallCounts RA8875_callCounts;
+void RA8875_ResetCallCounts(void);
+
+// Display command cost model (RA8875_cost.cpp). Every call on the RA8875 test doubles
+// is charged the SPI traffic and engine work it would cause on the real controller,
+// and attributed to the pane being drawn (see DisplayPaneProfile()). The figures are
+// a model for comparing revisions of the display code, not a cycle-accurate timing.
+enum RA8875Op {
+    RA8875Op_FillRect = 0,
+    RA8875Op_DrawRect,
+    RA8875Op_DrawLine,
+    RA8875Op_DrawFastVLine,
+    RA8875Op_DrawFastHLine,
+    RA8875Op_DrawCircle,
+    RA8875Op_FillCircle,
+    RA8875Op_ClearScreen,
+    RA8875Op_DrawPixels,
+    RA8875Op_WriteRect,
+    RA8875Op_BTEMove,
+    RA8875Op_Print,
+    RA8875Op_SetCursor,
+    RA8875Op_SetTextColor,
+    RA8875Op_SetFont,
+    RA8875Op_WriteTo,
+    RA8875Op_LayerControl,
+    RA8875Op_ReadStatus,
+    RA8875Op_Count
+};
+
+struct RA8875Cost {
+    uint32_t calls;      // API calls
+    uint32_t spiBytes;   // bytes clocked over SPI, including command/status phases
+    uint32_t bteOps;     // block transfer engine operations
+    uint64_t pixels;     // pixels written by the drawing or BTE engine
+};
+
+// Charge one API call. pixels is the number of pixels the engine writes and count
+// the number of pixels streamed over SPI (writeRect/drawPixels) or characters printed.
+void RA8875_Account(RA8875Op op, uint64_t pixels, uint32_t count);
+// Set the colour depth and SPI clock the model assumes (called by begin()).
+void RA8875_CostConfigure(uint8_t color_bpp, uint32_t spi_clock);
+// Close the current frame: its costs become the "last frame" and are added to the totals.
+void RA8875_EndCostFrame(void);
+// Cost of a pane in the last completed frame / summed over all frames since the reset.
+// pane = NULL returns the cost of the whole frame.
+RA8875Cost RA8875_GetFrameCost(const char *pane);
+RA8875Cost RA8875_GetTotalCost(const char *pane);
+uint32_t RA8875_GetCostFrames(void);
+// Estimated controller busy time in microseconds for a cost.
+float RA8875_EstimatedMicros(const RA8875Cost &cost);
+void RA8875_ResetCost(void);
+// Print the per-pane cost of the last frame and the average per frame to stdout.
+void RA8875_PrintCostReport(void);
+
 #ifdef USE_SDL_DISPLAY
 // Cleanup function for SDL resources - call at program exit
 void RA8875_SDL_Cleanup();
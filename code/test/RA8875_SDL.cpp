@@ -9,6 +9,7 @@
 #include <iostream>
 #include <cstring>
 #include <cmath>
+#include <algorithm>
 
 #ifdef USE_SDL_DISPLAY
 #include <SDL2/SDL.h>
@@ -778,6 +779,7 @@ RA8875::RA8875(uint8_t cs, uint8_t rst)
 }
 
 bool RA8875::begin(uint8_t display_size, uint8_t color_bpp, uint32_t spi_clock, uint32_t spi_clock_read) {
+    RA8875_CostConfigure(color_bpp, spi_clock);
     if (g_initialized) return true;
 
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
@@ -896,6 +898,7 @@ void RA8875::setRotation(uint8_t rotation) {
 }
 
 void RA8875::clearScreen(uint16_t color) {
+    RA8875_Account(RA8875Op_ClearScreen, 800 * 480, 0);
     if (!g_initialized) return;
 
     uint32_t argb = rgb565_to_argb8888(color);
@@ -912,29 +915,36 @@ void RA8875::fillWindow(uint16_t color) {
 }
 
 void RA8875::setTextColor(uint16_t color) {
+    RA8875_Account(RA8875Op_SetTextColor, 0, 0);
     _text_color = color;
 }
 
 void RA8875::setTextColor(uint16_t color1, uint16_t color2) {
+    RA8875_Account(RA8875Op_SetTextColor, 0, 0);
+    RA8875_Account(RA8875Op_SetTextColor, 0, 0);
     _text_color = color1;
 }
 
 void RA8875::setCursor(uint16_t x, uint16_t y) {
+    RA8875_Account(RA8875Op_SetCursor, 0, 0);
     _cursor_x = x;
     _cursor_y = y;
 }
 
 void RA8875::setFontScale(uint8_t scale) {
+    RA8875_Account(RA8875Op_SetFont, 0, 0);
     _font_scale = scale;
     if (_font_scale < 1) _font_scale = 1;
     if (_font_scale > 4) _font_scale = 4;
 }
 
 void RA8875::setFontScale(enum RA8875tsize scale) {
+    RA8875_Account(RA8875Op_SetFont, 0, 0);
     _font_scale = static_cast<uint8_t>(scale) + 1;
 }
 
 void RA8875::fillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+    RA8875_Account(RA8875Op_FillRect, (uint64_t)w * h, 0);
     if (!g_initialized) return;
 
     uint32_t argb = rgb565_to_argb8888(color);
@@ -947,6 +957,7 @@ void RA8875::fillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t c
 }
 
 void RA8875::drawRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+    RA8875_Account(RA8875Op_DrawRect, 2 * ((uint64_t)w + h), 0);
     if (!g_initialized) return;
 
     uint32_t argb = rgb565_to_argb8888(color);
@@ -965,6 +976,7 @@ void RA8875::drawRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t c
 }
 
 void RA8875::drawCircle(uint16_t x, uint16_t y, uint16_t r, uint16_t color) {
+    RA8875_Account(RA8875Op_DrawCircle, (uint64_t)(6.283f * r), 0);
     if (!g_initialized) return;
 
     uint32_t argb = rgb565_to_argb8888(color);
@@ -995,6 +1007,7 @@ void RA8875::drawCircle(uint16_t x, uint16_t y, uint16_t r, uint16_t color) {
 }
 
 void RA8875::fillCircle(uint16_t x, uint16_t y, uint16_t r, uint16_t color) {
+    RA8875_Account(RA8875Op_FillCircle, (uint64_t)(3.1416f * r * r), 0);
     if (!g_initialized) return;
 
     uint32_t argb = rgb565_to_argb8888(color);
@@ -1008,10 +1021,12 @@ void RA8875::fillCircle(uint16_t x, uint16_t y, uint16_t r, uint16_t color) {
 }
 
 void RA8875::setFont(const void* font) {
+    RA8875_Account(RA8875Op_SetFont, 0, 0);
     _custom_font = font;
 }
 
 void RA8875::print(const char* text) {
+    RA8875_Account(RA8875Op_Print, 0, text ? (uint32_t)strlen(text) : 0);
     if (!g_initialized || !text) return;
 
     uint32_t argb = rgb565_to_argb8888(_text_color);
@@ -1069,6 +1084,7 @@ void RA8875::print(float value, int digits) {
 }
 
 void RA8875::setFontDefault() {
+    RA8875_Account(RA8875Op_SetFont, 0, 0);
     _font_scale = 1;
     _custom_font = nullptr;
 }
@@ -1114,6 +1130,7 @@ uint16_t RA8875::Color565(uint8_t r, uint8_t g, uint8_t b) {
 }
 
 void RA8875::drawPixels(uint16_t* pixels, uint16_t count, uint16_t x, uint16_t y) {
+    RA8875_Account(RA8875Op_DrawPixels, count, count);
     if (!g_initialized || !pixels) return;
 
     for (uint16_t i = 0; i < count && (x + i) < DISPLAY_WIDTH; i++) {
@@ -1122,6 +1139,7 @@ void RA8875::drawPixels(uint16_t* pixels, uint16_t count, uint16_t x, uint16_t y
 }
 
 void RA8875::drawLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color) {
+    RA8875_Account(RA8875Op_DrawLine, std::max(abs((int)x1 - (int)x0), abs((int)y1 - (int)y0)) + 1, 0);
     if (!g_initialized) return;
 
     uint32_t argb = rgb565_to_argb8888(color);
@@ -1153,6 +1171,7 @@ void RA8875::drawLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16
 }
 
 void RA8875::drawFastVLine(uint16_t x, uint16_t y, uint16_t h, uint16_t color) {
+    RA8875_Account(RA8875Op_DrawFastVLine, h, 0);
     if (!g_initialized) return;
 
     uint32_t argb = rgb565_to_argb8888(color);
@@ -1163,6 +1182,7 @@ void RA8875::drawFastVLine(uint16_t x, uint16_t y, uint16_t h, uint16_t color) {
 }
 
 void RA8875::drawFastHLine(uint16_t x, uint16_t y, uint16_t w, uint16_t color) {
+    RA8875_Account(RA8875Op_DrawFastHLine, w, 0);
     if (!g_initialized) return;
 
     uint32_t argb = rgb565_to_argb8888(color);
@@ -1173,18 +1193,22 @@ void RA8875::drawFastHLine(uint16_t x, uint16_t y, uint16_t w, uint16_t color) {
 }
 
 void RA8875::useLayers(bool enable) {
+    RA8875_Account(RA8875Op_LayerControl, 0, 0);
     g_layers_enabled = enable;
 }
 
 void RA8875::layerEffect(uint8_t effect) {
+    RA8875_Account(RA8875Op_LayerControl, 0, 0);
     g_layer_effect = effect;
 }
 
 void RA8875::writeTo(uint8_t layer) {
+    RA8875_Account(RA8875Op_WriteTo, 0, 0);
     g_current_layer = layer;
 }
 
 void RA8875::clearMemory() {
+    RA8875_Account(RA8875Op_LayerControl, 0, 0);
     if (!g_initialized) return;
 
     uint32_t black = 0xFF000000;
@@ -1204,6 +1228,7 @@ void RA8875::clearMemory() {
 
 void RA8875::BTE_move(uint16_t src_x, uint16_t src_y, uint16_t width, uint16_t height,
                       uint16_t dst_x, uint16_t dst_y, uint8_t rop, uint8_t bte_operation) {
+    RA8875_Account(RA8875Op_BTEMove, (uint64_t)width * height, 0);
     if (!g_initialized) return;
 
     uint32_t* buffer = get_current_buffer();
@@ -1236,11 +1261,13 @@ void RA8875::BTE_move(uint16_t src_x, uint16_t src_y, uint16_t width, uint16_t h
 }
 
 bool RA8875::readStatus() {
+    RA8875_Account(RA8875Op_ReadStatus, 0, 0);
     // Always return false (operation complete) in simulator
     return false;
 }
 
 void RA8875::writeRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data) {
+    RA8875_Account(RA8875Op_WriteRect, (uint64_t)w * h, (uint32_t)w * h);
     if (!g_initialized || !data) return;
 
     for (int py = 0; py < h; py++) {
@@ -0,0 +1,195 @@
+// Command cost model shared by the RA8875 test doubles (RA8875_mock.cpp and RA8875_SDL.cpp).
+//
+// Each API call is charged the register writes the RA8875 library issues for it. A
+// register write is a command phase (0x80, register) followed by a data phase (0x00,
+// value): 4 bytes on the wire. Drawing and BTE operations end with a status poll while
+// the engine runs. Pixel streams (writeRect/drawPixels) and text add their payload on
+// top. Costs are attributed to the pane named by the last DisplayPaneProfile() call.
+
+#include "RA8875.h"
+#include <cstdio>
+#include <cstring>
+
+RA8875CallCounts RA8875_callCounts = {};
+
+void RA8875_ResetCallCounts(void) {
+    RA8875_callCounts = {};
+}
+
+#define REGISTER_WRITE_BYTES 4
+#define STATUS_POLL_BYTES 2
+#define MEMORY_WRITE_BYTES 3       // MRWC command phase plus the data-write prefix
+#define ENGINE_PIXELS_PER_US 30.0f // rough fill/BTE rate of the RA8875 engines
+#define MAX_COST_PANES 24
+
+struct OpCost {
+    uint8_t registers;   // register writes issued for the call
+    bool statusPoll;     // waits for the engine to finish
+    bool drawing;        // counted in RA8875_callCounts.total
+};
+
+static const OpCost opCosts[RA8875Op_Count] = {
+    {12, true,  true},   // FillRect: x0,y0,x1,y1 + colour + DCR
+    {12, true,  true},   // DrawRect
+    {12, true,  true},   // DrawLine
+    {12, true,  true},   // DrawFastVLine
+    {12, true,  true},   // DrawFastHLine
+    { 9, true,  true},   // DrawCircle: centre + radius + colour + DCR
+    { 9, true,  true},   // FillCircle
+    {12, true,  true},   // ClearScreen
+    {12, false, true},   // DrawPixels: cursor + active window
+    {20, false, true},   // WriteRect: cursor + active window + window restore
+    {14, true,  true},   // BTEMove: source, destination, size, ROP, start
+    { 2, false, true},   // Print: text mode on/off
+    { 4, false, false},  // SetCursor
+    { 3, false, false},  // SetTextColor
+    { 1, false, false},  // SetFont
+    { 1, false, false},  // WriteTo
+    { 1, false, false},  // LayerControl
+    { 0, true,  false},  // ReadStatus
+};
+
+static uint8_t bytesPerPixel = 2;
+static float spiBytesPerUs = 2.5f;  // 20 MHz
+
+static const char *paneNames[MAX_COST_PANES];
+static uint32_t paneCount = 0;
+static int32_t currentPane = -1;    // -1 = not inside a pane
+static RA8875Cost frameCost[MAX_COST_PANES + 1];
+static RA8875Cost lastFrameCost[MAX_COST_PANES + 1];
+static RA8875Cost totalCost[MAX_COST_PANES + 1];
+static uint32_t frames = 0;
+
+// Slot used for calls made outside any pane
+#define OTHER_SLOT MAX_COST_PANES
+
+static int32_t FindPane(const char *pane) {
+    for (uint32_t i = 0; i < paneCount; i++) {
+        if (strcmp(paneNames[i], pane) == 0) return (int32_t)i;
+    }
+    return -1;
+}
+
+static void AddCost(RA8875Cost *to, const RA8875Cost &from) {
+    to->calls += from.calls;
+    to->spiBytes += from.spiBytes;
+    to->bteOps += from.bteOps;
+    to->pixels += from.pixels;
+}
+
+/**
+ * Mark the start of drawing a pane. Called by the display code when it is compiled
+ * with DISPLAY_PANE_PROFILING; NULL ends the pane.
+ */
+void DisplayPaneProfile(const char *pane) {
+    if (pane == nullptr) {
+        currentPane = -1;
+        return;
+    }
+    currentPane = FindPane(pane);
+    if ((currentPane < 0) && (paneCount < MAX_COST_PANES)) {
+        paneNames[paneCount] = pane;
+        currentPane = (int32_t)paneCount++;
+    }
+}
+
+void RA8875_CostConfigure(uint8_t color_bpp, uint32_t spi_clock) {
+    bytesPerPixel = (color_bpp <= 8) ? 1 : 2;
+    spiBytesPerUs = (float)spi_clock / 8.0e6f;
+}
+
+void RA8875_Account(RA8875Op op, uint64_t pixels, uint32_t count) {
+    const OpCost &c = opCosts[op];
+    uint32_t bytes = c.registers * REGISTER_WRITE_BYTES;
+    if (c.statusPoll) bytes += STATUS_POLL_BYTES;
+    if ((op == RA8875Op_WriteRect) || (op == RA8875Op_DrawPixels))
+        bytes += MEMORY_WRITE_BYTES + count * bytesPerPixel;
+    if (op == RA8875Op_Print)
+        bytes += MEMORY_WRITE_BYTES + count * (2 + STATUS_POLL_BYTES); // each character waits for the font engine
+
+    RA8875Cost &slot = frameCost[(currentPane < 0) ? OTHER_SLOT : currentPane];
+    slot.calls++;
+    slot.spiBytes += bytes;
+    slot.pixels += pixels;
+    if (op == RA8875Op_BTEMove) slot.bteOps++;
+
+    if (c.drawing) {
+        RA8875_callCounts.total++;
+        switch (op) {
+            case RA8875Op_FillRect:      RA8875_callCounts.fillRect++; break;
+            case RA8875Op_DrawRect:      RA8875_callCounts.drawRect++; break;
+            case RA8875Op_DrawLine:      RA8875_callCounts.drawLine++; break;
+            case RA8875Op_DrawFastVLine: RA8875_callCounts.drawFastVLine++; break;
+            case RA8875Op_DrawFastHLine: RA8875_callCounts.drawFastHLine++; break;
+            case RA8875Op_DrawPixels:    RA8875_callCounts.drawPixels++; break;
+            case RA8875Op_WriteRect:     RA8875_callCounts.writeRect++; break;
+            case RA8875Op_BTEMove:       RA8875_callCounts.BTE_move++; break;
+            case RA8875Op_Print:         RA8875_callCounts.print++; break;
+            default: break;
+        }
+    }
+}
+
+void RA8875_EndCostFrame(void) {
+    for (uint32_t i = 0; i <= MAX_COST_PANES; i++) {
+        lastFrameCost[i] = frameCost[i];
+        AddCost(&totalCost[i], frameCost[i]);
+        frameCost[i] = {};
+    }
+    frames++;
+}
+
+static RA8875Cost GetCost(const RA8875Cost *costs, const char *pane) {
+    RA8875Cost result = {};
+    if (pane == nullptr) {
+        for (uint32_t i = 0; i <= MAX_COST_PANES; i++) AddCost(&result, costs[i]);
+        return result;
+    }
+    int32_t i = FindPane(pane);
+    if (i >= 0) result = costs[i];
+    return result;
+}
+
+RA8875Cost RA8875_GetFrameCost(const char *pane) {
+    return GetCost(lastFrameCost, pane);
+}
+
+RA8875Cost RA8875_GetTotalCost(const char *pane) {
+    return GetCost(totalCost, pane);
+}
+
+uint32_t RA8875_GetCostFrames(void) {
+    return frames;
+}
+
+float RA8875_EstimatedMicros(const RA8875Cost &cost) {
+    return (float)cost.spiBytes / spiBytesPerUs + (float)cost.pixels / ENGINE_PIXELS_PER_US;
+}
+
+void RA8875_ResetCost(void) {
+    for (uint32_t i = 0; i <= MAX_COST_PANES; i++) {
+        frameCost[i] = {};
+        lastFrameCost[i] = {};
+        totalCost[i] = {};
+    }
+    frames = 0;
+}
+
+static void PrintCostLine(const char *name, const RA8875Cost &last, const RA8875Cost &total) {
+    float n = (frames > 0) ? (float)frames : 1.0f;
+    RA8875Cost avg = {(uint32_t)(total.calls / n), (uint32_t)(total.spiBytes / n),
+                      (uint32_t)(total.bteOps / n), (uint64_t)(total.pixels / n)};
+    printf("  %-24s %7u %9u %4u %9.0f | %9.1f %11.1f %9.0f\n", name,
+           last.calls, last.spiBytes, last.bteOps, RA8875_EstimatedMicros(last),
+           total.calls / n, total.spiBytes / n, RA8875_EstimatedMicros(avg));
+}
+
+void RA8875_PrintCostReport(void) {
+    printf("Display cost: last frame | average over %u frames\n", frames);
+    printf("  %-24s %7s %9s %4s %9s | %9s %11s %9s\n", "pane",
+           "calls", "SPI bytes", "BTE", "est us", "calls", "SPI bytes", "est us");
+    for (uint32_t i = 0; i < paneCount; i++)
+        PrintCostLine(paneNames[i], lastFrameCost[i], totalCost[i]);
+    PrintCostLine("(other)", lastFrameCost[OTHER_SLOT], totalCost[OTHER_SLOT]);
+    PrintCostLine("TOTAL", RA8875_GetFrameCost(nullptr), RA8875_GetTotalCost(nullptr));
+}
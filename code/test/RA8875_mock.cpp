@@ -2,11 +2,16 @@
 #include "Arduino.h"
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 RA8875::RA8875(uint8_t cs, uint8_t rst) : _cs(cs), _rst(rst), _font_scale(1), _cursor_x(0), _cursor_y(0), _text_color(RA8875_WHITE), _custom_font(nullptr) {
 }
 
 bool RA8875::begin(uint8_t display_size, uint8_t color_bpp, uint32_t spi_clock, uint32_t spi_clock_read) {
+    RA8875_CostConfigure(color_bpp, spi_clock);
     // Mock implementation - always returns success
     return true;
 }
@@ -16,79 +21,102 @@ void RA8875::setRotation(uint8_t rotation) {
 }
 
 void RA8875::clearScreen(uint16_t color) {
+    RA8875_Account(RA8875Op_ClearScreen, 800 * 480, 0);
     // Mock implementation - could log the action if needed
 }
 
 void RA8875::fillWindow(uint16_t color) {
+    RA8875_Account(RA8875Op_ClearScreen, 800 * 480, 0);
     // Mock implementation - fills entire window
 }
 
 void RA8875::setTextColor(uint16_t color) {
+    RA8875_Account(RA8875Op_SetTextColor, 0, 0);
     _text_color = color;
 }
 
 void RA8875::setTextColor(uint16_t color1, uint16_t color2) {
+    RA8875_Account(RA8875Op_SetTextColor, 0, 0);
+    RA8875_Account(RA8875Op_SetTextColor, 0, 0);
     _text_color = color1;
 }
 
 void RA8875::setCursor(uint16_t x, uint16_t y) {
+    RA8875_Account(RA8875Op_SetCursor, 0, 0);
     _cursor_x = x;
     _cursor_y = y;
 }
 
 void RA8875::setFontScale(uint8_t scale) {
+    RA8875_Account(RA8875Op_SetFont, 0, 0);
     _font_scale = scale;
 }
 
 void RA8875::setFontScale(enum RA8875tsize scale) {
+    RA8875_Account(RA8875Op_SetFont, 0, 0);
     _font_scale = static_cast<uint8_t>(scale);
 }
 
 void RA8875::fillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+    RA8875_Account(RA8875Op_FillRect, (uint64_t)w * h, 0);
     // Mock implementation - could log the action if needed for testing
 }
 
 void RA8875::drawRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+    RA8875_Account(RA8875Op_DrawRect, 2 * ((uint64_t)w + h), 0);
     // Mock implementation - could log the action if needed for testing
 }
 
 void RA8875::drawCircle(uint16_t x, uint16_t y, uint16_t r, uint16_t color) {
+    RA8875_Account(RA8875Op_DrawCircle, (uint64_t)(6.283f * r), 0);
     // Mock implementation - could log the action if needed for testing
 }
 
 void RA8875::fillCircle(uint16_t x, uint16_t y, uint16_t r, uint16_t color) {
+    RA8875_Account(RA8875Op_FillCircle, (uint64_t)(3.1416f * r * r), 0);
     // Mock implementation - could log the action if needed for testing
 }
 
 void RA8875::setFont(const void* font) {
+    RA8875_Account(RA8875Op_SetFont, 0, 0);
     _custom_font = font;
 }
 
 void RA8875::print(const char* text) {
+    RA8875_Account(RA8875Op_Print, 0, text ? (uint32_t)strlen(text) : 0);
     // Mock implementation - could log the text if needed for testing
 }
 
 void RA8875::print(const String& str) {
-    // Mock implementation - could log the text if needed for testing
+    print(str.c_str());
 }
 
 void RA8875::print(int value) {
-    // Mock implementation - could log the value if needed for testing
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%d", value);
+    print(buf);
 }
 
 void RA8875::print(int64_t value) {
-    // Mock implementation - could log the value if needed for testing
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%lld", (long long)value);
+    print(buf);
 }
 
 void RA8875::print(float value) {
-    // Mock implementation - could log the value if needed for testing
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.2f", value);
+    print(buf);
 }
 
 void RA8875::print(float value, int digits) {
-    // Mock implementation - could log the value if needed for testing
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", digits, value);
+    print(buf);
 }
 
 void RA8875::setFontDefault() {
+    RA8875_Account(RA8875Op_SetFont, 0, 0);
     // Mock implementation - reset to default font
     _font_scale = 1;
     _custom_font = nullptr;
@@ -128,49 +156,60 @@ uint16_t RA8875::Color565(uint8_t r, uint8_t g, uint8_t b) {
 }
 
 void RA8875::drawPixels(uint16_t* pixels, uint16_t count, uint16_t x, uint16_t y) {
+    RA8875_Account(RA8875Op_DrawPixels, count, count);
     // Mock implementation - could log the pixel drawing if needed for testing
 }
 
 void RA8875::drawLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color) {
+    RA8875_Account(RA8875Op_DrawLine, std::max(abs((int)x1 - (int)x0), abs((int)y1 - (int)y0)) + 1, 0);
     // Mock implementation - could log the line drawing if needed for testing
 }
 
 void RA8875::drawFastVLine(uint16_t x, uint16_t y, uint16_t h, uint16_t color) {
+    RA8875_Account(RA8875Op_DrawFastVLine, h, 0);
     // Mock implementation - draws a vertical line
 }
 
 void RA8875::drawFastHLine(uint16_t x, uint16_t y, uint16_t w, uint16_t color) {
+    RA8875_Account(RA8875Op_DrawFastHLine, w, 0);
     // Mock implementation - draws a horizontal line
 }
 
 void RA8875::useLayers(bool enable) {
+    RA8875_Account(RA8875Op_LayerControl, 0, 0);
     // Mock implementation - enable/disable layer support
 }
 
 void RA8875::layerEffect(uint8_t effect) {
+    RA8875_Account(RA8875Op_LayerControl, 0, 0);
     // Mock implementation - set layer blending effect
 }
 
 void RA8875::writeTo(uint8_t layer) {
+    RA8875_Account(RA8875Op_WriteTo, 0, 0);
     // Mock implementation - select which layer to write to
 }
 
 void RA8875::clearMemory() {
+    RA8875_Account(RA8875Op_LayerControl, 0, 0);
     // Mock implementation - clear display memory
 }
 
 void RA8875::BTE_move(uint16_t src_x, uint16_t src_y, uint16_t width, uint16_t height,
                       uint16_t dst_x, uint16_t dst_y, uint8_t rop, uint8_t bte_operation) {
+    RA8875_Account(RA8875Op_BTEMove, (uint64_t)width * height, 0);
     // Mock implementation - Block Transfer Engine memory move operation
     // Used for scrolling waterfall display
 }
 
 bool RA8875::readStatus() {
+    RA8875_Account(RA8875Op_ReadStatus, 0, 0);
     // Mock implementation - return false to indicate operation complete
     return false;
 }
 
 void RA8875::writeRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* data) {
+    RA8875_Account(RA8875Op_WriteRect, (uint64_t)w * h, (uint32_t)w * h);
     // Mock implementation - write a rectangular array of pixels
 }
 
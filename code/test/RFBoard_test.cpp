@@ -9,8 +9,10 @@ extern int32_t EvenDivisor(int64_t freq2_Hz);
 extern int64_t GetTXRXFreq_dHz(void);
 extern int64_t GetCWTXFreq_dHz(void);
 
-// Mock control function for Si5351 address simulation
-extern void Si5351_Mock_SetDeviceAddress(uint8_t addr);
+// Mock control functions for Si5351 address simulation and the call log
+#include "si5351_mock.h"
+extern IntervalTimer rxQuadratureTimer;
+extern IntervalTimer txQuadratureTimer;
 
 // Test list:
 // Trying to pass a value if the I2C initialization failed fails
@@ -250,6 +252,246 @@ TEST(RFBoard, SetFreq_Test) {
     EXPECT_EQ(si5351.clk_freq[SI5351_CLK1], 707400000);
 }
 
+TEST(RFBoard, LowFrequencyQuadrature_DoesNotBlock) {
+    si5351 = Si5351(); // Reset mock
+    ResetVFOState();
+    InitRXVFO();
+    uint32_t t0 = micros();
+    SetRXVFOFrequency(190000000); // 1.9 MHz, multiple of 256
+    EXPECT_LT(micros() - t0, 5000);
+    // CLK0 is at the new frequency, CLK90 is still 4 Hz low
+    EXPECT_TRUE(IsVFOQuadraturePending());
+    EXPECT_EQ(GET_BIT(hardwareRegister,RXVFOQUADBIT), 1);
+    EXPECT_EQ(GET_BIT(hardwareRegister,RXVFOBIT), 1);
+    EXPECT_EQ(si5351.clk_freq[SI5351_CLK0], 190000000);
+    EXPECT_EQ(si5351.clk_freq[SI5351_CLK1], 190000000 - 400);
+    EXPECT_TRUE(rxQuadratureTimer.isRunning());
+    EXPECT_EQ(rxQuadratureTimer.interval(), VFO_QUADRATURE_DELAY_US);
+
+    // The timer only marks the delay as passed, the main loop finishes it
+    rxQuadratureTimer.fire();
+    EXPECT_FALSE(rxQuadratureTimer.isRunning());
+    EXPECT_TRUE(IsVFOQuadraturePending());
+    EXPECT_EQ(si5351.clk_freq[SI5351_CLK1], 190000000 - 400);
+    ServiceVFOQuadrature();
+    EXPECT_FALSE(IsVFOQuadraturePending());
+    EXPECT_EQ(GET_BIT(hardwareRegister,RXVFOQUADBIT), 0);
+    EXPECT_EQ(GET_BIT(hardwareRegister,RXVFOBIT), 1);
+    EXPECT_EQ(si5351.clk_freq[SI5351_CLK1], 190000000);
+}
+
+TEST(RFBoard, LowFrequencyQuadrature_RegisterSequenceAndTiming) {
+    si5351 = Si5351(); // Reset mock
+    ResetVFOState();
+    InitRXVFO();
+    Si5351_Mock_ClearLog();
+    SetRXVFOFrequency(190000000);
+    // Stand in for the one-shot timer
+    AddMillisTime((VFO_QUADRATURE_DELAY_US + 999) / 1000);
+    rxQuadratureTimer.fire();
+    ServiceVFOQuadrature();
+
+    const Si5351MockCall expected[] = {
+        {SI5351_MOCK_SET_FREQ_MANUAL, SI5351_CLK0, 190000000 - 400, 0},
+        {SI5351_MOCK_SET_FREQ_MANUAL, SI5351_CLK1, 190000000 - 400, 0},
+        {SI5351_MOCK_SET_PHASE, SI5351_CLK0, 0, 0},
+        {SI5351_MOCK_SET_PHASE, SI5351_CLK1, 0, 0},
+        {SI5351_MOCK_PLL_RESET, SI5351_PLLA, 0, 0},
+        {SI5351_MOCK_SET_FREQ_MANUAL, SI5351_CLK0, 190000000, 0},
+        {SI5351_MOCK_OUTPUT_ENABLE, SI5351_CLK0, 1, 0},
+        {SI5351_MOCK_OUTPUT_ENABLE, SI5351_CLK1, 1, 0},
+        {SI5351_MOCK_SET_FREQ_MANUAL, SI5351_CLK1, 190000000, 0},
+    };
+    size_t n = sizeof(expected)/sizeof(expected[0]);
+    ASSERT_EQ(Si5351_Mock_GetLogSize(), n);
+    for (size_t i = 0; i < n; i++){
+        Si5351MockCall c = Si5351_Mock_GetLogEntry(i);
+        EXPECT_EQ(c.op, expected[i].op) << "call " << i;
+        EXPECT_EQ(c.target, expected[i].target) << "call " << i;
+        EXPECT_EQ(c.value, expected[i].value) << "call " << i;
+    }
+    // CLK90 catches up with CLK0 no earlier than the quadrature delay
+    uint32_t dt = Si5351_Mock_GetLogEntry(8).time_us - Si5351_Mock_GetLogEntry(5).time_us;
+    EXPECT_GE(dt, VFO_QUADRATURE_DELAY_US);
+    EXPECT_LE(dt, VFO_QUADRATURE_DELAY_US + VFO_QUADRATURE_TOLERANCE_US);
+}
+
+TEST(RFBoard, LowFrequencyQuadrature_LateLoopStartsOffsetAgain) {
+    si5351 = Si5351(); // Reset mock
+    ResetVFOState();
+    InitRXVFO();
+    Si5351_Mock_ClearLog();
+    SetRXVFOFrequency(190000000);
+    // The main loop is busy for 70 ms after the timer fires, CLK90 would
+    // catch up about 16 degrees past quadrature
+    AddMillisTime(70);
+    rxQuadratureTimer.fire();
+    ServiceVFOQuadrature();
+    EXPECT_TRUE(IsVFOQuadraturePending());
+    EXPECT_TRUE(rxQuadratureTimer.isRunning());
+    EXPECT_EQ(si5351.clk_freq[SI5351_CLK1], 190000000 - 400);
+    // The next attempt is serviced in time
+    AddMillisTime((VFO_QUADRATURE_DELAY_US + 999) / 1000);
+    rxQuadratureTimer.fire();
+    ServiceVFOQuadrature();
+    EXPECT_FALSE(IsVFOQuadraturePending());
+    EXPECT_EQ(si5351.clk_freq[SI5351_CLK1], 190000000);
+
+    // CLK90 was written once, within the tolerance of the delay after the
+    // last time CLK0 left the aligned frequency
+    size_t n = Si5351_Mock_GetLogSize();
+    int clk0 = -1, clk90 = -1;
+    for (size_t i = 0; i < n; i++){
+        Si5351MockCall c = Si5351_Mock_GetLogEntry(i);
+        if (c.op != SI5351_MOCK_SET_FREQ_MANUAL || c.value != 190000000)
+            continue;
+        if (c.target == SI5351_CLK0)
+            clk0 = i;
+        if (c.target == SI5351_CLK1){
+            EXPECT_EQ(clk90, -1);
+            clk90 = i;
+        }
+    }
+    ASSERT_GE(clk0, 0);
+    ASSERT_GT(clk90, clk0);
+    uint32_t dt = Si5351_Mock_GetLogEntry(clk90).time_us - Si5351_Mock_GetLogEntry(clk0).time_us;
+    EXPECT_GE(dt, VFO_QUADRATURE_DELAY_US);
+    EXPECT_LE(dt, VFO_QUADRATURE_DELAY_US + VFO_QUADRATURE_TOLERANCE_US);
+}
+
+TEST(RFBoard, LowFrequencyQuadrature_RequestWhilePendingIsAppliedAfter) {
+    si5351 = Si5351(); // Reset mock
+    ResetVFOState();
+    InitRXVFO();
+    SetRXVFOFrequency(190000000);
+    Si5351_Mock_ClearLog();
+    // Tuning within the same multiple range would change the PLL under the
+    // offset clocks, so it must wait
+    SetRXVFOFrequency(185000000);
+    SetRXVFOFrequency(180000000);
+    EXPECT_EQ(Si5351_Mock_GetLogSize(), 0);
+    EXPECT_EQ(GetRXVFOFrequency(), 1900000);
+
+    rxQuadratureTimer.fire();
+    ServiceVFOQuadrature();
+    ASSERT_EQ(Si5351_Mock_GetLogSize(), 2);
+    EXPECT_EQ(Si5351_Mock_GetLogEntry(0).op, SI5351_MOCK_SET_FREQ_MANUAL);
+    EXPECT_EQ(Si5351_Mock_GetLogEntry(0).value, 190000000);
+    EXPECT_EQ(Si5351_Mock_GetLogEntry(1).op, SI5351_MOCK_SET_PLL);
+    EXPECT_EQ(Si5351_Mock_GetLogEntry(1).value, (uint64_t)180000000*256);
+    EXPECT_EQ(GetRXVFOFrequency(), 1800000);
+    EXPECT_FALSE(IsVFOQuadraturePending());
+}
+
+TEST(RFBoard, LowFrequencyQuadrature_TXVFO) {
+    si5351 = Si5351(); // Reset mock
+    ResetVFOState();
+    SetDualVFOs(true);
+    InitTXVFO();
+    SetTXVFOFrequency(190000000);
+    EXPECT_TRUE(IsVFOQuadraturePending());
+    EXPECT_EQ(GET_BIT(hardwareRegister,TXVFOQUADBIT), 1);
+    EXPECT_EQ(si5351.clk_freq[SI5351_CLK5], 190000000 - 400);
+    EXPECT_EQ(txQuadratureTimer.interval(), VFO_QUADRATURE_DELAY_US);
+    txQuadratureTimer.fire();
+    ServiceVFOQuadrature();
+    EXPECT_FALSE(IsVFOQuadraturePending());
+    EXPECT_EQ(GET_BIT(hardwareRegister,TXVFOQUADBIT), 0);
+    EXPECT_EQ(GET_BIT(hardwareRegister,TXVFOBIT), 1);
+    EXPECT_EQ(si5351.clk_freq[SI5351_CLK5], 190000000);
+}
+
+TEST(RFBoard, LowFrequencyQuadrature_OutputDisabledDuringDelayStaysOff) {
+    si5351 = Si5351(); // Reset mock
+    ResetVFOState();
+    SetDualVFOs(false);
+    InitRXVFO();
+    SetRXVFOFrequency(190000000);
+    DisableRXVFOOutput();
+    rxQuadratureTimer.fire();
+    ServiceVFOQuadrature();
+    // CLK90 reaches the new frequency but its output stays off
+    EXPECT_EQ(si5351.clk_freq[SI5351_CLK1], 190000000);
+    EXPECT_EQ(GET_BIT(hardwareRegister,RXVFOBIT), 0);
+    EXPECT_EQ(si5351.si5351_read(SI5351_OUTPUT_ENABLE_CTRL) & (1 << SI5351_CLK1), 1 << SI5351_CLK1);
+}
+
+TEST(RFBoard, LowFrequencyQuadrature_CancelledByInitVFOs) {
+    si5351 = Si5351(); // Reset mock
+    ResetVFOState();
+    InitRXVFO();
+    SetRXVFOFrequency(190000000);
+    EXPECT_TRUE(IsVFOQuadraturePending());
+    Si5351_Mock_SetDeviceAddress(SI5351_BUS_BASE_ADDR);
+    InitVFOs();
+    EXPECT_FALSE(IsVFOQuadraturePending());
+    EXPECT_FALSE(rxQuadratureTimer.isRunning());
+}
+
+TEST(RFBoard, RegisterShadow_SendsOnlyChangedBytes) {
+    si5351 = Si5351(); // Reset mock
+    uint8_t params[8] = {0xFF, 0xFF, 0x00, 0x0E, 0x00, 0xF0, 0x00, 0x00};
+    si5351.si5351_write_bulk(SI5351_PLLA_PARAMETERS, 8, params);
+    EXPECT_EQ(si5351.get_i2c_transactions(), 1);
+    EXPECT_EQ(si5351.get_i2c_bytes_sent(), 2 + 8);
+
+    // Nothing changed
+    si5351.reset_i2c_counters();
+    si5351.si5351_write_bulk(SI5351_PLLA_PARAMETERS, 8, params);
+    EXPECT_EQ(si5351.get_i2c_transactions(), 0);
+    EXPECT_EQ(si5351.get_i2c_bytes_sent(), 0);
+
+    // One byte changed
+    params[4] = 0x12;
+    si5351.si5351_write_bulk(SI5351_PLLA_PARAMETERS, 8, params);
+    EXPECT_EQ(si5351.get_i2c_transactions(), 1);
+    EXPECT_EQ(si5351.get_i2c_bytes_sent(), 2 + 1);
+
+    // Two changes with one unchanged byte between them go in one burst
+    si5351.reset_i2c_counters();
+    params[4] = 0x13;
+    params[6] = 0x01;
+    si5351.si5351_write_bulk(SI5351_PLLA_PARAMETERS, 8, params);
+    EXPECT_EQ(si5351.get_i2c_transactions(), 1);
+    EXPECT_EQ(si5351.get_i2c_bytes_sent(), 2 + 3);
+
+    // Changes at both ends of the block are sent as two bursts
+    si5351.reset_i2c_counters();
+    params[0] = 0x00;
+    params[7] = 0x01;
+    si5351.si5351_write_bulk(SI5351_PLLA_PARAMETERS, 8, params);
+    EXPECT_EQ(si5351.get_i2c_transactions(), 2);
+    EXPECT_EQ(si5351.get_i2c_bytes_sent(), 2*(2 + 1));
+}
+
+TEST(RFBoard, RegisterShadow_ReadsAndResets) {
+    si5351 = Si5351(); // Reset mock
+    si5351.si5351_write(SI5351_CLK0_CTRL, 0x4F);
+    si5351.reset_i2c_counters();
+    // A written register is read back from the shadow
+    EXPECT_EQ(si5351.si5351_read(SI5351_CLK0_CTRL), 0x4F);
+    EXPECT_EQ(si5351.get_i2c_transactions(), 0);
+    // A register that was never written has to be read from the device once
+    si5351.si5351_read(SI5351_CLK1_CTRL);
+    si5351.si5351_read(SI5351_CLK1_CTRL);
+    EXPECT_EQ(si5351.get_i2c_transactions(), 2);
+    // Status registers are always read from the device
+    si5351.reset_i2c_counters();
+    si5351.si5351_read(SI5351_DEVICE_STATUS);
+    si5351.si5351_read(SI5351_DEVICE_STATUS);
+    EXPECT_EQ(si5351.get_i2c_transactions(), 4);
+    // The PLL reset bits clear themselves, so every reset is sent
+    si5351.reset_i2c_counters();
+    si5351.pll_reset(SI5351_PLLA);
+    si5351.pll_reset(SI5351_PLLA);
+    EXPECT_EQ(si5351.get_i2c_transactions(), 2);
+    // A new address means a different device
+    si5351.reset_i2c_counters();
+    si5351.set_address(SI5351_DUAL_VFO_ADDR);
+    si5351.si5351_write(SI5351_CLK0_CTRL, 0x4F);
+    EXPECT_EQ(si5351.get_i2c_transactions(), 1);
+}
+
 TEST(RFBoard, SetRXVFOPower_Test) {
     si5351 = Si5351(); // Reset mock
     SetRXVFOPower(SI5351_DRIVE_4MA);
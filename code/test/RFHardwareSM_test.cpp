@@ -1,4 +1,5 @@
 #include "gtest/gtest.h"
+#include <vector>
 #include "../src/PhoenixSketch/SDT.h"
 #include "../src/PhoenixSketch/RFBoard_si5351.h"
 
@@ -7,10 +8,29 @@ extern Si5351 si5351;
 // Mock control function for Si5351 address simulation
 extern void Si5351_Mock_SetDeviceAddress(uint8_t addr);
 
+// One-shot timers that end the low frequency VFO quadrature setup
+extern IntervalTimer rxQuadratureTimer;
+extern IntervalTimer txQuadratureTimer;
+
+/**
+ * Run the T/R sequence to its end by calling the sequencer as tick1ms() and
+ * loop() would. Returns the number of 1 ms ticks the sequence took.
+ */
+static uint32_t FinishRFHardwareSequence(void){
+    uint32_t ticks = 0;
+    while (IsRFHardwareSequenceBusy() && (ticks < 1000)){
+        TickRFHardwareSequence();
+        ServiceRFHardwareSequence();
+        ticks++;
+    }
+    return ticks;
+}
+
 TEST(RFHardwareState, StateStartInReceive){
     InitializeRFHardware();
     modeSM.state_id = ModeSm_StateId_SSB_RECEIVE;
     UpdateRFHardwareState();
+    FinishRFHardwareSequence();
 
     // RECEIVE STATE
     // We expect CLK0 and CLK1 to be enabled, and CLK2 to be disabled
@@ -37,6 +57,7 @@ TEST(RFHardwareState, StateTransitionToSSBTransmit){
     InitializeRFHardware();
     modeSM.state_id = ModeSm_StateId_SSB_TRANSMIT;
     UpdateRFHardwareState();
+    FinishRFHardwareSequence();
 
     // SSB TRANSMIT STATE
     // We expect CLK0 and CLK1 to be enabled, and CLK2 to be disabled
@@ -64,6 +85,7 @@ TEST(RFHardwareState, StateTransitionToCWSpace){
     InitializeRFHardware();
     modeSM.state_id = ModeSm_StateId_CW_TRANSMIT_SPACE;
     UpdateRFHardwareState();
+    FinishRFHardwareSequence();
 
     // CW TRANSMIT SPACE STATE
     // We expect CLK0 and CLK1 (RX VFO) to be disabled, CLK4/CLK5 (TX VFO) to be disabled, and CLK6 (CW VFO) to be enabled
@@ -91,6 +113,7 @@ TEST(RFHardwareState, StateTransitionToCWMark){
     InitializeRFHardware();
     modeSM.state_id = ModeSm_StateId_CW_TRANSMIT_MARK;
     UpdateRFHardwareState();
+    FinishRFHardwareSequence();
 
     // CW TRANSMIT MARK STATE
     // We expect CLK0 and CLK1 (RX VFO) to be disabled, CLK4/CLK5 (TX VFO) to be disabled, and CLK6 (CW VFO) to be enabled
@@ -129,6 +152,7 @@ and between SSB receive and SSB transmit mode? it changes from state to state.
     InitializeRFHardware();
     modeSM.state_id = ModeSm_StateId_CW_RECEIVE;
     UpdateRFHardwareState();
+    FinishRFHardwareSequence();
     EXPECT_EQ(GetRXVFOFrequency(), 7100000L);
     EXPECT_EQ(ED.fineTuneFreq_Hz[ED.activeVFO], 500L);
     EXPECT_EQ(GetTXRXFreq_dHz(),rxtx*100);
@@ -297,6 +321,7 @@ TEST(RFHardwareState, TuneStateMachine_UpdateTuneStateFromCWTransmitKeyerWait) {
 TEST(RFHardwareState, TuneStateMachine_StateTransitionSequenceSSBToReceive) {
     SetDualVFOs(true);
     si5351 = Si5351(); // Reset mock
+    ResetVFOState(); // Drop any quadrature setup an earlier test left running
     ED.centerFreq_Hz[ED.activeVFO] = 14230000L;
     ED.fineTuneFreq_Hz[ED.activeVFO] = 100L;
     SampleRate = SAMPLE_RATE_48K;
@@ -321,6 +346,7 @@ TEST(RFHardwareState, TuneStateMachine_StateTransitionSequenceSSBToReceive) {
 TEST(RFHardwareState, TuneStateMachine_StateTransitionSequenceCWReceiveToTransmit) {
     SetDualVFOs(true);
     si5351 = Si5351(); // Reset mock
+    ResetVFOState(); // Drop any quadrature setup an earlier test left running
     ED.centerFreq_Hz[ED.activeVFO] = 7030000L;
     ED.fineTuneFreq_Hz[ED.activeVFO] = 200L;
     SampleRate = SAMPLE_RATE_48K;
@@ -584,6 +610,7 @@ TEST(RFHardwareState, SingleVFO_StateTransitionToCWSpace){
     InitializeRFHardware();
     modeSM.state_id = ModeSm_StateId_CW_TRANSMIT_SPACE;
     UpdateRFHardwareState();
+    FinishRFHardwareSequence();
 
     // CW TRANSMIT SPACE STATE (Single VFO)
     // We expect CLK0 and CLK1 (RX VFO) to be disabled, and CLK2 (CW single VFO) to be enabled
@@ -612,6 +639,7 @@ TEST(RFHardwareState, SingleVFO_StateTransitionToCWMark){
     InitializeRFHardware();
     modeSM.state_id = ModeSm_StateId_CW_TRANSMIT_MARK;
     UpdateRFHardwareState();
+    FinishRFHardwareSequence();
 
     // CW TRANSMIT MARK STATE (Single VFO)
     // We expect CLK0 and CLK1 (RX VFO) to be disabled, and CLK2 (CW single VFO) to be enabled
@@ -873,4 +901,287 @@ TEST(RFHardwareState, SingleVFO_BufferLogsCWVFOStateChanges) {
     // Verify buffer has two entries with different register values
     EXPECT_EQ(buffer.count, 2);
     EXPECT_NE(buffer.entries[0].register_value, buffer.entries[1].register_value);
-}
\ No newline at end of file
+}
+// ================== T/R SEQUENCER TESTS ==================
+
+/**
+ * Copy the hardware register history out of the rolling buffer, oldest first.
+ * Writes that left the register unchanged are dropped, since their number
+ * depends on which VFO settings were already cached.
+ */
+static std::vector<uint64_t> RegisterHistory(void){
+    std::vector<uint64_t> history;
+    size_t first = (buffer.head + REGISTER_BUFFER_SIZE - buffer.count) % REGISTER_BUFFER_SIZE;
+    for (size_t i = 0; i < buffer.count; i++){
+        uint64_t value = buffer.entries[(first + i) % REGISTER_BUFFER_SIZE].register_value;
+        if (history.empty() || (history.back() != value))
+            history.push_back(value);
+    }
+    return history;
+}
+
+/**
+ * Fire the quadrature timers as the hardware would 58.5 ms after a VFO change
+ * below 3.2 MHz, and finish the setup as loop() would, so the next transition
+ * starts with settled VFOs.
+ */
+static void FinishVFOQuadrature(void){
+    rxQuadratureTimer.fire();
+    txQuadratureTimer.fire();
+    ServiceVFOQuadrature();
+}
+
+static void EnterRFState(ModeSm_StateId state){
+    modeSM.state_id = state;
+    UpdateRFHardwareState();
+    FinishRFHardwareSequence();
+    FinishVFOQuadrature();
+}
+
+TEST(RFHardwareState, SequencerDoesNotBlock){
+    InitializeRFHardware();
+    EnterRFState(ModeSm_StateId_SSB_TRANSMIT);
+
+    modeSM.state_id = ModeSm_StateId_SSB_RECEIVE;
+    uint32_t start = micros();
+    UpdateRFHardwareState();
+    uint32_t elapsed = micros() - start;
+
+    // Only the first step has run. The transmit path is off but the relay is
+    // still in transmit
+    EXPECT_LT(elapsed, (uint32_t)5000);
+    EXPECT_TRUE(IsRFHardwareSequenceBusy());
+    EXPECT_EQ(getCWState(), 0);
+    EXPECT_EQ(GET_BIT(hardwareRegister, TXBPFBIT), 0);
+    EXPECT_EQ(GET_BIT(hardwareRegister, RXBPFBIT), 0);
+    EXPECT_EQ(getRXTXState(), 1);
+
+    // Staying in the same state while the sequence runs does nothing
+    UpdateRFHardwareState();
+    EXPECT_TRUE(IsRFHardwareSequenceBusy());
+
+    // The old code waited 10 + 10 + 20 ms
+    EXPECT_LE(FinishRFHardwareSequence(), (uint32_t)40);
+    EXPECT_FALSE(IsRFHardwareSequenceBusy());
+    EXPECT_EQ(getRXTXState(), 0);
+    EXPECT_EQ(GET_BIT(hardwareRegister, RXBPFBIT), 1);
+}
+
+TEST(RFHardwareState, SequencerReceiveOrderMatchesBlockingSequence){
+    ResetVFOState();
+    InitializeRFHardware();
+    EnterRFState(ModeSm_StateId_SSB_TRANSMIT);
+
+    // Reference: the receive sequence as the blocking code ran it, without the delays
+    buffer_flush();
+    modeSM.state_id = ModeSm_StateId_SSB_RECEIVE;
+    CWoff();
+    DisableCWVFOOutput();
+    if (HasDualVFOs())
+        DisableTXVFOOutput();
+    SetTXAttenuation(31.5);
+    TXBypassBPF();
+    SelectXVTR();
+    Bypass100WPA();
+    RXSelectBPF();
+    UpdateTuneState();
+    SetRXAttenuation( ED.RAtten[ED.currentBand[ED.activeVFO]] );
+    EnableRXVFOOutput();
+    SelectTXSSBModulation();
+    DisableCalFeedback();
+    SelectRXMode();
+    SetTXAttenuation(31.5);
+    std::vector<uint64_t> reference = RegisterHistory();
+    FinishVFOQuadrature();
+
+    // Back to transmit, then the same transition through the sequencer
+    ResetVFOState();
+    InitializeRFHardware();
+    EnterRFState(ModeSm_StateId_SSB_TRANSMIT);
+    buffer_flush();
+    modeSM.state_id = ModeSm_StateId_SSB_RECEIVE;
+    UpdateRFHardwareState();
+    uint32_t ticks = FinishRFHardwareSequence();
+    std::vector<uint64_t> sequenced = RegisterHistory();
+
+    EXPECT_GE(reference.size(), (size_t)6);
+    EXPECT_EQ(sequenced, reference);
+    EXPECT_LE(ticks, (uint32_t)40);
+}
+
+TEST(RFHardwareState, SequencerTransmitOrderMatchesBlockingSequence){
+    ResetVFOState();
+    InitializeRFHardware();
+    EnterRFState(ModeSm_StateId_SSB_RECEIVE);
+
+    buffer_flush();
+    modeSM.state_id = ModeSm_StateId_SSB_TRANSMIT;
+    CalculateSSBTXGain(ED.powerOutSSB[ED.currentBand[ED.activeVFO]],&ED.PA100Wactive);
+    SetRXAttenuation( 31.5 );
+    RXBypassBPF();
+    DisableCalFeedback();
+    SetTXAttenuation( 0 );
+    DisableCWVFOOutput();
+    CWoff();
+    UpdateTuneState();
+    EnableRXVFOOutput();
+    EnableTXVFOOutput();
+    SelectTXSSBModulation();
+    TXSelectBPF();
+    BypassXVTR();
+    if (ED.PA100Wactive)
+        Select100WPA();
+    else
+        Bypass100WPA();
+    SelectTXMode();
+    std::vector<uint64_t> reference = RegisterHistory();
+    FinishVFOQuadrature();
+
+    ResetVFOState();
+    InitializeRFHardware();
+    EnterRFState(ModeSm_StateId_SSB_RECEIVE);
+    buffer_flush();
+    modeSM.state_id = ModeSm_StateId_SSB_TRANSMIT;
+    UpdateRFHardwareState();
+    uint32_t ticks = FinishRFHardwareSequence();
+    std::vector<uint64_t> sequenced = RegisterHistory();
+
+    EXPECT_GE(reference.size(), (size_t)6);
+    EXPECT_EQ(sequenced, reference);
+    EXPECT_LE(ticks, (uint32_t)20);
+}
+
+TEST(RFHardwareState, SequencerCWMarkOrderMatchesBlockingSequence){
+    ResetVFOState();
+    InitializeRFHardware();
+    EnterRFState(ModeSm_StateId_CW_RECEIVE);
+
+    buffer_flush();
+    modeSM.state_id = ModeSm_StateId_CW_TRANSMIT_MARK;
+    float32_t att_dB = CalculateCWAttenuation(ED.powerOutCW[ED.currentBand[ED.activeVFO]],&ED.PA100Wactive);
+    RXBypassBPF();
+    DisableCalFeedback();
+    if ((att_dB >= 0) && (att_dB < 32))
+        SetTXAttenuation( att_dB );
+    else
+        SetTXAttenuation( ED.XAttenCW[ED.currentBand[ED.activeVFO]] );
+    DisableRXVFOOutput();
+    DisableTXVFOOutput();
+    UpdateTuneState();
+    EnableCWVFOOutput();
+    SelectTXCWModulation();
+    TXSelectBPF();
+    BypassXVTR();
+    if (ED.PA100Wactive)
+        Select100WPA();
+    else
+        Bypass100WPA();
+    SelectTXMode();
+    DisableCalFeedback();
+    CWon();
+    std::vector<uint64_t> reference = RegisterHistory();
+    FinishVFOQuadrature();
+
+    ResetVFOState();
+    InitializeRFHardware();
+    EnterRFState(ModeSm_StateId_CW_RECEIVE);
+    buffer_flush();
+    modeSM.state_id = ModeSm_StateId_CW_TRANSMIT_MARK;
+    UpdateRFHardwareState();
+    // The carrier stays off until the relay has switched
+    EXPECT_EQ(getRXTXState(), 1);
+    EXPECT_EQ(getCWState(), 0);
+    uint32_t ticks = FinishRFHardwareSequence();
+    std::vector<uint64_t> sequenced = RegisterHistory();
+
+    EXPECT_EQ(sequenced, reference);
+    EXPECT_LE(ticks, (uint32_t)20);
+    EXPECT_EQ(getCWState(), 1);
+
+    // Mark to space and back needs no settling time
+    modeSM.state_id = ModeSm_StateId_CW_TRANSMIT_SPACE;
+    UpdateRFHardwareState();
+    EXPECT_FALSE(IsRFHardwareSequenceBusy());
+    EXPECT_EQ(getCWState(), 0);
+    modeSM.state_id = ModeSm_StateId_CW_TRANSMIT_MARK;
+    UpdateRFHardwareState();
+    EXPECT_FALSE(IsRFHardwareSequenceBusy());
+    EXPECT_EQ(getCWState(), 1);
+}
+
+TEST(RFHardwareState, SequencerBatchesExpanderWrites){
+    ResetVFOState();
+    InitializeRFHardware();
+    EnterRFState(ModeSm_StateId_SSB_TRANSMIT);
+
+    // Reference: the receive sequence with every expander write sent at once
+    modeSM.state_id = ModeSm_StateId_SSB_RECEIVE;
+    ResetExpanderTransactions();
+    CWoff();
+    DisableCWVFOOutput();
+    if (HasDualVFOs())
+        DisableTXVFOOutput();
+    SetTXAttenuation(31.5);
+    TXBypassBPF();
+    SelectXVTR();
+    Bypass100WPA();
+    RXSelectBPF();
+    if (ED.PA100Wactive)
+        Select100WPA();
+    else
+        Bypass100WPA();
+    SelectLPFBand(ED.currentBand[ED.activeVFO]);
+    SelectBPFBand(ED.currentBand[ED.activeVFO]);
+    SelectAntenna(ED.antennaSelection[ED.currentBand[ED.activeVFO]]);
+    SetRXAttenuation( ED.RAtten[ED.currentBand[ED.activeVFO]] );
+    SelectRXMode();
+    uint32_t unbatched = GetExpanderTransactions();
+    FinishVFOQuadrature();
+
+    ResetVFOState();
+    InitializeRFHardware();
+    EnterRFState(ModeSm_StateId_SSB_TRANSMIT);
+    modeSM.state_id = ModeSm_StateId_SSB_RECEIVE;
+    ResetExpanderTransactions();
+    UpdateRFHardwareState();
+    // The first step leaves one write for each of the RF and LPF boards
+    EXPECT_EQ(GetExpanderTransactions(), (uint32_t)2);
+    FinishRFHardwareSequence();
+    uint32_t batched = GetExpanderTransactions();
+
+    EXPECT_LT(batched, unbatched);
+    // The expanders hold what the hardware register says
+    uint16_t gpioab = GetLPFMCPRegisters();
+    EXPECT_EQ((uint8_t)(gpioab & 0x00FF), (uint8_t)((hardwareRegister >> 8) & 0x03));
+    EXPECT_EQ((uint8_t)(gpioab >> 8), (uint8_t)(hardwareRegister & 0xFF));
+    gpioab = GetRFMCPRegisters();
+    EXPECT_EQ((uint8_t)(gpioab & 0x00FF), (uint8_t)((hardwareRegister >> RXATTLSB) & 0x3F));
+    EXPECT_EQ((uint8_t)(gpioab >> 8), (uint8_t)((hardwareRegister >> TXATTLSB) & 0x3F));
+    EXPECT_EQ(GetBPFMCPRegisters(), BPF_WORD);
+}
+
+TEST(RFHardwareState, SequencerEntersStateRequestedWhileBusy){
+    InitializeRFHardware();
+    EnterRFState(ModeSm_StateId_CW_RECEIVE);
+
+    // Key down, then key up and back to receive before the relay has settled
+    modeSM.state_id = ModeSm_StateId_CW_TRANSMIT_MARK;
+    UpdateRFHardwareState();
+    for (size_t k = 0; k < 5; k++){
+        TickRFHardwareSequence();
+        ServiceRFHardwareSequence();
+    }
+    modeSM.state_id = ModeSm_StateId_CW_TRANSMIT_SPACE;
+    UpdateRFHardwareState();
+    modeSM.state_id = ModeSm_StateId_CW_RECEIVE;
+    UpdateRFHardwareState();
+    EXPECT_TRUE(IsRFHardwareSequenceBusy());
+    EXPECT_EQ(getRXTXState(), 1);
+
+    // The mark sequence finishes, then the receive sequence runs
+    EXPECT_LE(FinishRFHardwareSequence(), (uint32_t)(20 + 40));
+    EXPECT_EQ(getCWState(), 0);
+    EXPECT_EQ(getRXTXState(), 0);
+    EXPECT_EQ(GET_BIT(hardwareRegister, RXBPFBIT), 1);
+    EXPECT_EQ(GET_BIT(hardwareRegister, TXBPFBIT), 0);
+}
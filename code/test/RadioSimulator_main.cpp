@@ -483,6 +483,27 @@ int main(int argc, char* argv[]) {
 
         // Update the SDL display once per frame (not on every draw call)
         tft.updateScreen();
+
+#ifdef TIMING_ANALYSIS
+        // Each pass through loop() is one display frame; report the display cost every 5 seconds
+        RA8875_EndCostFrame();
+        frameCount++;
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastFPSTime >= std::chrono::seconds(5)) {
+            double seconds = std::chrono::duration<double>(now - lastFPSTime).count();
+            printf("Display: %.1f loops/s, per loop: %.1f commands (%.1f drawLine, %.1f fillRect, %.2f BTE_move)\n",
+                   frameCount / seconds,
+                   (double)RA8875_callCounts.total / frameCount,
+                   (double)RA8875_callCounts.drawLine / frameCount,
+                   (double)RA8875_callCounts.fillRect / frameCount,
+                   (double)RA8875_callCounts.BTE_move / frameCount);
+            RA8875_PrintCostReport();
+            RA8875_ResetCallCounts();
+            RA8875_ResetCost();
+            frameCount = 0;
+            lastFPSTime = now;
+        }
+#endif
     }
 
     std::cout << "Cleaning up..." << std::endl;
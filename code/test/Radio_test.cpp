@@ -21,7 +21,7 @@ static std::thread timer_thread;
  * Dispatches DO events to the state machines
  */
 void timer1ms(void) {
-    ModeSm_dispatch_event(&modeSM, ModeSm_EventId_DO);
+    TickRFHardwareAndModeSm();
     UISm_dispatch_event(&uiSM, UISm_EventId_DO);
 }
 
@@ -74,19 +74,32 @@ void stop_timer1ms() {
     }
 }
 
+/**
+ * Wait for the T/R sequence started by the last state change to finish
+ */
+static void WaitForRFHardware(void){
+    // Poll finer than 1 ms so the keyer tests start their clock on the tick
+    // that ends the sequence
+    int64_t start = millis();
+    while (IsRFHardwareSequenceBusy() && (millis() - start < 1000)){
+        ServiceRFHardwareSequence();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
 // We can't override buffer_add due to linking conflicts.
 // The issue is that the timer thread and main thread are calling buffer_add simultaneously.
 // Let's analyze the actual timing output to understand the root cause better.
 
 void CheckThatHardwareRegisterMatchesActualHardware(){
     // LPF
-    uint16_t gpioab = GetLPFMCPRegisters(); // a is upper half, b is lower half
-    EXPECT_EQ((uint8_t)(gpioab & 0x00FF), (uint8_t)(hardwareRegister & 0x000000FF)); // gpiob
-    EXPECT_EQ((uint8_t)((gpioab >> 8) & 0x0003), (uint8_t)((hardwareRegister >> 8) & 0x00000003));
+    uint16_t gpioab = GetLPFMCPRegisters(); // a is lower half, b is upper half
+    EXPECT_EQ((uint8_t)((gpioab >> 8) & 0x00FF), (uint8_t)(hardwareRegister & 0x000000FF)); // gpiob
+    EXPECT_EQ((uint8_t)(gpioab & 0x0003), (uint8_t)((hardwareRegister >> 8) & 0x00000003));
     // RF
     gpioab = GetRFMCPRegisters();
-    EXPECT_EQ((uint8_t)(gpioab & 0x003F), (uint8_t)((hardwareRegister >> TXATTLSB) & 0x0000003F)); // tx atten
-    EXPECT_EQ((uint8_t)((gpioab >> 8) & 0x003F), (uint8_t)((hardwareRegister >> RXATTLSB) & 0x0000003F));
+    EXPECT_EQ((uint8_t)((gpioab >> 8) & 0x003F), (uint8_t)((hardwareRegister >> TXATTLSB) & 0x0000003F)); // tx atten
+    EXPECT_EQ((uint8_t)(gpioab & 0x003F), (uint8_t)((hardwareRegister >> RXATTLSB) & 0x0000003F));
     // BPF
     gpioab = GetBPFMCPRegisters();
     EXPECT_EQ(gpioab, BPF_WORD);
@@ -250,6 +263,7 @@ TEST(Radio, RadioStateRunThrough) {
 
     // Now, start the 1ms timer interrupt to simulate hardware timer
     start_timer1ms();
+    WaitForRFHardware(); // let the receive sequence started by ModeSm_start finish
 
     //-------------------------------------------------------------
     
@@ -296,7 +310,7 @@ TEST(Radio, RadioStateRunThrough) {
     
     // Go to SSB transmit mode
     SetInterrupt(iPTT_PRESSED);
-    loop(); MyDelay(10);
+    loop(); WaitForRFHardware();
     EXPECT_EQ(modeSM.state_id, ModeSm_StateId_SSB_TRANSMIT);
     CheckThatStateIsSSBTransmit();
     for (size_t i = 0; i < 50; i++){
@@ -320,7 +334,7 @@ TEST(Radio, RadioStateRunThrough) {
 
     // Go back to SSB receive mode
     SetInterrupt(iPTT_RELEASED);
-    loop(); MyDelay(10);
+    loop(); WaitForRFHardware();
     EXPECT_EQ(modeSM.state_id, ModeSm_StateId_SSB_RECEIVE);
     CheckThatStateIsReceive();
     EXPECT_EQ(oldrxtx+100*ED.freqIncrement, GetTXRXFreq_dHz()); // rxtx should stay the same
@@ -338,7 +352,7 @@ TEST(Radio, RadioStateRunThrough) {
     // Press the key to start transmitting
     digitalWrite(KEY1, 0); // KEY1 pressed (active low)
     SetInterrupt(iKEY1_PRESSED);
-    loop(); MyDelay(10);
+    loop(); WaitForRFHardware();
     EXPECT_EQ(modeSM.state_id, ModeSm_StateId_CW_TRANSMIT_MARK);
     CheckThatStateIsCWTransmitMark();
     Debug("Change to CW transmit mark mode:");print_frequency_state();
@@ -404,7 +418,7 @@ TEST(Radio, RadioStateRunThrough) {
     StartMillis();
     buffer_flush();
     SetInterrupt(iKEY1_PRESSED);
-    loop();
+    loop(); WaitForRFHardware();
     int64_t m0 = millis();
     for (size_t i = 0; i < 600; i++){
         loop(); MyDelay(1);
@@ -442,7 +456,7 @@ TEST(Radio, RadioStateRunThrough) {
     StartMillis();
     buffer_flush();
     SetInterrupt(iKEY1_PRESSED);
-    loop();
+    loop(); WaitForRFHardware();
     m0 = millis();
     for (size_t i = 0; i < 800; i++){
         loop(); MyDelay(1);
@@ -480,7 +494,7 @@ TEST(Radio, RadioStateRunThrough) {
     EXPECT_EQ(GetInterruptFifoSize(),0);
     SetInterrupt(iKEY2_PRESSED);
     EXPECT_EQ(GetInterruptFifoSize(),1);
-    loop();
+    loop(); WaitForRFHardware();
     m0 = millis();
     EXPECT_EQ(modeSM.state_id, ModeSm_StateId_CW_TRANSMIT_DIT_MARK);
     EXPECT_EQ(GetInterruptFifoSize(),0);
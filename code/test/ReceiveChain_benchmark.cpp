@@ -0,0 +1,406 @@
+/**
+ * @file ReceiveChain_benchmark.cpp
+ * @brief Host-side throughput benchmark for the receive signal processing chain
+ *
+ * Drives ReceiveProcessing() with recorded or synthetic IQ blocks and reports the
+ * cost of each stage of the chain. The sources are compiled with DSP_STAGE_TIMING
+ * defined, which makes ReceiveProcessing() call DSPStageTimer() after every stage.
+ * This file supplies that function.
+ *
+ * Costs are reported in ns per input sample (a block is READ_BUFFER_SIZE complex
+ * samples at 192 ksps), so the stage costs add up to the cost of the whole chain.
+ * The absolute numbers are for the host CPU, not the Teensy, but the relative
+ * cost of the stages and the change from one commit to the next are meaningful.
+ *
+ * Build with: make receive_chain_benchmark
+ * Run with:   ./receive_chain_benchmark [-n blocks] [-s] [-o out.csv] [-b baseline.csv] [-t pct]
+ *
+ *   -n blocks        Number of blocks timed per configuration (default 200)
+ *   -s               Use a synthetic two-tone + noise input instead of the recorded mock data
+ *   -o out.csv       Where to write the results (default ReceiveChain_benchmark.csv)
+ *   -b baseline.csv  Compare the total cost of each configuration against an earlier run
+ *   -t pct           Regression threshold in percent used with -b (default 10)
+ *
+ * With -b, the program returns a non-zero exit code if any configuration got slower
+ * than the baseline by more than the threshold.
+ *
+ * After the chain sweep, AGC() is timed on its own for each AGC preset and a range
+ * of look-ahead (attack) window lengths, to show that its cost does not grow with
+ * the window.
+ */
+
+#include "../src/PhoenixSketch/SDT.h"
+#include <chrono>
+#include <map>
+#include <string>
+
+#define WARMUP_BLOCKS 10
+#define REPETITIONS   3
+
+static const char *stageNames[DSPStage_Count] = {
+    "Start",
+    "ApplyRFGain",
+    "ApplyIQCorrection",
+    "CWSkimmer",
+    "ZoomFFTExe",
+    "FreqShiftFs4",
+    "FreqShiftDecimateBy4",
+    "DecimateBy2",
+    "VolumeScale",
+    "ConvolutionFilter",
+    "AGC",
+    "Demodulate",
+    "BandEQ",
+    "NoiseReduction",
+    "Notch",
+    "CWProcessing",
+    "InterpolateReceiveData",
+    "AdjustVolume",
+    "PlayBuffer",
+};
+
+/** One point in the sweep over zoom levels, modulations, noise reduction modes and FFT sizes */
+struct BenchConfig {
+    const char *name;
+    uint32_t zoom;
+    ModulationType modulation;
+    NoiseReductionType nr;
+    uint32_t fftSize;
+};
+
+static const BenchConfig configs[] = {
+    {"zoom1_USB_NROff",  SPECTRUM_ZOOM_1,  USB, NROff, 512},
+    {"zoom2_USB_NROff",  SPECTRUM_ZOOM_2,  USB, NROff, 512},
+    {"zoom4_USB_NROff",  SPECTRUM_ZOOM_4,  USB, NROff, 512},
+    {"zoom8_USB_NROff",  SPECTRUM_ZOOM_8,  USB, NROff, 512},
+    {"zoom16_USB_NROff", SPECTRUM_ZOOM_16, USB, NROff, 512},
+    {"zoom2_LSB_NROff",  SPECTRUM_ZOOM_2,  LSB, NROff, 512},
+    {"zoom2_AM_NROff",   SPECTRUM_ZOOM_2,  AM,  NROff, 512},
+    {"zoom2_SAM_NROff",  SPECTRUM_ZOOM_2,  SAM, NROff, 512},
+    {"zoom2_USB_NRKim",  SPECTRUM_ZOOM_2,  USB, NRKim, 512},
+    {"zoom2_USB_NRSpectral", SPECTRUM_ZOOM_2, USB, NRSpectral, 512},
+    {"zoom2_USB_NRLMS",  SPECTRUM_ZOOM_2,  USB, NRLMS, 512},
+    {"zoom1_USB_NROff_FFT2048", SPECTRUM_ZOOM_1, USB, NROff, 2048},
+    {"zoom2_USB_NROff_FFT2048", SPECTRUM_ZOOM_2, USB, NROff, 2048},
+};
+#define N_CONFIGS (sizeof(configs)/sizeof(configs[0]))
+
+// Accumulated time in each stage, filled in by DSPStageTimer()
+static double stageTime_ns[DSPStage_Count];
+static std::chrono::steady_clock::time_point lastMark;
+
+void DSPStageTimer(DSPStage stage){
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (stage != DSPStage_Start){
+        stageTime_ns[stage] += std::chrono::duration<double, std::nano>(now - lastMark).count();
+    }
+    lastMark = now;
+}
+
+// The mock AudioRecordQueue reads one block past 4*2048 samples before wrapping
+#define SYNTH_SAMPLES (4*READ_BUFFER_SIZE + USB_BUFFER_SIZE)
+static int16_t synth_I[SYNTH_SAMPLES];
+static int16_t synth_Q[SYNTH_SAMPLES];
+
+/**
+ * Create a repeatable IQ input: two tones inside the receive passband plus
+ * pseudo-random noise, scaled to the int16 range delivered by the audio codec.
+ */
+static void CreateSyntheticInput(void){
+    uint32_t seed = 12345;
+    float32_t fs = 192000.0;
+    for (size_t i = 0; i < SYNTH_SAMPLES; i++){
+        seed = seed * 1664525 + 1013904223;
+        float32_t nI = ((float32_t)(seed >> 16) / 65536.0 - 0.5) * 0.02;
+        seed = seed * 1664525 + 1013904223;
+        float32_t nQ = ((float32_t)(seed >> 16) / 65536.0 - 0.5) * 0.02;
+        float32_t p1 = TWO_PI * (-48000.0 + 1000.0) * (float32_t)i / fs;
+        float32_t p2 = TWO_PI * (-48000.0 + 2300.0) * (float32_t)i / fs;
+        synth_I[i] = (int16_t)(32767 * (0.1*cosf(p1) + 0.01*cosf(p2) + nI));
+        synth_Q[i] = (int16_t)(32767 * (0.1*sinf(p1) + 0.01*sinf(p2) + nQ));
+    }
+}
+
+/**
+ * Run one configuration of the receive chain and fill stage_ns with the cost of
+ * each stage in ns per input sample. The fastest of REPETITIONS passes is kept
+ * for each stage to suppress scheduling noise on the host.
+ */
+static void RunConfig(const BenchConfig *cfg, uint32_t nblocks, double *stage_ns){
+    ED.spectrum_zoom = cfg->zoom;
+    ED.modulation[ED.activeVFO] = cfg->modulation;
+    ED.nrOptionSelect = cfg->nr;
+    SetSpectrumFFTSize(cfg->fftSize);
+    InitializeSignalProcessing();
+    ResetPSD();
+
+    for (size_t k = 0; k < WARMUP_BLOCKS; k++){
+        ReceiveProcessing(nullptr);
+    }
+
+    for (size_t s = 0; s < DSPStage_Count; s++)
+        stage_ns[s] = -1;
+    for (size_t r = 0; r < REPETITIONS; r++){
+        memset(stageTime_ns, 0, sizeof(stageTime_ns));
+        for (size_t k = 0; k < nblocks; k++){
+            ReceiveProcessing(nullptr);
+        }
+        for (size_t s = 1; s < DSPStage_Count; s++){
+            double ns = stageTime_ns[s] / ((double)nblocks * READ_BUFFER_SIZE);
+            if ((stage_ns[s] < 0) || (ns < stage_ns[s]))
+                stage_ns[s] = ns;
+        }
+    }
+}
+
+static const AGCMode agcPresets[] = {AGCFast, AGCMed, AGCSlow, AGCLong};
+static const char *agcPresetNames[] = {"AGCFast", "AGCMed", "AGCSlow", "AGCLong"};
+// Look-ahead window lengths in samples. InitializeAGC() sets 96 at 24 ksps; the
+// largest must fit in the AGC ring buffer.
+static const uint32_t agcWindows[] = {24, 96, 384, 1536};
+#define N_AGC_PRESETS (sizeof(agcPresets)/sizeof(agcPresets[0]))
+#define N_AGC_WINDOWS (sizeof(agcWindows)/sizeof(agcWindows[0]))
+
+/**
+ * Time AGC() alone on a keyed 700 Hz tone at the decimated sample rate and return
+ * the cost in ns per sample. A constant envelope is the worst case for tracking
+ * the window peak. The attack time constant is fixed in AGCConfig, so the window
+ * length is set directly after InitializeAGC().
+ */
+static double RunAGC(AGCMode preset, uint32_t window, uint32_t nblocks){
+    const uint32_t N = READ_BUFFER_SIZE / RXfilters.DF;
+    const float32_t fs = SR[SampleRate].rate / RXfilters.DF;
+    static float32_t I[READ_BUFFER_SIZE];
+    static float32_t Q[READ_BUFFER_SIZE];
+    static float32_t tone_I[READ_BUFFER_SIZE];
+    static float32_t tone_Q[READ_BUFFER_SIZE];
+
+    ED.agc = preset;
+    InitializeAGC(&agc, (uint32_t)fs);
+    agc.attack_buffsize = window;
+    agc.in_index = agc.attack_buffsize + agc.out_index;
+
+    DataBlock data;
+    data.I = I;
+    data.Q = Q;
+    data.N = N;
+    data.sampleRate_Hz = fs;
+
+    double best = -1;
+    for (size_t r = 0; r < REPETITIONS; r++){
+        double elapsed = 0;
+        for (size_t k = 0; k < nblocks; k++){
+            // Key the tone on and off every 8 blocks
+            float32_t amplitude = ((k / 8) % 2) ? 0.0 : 0.1;
+            for (size_t i = 0; i < N; i++){
+                float32_t p = TWO_PI * 700.0 * (float32_t)(k * N + i) / fs;
+                tone_I[i] = amplitude * cosf(p);
+                tone_Q[i] = amplitude * sinf(p);
+            }
+            memcpy(I, tone_I, N * sizeof(float32_t));
+            memcpy(Q, tone_Q, N * sizeof(float32_t));
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            AGC(&data, &agc);
+            elapsed += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+        }
+        double ns = elapsed / ((double)nblocks * N);
+        if ((best < 0) || (ns < best))
+            best = ns;
+    }
+    return best;
+}
+
+static const uint32_t skimmerSignals[] = {0, 2, 8};
+#define N_SKIMMER_ROWS (sizeof(skimmerSignals)/sizeof(skimmerSignals[0]))
+
+/**
+ * Time DoCWSkimmerProcessing() alone on noise plus nsignals keyed tones spread
+ * across the band and return the cost in us per block. Each tone is keyed with
+ * a different dit length so that the decoders do not run in lock step.
+ */
+static double RunCWSkimmer(uint32_t nsignals, uint32_t nblocks, uint32_t *active){
+    static float32_t I[READ_BUFFER_SIZE];
+    static float32_t Q[READ_BUFFER_SIZE];
+    const float32_t fs = 192000.0;
+    DataBlock data = {READ_BUFFER_SIZE, (uint32_t)fs, I, Q};
+
+    EnableCWSkimmer(true);
+    uint32_t seed = 12345;
+    double best = -1;
+    for (size_t r = 0; r < REPETITIONS; r++){
+        double elapsed = 0;
+        for (size_t k = 0; k < nblocks; k++){
+            for (size_t i = 0; i < READ_BUFFER_SIZE; i++){
+                seed = seed * 1664525 + 1013904223;
+                I[i] = ((float32_t)(seed >> 16) / 65536.0 - 0.5) * 0.002;
+                seed = seed * 1664525 + 1013904223;
+                Q[i] = ((float32_t)(seed >> 16) / 65536.0 - 0.5) * 0.002;
+            }
+            for (size_t s = 0; s < nsignals; s++){
+                float32_t f = (float32_t)GetCWSkimmerChannelOffset_Hz(10 + 29*s, fs);
+                uint32_t dit = 8 + 3*s;
+                for (size_t i = 0; i < READ_BUFFER_SIZE; i++){
+                    uint32_t n = (r*nblocks + k)*READ_BUFFER_SIZE + i;
+                    if (((n / READ_BUFFER_SIZE) / dit) % 2) continue;
+                    float32_t p = TWO_PI * f * (float32_t)(n % 192000) / fs;
+                    I[i] += 0.01*cosf(p);
+                    Q[i] += 0.01*sinf(p);
+                }
+            }
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            DoCWSkimmerProcessing(&data);
+            elapsed += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        }
+        double us = elapsed / nblocks;
+        if ((best < 0) || (us < best))
+            best = us;
+    }
+    *active = GetCWSkimmerActiveChannels();
+    EnableCWSkimmer(false);
+    return best;
+}
+
+/**
+ * Read the total cost of each configuration from a CSV file written by an
+ * earlier run of this program.
+ */
+static std::map<std::string, double> ReadBaseline(const char *fname){
+    std::map<std::string, double> totals;
+    FILE *file = fopen(fname, "r");
+    if (file == nullptr){
+        printf("Could not open baseline file %s\n", fname);
+        return totals;
+    }
+    char line[200];
+    while (fgets(line, sizeof(line), file) != nullptr){
+        char cfg[100], stage[100];
+        double ns;
+        if (sscanf(line, "%99[^,],%99[^,],%lf", cfg, stage, &ns) == 3){
+            if (strcmp(stage, "Total") == 0)
+                totals[cfg] = ns;
+        }
+    }
+    fclose(file);
+    return totals;
+}
+
+int main(int argc, char **argv){
+    uint32_t nblocks = 200;
+    bool synthetic = false;
+    const char *outname = "ReceiveChain_benchmark.csv";
+    const char *baselinename = nullptr;
+    double tolerance_pct = 10.0;
+    for (int i = 1; i < argc; i++){
+        if ((strcmp(argv[i], "-n") == 0) && (i+1 < argc)) nblocks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-s") == 0) synthetic = true;
+        else if ((strcmp(argv[i], "-o") == 0) && (i+1 < argc)) outname = argv[++i];
+        else if ((strcmp(argv[i], "-b") == 0) && (i+1 < argc)) baselinename = argv[++i];
+        else if ((strcmp(argv[i], "-t") == 0) && (i+1 < argc)) tolerance_pct = atof(argv[++i]);
+        else {
+            printf("Usage: %s [-n blocks] [-s] [-o out.csv] [-b baseline.csv] [-t pct]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (nblocks == 0) nblocks = 1;
+
+    StartMillis();
+    modeSM.state_id = ModeSm_StateId_SSB_RECEIVE;
+    ED.agc = AGCMed;
+    // A non-zero fine tune offset so FreqShiftF() does representative work
+    ED.fineTuneFreq_Hz[ED.activeVFO] = 1234;
+    Q_out_L.setName(nullptr);
+    Q_out_R.setName(nullptr);
+    if (synthetic){
+        CreateSyntheticInput();
+        Q_in_L.setChannel(0, synth_I);
+        Q_in_R.setChannel(1, synth_Q);
+    } else {
+        Q_in_L.setChannel(0);
+        Q_in_R.setChannel(1);
+    }
+    Q_in_L.clear();
+    Q_in_R.clear();
+
+    printf("Receive chain benchmark: %s input, %u blocks of %d samples per configuration\n",
+            synthetic ? "synthetic" : "recorded", nblocks, READ_BUFFER_SIZE);
+    printf("Costs in ns per input sample (192 ksps)\n\n");
+
+    FILE *csv = fopen(outname, "w");
+    if (csv != nullptr) fprintf(csv, "config,stage,ns_per_sample\n");
+
+    double results[N_CONFIGS][DSPStage_Count];
+    double totals[N_CONFIGS];
+    for (size_t c = 0; c < N_CONFIGS; c++){
+        RunConfig(&configs[c], nblocks, results[c]);
+        totals[c] = 0;
+        for (size_t s = 1; s < DSPStage_Count; s++){
+            totals[c] += results[c][s];
+            if (csv != nullptr) fprintf(csv, "%s,%s,%.3f\n", configs[c].name, stageNames[s], results[c][s]);
+        }
+        if (csv != nullptr) fprintf(csv, "%s,Total,%.3f\n", configs[c].name, totals[c]);
+    }
+    if (csv != nullptr) fclose(csv);
+
+    // One row per stage, one column per configuration
+    printf("%-24s", "Stage");
+    for (size_t c = 0; c < N_CONFIGS; c++) printf(" %8zu", c);
+    printf("\n");
+    for (size_t s = 1; s < DSPStage_Count; s++){
+        printf("%-24s", stageNames[s]);
+        for (size_t c = 0; c < N_CONFIGS; c++) printf(" %8.2f", results[c][s]);
+        printf("\n");
+    }
+    printf("%-24s", "Total");
+    for (size_t c = 0; c < N_CONFIGS; c++) printf(" %8.2f", totals[c]);
+    printf("\n\nConfigurations:\n");
+    for (size_t c = 0; c < N_CONFIGS; c++){
+        printf("  %2zu: %-22s %8.2f ns/sample, %8.1f us/block\n", c, configs[c].name,
+                totals[c], totals[c] * READ_BUFFER_SIZE / 1000.0);
+    }
+
+    // AGC cost against the look-ahead window length, one row per preset
+    printf("\nAGC cost in ns per sample (%u ksps) against attack window length\n",
+            (uint32_t)(SR[SampleRate].rate / RXfilters.DF / 1000));
+    printf("%-10s", "Preset");
+    for (size_t w = 0; w < N_AGC_WINDOWS; w++) printf(" %7u", agcWindows[w]);
+    printf("\n");
+    for (size_t p = 0; p < N_AGC_PRESETS; p++){
+        printf("%-10s", agcPresetNames[p]);
+        for (size_t w = 0; w < N_AGC_WINDOWS; w++)
+            printf(" %7.2f", RunAGC(agcPresets[p], agcWindows[w], nblocks));
+        printf("\n");
+    }
+    ED.agc = AGCMed;
+
+    // Skimmer cost against the number of keyed signals in the band
+    printf("\nCW skimmer, %d channels: cost per block of %d samples\n",
+            CW_SKIMMER_CHANNELS, READ_BUFFER_SIZE);
+    printf("%-8s %8s %10s %12s\n", "Signals", "Decoders", "us/block", "channels/ms");
+    for (size_t k = 0; k < N_SKIMMER_ROWS; k++){
+        uint32_t active = 0;
+        double us = RunCWSkimmer(skimmerSignals[k], nblocks, &active);
+        printf("%-8u %8u %10.1f %12.1f\n", skimmerSignals[k], active, us,
+                CW_SKIMMER_CHANNELS * 1000.0 / us);
+    }
+
+    printf("\nResults written to %s\n", outname);
+
+    if (baselinename == nullptr) return 0;
+
+    int regressions = 0;
+    std::map<std::string, double> baseline = ReadBaseline(baselinename);
+    printf("\nComparison with %s (threshold %.1f%%):\n", baselinename, tolerance_pct);
+    for (size_t c = 0; c < N_CONFIGS; c++){
+        std::map<std::string, double>::iterator it = baseline.find(configs[c].name);
+        if (it == baseline.end()){
+            printf("  %-22s not in baseline\n", configs[c].name);
+            continue;
+        }
+        double change_pct = 100.0 * (totals[c] - it->second) / it->second;
+        bool regressed = change_pct > tolerance_pct;
+        if (regressed) regressions++;
+        printf("  %-22s %8.2f -> %8.2f ns/sample (%+6.1f%%)%s\n", configs[c].name,
+                it->second, totals[c], change_pct, regressed ? "  REGRESSION" : "");
+    }
+    return (regressions > 0) ? 2 : 0;
+}
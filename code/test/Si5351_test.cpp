@@ -0,0 +1,97 @@
+#include "gtest/gtest.h"
+#include "../src/PhoenixSketch/SDT.h"
+#include "../src/PhoenixSketch/RFBoard_si5351.h"
+
+// These tests run the real Si5351 driver (RFBoard_si5351.cpp) against the Wire
+// mock and count the bytes it puts on the bus.
+
+/**
+ * Tune a quadrature pair the way SetRXVFOFrequency() does above 3.2 MHz: only
+ * the PLL changes while the divider stays the same, a new divider sets up both
+ * outputs again.
+ */
+static void TuneQuadrature(Si5351 &dev, uint64_t freq_dHz, uint32_t multiple, uint32_t *oldMultiple) {
+    uint64_t pll_freq = freq_dHz * multiple;
+    if (multiple == *oldMultiple) {
+        dev.set_pll(pll_freq, SI5351_PLLA);
+        return;
+    }
+    dev.set_freq_manual(freq_dHz, pll_freq, SI5351_CLK0);
+    dev.set_freq_manual(freq_dHz, pll_freq, SI5351_CLK1);
+    dev.set_phase(SI5351_CLK0, 0);
+    dev.set_phase(SI5351_CLK1, multiple);
+    dev.pll_reset(SI5351_PLLA);
+    dev.output_enable(SI5351_CLK0, 1);
+    dev.output_enable(SI5351_CLK1, 1);
+    *oldMultiple = multiple;
+}
+
+/**
+ * Tune across 40 m in 100 Hz steps, as a fast spin of the tune encoder would,
+ * then jump to 20 m and back. Returns the bytes the driver sent on the bus.
+ */
+static uint32_t TuningSweepBytes(bool shadow, uint32_t *transactions) {
+    Si5351 dev(SI5351_BUS_BASE_ADDR);
+    Wire.respond = true;
+    Wire.readValue = 0;
+    dev.init(SI5351_CRYSTAL_LOAD_8PF, 25000000L, 0);
+    dev.set_register_shadow(shadow);
+    dev.set_ms_source(SI5351_CLK0, SI5351_PLLA);
+    dev.set_ms_source(SI5351_CLK1, SI5351_PLLA);
+    uint32_t oldMultiple = 0;
+    TuneQuadrature(dev, 700000000, 88, &oldMultiple);
+    Wire.resetCounters();
+    for (uint64_t f = 700000000; f <= 730000000; f += 10000)
+        TuneQuadrature(dev, f, 88, &oldMultiple);
+    TuneQuadrature(dev, 1407400000, 44, &oldMultiple);
+    TuneQuadrature(dev, 707400000, 88, &oldMultiple);
+    Wire.respond = false;
+    *transactions = Wire.transactions;
+    return Wire.bytes;
+}
+
+TEST(Si5351, TuningSweepSendsFewerBytes) {
+    uint32_t fullTransactions, shadowTransactions;
+    uint32_t fullBytes = TuningSweepBytes(false, &fullTransactions);
+    uint32_t shadowBytes = TuningSweepBytes(true, &shadowTransactions);
+    printf("Tuning sweep: %u bytes in %u transactions without the shadow, "
+           "%u bytes in %u transactions with it\n",
+           fullBytes, fullTransactions, shadowBytes, shadowTransactions);
+    // Each 100 Hz step sends the full PLL block without the shadow
+    EXPECT_GE(fullBytes, (uint32_t)(3001*(2 + 8)));
+    EXPECT_LT(shadowBytes, fullBytes/2);
+    EXPECT_LT(shadowTransactions, fullTransactions);
+}
+
+TEST(Si5351, CountersMatchTheBus) {
+    // The driver's own counters agree with what the Wire mock saw
+    Si5351 dev(SI5351_BUS_BASE_ADDR);
+    Wire.respond = true;
+    Wire.resetCounters();
+    dev.reset_i2c_counters();
+    dev.set_pll(62000000000ULL, SI5351_PLLA);
+    dev.set_pll(62000100000ULL, SI5351_PLLA);
+    dev.si5351_read(SI5351_DEVICE_STATUS);
+    Wire.respond = false;
+    EXPECT_EQ(dev.get_i2c_bytes_sent(), Wire.bytes);
+    EXPECT_EQ(dev.get_i2c_transactions(), Wire.transactions);
+}
+
+TEST(Si5351, FailedReadIsNotShadowed) {
+    Si5351 dev(SI5351_BUS_BASE_ADDR);
+    // No device answers: the read returns 0 but the register stays unknown
+    Wire.respond = false;
+    Wire.resetCounters();
+    EXPECT_EQ(dev.si5351_read(SI5351_CLK0_CTRL), 0);
+    EXPECT_EQ(dev.si5351_read(SI5351_CLK0_CTRL), 0);
+    EXPECT_EQ(Wire.transactions, (uint32_t)4);
+    // Once the device answers its value is kept
+    Wire.respond = true;
+    Wire.readValue = 0x4F;
+    Wire.resetCounters();
+    EXPECT_EQ(dev.si5351_read(SI5351_CLK0_CTRL), 0x4F);
+    EXPECT_EQ(dev.si5351_read(SI5351_CLK0_CTRL), 0x4F);
+    EXPECT_EQ(Wire.transactions, (uint32_t)2);
+    Wire.respond = false;
+    Wire.readValue = 0;
+}
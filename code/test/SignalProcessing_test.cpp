@@ -1,7 +1,12 @@
 #include "gtest/gtest.h"
 
 #include "../src/PhoenixSketch/SDT.h"
+#include <atomic>
+#include <cfloat>
+#include <thread>
+#include <string>
 #include <sys/time.h>
+#include <malloc.h>
 
 
 float32_t get_max(float32_t *d, uint32_t Nsamples){
@@ -306,6 +311,192 @@ TEST(SignalProcessing, PSDCalculation){
 
 }
 
+TEST(SignalProcessing, Log10fFastBlock){
+    // The block version must give the same result as log10f_fast() for normal numbers
+    float32_t x[200];
+    float32_t y[200];
+    for (size_t i = 0; i < 200; i++){
+        x[i] = powf(10.0, -15.0 + 0.15*i) * (1.0 + 0.37*(i % 7));
+    }
+    log10f_fast_f32(x, y, 200);
+    for (size_t i = 0; i < 200; i++){
+        EXPECT_NEAR(y[i], log10f_fast(x[i]), 1e-6);
+        EXPECT_NEAR(y[i], log10f(x[i]), 0.001);
+    }
+
+    // Zero and denormals are clamped to FLT_MIN, the floor of an empty PSD bin
+    float32_t small[3] = {0.0, 1e-42, FLT_MIN};
+    log10f_fast_f32(small, y, 3);
+    for (size_t i = 0; i < 3; i++){
+        EXPECT_FLOAT_EQ(y[i], log10f_fast(FLT_MIN));
+    }
+    EXPECT_NEAR(y[0], log10f(FLT_MIN), 0.001);
+}
+
+TEST(SignalProcessing, PSDDropsNonFiniteFrame){
+    // A frame containing a NaN must not latch in the spectrum average: it is
+    // dropped and the average restarts, so the next clean frame gives the same
+    // PSD as the first frame after a reset
+    float32_t I[SPECTRUM_RES], Q[SPECTRUM_RES];
+    float32_t first[SPECTRUM_RES];
+    SetSpectrumAveraging(SpectrumAvgExponential, 0);
+    CreateIQTone(I, Q, SPECTRUM_RES, SR[SampleRate].rate, 3000.0);
+    ResetPSD();
+    CalcPSD512(I, Q);
+    memcpy(first, psdnew, sizeof(first));
+
+    CalcPSD512(I, Q);
+    I[100] = NAN;
+    CalcPSD512(I, Q);
+    CreateIQTone(I, Q, SPECTRUM_RES, SR[SampleRate].rate, 3000.0);
+    CalcPSD512(I, Q);
+    for (size_t i = 0; i < SPECTRUM_RES; i++){
+        ASSERT_TRUE(isfinite(psdnew[i])) << "bin " << i;
+        EXPECT_FLOAT_EQ(psdnew[i], first[i]) << "bin " << i;
+    }
+}
+
+TEST(SignalProcessing, WindowTables){
+    for (int t = 0; t < WindowTypeCount; t++){
+        for (uint32_t N = 256; N <= 512; N *= 2){
+            const float32_t *w = GetWindowTable((WindowType)t, N);
+            ASSERT_NE(w, nullptr);
+            // Every window is scaled to the coherent gain of the Hann window
+            float32_t sum = 0;
+            for (size_t i = 0; i < N; i++) sum += w[i];
+            EXPECT_NEAR(sum/N, 0.5, 1e-4);
+            // Periodic windows are symmetric about N/2
+            for (size_t i = 1; i < N/2; i++) EXPECT_NEAR(w[i], w[N-i], 1e-5);
+            // The table is only built once
+            EXPECT_EQ(w, GetWindowTable((WindowType)t, N));
+        }
+    }
+    const float32_t *hann = GetWindowTable(WindowHann, 512);
+    for (size_t i = 0; i < 512; i++){
+        EXPECT_NEAR(hann[i], 0.5 - 0.5 * cos(TWO_PI * i / 512), 1e-6);
+    }
+    EXPECT_EQ(GetWindowTable(WindowHann, 100), nullptr);
+    EXPECT_EQ(GetWindowTable(WindowTypeCount, 512), nullptr);
+}
+
+/**
+ * Peak of the 512 point PSD of a tone at the given bin (can be fractional), in dB
+ */
+float32_t PSDPeak_dB(float32_t bin){
+    float I[512];
+    float Q[512];
+    for (size_t i = 0; i < 512; i++){
+        I[i] = cos(TWO_PI * bin * i / 512);
+        Q[i] = sin(TWO_PI * bin * i / 512);
+    }
+    ResetPSD();
+    CalcPSD512(I, Q);
+    float32_t peak = -1e10;
+    for (size_t i = 0; i < 512; i++) peak = fmaxf(peak, psdnew[i]);
+    return 10*peak;
+}
+
+TEST(SignalProcessing, PSDWindowScalloping){
+    // A tone halfway between two bins reads low by the scalloping loss of the window.
+    // Hann loses about 1.4 dB, the flat-top window almost nothing. Because the windows
+    // are normalized, a tone in the center of a bin reads the same with all of them.
+    float32_t centered[WindowTypeCount];
+    float32_t loss[WindowTypeCount];
+    for (int t = 0; t < WindowTypeCount; t++){
+        SetPSDWindow((WindowType)t);
+        EXPECT_EQ(GetPSDWindow(), (WindowType)t);
+        centered[t] = PSDPeak_dB(64.0);
+        loss[t] = centered[t] - PSDPeak_dB(64.5);
+    }
+    SetPSDWindow(WindowHann);
+    ResetPSD();
+    EXPECT_NEAR(loss[WindowHann], 1.42, 0.05);
+    EXPECT_LT(loss[WindowBlackmanHarris], loss[WindowHann]);
+    EXPECT_LT(fabsf(loss[WindowFlatTop]), 0.05);
+    EXPECT_NEAR(centered[WindowBlackmanHarris], centered[WindowHann], 0.05);
+    EXPECT_NEAR(centered[WindowFlatTop], centered[WindowHann], 0.05);
+}
+
+/**
+ * The original CalcPSD512(), which evaluates the Hann window with cos() for every
+ * bin and converts the spectrum with scalar loops. Kept here as the reference for
+ * the window table and block processing version.
+ */
+void CalcPSD512_cos(float32_t *I, float32_t *Q){
+    extern float32_t buffer_spec_FFT[];
+    extern float32_t FFT_spec[];
+    extern float32_t FFT_spec_old[];
+    for (size_t i = 0; i < SPECTRUM_RES; i++) { 
+        buffer_spec_FFT[i * 2] =      I[i] * (0.5 - 0.5 * cos(TWO_PI * i / SPECTRUM_RES)); 
+        buffer_spec_FFT[i * 2 + 1] =  Q[i] * (0.5 - 0.5 * cos(TWO_PI * i / SPECTRUM_RES));
+    }
+    FFT512Forward(buffer_spec_FFT);
+    for (size_t i = 0; i < SPECTRUM_RES/2; i++) {
+        FFT_spec[i + SPECTRUM_RES/2] = (buffer_spec_FFT[i * 2] * buffer_spec_FFT[i * 2] + buffer_spec_FFT[i * 2 + 1] * buffer_spec_FFT[i * 2 + 1]);
+        FFT_spec[i]                  = (buffer_spec_FFT[(i + SPECTRUM_RES/2) * 2] * buffer_spec_FFT[(i + SPECTRUM_RES/2)  * 2] + buffer_spec_FFT[(i + SPECTRUM_RES/2)  * 2 + 1] * buffer_spec_FFT[(i + SPECTRUM_RES/2)  * 2 + 1]);
+    }
+    float32_t LPFcoeff = 0.7;
+    for (size_t x = 0; x < SPECTRUM_RES; x++) {
+        if (isnan(FFT_spec_old[x])){
+            FFT_spec_old[x] = -3.0;
+        }
+        FFT_spec[x] = LPFcoeff * FFT_spec[x] + (1-LPFcoeff) * FFT_spec_old[x];
+        FFT_spec_old[x] = FFT_spec[x];
+    }
+    for (size_t i = 0; i < SPECTRUM_RES; i++) {
+        psdnew[i] = log10f_fast(FFT_spec[i]);
+    }
+    psdupdated = true;
+}
+
+TEST(SignalProcessing, PSDProcessingTime){
+    float I[512];
+    float Q[512];
+    float32_t reference[512];
+    uint32_t Nruns = 200;
+    CreateIQTone(I, Q, 512, 192000, 10000.0);
+    SetPSDWindow(WindowHann);
+
+    // The window table version gives the same spectrum as the original. Far below
+    // the peak the bins are rounding noise, so compare linear power relative to the peak
+    ResetPSD();
+    CalcPSD512_cos(I, Q);
+    memcpy(reference, psdnew, sizeof(reference));
+    float32_t peak = -1e10;
+    for (size_t i = 0; i < 512; i++) peak = fmaxf(peak, reference[i]);
+    ResetPSD();
+    CalcPSD512(I, Q);
+    for (size_t i = 0; i < 512; i++){
+        EXPECT_NEAR(powf(10, psdnew[i] - peak), powf(10, reference[i] - peak), 1e-5);
+    }
+
+    FILE *file = fopen("PSDTime.txt", "w");
+    struct timeval tv;
+    gettimeofday(&tv,NULL);
+    unsigned long before_us = 1000000 * tv.tv_sec + tv.tv_usec;
+    for (size_t i = 0; i < Nruns; i++){
+        CalcPSD512_cos(I, Q);
+    }
+    gettimeofday(&tv,NULL);
+    unsigned long after_us = 1000000 * tv.tv_sec + tv.tv_usec;
+    unsigned long cos_us = after_us - before_us;
+    fprintf(file, "CalcPSD512 with cos() window: %ld us per %u calls\n", cos_us, Nruns);
+
+    gettimeofday(&tv,NULL);
+    before_us = 1000000 * tv.tv_sec + tv.tv_usec;
+    for (size_t i = 0; i < Nruns; i++){
+        CalcPSD512(I, Q);
+    }
+    gettimeofday(&tv,NULL);
+    after_us = 1000000 * tv.tv_sec + tv.tv_usec;
+    unsigned long table_us = after_us - before_us;
+    fprintf(file, "CalcPSD512 with window table: %ld us per %u calls\n", table_us, Nruns);
+    if (table_us > 0)
+        fprintf(file, "Speedup: %.1fx\n", (float)cos_us/(float)table_us);
+    fclose(file);
+    ResetPSD();
+}
+
 // Is the frequency translation function working?
 TEST(SignalProcessing, FsOver4SampleSwappingCorrect){
     float Re[]  = {+1,+2,+3,+4,+5,+6,+7,+8};
@@ -602,6 +793,398 @@ TEST(SignalProcessing, ZoomFFTCorrectWhenZoomIs16){
     EXPECT_NEAR(psdnew[bin2],4.0595,0.01);
 }
 
+TEST(SignalProcessing, SpectrumFFTSizeSelection){
+    EXPECT_EQ(GetSpectrumFFTSize(), (uint32_t)SPECTRUM_RES);
+    EXPECT_EQ(SetSpectrumFFTSize(768), EFAIL);
+    EXPECT_EQ(SetSpectrumFFTSize(4096), EFAIL);
+    EXPECT_EQ(GetSpectrumFFTSize(), (uint32_t)SPECTRUM_RES);
+    EXPECT_EQ(SetSpectrumFFTSize(1024), ESUCCESS);
+    EXPECT_EQ(GetSpectrumFFTSize(), (uint32_t)1024);
+    EXPECT_EQ(SetSpectrumFFTSize(2048), ESUCCESS);
+    EXPECT_EQ(GetSpectrumFFTSize(), (uint32_t)2048);
+    EXPECT_EQ(SetSpectrumFFTSize(512), ESUCCESS);
+    EXPECT_EQ(SetSpectrumAveraging(SpectrumAvgCount, 1), EFAIL);
+    EXPECT_EQ(GetSpectrumAveraging(), SpectrumAvgExponential);
+    EXPECT_EQ(SetSpectrumAveraging(SpectrumAvgPeakHold, 10), ESUCCESS);
+    EXPECT_EQ(GetSpectrumAveraging(), SpectrumAvgPeakHold);
+    EXPECT_EQ(SetSpectrumAveraging(SpectrumAvgExponential, 0), ESUCCESS);
+}
+
+/**
+ * Run ZoomFFTExe at zoom 1 on one block of a tone (plus an optional second tone)
+ * with the given FFT size and no averaging. Leaves the result in psdnew.
+ */
+void LargeFFTSpectrum(uint32_t fftSize, float tone_Hz, float tone2_Hz){
+    uint32_t sampleRate_Hz = 192000;
+    float I[READ_BUFFER_SIZE];
+    float Q[READ_BUFFER_SIZE];
+    CreateIQTone(I, Q, READ_BUFFER_SIZE, sampleRate_Hz, tone_Hz);
+    if (tone2_Hz != 0) add_second_tone(I, Q, tone2_Hz, sampleRate_Hz, READ_BUFFER_SIZE);
+    DataBlock data;
+    data.I = I;
+    data.Q = Q;
+    data.N = READ_BUFFER_SIZE;
+    data.sampleRate_Hz = sampleRate_Hz;
+
+    ReceiveFilterConfig receiveFilters;
+    InitializeFilters(SPECTRUM_ZOOM_1, &receiveFilters);
+    ZoomFFTPrep(SPECTRUM_ZOOM_1, &receiveFilters);
+    SetSpectrumFFTSize(fftSize);
+    SetSpectrumAveraging(SpectrumAvgLinear, 1);
+    ResetPSD();
+    psdupdated = false;
+    EXPECT_EQ(ZoomFFTExe(&data, SPECTRUM_ZOOM_1, &receiveFilters), true);
+    EXPECT_EQ(psdupdated, true);
+}
+
+TEST(SignalProcessing, SpectrumLargeFFTToneLevel){
+    // A tone reads the same level in the same display bin whatever the FFT size,
+    // = log10((0.5*0.5*512)^2) with no averaging
+    float tone_Hz = -20*192000.0/512;
+    int32_t bin = frequency_to_bin(tone_Hz, 512, 192000);
+    uint32_t sizes[3] = {512, 1024, 2048};
+    for (size_t s = 0; s < 3; s++){
+        LargeFFTSpectrum(sizes[s], tone_Hz, 0);
+        EXPECT_NEAR(psdnew[bin], 4.2144, 0.01);
+        // DC stays in the middle of the display
+        LargeFFTSpectrum(sizes[s], 0, 0);
+        EXPECT_NEAR(psdnew[SPECTRUM_RES/2], 4.2144, 0.01);
+    }
+    SetSpectrumFFTSize(SPECTRUM_RES);
+    SetSpectrumAveraging(SpectrumAvgExponential, 0);
+    ResetPSD();
+}
+
+TEST(SignalProcessing, SpectrumLargeFFTResolution){
+    // Two tones two display bins apart merge in the 512 point spectrum but are
+    // clearly separated in the max-pooled 2048 point spectrum
+    float binWidth = 192000.0/512;
+    float tone_Hz = 100*binWidth;
+    int32_t bin = frequency_to_bin(tone_Hz, 512, 192000);
+    float32_t dip_dB[2];
+    uint32_t sizes[2] = {512, 2048};
+    for (size_t s = 0; s < 2; s++){
+        LargeFFTSpectrum(sizes[s], tone_Hz, tone_Hz + 2*binWidth);
+        EXPECT_NEAR(psdnew[bin], psdnew[bin+2], 0.05);
+        dip_dB[s] = 10*(psdnew[bin] - psdnew[bin+1]);
+    }
+    EXPECT_LT(dip_dB[0], 10.0);
+    EXPECT_GT(dip_dB[1], 30.0);
+    SetSpectrumFFTSize(SPECTRUM_RES);
+    SetSpectrumAveraging(SpectrumAvgExponential, 0);
+    ResetPSD();
+}
+
+TEST(SignalProcessing, SpectrumLargeFFTPoolsCentred){
+    // In the 1024 point FFT a tone halfway between two display bins is as far
+    // from one as from the other, so both show it at full level
+    float binWidth = 192000.0/512;
+    int32_t bin = frequency_to_bin(-20*binWidth, 512, 192000);
+    LargeFFTSpectrum(1024, -20*binWidth + binWidth/2, 0);
+    EXPECT_NEAR(psdnew[bin], 4.2144, 0.01);
+    EXPECT_NEAR(psdnew[bin+1], 4.2144, 0.01);
+    LargeFFTSpectrum(1024, -20*binWidth - binWidth/2, 0);
+    EXPECT_NEAR(psdnew[bin-1], 4.2144, 0.01);
+    EXPECT_NEAR(psdnew[bin], 4.2144, 0.01);
+    SetSpectrumFFTSize(SPECTRUM_RES);
+    SetSpectrumAveraging(SpectrumAvgExponential, 0);
+    ResetPSD();
+}
+
+TEST(SignalProcessing, SpectrumLargeFFTPoolsWrapAround){
+    // A tone in the highest bin of the 2048 point FFT, just below +fs/2, belongs
+    // to the group of display bin 0 at -fs/2
+    LargeFFTSpectrum(2048, 96000.0 - 192000.0/2048, 0);
+    EXPECT_NEAR(psdnew[0], 4.2144, 0.01);
+    SetSpectrumFFTSize(SPECTRUM_RES);
+    SetSpectrumAveraging(SpectrumAvgExponential, 0);
+    ResetPSD();
+}
+
+TEST(SignalProcessing, SpectrumWelchFrames){
+    // Frames overlap by 50%, so after the ring buffer first fills there is a new
+    // frame every N/2 (decimated) samples and no samples are discarded
+    uint32_t sampleRate_Hz = 192000;
+    float I[READ_BUFFER_SIZE];
+    float Q[READ_BUFFER_SIZE];
+    CreateIQTone(I, Q, READ_BUFFER_SIZE, sampleRate_Hz, 1000);
+    DataBlock data;
+    data.I = I;
+    data.Q = Q;
+    data.sampleRate_Hz = sampleRate_Hz;
+    ReceiveFilterConfig receiveFilters;
+
+    struct { uint32_t zoom; uint32_t N; uint32_t frames[4]; } cases[] = {
+        {SPECTRUM_ZOOM_1, 1024, {3, 7, 11, 15}},
+        {SPECTRUM_ZOOM_1, 2048, {1, 3, 5, 7}},
+        {SPECTRUM_ZOOM_2, 2048, {0, 1, 2, 3}},
+        {SPECTRUM_ZOOM_8, 2048, {0, 0, 0, 0}},
+    };
+    for (size_t c = 0; c < 4; c++){
+        InitializeFilters(cases[c].zoom, &receiveFilters);
+        ZoomFFTPrep(cases[c].zoom, &receiveFilters);
+        SetSpectrumFFTSize(cases[c].N);
+        ResetPSD();
+        for (size_t k = 0; k < 4; k++){
+            data.N = READ_BUFFER_SIZE;
+            bool updated = ZoomFFTExe(&data, cases[c].zoom, &receiveFilters);
+            EXPECT_EQ(GetSpectrumFrameCount(), cases[c].frames[k]);
+            EXPECT_EQ(updated, cases[c].frames[k] > (k == 0 ? 0 : cases[c].frames[k-1]));
+        }
+    }
+    // At zoom 8 the ring buffer fills after 8 blocks, then a frame every 4 blocks
+    for (size_t k = 4; k < 12; k++){
+        ZoomFFTExe(&data, SPECTRUM_ZOOM_8, &receiveFilters);
+    }
+    EXPECT_EQ(GetSpectrumFrameCount(), (uint32_t)2);
+    SetSpectrumFFTSize(SPECTRUM_RES);
+    ResetPSD();
+}
+
+/**
+ * Fill I and Q with uniformly distributed noise from a repeatable generator
+ */
+void CreateIQNoise(float *I, float *Q, uint32_t Nsamples, uint32_t *seed){
+    for (size_t i = 0; i < Nsamples; i++){
+        *seed = *seed * 1664525 + 1013904223;
+        I[i] = (float)(*seed >> 8) / 16777216.0 - 0.5;
+        *seed = *seed * 1664525 + 1013904223;
+        Q[i] = (float)(*seed >> 8) / 16777216.0 - 0.5;
+    }
+}
+
+/**
+ * Standard deviation of psdnew in dB
+ */
+float32_t PSDSpread_dB(void){
+    float32_t mean = 0;
+    for (size_t i = 0; i < SPECTRUM_RES; i++) mean += psdnew[i];
+    mean /= SPECTRUM_RES;
+    float32_t var = 0;
+    for (size_t i = 0; i < SPECTRUM_RES; i++) var += (psdnew[i] - mean)*(psdnew[i] - mean);
+    return 10*sqrtf(var / SPECTRUM_RES);
+}
+
+TEST(SignalProcessing, SpectrumLinearAveraging){
+    // The mean of 16 noise spectra varies about a quarter as much as one spectrum,
+    // and psdnew is only updated once the 16 frames have been averaged
+    float I[512];
+    float Q[512];
+    uint32_t seed = 1;
+    float32_t spread[2];
+    uint32_t nFrames[2] = {1, 16};
+    for (size_t n = 0; n < 2; n++){
+        SetSpectrumAveraging(SpectrumAvgLinear, nFrames[n]);
+        ResetPSD();
+        for (size_t k = 0; k < 16; k++){
+            psdupdated = false;
+            CreateIQNoise(I, Q, 512, &seed);
+            CalcPSD512(I, Q);
+            EXPECT_EQ(psdupdated, ((k + 1) % nFrames[n]) == 0);
+        }
+        spread[n] = PSDSpread_dB();
+    }
+    EXPECT_LT(spread[1], 0.35*spread[0]);
+    SetSpectrumAveraging(SpectrumAvgExponential, 0);
+    ResetPSD();
+}
+
+TEST(SignalProcessing, SpectrumLinearAveragingSkipsCalibration){
+    // The calibration filter configs get a fresh psdnew after every frame even
+    // when the panadapter is averaging frames linearly
+    float I[512];
+    float Q[512];
+    uint32_t seed = 1;
+    DataBlock data;
+    data.I = I;
+    data.Q = Q;
+    data.N = 512;
+    data.sampleRate_Hz = 192000;
+    ReceiveFilterConfig calFilters;
+    InitializeFilters(SPECTRUM_ZOOM_1, &calFilters);
+    calFilters.zoom_track_every_frame = true;
+    SetSpectrumAveraging(SpectrumAvgLinear, 4);
+    ResetPSD();
+    for (size_t k = 0; k < 8; k++){
+        psdupdated = false;
+        CreateIQNoise(I, Q, 512, &seed);
+        EXPECT_EQ(ZoomFFTExe(&data, SPECTRUM_ZOOM_1, &calFilters), true);
+        EXPECT_EQ(psdupdated, true);
+    }
+    // while the panadapter config still waits for four frames
+    ReceiveFilterConfig displayFilters;
+    InitializeFilters(SPECTRUM_ZOOM_1, &displayFilters);
+    for (size_t k = 0; k < 4; k++){
+        CreateIQNoise(I, Q, 512, &seed);
+        EXPECT_EQ(ZoomFFTExe(&data, SPECTRUM_ZOOM_1, &displayFilters), k == 3);
+    }
+    SetSpectrumAveraging(SpectrumAvgExponential, 0);
+    ResetPSD();
+}
+
+TEST(SignalProcessing, SpectrumPeakHold){
+    // A tone that moves leaves its peak behind for the hold time
+    float I[512];
+    float Q[512];
+    float binWidth = 192000.0/512;
+    int32_t binA = frequency_to_bin(-50*binWidth, 512, 192000);
+    int32_t binB = frequency_to_bin(50*binWidth, 512, 192000);
+    uint32_t hold[2] = {0, 4};
+    for (size_t h = 0; h < 2; h++){
+        SetSpectrumAveraging(SpectrumAvgPeakHold, hold[h]);
+        ResetPSD();
+        CreateIQTone(I, Q, 512, 192000, -50*binWidth);
+        CalcPSD512(I, Q);
+        EXPECT_NEAR(psdnew[binA], 4.2144, 0.01);
+        CreateIQTone(I, Q, 512, 192000, 50*binWidth);
+        for (size_t k = 1; k < 8; k++){
+            CalcPSD512(I, Q);
+            EXPECT_NEAR(psdnew[binB], 4.2144, 0.01);
+            bool held = (hold[h] == 0) || (k < hold[h]);
+            if (held){
+                EXPECT_NEAR(psdnew[binA], 4.2144, 0.01);
+            } else {
+                EXPECT_LT(psdnew[binA], 0.0);
+            }
+        }
+    }
+    // The exponential average lets the old peak decay straight away
+    SetSpectrumAveraging(SpectrumAvgExponential, 0);
+    ResetPSD();
+    CreateIQTone(I, Q, 512, 192000, -50*binWidth);
+    CalcPSD512(I, Q);
+    CreateIQTone(I, Q, 512, 192000, 50*binWidth);
+    CalcPSD512(I, Q);
+    EXPECT_NEAR(psdnew[binA], 4.0595 + log10f(0.3), 0.01);
+    ResetPSD();
+}
+
+TEST(SignalProcessing, PSDFrameHandoff){
+    float32_t psd[SPECTRUM_RES];
+    // Drain anything published by earlier tests
+    const PSDFrame *frame = AcquirePSDFrame();
+    EXPECT_FALSE(PSDFrameAvailable());
+    EXPECT_EQ(AcquirePSDFrame(), frame);
+
+    for (size_t i = 0; i < SPECTRUM_RES; i++) psd[i] = 1.0;
+    PublishPSDFrame(psd);
+    EXPECT_TRUE(PSDFrameAvailable());
+    frame = AcquirePSDFrame();
+    EXPECT_FALSE(PSDFrameAvailable());
+    uint32_t seq = frame->sequence;
+    EXPECT_EQ(frame->bins[0], 1.0);
+
+    // The DSP can publish repeatedly while the display holds its frame; the
+    // frame being drawn does not change and the display gets the newest one next
+    for (size_t k = 2; k < 6; k++){
+        for (size_t i = 0; i < SPECTRUM_RES; i++) psd[i] = (float32_t)k;
+        PublishPSDFrame(psd);
+        EXPECT_EQ(frame->bins[SPECTRUM_RES-1], 1.0);
+        EXPECT_EQ(frame->sequence, seq);
+    }
+    const PSDFrame *next = AcquirePSDFrame();
+    EXPECT_NE(next, frame);
+    EXPECT_EQ(next->bins[0], 5.0);
+    EXPECT_EQ(next->sequence, seq + 4);
+
+    // Every PSD that updates psdnew is published
+    float I[512];
+    float Q[512];
+    CreateIQTone(I, Q, 512, 192000, 1000);
+    ResetPSD();
+    CalcPSD512(I, Q);
+    frame = AcquirePSDFrame();
+    EXPECT_EQ(frame->sequence, seq + 5);
+    EXPECT_EQ(memcmp(frame->bins, psdnew, sizeof(frame->bins)), 0);
+
+    // including the 256-point PSD
+    psdupdated = false;
+    CalcPSD256(I, Q);
+    EXPECT_TRUE(psdupdated);
+    frame = AcquirePSDFrame();
+    EXPECT_EQ(frame->sequence, seq + 6);
+    EXPECT_EQ(memcmp(frame->bins, psdnew, sizeof(frame->bins)), 0);
+    ResetPSD();
+}
+
+TEST(SignalProcessing, PSDFrameSkipsCalibration){
+    // Calibration spectra update psdnew but leave the home screen's frame alone
+    float I[512];
+    float Q[512];
+    uint32_t seed = 1;
+    DataBlock data;
+    data.I = I;
+    data.Q = Q;
+    data.N = 512;
+    data.sampleRate_Hz = 192000;
+    ReceiveFilterConfig calFilters;
+    InitializeFilters(SPECTRUM_ZOOM_1, &calFilters);
+    calFilters.zoom_track_every_frame = true;
+    AcquirePSDFrame();
+    ResetPSD();
+    for (size_t k = 0; k < 4; k++){
+        psdupdated = false;
+        CreateIQNoise(I, Q, 512, &seed);
+        EXPECT_TRUE(ZoomFFTExe(&data, SPECTRUM_ZOOM_1, &calFilters));
+        EXPECT_TRUE(psdupdated);
+        EXPECT_FALSE(PSDFrameAvailable());
+    }
+    // also through the Welch path used with the larger FFT sizes
+    SetSpectrumFFTSize(1024);
+    psdupdated = false;
+    for (size_t k = 0; k < 4; k++){
+        CreateIQNoise(I, Q, 512, &seed);
+        ZoomFFTExe(&data, SPECTRUM_ZOOM_1, &calFilters);
+    }
+    EXPECT_TRUE(psdupdated);
+    EXPECT_FALSE(PSDFrameAvailable());
+    SetSpectrumFFTSize(SPECTRUM_RES);
+
+    // while the panadapter's filter bank publishes every spectrum
+    ReceiveFilterConfig displayFilters;
+    InitializeFilters(SPECTRUM_ZOOM_1, &displayFilters);
+    CreateIQNoise(I, Q, 512, &seed);
+    EXPECT_TRUE(ZoomFFTExe(&data, SPECTRUM_ZOOM_1, &displayFilters));
+    EXPECT_TRUE(PSDFrameAvailable());
+    AcquirePSDFrame();
+    ResetPSD();
+}
+
+TEST(SignalProcessing, PSDFrameHandoffThreaded){
+    // The DSP publishes from another thread as fast as it can. Every frame the
+    // display acquires must be complete (all bins from the same frame) and
+    // frames must arrive in order.
+    const uint32_t Nframes = 20000;
+    AcquirePSDFrame();
+    std::atomic<bool> done(false);
+    std::thread producer([&]() {
+        float32_t psd[SPECTRUM_RES];
+        for (uint32_t k = 1; k <= Nframes; k++){
+            for (size_t i = 0; i < SPECTRUM_RES; i++) psd[i] = (float32_t)k;
+            PublishPSDFrame(psd);
+        }
+        done = true;
+    });
+    uint32_t last = 0;
+    uint32_t received = 0;
+    uint32_t torn = 0;
+    while (!done || PSDFrameAvailable()){
+        if (!PSDFrameAvailable()) continue;
+        const PSDFrame *frame = AcquirePSDFrame();
+        float32_t first = frame->bins[0];
+        for (size_t i = 1; i < SPECTRUM_RES; i++){
+            if (frame->bins[i] != first) torn++;
+        }
+        EXPECT_GT(frame->sequence, last);
+        last = frame->sequence;
+        received++;
+    }
+    producer.join();
+    EXPECT_EQ(torn, (uint32_t)0);
+    EXPECT_GT(received, (uint32_t)0);
+    EXPECT_EQ(AcquirePSDFrame()->bins[0], (float32_t)Nframes);
+}
+
 TEST(SignalProcessing, FrequencyTranslate){
     uint32_t Nsamples = 2048;
     uint32_t sampleRate_Hz = 192000;
@@ -724,6 +1307,134 @@ TEST(SignalProcessing, FineTunePhaseDiscontinuity){
     EXPECT_LT(psdnew[bin-50],4.0595-8.0); // expect noise to be 80 dB below peak
 }
 
+/**
+ * The original FreqShiftF() implementation, which evaluates cosf/sinf for every
+ * sample. Kept here as the reference for the phase accumulator version.
+ */
+void FreqShiftF_cosf(DataBlock *data, float32_t freqShift_Hz, uint32_t *index){
+    float32_t NCO_INC = TWO_PI * freqShift_Hz / (float32_t)data->sampleRate_Hz;
+    float32_t OSC_COS, OSC_SIN, ip, qp;
+    for (size_t i = 0; i < data->N; i++) {
+        float32_t itheta = NCO_INC*(float32_t)(*index);
+        OSC_COS = cosf (itheta);
+        OSC_SIN = sinf (itheta);
+        ip = data->I[i];
+        qp = data->Q[i];
+        data->I[i] = (ip * OSC_COS - qp * OSC_SIN);
+        data->Q[i] = (qp * OSC_COS + ip * OSC_SIN);
+        (*index)++;
+        if (*index == data->sampleRate_Hz) *index = 0;
+    }
+}
+
+/**
+ * Power of the difference between the oscillator samples o and an ideal complex
+ * exponential at the increment inc, relative to the carrier, in dBc. The phase of
+ * the ideal exponential is fitted to o so only the oscillator impurity is measured.
+ */
+double OscillatorErrorPower_dBc(float32_t *oI, float32_t *oQ, uint32_t N, double inc){
+    double fitI = 0, fitQ = 0;
+    for (size_t n = 0; n < N; n++){
+        // o[n] * conj(exp(j*inc*n))
+        fitI += oI[n]*cos(inc*n) + oQ[n]*sin(inc*n);
+        fitQ += oQ[n]*cos(inc*n) - oI[n]*sin(inc*n);
+    }
+    double phi = atan2(fitQ, fitI);
+    double err = 0;
+    for (size_t n = 0; n < N; n++){
+        double eI = oI[n] - cos(phi + inc*n);
+        double eQ = oQ[n] - sin(phi + inc*n);
+        err += eI*eI + eQ*eQ;
+    }
+    return 10*log10(err/N);
+}
+
+TEST(SignalProcessing, FineTuneNCOPhaseContinuity){
+    // Shifting a DC input returns the oscillator itself. Every sample must be the
+    // previous one rotated by the phase increment, including across the
+    // boundaries between blocks.
+    uint32_t Nblocks = 8;
+    uint32_t Nsamples = 2048;
+    uint32_t sampleRate_Hz = 192000;
+    float32_t offset_Hz = 1234.0;
+    float I[Nsamples*Nblocks];
+    float Q[Nsamples*Nblocks];
+    for (size_t i = 0; i < Nsamples*Nblocks; i++){
+        I[i] = 1.0;
+        Q[i] = 0.0;
+    }
+
+    DataBlock data;
+    data.N = Nsamples;
+    data.sampleRate_Hz = sampleRate_Hz;
+    for (size_t k = 0; k < Nblocks; k++){
+        data.I = &I[Nsamples*k];
+        data.Q = &Q[Nsamples*k];
+        FreqShiftF(&data, offset_Hz);
+    }
+
+    double inc = TWO_PI * (double)offset_Hz / (double)sampleRate_Hz;
+    double maxStepError = 0;
+    double maxAmpError = 0;
+    for (size_t n = 0; n < Nsamples*Nblocks - 1; n++){
+        double pI = I[n]*cos(inc) - Q[n]*sin(inc);
+        double pQ = Q[n]*cos(inc) + I[n]*sin(inc);
+        double e = sqrt((I[n+1]-pI)*(I[n+1]-pI) + (Q[n+1]-pQ)*(Q[n+1]-pQ));
+        if (e > maxStepError) maxStepError = e;
+        double a = fabs(sqrt(I[n]*I[n] + Q[n]*Q[n]) - 1.0);
+        if (a > maxAmpError) maxAmpError = a;
+    }
+    EXPECT_LT(maxStepError, 1e-5);
+    EXPECT_LT(maxAmpError, 1e-5);
+}
+
+TEST(SignalProcessing, FineTuneNCOSpurLevel){
+    // Compare the oscillator impurity of FreqShiftF() against the per-sample
+    // cosf/sinf implementation. The cosf/sinf version gets worse as its sample
+    // index grows because NCO_INC*index loses precision, so it is measured at the
+    // start and at the end of its one second index range.
+    uint32_t Nsamples = 2048;
+    uint32_t sampleRate_Hz = 192000;
+    float32_t offset_Hz = 2200.0;
+    double inc = TWO_PI * (double)offset_Hz / (double)sampleRate_Hz;
+    float I[Nsamples];
+    float Q[Nsamples];
+    DataBlock data;
+    data.I = I;
+    data.Q = Q;
+    data.N = Nsamples;
+    data.sampleRate_Hz = sampleRate_Hz;
+
+    double new_dBc = -1000;
+    for (size_t k = 0; k < 100; k++){
+        // Covers a full wrap of the sample index
+        for (size_t i = 0; i < Nsamples; i++){ I[i] = 1.0; Q[i] = 0.0; }
+        FreqShiftF(&data, offset_Hz);
+        double e = OscillatorErrorPower_dBc(I, Q, Nsamples, inc);
+        if (e > new_dBc) new_dBc = e;
+    }
+
+    uint32_t index = 0;
+    for (size_t i = 0; i < Nsamples; i++){ I[i] = 1.0; Q[i] = 0.0; }
+    FreqShiftF_cosf(&data, offset_Hz, &index);
+    double refStart_dBc = OscillatorErrorPower_dBc(I, Q, Nsamples, inc);
+
+    index = sampleRate_Hz - Nsamples;
+    for (size_t i = 0; i < Nsamples; i++){ I[i] = 1.0; Q[i] = 0.0; }
+    FreqShiftF_cosf(&data, offset_Hz, &index);
+    double refEnd_dBc = OscillatorErrorPower_dBc(I, Q, Nsamples, inc);
+
+    FILE *file = fopen("FineTuneNCOSpurLevel.txt", "w");
+    fprintf(file, "FreqShiftF worst block:        %6.1f dBc\n", new_dBc);
+    fprintf(file, "cosf/sinf start of index range: %6.1f dBc\n", refStart_dBc);
+    fprintf(file, "cosf/sinf end of index range:   %6.1f dBc\n", refEnd_dBc);
+    fclose(file);
+
+    EXPECT_LT(new_dBc, -110.0);
+    EXPECT_LT(new_dBc, refStart_dBc + 3.0);
+    EXPECT_LT(new_dBc, refEnd_dBc);
+}
+
 TEST(SignalProcessing, FineTuneProcessingTime){
     // Make a tone at frequency 1
     uint32_t Nsamples = 2048;
@@ -746,12 +1457,27 @@ TEST(SignalProcessing, FineTuneProcessingTime){
     struct timeval tv;
     gettimeofday(&tv,NULL);
     unsigned long before_us = 1000000 * tv.tv_sec + tv.tv_usec;
-    for (size_t i =0; i<1; i++){
+    for (size_t i =0; i<100; i++){
         FreqShiftF(&data,offset_Hz);
     }
     gettimeofday(&tv,NULL);
     unsigned long after_us = 1000000 * tv.tv_sec + tv.tv_usec;
-    fprintf(file, "FreqShiftF: %ld us\n", after_us-before_us);
+    unsigned long nco_us = after_us-before_us;
+    fprintf(file, "FreqShiftF: %ld us per 100 blocks\n", nco_us);
+
+    CreateIQTone(I, Q, Nsamples, sampleRate_Hz, tone_Hz);
+    uint32_t index = 0;
+    gettimeofday(&tv,NULL);
+    before_us = 1000000 * tv.tv_sec + tv.tv_usec;
+    for (size_t i =0; i<100; i++){
+        FreqShiftF_cosf(&data,offset_Hz,&index);
+    }
+    gettimeofday(&tv,NULL);
+    after_us = 1000000 * tv.tv_sec + tv.tv_usec;
+    unsigned long cosf_us = after_us-before_us;
+    fprintf(file, "FreqShiftF with cosf/sinf per sample: %ld us per 100 blocks\n", cosf_us);
+    if (nco_us > 0)
+        fprintf(file, "Speedup: %.1fx\n", (float)cosf_us/(float)nco_us);
 
     CreateIQTone(I, Q, Nsamples, sampleRate_Hz, tone_Hz);
     gettimeofday(&tv,NULL);
@@ -881,6 +1607,85 @@ TEST(SignalProcessing, DecimateBy8){
 }
 
 
+/**
+ * Run Nblocks blocks of I/Q through FreqShiftFs4, FreqShiftF and DecimateBy8 (fused
+ * = false) or through the fused front end and DecimateBy2 (fused = true), the way
+ * ReceiveProcessing does. Returns the decimated samples of every block.
+ */
+void FrontEndDecimate(float *I, float *Q, uint32_t Nblocks, float32_t shift_Hz, bool zoomed,
+                      bool fused, float *outI, float *outQ){
+    ReceiveFilterConfig filters;
+    InitializeFilters(SPECTRUM_ZOOM_1, &filters);
+    ResetFreqShiftF();
+    DataBlock data;
+    for (size_t k = 0; k < Nblocks; k++){
+        data.I = &I[2048*k];
+        data.Q = &Q[2048*k];
+        data.N = 2048;
+        data.sampleRate_Hz = 192000;
+        if (fused){
+            if (zoomed) FreqShiftFs4(&data);
+            EXPECT_EQ(FreqShiftAndDecimateBy4(&data, !zoomed, shift_Hz, &filters), ESUCCESS);
+            EXPECT_EQ(DecimateBy2(&data, &filters), ESUCCESS);
+        } else {
+            FreqShiftFs4(&data);
+            FreqShiftF(&data, shift_Hz);
+            EXPECT_EQ(DecimateBy8(&data, &filters), ESUCCESS);
+        }
+        EXPECT_EQ(data.N, (uint32_t)256);
+        EXPECT_EQ(data.sampleRate_Hz, (uint32_t)24000);
+        for (size_t i = 0; i < 256; i++){
+            outI[256*k + i] = data.I[i];
+            outQ[256*k + i] = data.Q[i];
+        }
+    }
+}
+
+TEST(SignalProcessing, FreqShiftAndDecimateBy4){
+    // The fused front end must reproduce the SaveData(&data, 3) checkpoint of the
+    // separate FreqShiftFs4, FreqShiftF and DecimateBy8 steps, with and without
+    // the Fs/4 shift (spectrum zoom 1 and zoom > 1).
+    uint32_t Nblocks = 4;
+    uint32_t Nsamples = 2048*Nblocks;
+    uint32_t sampleRate_Hz = 192000;
+    float32_t shift_Hz = 1234.0;
+    float input_I[Nsamples], input_Q[Nsamples];
+    float I[Nsamples], Q[Nsamples];
+    float tone_I[Nsamples], tone_Q[Nsamples];
+    float refI[256*Nblocks], refQ[256*Nblocks];
+    float fusedI[256*Nblocks], fusedQ[256*Nblocks];
+
+    // One tone that ends up in the passband and one that is removed by the decimation filter
+    CreateIQTone(input_I, input_Q, Nsamples, sampleRate_Hz, -48000.0 - 2500.0);
+    CreateIQTone(tone_I, tone_Q, Nsamples, sampleRate_Hz, -48000.0 + 30000.0);
+    for (size_t i = 0; i < Nsamples; i++){
+        input_I[i] += tone_I[i];
+        input_Q[i] += tone_Q[i];
+    }
+
+    for (int zoomed = 0; zoomed < 2; zoomed++){
+        memcpy(I, input_I, sizeof(I));
+        memcpy(Q, input_Q, sizeof(Q));
+        FrontEndDecimate(I, Q, Nblocks, shift_Hz, zoomed, false, refI, refQ);
+        memcpy(I, input_I, sizeof(I));
+        memcpy(Q, input_Q, sizeof(Q));
+        FrontEndDecimate(I, Q, Nblocks, shift_Hz, zoomed, true, fusedI, fusedQ);
+        if (!zoomed)
+            WriteIQFile(fusedI, fusedQ, "FreqShiftAndDecimateBy4_IQ.txt", 256*Nblocks);
+
+        float32_t maxdiff = 0;
+        float32_t maxamp = 0;
+        for (size_t i = 0; i < 256*Nblocks; i++){
+            maxdiff = fmaxf(maxdiff, fabsf(fusedI[i] - refI[i]));
+            maxdiff = fmaxf(maxdiff, fabsf(fusedQ[i] - refQ[i]));
+            maxamp = fmaxf(maxamp, fabsf(refI[i]));
+        }
+        // The tone in the passband survives, so this is not a comparison of two zero arrays
+        EXPECT_GT(maxamp, 0.4);
+        EXPECT_LT(maxdiff, 1e-5);
+    }
+}
+
 TEST(SignalProcessing, InitFIRFilterMask){
     extern ReceiveFilterConfig RXfilters;
     float32_t DMAMEM FIR_filter_mask[FFT_LENGTH * 2] __attribute__((aligned(4)));
@@ -1007,9 +1812,12 @@ TEST(SignalProcessing, ConvolutionFilterChanges){
     WriteIQFile(I,Q,"ConvolutionFilterChange_original_IQ.txt",512);
 
     // Change the band limits
+    int32_t FLoCut_Hz = bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz;
+    int32_t FHiCut_Hz = bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz;
     bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = -2000;
     bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = -1000;
     UpdateFIRFilterMask(&RXfilters);
+    ServiceFIRFilterMask();
 
     DataBlock data;
     data.I = I;
@@ -1040,6 +1848,271 @@ TEST(SignalProcessing, ConvolutionFilterChanges){
     WriteFile(psdnew,"ConvolutionFilterChange_filtered_PSD.txt",512);
 
     // Analyse using analyze_filter_chain.ipynb to confirm change happened as expected
+
+    // Restore the band limits, the noise reduction tests depend on them
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = FLoCut_Hz;
+    bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = FHiCut_Hz;
+    ApplyFIRFilterMask(&RXfilters);
+}
+
+TEST(SignalProcessing, DSPArenaHoldsDecimationFilters){
+    InitializeSignalProcessing();
+    size_t rx = GetDSPArenaBankBytes(&RXfilters);
+    EXPECT_GT(rx, (size_t)0);
+    EXPECT_LE(rx, (size_t)DSP_ARENA_BANK_BYTES);
+    EXPECT_EQ(GetDSPArenaBankBytes(&RXTXfilters), rx);
+    EXPECT_EQ(GetDSPArenaBankBytes(&TXIQfilters), rx);
+    // The banks the other tests built on the stack gave their regions back
+    EXPECT_EQ(GetDSPArenaBytesUsed(), 3 * rx);
+    EXPECT_EQ(GetDSPArenaOverflowBytes(), (size_t)0);
+
+    // Initializing a bank again reuses its region
+    float32_t *state = RXfilters.DecimateRxStage1.FIR_dec_I_state;
+    InitializeFilters(ED.spectrum_zoom, &RXfilters);
+    EXPECT_EQ(RXfilters.DecimateRxStage1.FIR_dec_I_state, state);
+    EXPECT_EQ(GetDSPArenaBankBytes(&RXfilters), rx);
+    EXPECT_EQ(GetDSPArenaBytesUsed(), 3 * rx);
+}
+
+TEST(SignalProcessing, DSPArenaReinitializationDoesNotGrowHeap){
+    InitializeSignalProcessing();
+    size_t used = GetDSPArenaBytesUsed();
+    size_t heap = mallinfo2().uordblks;
+    for (int i = 0; i < 1000; i++){
+        if (i % 2){
+            // As InitializeSignalProcessing() does it
+            InitializeFilters(ED.spectrum_zoom, &RXfilters);
+            InitializeFilters(SPECTRUM_ZOOM_8, &RXTXfilters);
+            InitializeFilters(SPECTRUM_ZOOM_8, &TXIQfilters);
+        } else {
+            InitializeFilters(ED.spectrum_zoom, &RXfilters);
+        }
+    }
+    EXPECT_EQ(mallinfo2().uordblks, heap);
+    EXPECT_EQ(GetDSPArenaBytesUsed(), used);
+    EXPECT_EQ(GetDSPArenaOverflowBytes(), (size_t)0);
+}
+
+TEST(SignalProcessing, DSPArenaRegionsAreHandedBack){
+    InitializeSignalProcessing();
+    size_t used = GetDSPArenaBytesUsed();
+    for (int i = 0; i < 100; i++){
+        ReceiveFilterConfig filters;
+        InitializeFilters(SPECTRUM_ZOOM_1, &filters);
+        EXPECT_EQ(GetDSPArenaBankBytes(&filters), GetDSPArenaBankBytes(&RXfilters));
+    }
+    EXPECT_EQ(GetDSPArenaBytesUsed(), used);
+
+    // Once every region has an owner a new bank is refused, not put on the heap
+    static ReceiveFilterConfig extra[DSP_ARENA_BANKS];
+    size_t n = 0;
+    while ((n < DSP_ARENA_BANKS) && ResetDSPArenaBank(&extra[n]))
+        n++;
+    EXPECT_LT(n, (size_t)DSP_ARENA_BANKS);
+    EXPECT_EQ(GetDSPArenaBankBytes(&extra[n]), (size_t)0);
+    for (size_t i = 0; i < n; i++)
+        ReleaseDSPArenaBank(&extra[i]);
+    EXPECT_EQ(GetDSPArenaBytesUsed(), used);
+    EXPECT_EQ(GetDSPArenaOverflowBytes(), (size_t)0);
+}
+
+extern float32_t *FIR_filter_mask; // in DSP_FFT.cpp
+
+TEST(SignalProcessing, FilterMaskCacheAvoidsRedesign){
+    int32_t FLoCut_Hz = bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz;
+    int32_t FHiCut_Hz = bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz;
+    static float32_t original[FFT_LENGTH * 2];
+
+    ResetFilterMaskCache();
+    ApplyFIRFilterMask(&RXfilters);
+    EXPECT_EQ(GetFilterMaskCacheMisses(), (uint32_t)1);
+    memcpy(original, FIR_filter_mask, sizeof(original));
+
+    // Tuning leaves the passband alone, which is neither a hit nor a miss
+    for (int i = 0; i < 100; i++)
+        ApplyFIRFilterMask(&RXfilters);
+    EXPECT_EQ(GetFilterMaskCacheHits(), (uint32_t)0);
+    EXPECT_EQ(GetFilterMaskCacheMisses(), (uint32_t)1);
+
+    // A new width is designed once, then toggling between the two is a copy
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = -2000;
+    bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = -1000;
+    ApplyFIRFilterMask(&RXfilters);
+    EXPECT_EQ(GetFilterMaskCacheMisses(), (uint32_t)2);
+    for (int i = 0; i < 5; i++){
+        bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = FLoCut_Hz;
+        bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = FHiCut_Hz;
+        ApplyFIRFilterMask(&RXfilters);
+        bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = -2000;
+        bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = -1000;
+        ApplyFIRFilterMask(&RXfilters);
+    }
+    EXPECT_EQ(GetFilterMaskCacheMisses(), (uint32_t)2);
+    EXPECT_EQ(GetFilterMaskCacheHits(), (uint32_t)10);
+
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = FLoCut_Hz;
+    bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = FHiCut_Hz;
+    ApplyFIRFilterMask(&RXfilters);
+    EXPECT_EQ(memcmp(original, FIR_filter_mask, sizeof(original)), 0);
+}
+
+TEST(SignalProcessing, FilterMaskCacheEvictsLeastRecentlyUsed){
+    int32_t FLoCut_Hz = bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz;
+    int32_t FHiCut_Hz = bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz;
+
+    ResetFilterMaskCache();
+    // Fill the cache with four widths, then use the first one again
+    for (int32_t w = 1; w <= 4; w++){
+        bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = -500*w;
+        bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = -100;
+        ApplyFIRFilterMask(&RXfilters);
+    }
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = -500;
+    ApplyFIRFilterMask(&RXfilters);
+    EXPECT_EQ(GetFilterMaskCacheMisses(), (uint32_t)4);
+
+    // A fifth width replaces the second, which was used least recently
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = -2500;
+    ApplyFIRFilterMask(&RXfilters);
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = -500;
+    ApplyFIRFilterMask(&RXfilters);
+    EXPECT_EQ(GetFilterMaskCacheMisses(), (uint32_t)5);
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = -1000;
+    ApplyFIRFilterMask(&RXfilters);
+    EXPECT_EQ(GetFilterMaskCacheMisses(), (uint32_t)6);
+
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = FLoCut_Hz;
+    bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = FHiCut_Hz;
+    ApplyFIRFilterMask(&RXfilters);
+}
+
+TEST(SignalProcessing, FilterMaskChangeWaitsForIdleAndBlockBoundary){
+    int32_t FLoCut_Hz = bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz;
+    int32_t FHiCut_Hz = bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz;
+    ApplyFIRFilterMask(&RXfilters);
+    float32_t *active = FIR_filter_mask;
+
+    // The request alone changes nothing
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = -2000;
+    bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = -1000;
+    UpdateFIRFilterMask(&RXfilters);
+    EXPECT_TRUE(IsFIRFilterMaskPending());
+    EXPECT_EQ(FIR_filter_mask, active);
+
+    // Preparing the mask does not touch the one in use either
+    ServiceFIRFilterMask();
+    EXPECT_TRUE(IsFIRFilterMaskPending());
+    EXPECT_EQ(FIR_filter_mask, active);
+
+    // Changing back before the swap cancels the request
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = FLoCut_Hz;
+    bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = FHiCut_Hz;
+    UpdateFIRFilterMask(&RXfilters);
+    EXPECT_FALSE(IsFIRFilterMaskPending());
+    EXPECT_EQ(FIR_filter_mask, active);
+}
+
+TEST(SignalProcessing, FilterMaskDesignedForTheRequest){
+    // The mask is designed for the passband that was requested, even when the
+    // band settings change again before it is prepared
+    int32_t FLoCut_Hz = bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz;
+    int32_t FHiCut_Hz = bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz;
+    static float32_t expected[FFT_LENGTH * 2];
+    ResetFilterMaskCache();
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = -2000;
+    bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = -1000;
+    ApplyFIRFilterMask(&RXfilters);
+    memcpy(expected, FIR_filter_mask, sizeof(expected));
+
+    ResetFilterMaskCache();
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = FLoCut_Hz;
+    bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = FHiCut_Hz;
+    ApplyFIRFilterMask(&RXfilters);
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = -2000;
+    bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = -1000;
+    UpdateFIRFilterMask(&RXfilters);
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = -3000;
+    ServiceFIRFilterMask();
+    // Asking for the requested passband again swaps in the prepared mask
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = -2000;
+    ApplyFIRFilterMask(&RXfilters);
+    EXPECT_EQ(memcmp(expected, FIR_filter_mask, sizeof(expected)), 0);
+    EXPECT_EQ(GetFilterMaskCacheMisses(), (uint32_t)2);
+
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = FLoCut_Hz;
+    bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = FHiCut_Hz;
+    ApplyFIRFilterMask(&RXfilters);
+}
+
+TEST(SignalProcessing, FilterMaskChangeIsCrossfaded){
+    int32_t FLoCut_Hz = bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz;
+    int32_t FHiCut_Hz = bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz;
+    const uint32_t N = 256;
+    const float32_t sampleRate_Hz = 24000;
+    static float32_t I[3*256], Q[3*256];
+    static float32_t Iold[256], Qold[256], Inew[256], Qnew[256];
+    static float32_t Ifade[256], Qfade[256];
+    // A tone that the narrow filter removes and the default one passes
+    for (size_t i = 0; i < 3*N; i++){
+        I[i] = cosf(2.0f*PI*750.0f*i/sampleRate_Hz);
+        Q[i] = sinf(2.0f*PI*750.0f*i/sampleRate_Hz);
+    }
+    DataBlock data;
+    data.N = N;
+    data.sampleRate_Hz = sampleRate_Hz;
+
+    // Reference outputs of the third block with the old and the new filter.
+    // The first two blocks fill the overlap buffer.
+    float32_t *outs[2][2] = {{Iold, Qold}, {Inew, Qnew}};
+    for (int pass = 0; pass < 2; pass++){
+        bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = pass ? -2000 : FLoCut_Hz;
+        bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = pass ? -1000 : FHiCut_Hz;
+        ApplyFIRFilterMask(&RXfilters);
+        for (int b = 0; b < 3; b++){
+            static float32_t bi[256], bq[256];
+            memcpy(bi, &I[b*N], sizeof(bi));
+            memcpy(bq, &Q[b*N], sizeof(bq));
+            data.I = bi;
+            data.Q = bq;
+            data.N = N;
+            ConvolutionFilter(&data, &RXfilters, nullptr);
+        }
+        memcpy(outs[pass][0], data.I, N*sizeof(float32_t));
+        memcpy(outs[pass][1], data.Q, N*sizeof(float32_t));
+    }
+
+    // Filter the first two blocks with the old mask, then switch
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = FLoCut_Hz;
+    bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = FHiCut_Hz;
+    ApplyFIRFilterMask(&RXfilters);
+    for (int b = 0; b < 3; b++){
+        if (b == 2){
+            bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = -2000;
+            bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = -1000;
+            UpdateFIRFilterMask(&RXfilters);
+            ServiceFIRFilterMask();
+        }
+        memcpy(Ifade, &I[b*N], sizeof(Ifade));
+        memcpy(Qfade, &Q[b*N], sizeof(Qfade));
+        data.I = Ifade;
+        data.Q = Qfade;
+        data.N = N;
+        ConvolutionFilter(&data, &RXfilters, nullptr);
+    }
+    EXPECT_FALSE(IsFIRFilterMaskPending());
+
+    // The switch block starts at the old output and ends at the new one
+    for (size_t i = 0; i < N; i++){
+        float32_t w = (float32_t)(i + 1) / (float32_t)N;
+        EXPECT_NEAR(Ifade[i], (1.0f - w)*Iold[i] + w*Inew[i], 1e-4);
+        EXPECT_NEAR(Qfade[i], (1.0f - w)*Qold[i] + w*Qnew[i], 1e-4);
+    }
+    EXPECT_NEAR(Ifade[0], Iold[0], 0.01);
+    EXPECT_NEAR(Ifade[N-1], Inew[N-1], 1e-4);
+
+    bands[ED.currentBand[ED.activeVFO]].FLoCut_Hz = FLoCut_Hz;
+    bands[ED.currentBand[ED.activeVFO]].FHiCut_Hz = FHiCut_Hz;
+    ApplyFIRFilterMask(&RXfilters);
 }
 
 TEST(SignalProcessing, AGCInitializesCorrectly){
@@ -1179,6 +2252,135 @@ TEST(SignalProcessing, AGCRecoveryTime){
     }
 }
 
+/**
+ * Reference for the AGC look-ahead peak: the full window rescan that AGC()
+ * used before the sliding-window peak tracker, applied to the AGC's own ring.
+ */
+float32_t AGCReferenceRingMax(AGCConfig *a, float32_t ring_max){
+    float32_t abs_out_sample = a->abs_ring[a->out_index];
+    if ((abs_out_sample >= ring_max) && (abs_out_sample > 0.0)){
+        ring_max = 0.0;
+        uint32_t k = a->out_index;
+        for (uint32_t j = 0; j < a->attack_buffsize; j++){
+            if (++k == a->ring_buffsize)
+                k = 0;
+            if (a->abs_ring[k] > ring_max)
+                ring_max = a->abs_ring[k];
+        }
+    }
+    if (a->abs_ring[a->in_index] > ring_max)
+        ring_max = a->abs_ring[a->in_index];
+    return ring_max;
+}
+
+TEST(SignalProcessing, AGCPeakTrackerMatchesWindowRescan){
+    // Feed the AGC one sample at a time and check that the peak it tracks is
+    // bit-identical to the rescan of the look-ahead window. The gain depends
+    // on the input only through ring_max, so this pins the gain trajectory.
+    uint32_t Nsamples = 4096;
+    float I[Nsamples];
+    float Q[Nsamples];
+    float32_t sampleRate_Hz = SR[SampleRate].rate/RXfilters.DF;
+    AGCMode presets[] = {AGCLong, AGCSlow, AGCMed, AGCFast};
+    uint32_t seed = 1;
+
+    for (AGCMode preset : presets){
+        ED.agc = preset;
+        InitializeAGC(&agc, sampleRate_Hz);
+        for (int signal = 0; signal < 3; signal++){
+            switch (signal){
+                case 0:
+                    // Keyed tone: constant envelope, which rescanned every sample
+                    CreateIQToneWithPhase(I, Q, Nsamples, sampleRate_Hz, 700.0, 0, 0.1);
+                    for (size_t i = 0; i < Nsamples; i++){
+                        if ((i / 600) % 2){
+                            I[i] = 0;
+                            Q[i] = 0;
+                        }
+                    }
+                    break;
+                case 1:
+                    // Impulses on a noise floor, including equal-height peaks
+                    CreateIQNoise(I, Q, Nsamples, &seed);
+                    for (size_t i = 0; i < Nsamples; i++){
+                        I[i] *= 0.001;
+                        Q[i] *= 0.001;
+                        if (i % 37 == 0) I[i] = 0.5;
+                    }
+                    break;
+                case 2:
+                    // Decaying burst, so the peak steps down every sample
+                    CreateIQNoise(I, Q, Nsamples, &seed);
+                    for (size_t i = 0; i < Nsamples; i++){
+                        I[i] *= expf(-(float)i / 500.0);
+                        Q[i] *= expf(-(float)i / 500.0);
+                    }
+                    break;
+            }
+            float32_t ref = agc.ring_max;
+            uint32_t mismatches = 0;
+            for (size_t i = 0; i < Nsamples; i++){
+                DataBlock data;
+                data.I = &I[i];
+                data.Q = &Q[i];
+                data.N = 1;
+                data.sampleRate_Hz = sampleRate_Hz;
+                AGC(&data, &agc);
+                ref = AGCReferenceRingMax(&agc, ref);
+                if (ref != agc.ring_max) mismatches++;
+            }
+            EXPECT_EQ(mismatches, 0u) << "preset " << preset << " signal " << signal;
+        }
+    }
+}
+
+TEST(SignalProcessing, AGCDecimatedGainTracksPerSampleGain){
+    // Run the same tone burst through an AGC that evaluates its gain on every
+    // sample and one that evaluates it every AGC_GAIN_DECIMATION samples. The
+    // output magnitudes must agree to within 0.1 dB through the attack, the
+    // hang and the decay, and exactly once the gain has settled.
+    uint32_t Nsamples = 256;
+    float I1[Nsamples], Q1[Nsamples];
+    float I2[Nsamples], Q2[Nsamples];
+    float32_t sampleRate_Hz = SR[SampleRate].rate/RXfilters.DF;
+    AGCMode presets[] = {AGCLong, AGCSlow, AGCMed, AGCFast};
+
+    for (AGCMode preset : presets){
+        ED.agc = preset;
+        // Two fresh instances, so neither carries envelope state from earlier tests
+        AGCConfig exact;
+        AGCConfig decimated;
+        exact.gain_decimation = 1;
+        InitializeAGC(&exact, sampleRate_Hz);
+        InitializeAGC(&decimated, sampleRate_Hz);
+        ASSERT_EQ(decimated.gain_decimation, (uint32_t)AGC_GAIN_DECIMATION);
+
+        int phase = 0;
+        float32_t worst_dB = 0;
+        float32_t last_dB = 0;
+        for (size_t block = 0; block < 400; block++){
+            // 1 s at a low level, a 100 ms burst 34 dB up, then the recovery
+            float32_t amplitude = ((block >= 100) && (block < 110)) ? 0.5 : 0.01;
+            phase = CreateIQToneWithPhase(I1, Q1, Nsamples, sampleRate_Hz, -440.0, phase, amplitude);
+            memcpy(I2, I1, sizeof(I1));
+            memcpy(Q2, Q1, sizeof(Q1));
+            DataBlock d1 = {Nsamples, (uint32_t)sampleRate_Hz, I1, Q1};
+            DataBlock d2 = {Nsamples, (uint32_t)sampleRate_Hz, I2, Q2};
+            AGC(&d1, &exact);
+            AGC(&d2, &decimated);
+            for (size_t i = 0; i < Nsamples; i++){
+                float32_t m1 = sqrtf(I1[i]*I1[i] + Q1[i]*Q1[i]);
+                float32_t m2 = sqrtf(I2[i]*I2[i] + Q2[i]*Q2[i]);
+                if (m1 < 1e-6) continue;
+                last_dB = fabsf(20*log10f(m2/m1));
+                if (last_dB > worst_dB) worst_dB = last_dB;
+            }
+        }
+        EXPECT_LT(worst_dB, 0.1) << "preset " << preset;
+        EXPECT_LT(last_dB, 1e-4) << "preset " << preset;
+    }
+}
+
 TEST(SignalProcessing, DemodulateLSB){
     uint32_t Nsamples = 256;
     float I[Nsamples];
@@ -1667,8 +2869,65 @@ TEST(SignalProcessing, NoiseReduction){
 }
 
 TEST(SignalProcessing, InitializeCWProcessing){
-    float32_t * sinbuf = InitializeCWProcessing(15, &RXfilters);
-    EXPECT_FLOAT_EQ(sinbuf[50],sin(50*2*PI*750.0/24000.0));
+    InitializeCWProcessing(15, &RXfilters);
+    EXPECT_EQ(ED.currentWPM, 15);
+
+    // The detector is tuned to the CW tone: a tone there reads its squared
+    // amplitude, and the noise bins see almost nothing of it
+    uint32_t Nsamples = 256;
+    float32_t I[Nsamples], Q[Nsamples];
+    float32_t tone[Nsamples], noise[Nsamples];
+    CreateIQToneWithPhase(I, Q, Nsamples, 24000, CWToneOffsetsHz[ED.CWToneIndex], 0, 0.1);
+    CWToneDetect(I, Nsamples, tone, noise);
+    EXPECT_NEAR(tone[Nsamples-1], 0.01, 0.0005);
+    EXPECT_LT(noise[Nsamples-1], 0.0001);
+}
+
+TEST(SignalProcessing, CWToneDetectorSNR){
+    // Tone in noise, noise alone and a tone halfway to a noise bin
+    uint32_t Nsamples = 256;
+    float32_t sampleRate_Hz = 24000;
+    float32_t tone_Hz = 750.0;
+    float32_t I[Nsamples], Q[Nsamples];
+    float32_t tone[Nsamples], noise[Nsamples];
+    uint32_t seed = 11;
+
+    // A 0.1 amplitude tone in noise is far above the noise bins
+    InitializeCWToneDetector(tone_Hz, sampleRate_Hz);
+    float32_t toneMean = 0, noiseMean = 0;
+    for (int block = 0; block < 8; block++){
+        CreateIQToneWithPhase(I, Q, Nsamples, sampleRate_Hz, tone_Hz, block*Nsamples, 0.1);
+        float32_t nI[Nsamples], nQ[Nsamples];
+        CreateIQNoise(nI, nQ, Nsamples, &seed);
+        for (size_t i = 0; i < Nsamples; i++) I[i] += 0.1*nI[i];
+        CWToneDetect(I, Nsamples, tone, noise);
+    }
+    for (size_t i = 0; i < Nsamples; i++){
+        toneMean += tone[i];
+        noiseMean += noise[i];
+    }
+    EXPECT_GT(10*log10f(toneMean/noiseMean), 20.0);
+
+    // Noise alone reads about the same in all bins
+    InitializeCWToneDetector(tone_Hz, sampleRate_Hz);
+    toneMean = 0;
+    noiseMean = 0;
+    for (int block = 0; block < 40; block++){
+        CreateIQNoise(I, Q, Nsamples, &seed);
+        CWToneDetect(I, Nsamples, tone, noise);
+        if (block < 4) continue;
+        for (size_t i = 0; i < Nsamples; i++){
+            toneMean += tone[i];
+            noiseMean += noise[i];
+        }
+    }
+    EXPECT_NEAR(10*log10f(toneMean/noiseMean), 0.0, 1.5);
+
+    // A tone one bin (250 Hz) away from the CW tone does not read as the CW tone
+    InitializeCWToneDetector(tone_Hz, sampleRate_Hz);
+    CreateIQToneWithPhase(I, Q, Nsamples, sampleRate_Hz, tone_Hz + 250.0, 0, 0.1);
+    CWToneDetect(I, Nsamples, tone, noise);
+    EXPECT_LT(tone[Nsamples-1], 0.01/100);
 }
 
 void delay_us(int64_t delay_time_us){
@@ -1785,6 +3044,198 @@ TEST(SignalProcessing, CWProcessing){
     fclose(file);
 }
 
+/**
+ * Turn a morse string into keying atoms, 1 for key down. '.' and '-' are followed
+ * by one atom of space and ' ' adds two more atoms of space. The atoms start
+ * and end with 10 atoms of silence.
+ * @return The number of atoms
+ */
+size_t MorseToAtoms(const char *morse, uint8_t *ditdah){
+    size_t ddp = 10; // lead in with some silence
+    for (size_t k = 0; k < strlen(morse); k++){
+        switch (morse[k]){
+            case '.':
+                ditdah[ddp++] = 1;
+                ddp++;
+                break;
+            case '-':
+                ditdah[ddp++] = 1;
+                ditdah[ddp++] = 1;
+                ditdah[ddp++] = 1;
+                ddp++;
+                break;
+            case ' ':
+                ddp += 2;
+                break;
+        }
+    }
+    return ddp + 10; // and let the decoder finish the last word
+}
+
+/**
+ * Key the CW tone with a morse string at the given speed, run it through
+ * DoCWReceiveProcessing() and collect the decoded characters.
+ */
+void DecodeKeyedTone(uint32_t wpm, const char *morse, float32_t noise, char *decoded, size_t len){
+    uint8_t ditdah[400] = {0};
+    ASSERT_LT(strlen(morse)*4 + 20, sizeof(ditdah));
+    size_t ddp = MorseToAtoms(morse, ditdah);
+
+    ED.decoderFlag = 1;
+    InitializeCWProcessing(wpm, &RXfilters);
+    InitializeFilters(ED.spectrum_zoom,&RXfilters);
+    uint32_t sampleRate_Hz = SR[SampleRate].rate/RXfilters.DF;
+    uint32_t samples_per_atom = (uint32_t)(1.2 * sampleRate_Hz / wpm);
+    uint32_t N_frames = ddp * samples_per_atom / 256;
+    float32_t I[256];
+    float32_t Q[256];
+    float32_t nI[256];
+    float32_t nQ[256];
+    DataBlock data;
+    data.I = I;
+    data.Q = Q;
+    data.N = 256;
+    data.sampleRate_Hz = sampleRate_Hz;
+
+    uint32_t phase = 0;
+    uint32_t seed = 5;
+    size_t n = 0;
+    for (size_t k = 0; k < N_frames; k++){
+        phase = CreateIQToneWithPhase(I, Q, 256, sampleRate_Hz,
+            CWToneOffsetsHz[ED.CWToneIndex], phase, 0.1);
+        CreateIQNoise(nI, nQ, 256, &seed);
+        for (size_t j = 0; j < 256; j++){
+            I[j] = ditdah[(k*256 + j)/samples_per_atom]*I[j] + noise*nI[j];
+        }
+        DoCWReceiveProcessing(&data, &RXfilters);
+        if (IsMorseCharacterBufferUpdated() && (n < len - 1)){
+            char *buff = GetMorseCharacterBuffer();
+            decoded[n++] = buff[strlen(buff) - 1];
+        }
+    }
+    decoded[n] = '\0';
+}
+
+TEST(SignalProcessing, CWDecoderSpeeds){
+    // The decoder is timed by the sample clock, so it copes with speeds where a
+    // dit lasts only a couple of 256 sample blocks
+    const char *morse = ".--. .- .-. .. ...     -.-. --.-     ";
+    uint32_t wpm[6] = {15, 20, 25, 30, 40, 60};
+    char decoded[32];
+    for (size_t w = 0; w < 6; w++){
+        DecodeKeyedTone(wpm[w], morse, 0.0, decoded, sizeof(decoded));
+        EXPECT_STREQ(decoded, "PARIS CQ ") << wpm[w] << " WPM";
+    }
+    // and still decodes a noisy signal at high speed
+    DecodeKeyedTone(40, morse, 0.05, decoded, sizeof(decoded));
+    EXPECT_STREQ(decoded, "PARIS CQ ");
+    ED.decoderFlag = 0;
+}
+
+TEST(SignalProcessing, CWDecoderReportsSpeed){
+    // The receiver's decoder follows a faster sender and shows its speed. The
+    // speed histogram is only updated every 5 seconds, so key for a minute.
+    const char *morse = ".--. .- .-. .. ...     ";
+    uint8_t atoms[100] = {0};
+    size_t nAtoms = MorseToAtoms(morse, atoms) - 10;
+    uint32_t wpm = 25;
+    InitializeCWProcessing(15, &RXfilters);
+    EXPECT_EQ(ED.currentWPM, 15);
+    int64_t sampleRate_Hz = SR[SampleRate].rate/RXfilters.DF;
+    uint32_t atom_ms = 1200 / wpm;
+    for (int64_t t_ms = 0; t_ms < 60000; t_ms++){
+        uint8_t key = atoms[(t_ms / atom_ms) % nAtoms];
+        DoCWDecoding(key, t_ms * sampleRate_Hz / 1000);
+    }
+    EXPECT_NEAR(ED.currentWPM, wpm, 2);
+}
+
+TEST(SignalProcessing, CWSkimmerChannels){
+    // A tone at a channel centre comes out of that channel only, with its own
+    // power. One halfway between two channels is 6 dB down in both.
+    float32_t I[READ_BUFFER_SIZE], Q[READ_BUFFER_SIZE];
+    DataBlock data = {READ_BUFFER_SIZE, 192000, I, Q};
+    double spacing_Hz = 192000.0 / CW_SKIMMER_CHANNELS;
+    EXPECT_EQ(GetCWSkimmerChannelOffset_Hz(20, 192000), 15000);
+    EXPECT_EQ(GetCWSkimmerChannelOffset_Hz(CW_SKIMMER_CHANNELS - 30, 192000), -22500);
+
+    InitializeCWSkimmer();
+    for (size_t block = 0; block < 3; block++){
+        for (size_t i = 0; i < READ_BUFFER_SIZE; i++){
+            double t = 2.0 * M_PI * (double)(block * READ_BUFFER_SIZE + i) / 192000.0;
+            I[i] = 0.01*cos(20*spacing_Hz*t) + 0.02*cos(-30.5*spacing_Hz*t);
+            Q[i] = 0.01*sin(20*spacing_Hz*t) + 0.02*sin(-30.5*spacing_Hz*t);
+        }
+        DoCWSkimmerProcessing(&data);
+    }
+    EXPECT_NEAR(GetCWSkimmerChannelPower(20), 1e-4, 2e-6);
+    EXPECT_LT(GetCWSkimmerChannelPower(19), 1e-4/1000);
+    EXPECT_LT(GetCWSkimmerChannelPower(21), 1e-4/1000);
+    EXPECT_NEAR(GetCWSkimmerChannelPower(CW_SKIMMER_CHANNELS - 30), 1e-4, 1e-5);
+    EXPECT_NEAR(GetCWSkimmerChannelPower(CW_SKIMMER_CHANNELS - 31), 1e-4, 1e-5);
+    EXPECT_LT(GetCWSkimmerChannelPower(CW_SKIMMER_CHANNELS - 29), 1e-4/100);
+}
+
+TEST(SignalProcessing, CWSkimmerDecodesSeveralSignals){
+    // Two stations keying at the same time in different channels are decoded
+    // independently, and each word comes out with its channel frequency
+    const char *morseA = ".--. .- .-. .. ...     -.-. --.-     ";    // PARIS CQ
+    const char *morseB = "     - . ... -     -.. .     -.- .---- "; // TEST DE K1
+    uint8_t atomsA[400] = {0};
+    uint8_t atomsB[400] = {0};
+    size_t nA = MorseToAtoms(morseA, atomsA);
+    size_t nB = MorseToAtoms(morseB, atomsB);
+    size_t nAtoms = (nA > nB) ? nA : nB;
+    int32_t offsetA_Hz = 40 * 750;
+    int32_t offsetB_Hz = -60 * 750 + 150; // not quite at the channel centre
+    uint32_t samplesPerAtom = (uint32_t)(1.2 * 192000 / CW_SKIMMER_WPM);
+
+    float32_t I[READ_BUFFER_SIZE], Q[READ_BUFFER_SIZE];
+    float32_t nI[READ_BUFFER_SIZE], nQ[READ_BUFFER_SIZE];
+    DataBlock data = {READ_BUFFER_SIZE, 192000, I, Q};
+    uint32_t seed = 7;
+    InitializeCWSkimmer();
+    EnableCWSkimmer(true);
+    ED.currentWPM = 17;
+    uint32_t nBlocks = nAtoms * samplesPerAtom / READ_BUFFER_SIZE;
+    uint32_t maxActive = 0;
+    for (size_t block = 0; block < nBlocks; block++){
+        CreateIQNoise(nI, nQ, READ_BUFFER_SIZE, &seed);
+        for (size_t i = 0; i < READ_BUFFER_SIZE; i++){
+            size_t n = block * READ_BUFFER_SIZE + i;
+            size_t atom = n / samplesPerAtom;
+            double tA = 2.0 * M_PI * offsetA_Hz * (double)n / 192000.0;
+            double tB = 2.0 * M_PI * offsetB_Hz * (double)n / 192000.0;
+            I[i] = 0.01*atomsA[atom]*cos(tA) + 0.005*atomsB[atom]*cos(tB) + 0.002*nI[i];
+            Q[i] = 0.01*atomsA[atom]*sin(tA) + 0.005*atomsB[atom]*sin(tB) + 0.002*nQ[i];
+        }
+        DoCWSkimmerProcessing(&data);
+        if (GetCWSkimmerActiveChannels() > maxActive) maxActive = GetCWSkimmerActiveChannels();
+    }
+    EXPECT_EQ(maxActive, (uint32_t)2);
+
+    std::string textA, textB;
+    CWSkimmerSpot spot;
+    while (GetCWSkimmerSpot(&spot)){
+        if (spot.offset_Hz == offsetA_Hz){
+            textA += spot.text;
+            textA += " ";
+            EXPECT_EQ(spot.frequency_Hz, ED.centerFreq_Hz[ED.activeVFO] + offsetA_Hz);
+            EXPECT_GT(spot.snr_dB, CW_SKIMMER_SNR_DB);
+        } else if (spot.offset_Hz == -60 * 750){
+            textB += spot.text;
+            textB += " ";
+        } else {
+            ADD_FAILURE() << "Spot " << spot.text << " at " << spot.offset_Hz << " Hz";
+        }
+    }
+    EXPECT_EQ(textA, "PARIS CQ ");
+    EXPECT_EQ(textB, "TEST DE K1 ");
+    // The skimmer channels leave the receiver's speed alone
+    EXPECT_EQ(ED.currentWPM, 17);
+    EnableCWSkimmer(false);
+}
+
 
 void CW_filter_tone(float32_t toneFreq_Hz, DataBlock *dout, float32_t *gain){
     uint32_t Nsamples = 256;
@@ -11,13 +11,38 @@ public:
     TwoWire() {}
     ~TwoWire() {}
 
+    // Bus traffic since the last resetCounters(), address bytes included
+    uint32_t bytes = 0;
+    uint32_t transactions = 0;
+    // When true, requestFrom() receives readValue for every byte requested
+    bool respond = false;
+    uint8_t readValue = 0;
+
+    void resetCounters(void) { bytes = 0; transactions = 0; }
+
     void begin() {}
-    void beginTransmission(uint8_t address) {}
-    size_t write(uint8_t data) { return 1; }
+    void beginTransmission(uint8_t address) { bytes++; transactions++; }
+    size_t write(uint8_t data) { bytes++; return 1; }
     uint8_t endTransmission(void) { return 0; }
-    uint8_t requestFrom(uint8_t address, size_t quantity) { return 0; }
-    int read(void) { return -1; }
-    int available(void) { return 0; }
+    uint8_t requestFrom(uint8_t address, size_t quantity) {
+        bytes++;
+        transactions++;
+        rxAvailable = respond ? (int)quantity : 0;
+        bytes += rxAvailable;
+        return (uint8_t)rxAvailable;
+    }
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop) {
+        return requestFrom(address, (size_t)quantity);
+    }
+    int read(void) {
+        if (rxAvailable == 0) return -1;
+        rxAvailable--;
+        return readValue;
+    }
+    int available(void) { return rxAvailable; }
+
+private:
+    int rxAvailable = 0;
 };
 
 extern TwoWire Wire;
@@ -25,16 +25,73 @@
 #include "Arduino.h"
 #include "Wire.h"
 #include "RFBoard_si5351.h"
+#include "si5351_mock.h"
 
 // Mock control: which I2C address the simulated device responds to
 static uint8_t mock_device_address = SI5351_DUAL_VFO_ADDR;  // Default to dual VFO for backwards compatibility
 //static uint8_t mock_device_address = SI5351_BUS_BASE_ADDR;
 
+// Log of the calls that change the outputs, so tests can check their order and timing
+static Si5351MockCall mock_log[SI5351_MOCK_LOG_SIZE];
+static size_t mock_log_size = 0;
+
 // Function to control mock behavior from tests
 void Si5351_Mock_SetDeviceAddress(uint8_t addr) {
     mock_device_address = addr;
 }
 
+void Si5351_Mock_ClearLog(void) {
+    mock_log_size = 0;
+}
+
+size_t Si5351_Mock_GetLogSize(void) {
+    return mock_log_size;
+}
+
+Si5351MockCall Si5351_Mock_GetLogEntry(size_t i) {
+    return mock_log[i];
+}
+
+static void mock_log_call(Si5351MockOp op, uint8_t target, uint64_t value) {
+    if (mock_log_size >= SI5351_MOCK_LOG_SIZE) return;
+    mock_log[mock_log_size++] = {op, target, value, micros()};
+}
+
+// The mock writes the same registers as the driver, with values close enough
+// to the real ones that the register shadow and its I2C counters behave as
+// they do on the hardware.
+
+// Pack num/den as a + b/c into a PLL or multisynth parameter block
+static void mock_pack_ratio(uint64_t num, uint64_t den, uint8_t *params) {
+    uint64_t c = SI5351_PLL_C_MAX;
+    uint64_t a = num / den;
+    uint64_t b = ((num % den) * c) / den;
+    uint32_t p1 = (uint32_t)(128 * a + (128 * b) / c - 512);
+    uint32_t p2 = (uint32_t)(128 * b - c * ((128 * b) / c));
+    uint32_t p3 = (uint32_t)c;
+    params[0] = (p3 >> 8) & 0xFF;
+    params[1] = p3 & 0xFF;
+    params[2] = (p1 >> 16) & 0x03;
+    params[3] = (p1 >> 8) & 0xFF;
+    params[4] = p1 & 0xFF;
+    params[5] = ((p3 >> 12) & 0xF0) | ((p2 >> 16) & 0x0F);
+    params[6] = (p2 >> 8) & 0xFF;
+    params[7] = p2 & 0xFF;
+}
+
+static void mock_write_pll(Si5351 &dev, uint64_t pll_freq, enum si5351_pll target_pll) {
+    uint8_t params[SI5351_PARAMETERS_LENGTH];
+    mock_pack_ratio(pll_freq, dev.xtal_freq[0] * SI5351_FREQ_MULT, params);
+    dev.si5351_write_bulk(target_pll == SI5351_PLLA ? SI5351_PLLA_PARAMETERS : SI5351_PLLB_PARAMETERS,
+                          SI5351_PARAMETERS_LENGTH, params);
+}
+
+// Read-modify-write of the bits in mask, as the driver's control functions do
+static void mock_update_register(Si5351 &dev, uint8_t addr, uint8_t mask, uint8_t value) {
+    uint8_t reg_val = dev.si5351_read(addr);
+    dev.si5351_write(addr, (reg_val & ~mask) | (value & mask));
+}
+
 /********************/
 /* Public functions */
 /********************/
@@ -58,6 +115,7 @@ Si5351::Si5351(uint8_t i2c_addr):
 void Si5351::set_address(uint8_t i2c_addr)
 {
 	i2c_bus_addr = i2c_addr;
+	regmap.invalidate();
 }
 
 /*
@@ -77,6 +135,7 @@ void Si5351::set_address(uint8_t i2c_addr)
  *
  */
 bool Si5351::init(uint8_t xtal_load_c, uint32_t xo_freq, int32_t corr){
+    regmap.invalidate();
     // Only return true if our current address matches the mock device address
     return (i2c_bus_addr == mock_device_address);
 }
@@ -121,12 +180,26 @@ uint8_t Si5351::set_freq(uint64_t freq, enum si5351_clock clk){
  *   (use the si5351_clock enum)
  */
 uint8_t Si5351::set_freq_manual(uint64_t freq, uint64_t pll_freq, enum si5351_clock clk){
+    mock_log_call(SI5351_MOCK_SET_FREQ_MANUAL, clk, freq);
     clk_freq[clk] = freq;
     if (pll_assignment[clk] == SI5351_PLLA) {
         plla_freq = pll_freq;
     } else {
         pllb_freq = pll_freq;
     }
+    if ((clk > SI5351_CLK5) || (freq == 0)) return 0;
+
+    // Register writes of the driver: PLL, output enable, multisynth
+    // parameters, integer mode and output divider
+    uint8_t ms_addr = SI5351_CLK0_PARAMETERS + SI5351_PARAMETERS_LENGTH * clk;
+    uint8_t params[SI5351_PARAMETERS_LENGTH];
+    mock_write_pll(*this, pll_freq, pll_assignment[clk]);
+    mock_update_register(*this, SI5351_OUTPUT_ENABLE_CTRL, 1 << clk, 0);
+    mock_pack_ratio(pll_freq, freq, params);
+    params[2] |= si5351_read(ms_addr + 2) & ~0x03;
+    si5351_write_bulk(ms_addr, SI5351_PARAMETERS_LENGTH, params);
+    mock_update_register(*this, SI5351_CLK0_CTRL + clk, SI5351_CLK_INTEGER_MODE, 0);
+    mock_update_register(*this, ms_addr + 2, 0x7c, 0);
     return 0;
 }
 
@@ -140,11 +213,13 @@ uint8_t Si5351::set_freq_manual(uint64_t freq, uint64_t pll_freq, enum si5351_cl
  *     (use the si5351_pll enum)
  */
 void Si5351::set_pll(uint64_t pll_freq, enum si5351_pll target_pll){
+    mock_log_call(SI5351_MOCK_SET_PLL, target_pll, pll_freq);
     if (target_pll == SI5351_PLLA) {
         plla_freq = pll_freq;
     } else {
         pllb_freq = pll_freq;
     }
+    mock_write_pll(*this, pll_freq, target_pll);
 }
 
 /*
@@ -173,7 +248,9 @@ void Si5351::set_ms(enum si5351_clock clk, struct Si5351RegSet ms_reg, uint8_t i
  */
 void Si5351::output_enable(enum si5351_clock clk, uint8_t enable)
 {
+    mock_log_call(SI5351_MOCK_OUTPUT_ENABLE, clk, enable);
     output_enable_calls[clk] = enable;
+    mock_update_register(*this, SI5351_OUTPUT_ENABLE_CTRL, 1 << clk, enable == 1 ? 0 : 1 << clk);
 }
 
 /*
@@ -190,6 +267,7 @@ void Si5351::drive_strength(enum si5351_clock clk, enum si5351_drive drive)
 {
     drive_strength_calls[clk]++;
     drive_strength_values[clk] = drive;
+    mock_update_register(*this, SI5351_CLK0_CTRL + clk, SI5351_CLK_DRIVE_STRENGTH_MASK, drive);
 }
 
 /*
@@ -248,8 +326,10 @@ void Si5351::set_correction(int32_t corr, enum si5351_pll_input ref_osc)
  */
 void Si5351::set_phase(enum si5351_clock clk, uint8_t phase)
 {
+    mock_log_call(SI5351_MOCK_SET_PHASE, clk, phase);
     phase_calls[clk]++;
     phase_values[clk] = phase;
+    si5351_write(SI5351_CLK0_PHASE_OFFSET + clk, phase & 0b01111111);
 }
 
 /*
@@ -277,7 +357,9 @@ int32_t Si5351::get_correction(enum si5351_pll_input ref_osc)
  */
 void Si5351::pll_reset(enum si5351_pll target_pll)
 {
+    mock_log_call(SI5351_MOCK_PLL_RESET, target_pll, 0);
     pll_reset_calls[target_pll]++;
+    si5351_write(SI5351_PLL_RESET, target_pll == SI5351_PLLA ? SI5351_PLL_RESET_A : SI5351_PLL_RESET_B);
 }
 
 /*
@@ -293,6 +375,8 @@ void Si5351::pll_reset(enum si5351_pll target_pll)
 void Si5351::set_ms_source(enum si5351_clock clk, enum si5351_pll pll)
 {
     pll_assignment[clk] = pll;
+    mock_update_register(*this, SI5351_CLK0_CTRL + clk, SI5351_CLK_PLL_SELECT,
+                         pll == SI5351_PLLB ? SI5351_CLK_PLL_SELECT : 0);
 }
 
 /*
@@ -417,16 +501,22 @@ void Si5351::set_ref_freq(uint32_t ref_freq, enum si5351_pll_input ref_osc)
 
 uint8_t Si5351::si5351_write_bulk(uint8_t addr, uint8_t bytes, uint8_t *data)
 {
-	return 0;
+	return regmap.write(i2c_bus_addr, addr, bytes, data);
 }
 
 uint8_t Si5351::si5351_write(uint8_t addr, uint8_t data)
 {
-	return 0;
+	return regmap.write(i2c_bus_addr, addr, 1, &data);
 }
 
+// The simulated device powers up with all registers at zero
 uint8_t Si5351::si5351_read(uint8_t addr)
 {
+	uint8_t reg_val = 0;
+	if (regmap.lookup(addr, &reg_val))
+		return reg_val;
+	regmap.count_read(1);
+	regmap.fill(addr, 0);
 	return 0;
 }
 
@@ -0,0 +1,33 @@
+#ifndef SI5351_MOCK_H
+#define SI5351_MOCK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Calls into the mock Si5351 that change the clock outputs, in the order made
+enum Si5351MockOp {
+    SI5351_MOCK_SET_FREQ_MANUAL,
+    SI5351_MOCK_SET_PLL,
+    SI5351_MOCK_SET_PHASE,
+    SI5351_MOCK_PLL_RESET,
+    SI5351_MOCK_OUTPUT_ENABLE
+};
+
+struct Si5351MockCall {
+    Si5351MockOp op;
+    uint8_t target;  // clock output, or PLL for SET_PLL and PLL_RESET
+    uint64_t value;  // frequency, phase or enable, depending on op
+    uint32_t time_us;// micros() when the call was made
+};
+
+#define SI5351_MOCK_LOG_SIZE 64
+
+// Mock control: which I2C address the simulated device responds to
+void Si5351_Mock_SetDeviceAddress(uint8_t addr);
+
+// Call log
+void Si5351_Mock_ClearLog(void);
+size_t Si5351_Mock_GetLogSize(void);
+Si5351MockCall Si5351_Mock_GetLogEntry(size_t i);
+
+#endif // SI5351_MOCK_H